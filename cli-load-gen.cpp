@@ -0,0 +1,784 @@
+/**
+ * Semtech UDP packet forwarder load generator.
+ * Simulate virtual gateways (each has own UDP socket) and ABP/OTAA devices (keys from GenIdentityService),
+ * send PUSH_DATA and PULL_DATA to the network server, check PUSH_ACK, PULL_ACK and PULL_RESP timing.
+ * Print throughput and latency percentiles as JSON.
+ */
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include "argtable3/argtable3.h"
+
+#include "lorawan/lorawan-error.h"
+#include "lorawan/lorawan-msg.h"
+#include "lorawan/lorawan-string.h"
+#include "lorawan/lorawan-conv.h"
+#include "lorawan/lorawan-mic.h"
+#include "lorawan/helper/aes-helper.h"
+#include "lorawan/helper/codec-helper.h"
+#include "lorawan/helper/ip-address.h"
+#include "lorawan/proto/gw/basic-udp.h"
+#include "lorawan/storage/service/identity-service-gen.h"
+
+// i18n
+#include <libintl.h>
+#define _(String) gettext (String)
+/// #define _(String) (String)
+
+const char *programName = "tlns-load-gen";
+
+#define DEF_PORT                4242
+#define DEF_GATEWAYS            100
+#define DEF_DEVICES             10000
+#define DEF_RATE                1000
+#define DEF_SECONDS             10
+#define DEF_DUPLICATES          1
+#define DEF_PAYLOAD_SIZE        16
+#define DEF_PULL_INTERVAL_MS    10000
+#define DEF_ACK_TIMEOUT_MS      1000
+#define DEF_RX1_DELAY_MS        1000
+#define DEF_FIRST_GATEWAY_ID    0x00006cc300000000ULL
+#define FRM_PORT                1
+#define MAX_PACKET_SIZE         1024
+
+typedef std::chrono::steady_clock::time_point LOAD_TIME;
+
+class LoadGenParams {
+public:
+    std::string intf;
+    uint16_t port;
+    int gateways;
+    int devices;
+    int otaaPercent;            ///< devices sending Join-request
+    int confirmedPercent;       ///< confirmed uplinks
+    double rate;                ///< uplinks per second, all threads
+    int seconds;
+    int duplicates;             ///< gateways receiving each uplink
+    int payloadSize;
+    int threads;
+    uint32_t firstAddr;
+    uint64_t firstGatewayId;
+    std::string masterKey;
+    int pullIntervalMs;
+    int ackTimeoutMs;
+    int rx1DelayMs;
+    int verbose;
+    LoadGenParams()
+        : port(DEF_PORT), gateways(DEF_GATEWAYS), devices(DEF_DEVICES), otaaPercent(0), confirmedPercent(0),
+        rate(DEF_RATE), seconds(DEF_SECONDS), duplicates(DEF_DUPLICATES), payloadSize(DEF_PAYLOAD_SIZE), threads(1),
+        firstAddr(1), firstGatewayId(DEF_FIRST_GATEWAY_ID), pullIntervalMs(DEF_PULL_INTERVAL_MS),
+        ackTimeoutMs(DEF_ACK_TIMEOUT_MS), rx1DelayMs(DEF_RX1_DELAY_MS), verbose(0)
+    {
+    }
+};
+
+static LoadGenParams params;
+
+class VirtualDevice {
+public:
+    NetworkIdentity identity;
+    bool otaa;
+    uint32_t fcnt;
+    uint16_t devNonce;
+    bool confirmedPending;      ///< waiting for the downlink
+    LOAD_TIME confirmedSent;
+    uint32_t confirmedTmst;
+    VirtualDevice()
+        : otaa(false), fcnt(0), devNonce(0), confirmedPending(false), confirmedTmst(0)
+    {
+    }
+};
+
+class VirtualGateway {
+public:
+    DEVEUI id;
+    int sock;
+    uint16_t token;
+    LOAD_TIME nextPull;
+    VirtualGateway()
+        : sock(-1), token(0)
+    {
+    }
+};
+
+class PendingAck {
+public:
+    LOAD_TIME sent;
+    bool pull;
+};
+
+class LoadStat {
+public:
+    uint64_t uplinks;
+    uint64_t confirmed;
+    uint64_t joinRequests;
+    uint64_t pushData;
+    uint64_t pushAck;
+    uint64_t pullData;
+    uint64_t pullAck;
+    uint64_t ackLost;           ///< PUSH_ACK not received
+    uint64_t pullAckLost;       ///< keepalive PULL_ACK not received, does not fail the run
+    uint64_t downlinks;
+    uint64_t lateDownlinks;
+    uint64_t tmstMismatch;
+    uint64_t confirmedUnanswered;
+    uint64_t joinAccepts;
+    uint64_t unexpected;
+    uint64_t sendErrors;
+    std::vector<uint32_t> pushAckMicroseconds;
+    std::vector<uint32_t> pullAckMicroseconds;
+    std::vector<uint32_t> downlinkMicroseconds;
+    LoadStat()
+        : uplinks(0), confirmed(0), joinRequests(0), pushData(0), pushAck(0), pullData(0), pullAck(0), ackLost(0), pullAckLost(0),
+        downlinks(0), lateDownlinks(0), tmstMismatch(0), confirmedUnanswered(0), joinAccepts(0), unexpected(0),
+        sendErrors(0)
+    {
+    }
+
+    void add(
+        const LoadStat &value
+    )
+    {
+        uplinks += value.uplinks;
+        confirmed += value.confirmed;
+        joinRequests += value.joinRequests;
+        pushData += value.pushData;
+        pushAck += value.pushAck;
+        pullData += value.pullData;
+        pullAck += value.pullAck;
+        ackLost += value.ackLost;
+        pullAckLost += value.pullAckLost;
+        downlinks += value.downlinks;
+        lateDownlinks += value.lateDownlinks;
+        tmstMismatch += value.tmstMismatch;
+        confirmedUnanswered += value.confirmedUnanswered;
+        joinAccepts += value.joinAccepts;
+        unexpected += value.unexpected;
+        sendErrors += value.sendErrors;
+        pushAckMicroseconds.insert(pushAckMicroseconds.end(), value.pushAckMicroseconds.begin(), value.pushAckMicroseconds.end());
+        pullAckMicroseconds.insert(pullAckMicroseconds.end(), value.pullAckMicroseconds.begin(), value.pullAckMicroseconds.end());
+        downlinkMicroseconds.insert(downlinkMicroseconds.end(), value.downlinkMicroseconds.begin(), value.downlinkMicroseconds.end());
+    }
+};
+
+static uint32_t microseconds(
+    LOAD_TIME since,
+    LOAD_TIME now
+)
+{
+    return (uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(now - since).count();
+}
+
+/**
+ * Each worker thread owns every n-th gateway and device so downlinks come back to the same thread
+ */
+class LoadWorker {
+private:
+    const struct sockaddr *destAddr;
+    std::vector<VirtualGateway> gateways;
+    std::vector<VirtualDevice> &devices;
+    std::vector<size_t> deviceIndices;
+    std::unordered_map<uint64_t, PendingAck> pending;
+    std::mt19937 rnd;
+    LOAD_TIME started;
+    size_t nextDevice;
+
+    int sendPacket(
+        VirtualGateway &gw,
+        const char *buf,
+        size_t size
+    )
+    {
+        if (send(gw.sock, buf, size, 0) != (ssize_t) size) {
+            stat.sendErrors++;
+            return ERR_CODE_SOCKET_WRITE;
+        }
+        return CODE_OK;
+    }
+
+    static size_t setPrefix(
+        char *buf,
+        VirtualGateway &gw,
+        uint8_t tag,
+        uint16_t token
+    )
+    {
+        auto p = (SEMTECH_PREFIX_GW *) buf;
+        p->version = 2;
+        p->token = token;
+        p->tag = tag;
+        p->mac.u = NTOH8(gw.id.u);
+        return SIZE_SEMTECH_PREFIX_GW;
+    }
+
+    void addPending(
+        size_t gwIndex,
+        uint16_t token,
+        LOAD_TIME now,
+        bool pull
+    )
+    {
+        pending[((uint64_t) gwIndex << 16) | token] = PendingAck { now, pull };
+    }
+
+    void sendPull(
+        size_t gwIndex,
+        LOAD_TIME now
+    )
+    {
+        VirtualGateway &gw = gateways[gwIndex];
+        char buf[SIZE_SEMTECH_PREFIX_GW];
+        uint16_t token = ++gw.token;
+        setPrefix(buf, gw, SEMTECH_GW_PULL_DATA, token);
+        if (sendPacket(gw, buf, sizeof(buf)) == CODE_OK) {
+            stat.pullData++;
+            addPending(gwIndex, token, now, true);
+        }
+        gw.nextPull = now + std::chrono::milliseconds(params.pullIntervalMs);
+    }
+
+    /**
+     * Make data uplink (ABP) or Join-request (OTAA) radio packet
+     * @return packet size
+     */
+    size_t makeFrame(
+        uint8_t *retVal,
+        VirtualDevice &dev,
+        bool confirmed
+    )
+    {
+        if (dev.otaa) {
+            JOIN_REQUEST_HEADER h {};
+            h.mhdr.f.mtype = MTYPE_JOIN_REQUEST;
+            h.frame.joinEUI = dev.identity.appEUI;
+            h.frame.devEUI = dev.identity.devEUI;
+            h.frame.devNonce.u = ++dev.devNonce;
+            h.mic = NTOH4(calculateMICJoinRequest(&h, dev.identity.nwkKey));
+            memmove(retVal, &h, SIZE_JOIN_REQUEST_HEADER);
+            return SIZE_JOIN_REQUEST_HEADER;
+        }
+        MHDR mhdr {};
+        mhdr.f.mtype = confirmed ? MTYPE_CONFIRMED_DATA_UP : MTYPE_UNCONFIRMED_DATA_UP;
+        uint32_t a = dev.identity.devaddr.u;
+        uint16_t fcnt = (uint16_t) dev.fcnt++;
+        retVal[0] = mhdr.i;
+        // DevAddr, FCnt are little endian
+        retVal[1] = (uint8_t) a;
+        retVal[2] = (uint8_t) (a >> 8);
+        retVal[3] = (uint8_t) (a >> 16);
+        retVal[4] = (uint8_t) (a >> 24);
+        retVal[5] = 0;  // FCtrl
+        retVal[6] = (uint8_t) fcnt;
+        retVal[7] = (uint8_t) (fcnt >> 8);
+        retVal[8] = FRM_PORT;
+        size_t sz = 9;
+        for (int i = 0; i < params.payloadSize; i++) {
+            retVal[sz + i] = (uint8_t) rnd();
+        }
+        encryptPayload(retVal + sz, params.payloadSize, fcnt, LORAWAN_UPLINK, dev.identity.devaddr, dev.identity.appSKey);
+        sz += params.payloadSize;
+        uint32_t mic = NTOH4(calculateMICFrmPayload(retVal, (unsigned char) sz, fcnt, LORAWAN_UPLINK,
+            dev.identity.devaddr, dev.identity.nwkSKey));
+        memmove(retVal + sz, &mic, SIZE_MIC);
+        return sz + SIZE_MIC;
+    }
+
+    void sendUplink(
+        VirtualDevice &dev,
+        size_t deviceNo,
+        LOAD_TIME now
+    )
+    {
+        bool confirmed = !dev.otaa && params.confirmedPercent > 0
+            && (int) (rnd() % 100) < params.confirmedPercent;
+        uint8_t frame[256];
+        size_t frameSize = makeFrame(frame, dev, confirmed);
+        char base64[BASE64_ENCODED_SIZE(256)];
+        size_t base64Size = base64Encode(base64, frame, frameSize);
+        uint32_t tmst = microseconds(started, now);
+        if (confirmed) {
+            if (dev.confirmedPending)
+                stat.confirmedUnanswered++;
+            dev.confirmedPending = true;
+            dev.confirmedSent = now;
+            dev.confirmedTmst = tmst;
+            stat.confirmed++;
+        }
+        if (dev.otaa)
+            stat.joinRequests++;
+        stat.uplinks++;
+        // same radio packet heard by duplicates gateways
+        size_t gwCount = gateways.size();
+        size_t dups = std::min((size_t) params.duplicates, gwCount);
+        size_t firstGw = (deviceNo * 7) % gwCount;
+        int chan = (int) (deviceNo % 8);
+        char buf[MAX_PACKET_SIZE];
+        for (size_t d = 0; d < dups; d++) {
+            size_t gwIndex = (firstGw + d) % gwCount;
+            VirtualGateway &gw = gateways[gwIndex];
+            uint16_t token = ++gw.token;
+            size_t sz = setPrefix(buf, gw, SEMTECH_GW_PUSH_DATA, token);
+            int r = snprintf(buf + sz, sizeof(buf) - sz,
+                R"({"rxpk":[{"tmst":%u,"chan":%d,"rfch":0,"freq":%.6f,"stat":1,"modu":"LORA","datr":"SF7BW125",)"
+                R"("codr":"4/5","lsnr":%.1f,"rssi":%d,"size":%u,"data":"%.*s"}]})",
+                tmst, chan, 868.1 + 0.2 * chan, 9.5 - (double) d, -40 - (int) (d * 10) - (int) (rnd() % 5),
+                (unsigned) frameSize, (int) base64Size, base64);
+            if (r <= 0 || (size_t) r >= sizeof(buf) - sz)
+                continue;
+            if (sendPacket(gw, buf, sz + r) == CODE_OK) {
+                stat.pushData++;
+                addPending(gwIndex, token, now, false);
+            }
+        }
+    }
+
+    void onDownlink(
+        VirtualGateway &gw,
+        const char *buf,
+        size_t size,
+        uint16_t token,
+        LOAD_TIME now
+    )
+    {
+        // network server may send PULL_RESP with or without gateway identifier
+        auto json = (const char *) memchr(buf, '{', size);
+        if (!json) {
+            stat.unexpected++;
+            return;
+        }
+        GwPullResp resp;
+        if (parsePullResp(&resp, json, size - (json - buf), gw.id) != CODE_OK) {
+            stat.unexpected++;
+            return;
+        }
+        // TX_ACK
+        char ack[SIZE_SEMTECH_PREFIX_GW + 32];
+        size_t sz = setPrefix(ack, gw, SEMTECH_GW_TX_ACK, token);
+        static const char TX_ACK_NONE[] = R"({"txpk_ack":{"error":"NONE"}})";
+        memmove(ack + sz, TX_ACK_NONE, sizeof(TX_ACK_NONE) - 1);
+        sendPacket(gw, ack, sz + sizeof(TX_ACK_NONE) - 1);
+
+        switch ((MTYPE) resp.txData.mhdr.f.mtype) {
+            case MTYPE_JOIN_ACCEPT:
+                stat.joinAccepts++;
+                return;
+            case MTYPE_UNCONFIRMED_DATA_DOWN:
+            case MTYPE_CONFIRMED_DATA_DOWN:
+                break;
+            default:
+                stat.unexpected++;
+                return;
+        }
+        uint32_t devIndex = resp.txData.data.downlink.devaddr.u - params.firstAddr;
+        if (devIndex >= devices.size() || !devices[devIndex].confirmedPending) {
+            stat.unexpected++;
+            return;
+        }
+        VirtualDevice &dev = devices[devIndex];
+        dev.confirmedPending = false;
+        stat.downlinks++;
+        uint32_t us = microseconds(dev.confirmedSent, now);
+        stat.downlinkMicroseconds.push_back(us);
+        // PULL_RESP must arrive before RX1 window opens
+        if (us > (uint32_t) params.rx1DelayMs * 1000)
+            stat.lateDownlinks++;
+        uint32_t t = resp.txMetadata.count_us;
+        if (t && t != dev.confirmedTmst + (uint32_t) params.rx1DelayMs * 1000
+            && t != dev.confirmedTmst + (uint32_t) (params.rx1DelayMs + 1000) * 1000)
+            stat.tmstMismatch++;
+    }
+
+    void onReceive(
+        size_t gwIndex,
+        const char *buf,
+        size_t size,
+        LOAD_TIME now
+    )
+    {
+        if (size < SIZE_SEMTECH_ACK || buf[0] != 2) {
+            stat.unexpected++;
+            return;
+        }
+        auto p = (const SEMTECH_PREFIX *) buf;
+        switch (p->tag) {
+            case SEMTECH_GW_PUSH_ACK:
+            case SEMTECH_GW_PULL_ACK:
+            {
+                auto it = pending.find(((uint64_t) gwIndex << 16) | p->token);
+                if (it == pending.end()) {
+                    stat.unexpected++;
+                    break;
+                }
+                uint32_t us = microseconds(it->second.sent, now);
+                if (it->second.pull) {
+                    stat.pullAck++;
+                    stat.pullAckMicroseconds.push_back(us);
+                } else {
+                    stat.pushAck++;
+                    stat.pushAckMicroseconds.push_back(us);
+                }
+                pending.erase(it);
+            }
+                break;
+            case SEMTECH_GW_PULL_RESP:
+            case SEMTECH_GW_PULL_DATA:
+                onDownlink(gateways[gwIndex], buf, size, p->token, now);
+                break;
+            default:
+                stat.unexpected++;
+        }
+    }
+
+    void expire(
+        LOAD_TIME now,
+        bool all
+    )
+    {
+        auto timeout = std::chrono::milliseconds(params.ackTimeoutMs);
+        for (auto it = pending.begin(); it != pending.end(); ) {
+            if (all || now - it->second.sent > timeout) {
+                if (it->second.pull)
+                    stat.pullAckLost++;
+                else
+                    stat.ackLost++;
+                it = pending.erase(it);
+            } else
+                it++;
+        }
+    }
+
+    void receive(
+        std::vector<struct pollfd> &fds,
+        int timeoutMs
+    )
+    {
+        if (poll(fds.data(), fds.size(), timeoutMs) <= 0)
+            return;
+        char buf[MAX_PACKET_SIZE];
+        for (size_t i = 0; i < fds.size(); i++) {
+            if (!(fds[i].revents & POLLIN))
+                continue;
+            while (true) {
+                ssize_t sz = recv(fds[i].fd, buf, sizeof(buf), MSG_DONTWAIT);
+                if (sz <= 0)
+                    break;
+                onReceive(i, buf, (size_t) sz, std::chrono::steady_clock::now());
+            }
+        }
+    }
+
+public:
+    LoadStat stat;
+
+    LoadWorker(
+        const struct sockaddr *aDestAddr,
+        std::vector<VirtualDevice> &aDevices,
+        int workerNo
+    )
+        : destAddr(aDestAddr), devices(aDevices), rnd(workerNo + 1), nextDevice(0)
+    {
+        for (int g = workerNo; g < params.gateways; g += params.threads) {
+            VirtualGateway gw;
+            gw.id.u = params.firstGatewayId + g;
+            gateways.push_back(gw);
+        }
+        for (size_t d = workerNo; d < devices.size(); d += params.threads) {
+            deviceIndices.push_back(d);
+        }
+    }
+
+    ~LoadWorker()
+    {
+        for (auto &gw : gateways) {
+            if (gw.sock >= 0)
+                close(gw.sock);
+        }
+    }
+
+    int open()
+    {
+        socklen_t addrLen = destAddr->sa_family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+        for (auto &gw : gateways) {
+            gw.sock = socket(destAddr->sa_family, SOCK_DGRAM, 0);
+            if (gw.sock < 0)
+                return ERR_CODE_SOCKET_CREATE;
+            if (connect(gw.sock, destAddr, addrLen))
+                return ERR_CODE_SOCKET_CONNECT;
+        }
+        return CODE_OK;
+    }
+
+    void run()
+    {
+        if (gateways.empty() || deviceIndices.empty())
+            return;
+        std::vector<struct pollfd> fds;
+        for (auto &gw : gateways) {
+            fds.push_back({ gw.sock, POLLIN, 0 });
+        }
+        started = std::chrono::steady_clock::now();
+        // gateways start with PULL_DATA so network server knows where to send downlinks
+        for (size_t g = 0; g < gateways.size(); g++) {
+            sendPull(g, started);
+        }
+        double rate = params.rate / params.threads;
+        auto finish = started + std::chrono::seconds(params.seconds);
+        uint64_t sent = 0;
+        while (true) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= finish)
+                break;
+            double elapsed = std::chrono::duration<double>(now - started).count();
+            auto due = (uint64_t) (elapsed * rate);
+            for (; sent < due; sent++) {
+                size_t d = deviceIndices[nextDevice++ % deviceIndices.size()];
+                sendUplink(devices[d], d, now);
+            }
+            for (size_t g = 0; g < gateways.size(); g++) {
+                if (gateways[g].nextPull <= now)
+                    sendPull(g, now);
+            }
+            expire(now, false);
+            // wait until next uplink is due
+            int waitMs = rate > 0 ? (int) (((double) (sent + 1) / rate - elapsed) * 1000) : 100;
+            receive(fds, std::max(0, std::min(waitMs, 100)));
+        }
+        // wait for the rest of ACKs and downlinks
+        auto drain = std::chrono::steady_clock::now()
+            + std::chrono::milliseconds(std::max(params.ackTimeoutMs, params.rx1DelayMs + 1000));
+        while (std::chrono::steady_clock::now() < drain) {
+            receive(fds, 10);
+        }
+        expire(std::chrono::steady_clock::now(), true);
+        for (auto d : deviceIndices) {
+            if (devices[d].confirmedPending)
+                stat.confirmedUnanswered++;
+        }
+    }
+};
+
+static uint32_t percentile(
+    const std::vector<uint32_t> &sorted,
+    double p
+)
+{
+    if (sorted.empty())
+        return 0;
+    size_t i = (size_t) (p * (double) (sorted.size() - 1));
+    return sorted[i];
+}
+
+static void printLatency(
+    std::ostream &strm,
+    const char *name,
+    std::vector<uint32_t> &value
+)
+{
+    std::sort(value.begin(), value.end());
+    strm << ", \"" << name << "\": {\"p50\": " << percentile(value, 0.5)
+        << ", \"p99\": " << percentile(value, 0.99)
+        << ", \"max\": " << (value.empty() ? 0 : value.back()) << "}";
+}
+
+/**
+ * Allow a socket per virtual gateway
+ */
+static void raiseFileLimit(
+    rlim_t count
+)
+{
+    struct rlimit l {};
+    if (getrlimit(RLIMIT_NOFILE, &l) || l.rlim_cur >= count)
+        return;
+    l.rlim_cur = std::min(count, l.rlim_max);
+    setrlimit(RLIMIT_NOFILE, &l);
+}
+
+static void generateDevices(
+    std::vector<VirtualDevice> &retVal
+)
+{
+    GenIdentityService identityService(params.masterKey);
+    retVal.resize(params.devices);
+    size_t otaaCount = (size_t) params.devices * params.otaaPercent / 100;
+    for (size_t i = 0; i < retVal.size(); i++) {
+        DEVADDR addr(params.firstAddr + (uint32_t) i);
+        DEVICEID id;
+        identityService.get(id, addr);
+        retVal[i].identity = NetworkIdentity(addr, id);
+        retVal[i].otaa = i < otaaCount;
+    }
+}
+
+static int run()
+{
+    struct sockaddr_storage destAddr {};
+    if (!string2sockaddr((struct sockaddr *) &destAddr, params.intf, params.port)) {
+        std::cerr << ERR_MESSAGE << ERR_CODE_ADDR_OUT_OF_RANGE << ": " << params.intf << std::endl;
+        return ERR_CODE_ADDR_OUT_OF_RANGE;
+    }
+    raiseFileLimit((rlim_t) params.gateways + 64);
+
+    std::vector<VirtualDevice> devices;
+    generateDevices(devices);
+    if (params.verbose)
+        std::cerr << params.devices << _(" devices generated") << std::endl;
+
+    std::vector<LoadWorker *> workers;
+    for (int t = 0; t < params.threads; t++) {
+        auto w = new LoadWorker((const struct sockaddr *) &destAddr, devices, t);
+        workers.push_back(w);
+        int r = w->open();
+        if (r) {
+            std::cerr << ERR_MESSAGE << r << ": " << strerror(errno) << std::endl;
+            for (auto it : workers) {
+                delete it;
+            }
+            return r;
+        }
+    }
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (auto w : workers) {
+        threads.emplace_back(&LoadWorker::run, w);
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    LoadStat stat;
+    for (auto w : workers) {
+        stat.add(w->stat);
+        delete w;
+    }
+    std::cout << "{\"gateways\": " << params.gateways
+        << ", \"devices\": " << params.devices
+        << ", \"threads\": " << params.threads
+        << ", \"duplicates\": " << params.duplicates
+        << ", \"seconds\": " << seconds
+        << ", \"uplinks\": " << stat.uplinks
+        << ", \"uplinksPerSecond\": " << (params.seconds > 0 ? (double) stat.uplinks / params.seconds : 0.0)
+        << ", \"confirmed\": " << stat.confirmed
+        << ", \"joinRequests\": " << stat.joinRequests
+        << ", \"pushData\": " << stat.pushData
+        << ", \"pushAck\": " << stat.pushAck
+        << ", \"pullData\": " << stat.pullData
+        << ", \"pullAck\": " << stat.pullAck
+        << ", \"ackLost\": " << stat.ackLost
+        << ", \"pullAckLost\": " << stat.pullAckLost
+        << ", \"downlinks\": " << stat.downlinks
+        << ", \"lateDownlinks\": " << stat.lateDownlinks
+        << ", \"tmstMismatch\": " << stat.tmstMismatch
+        << ", \"confirmedUnanswered\": " << stat.confirmedUnanswered
+        << ", \"joinAccepts\": " << stat.joinAccepts
+        << ", \"unexpected\": " << stat.unexpected
+        << ", \"sendErrors\": " << stat.sendErrors;
+    printLatency(std::cout, "pushAckLatency", stat.pushAckMicroseconds);
+    printLatency(std::cout, "pullAckLatency", stat.pullAckMicroseconds);
+    printLatency(std::cout, "downlinkLatency", stat.downlinkMicroseconds);
+    std::cout << "}" << std::endl;
+    // lost keepalive PULL_ACK is reported, only lost PUSH_ACK fails the run
+    return stat.ackLost || stat.sendErrors ? ERR_CODE_SOCKET_READ : CODE_OK;
+}
+
+int main(int argc, char **argv) {
+    struct arg_str *a_interface_n_port = arg_str0(nullptr, nullptr, _("<ipaddr:port>"), _("Network server. Default 127.0.0.1:4242"));
+    struct arg_int *a_gateways = arg_int0("g", "gateways", _("<number>"), _("virtual gateways. Default 100"));
+    struct arg_int *a_devices = arg_int0("d", "devices", _("<number>"), _("virtual devices. Default 10000"));
+    struct arg_int *a_otaa = arg_int0("o", "otaa", _("<percent>"), _("devices sending Join-request. Default 0"));
+    struct arg_int *a_confirmed = arg_int0("c", "confirmed", _("<percent>"), _("confirmed uplinks. Default 0"));
+    struct arg_dbl *a_rate = arg_dbl0("r", "rate", _("<number>"), _("uplinks per second. Default 1000"));
+    struct arg_int *a_seconds = arg_int0("n", "seconds", _("<number>"), _("send uplinks for n seconds. Default 10"));
+    struct arg_int *a_duplicates = arg_int0("u", "duplicates", _("<number>"), _("gateways receiving each uplink. Default 1"));
+    struct arg_int *a_payload_size = arg_int0("s", "size", _("<number>"), _("payload size 0..242. Default 16"));
+    struct arg_int *a_threads = arg_int0("t", "threads", _("<number>"), _("threads. Default 1"));
+    struct arg_str *a_first_addr = arg_str0("a", "address", _("<hex>"), _("first device address. Default 00000001"));
+    struct arg_str *a_first_gateway = arg_str0("e", "gateway", _("<hex>"), _("first gateway identifier. Default 00006cc300000000"));
+    struct arg_str *a_master_key = arg_str0("k", "key", _("<pass-phrase>"), _("GenIdentityService master key. Default empty"));
+    struct arg_int *a_pull_interval = arg_int0("p", "pull", _("<ms>"), _("PULL_DATA interval. Default 10000"));
+    struct arg_int *a_ack_timeout = arg_int0("w", "timeout", _("<ms>"), _("ACK timeout. Default 1000"));
+    struct arg_int *a_rx1_delay = arg_int0(nullptr, "rx1", _("<ms>"), _("RX1 delay, PULL_RESP deadline. Default 1000"));
+    struct arg_lit *a_verbose = arg_litn("v", "verbose", 0, 2, _("-v verbose -vv debug"));
+    struct arg_lit *a_help = arg_lit0("h", "help", _("Show this help"));
+    struct arg_end *a_end = arg_end(20);
+
+    void* argtable[] = {
+        a_interface_n_port, a_gateways, a_devices, a_otaa, a_confirmed, a_rate, a_seconds, a_duplicates,
+        a_payload_size, a_threads, a_first_addr, a_first_gateway, a_master_key,
+        a_pull_interval, a_ack_timeout, a_rx1_delay,
+        a_verbose, a_help, a_end
+    };
+
+    if (arg_nullcheck(argtable) != 0) {
+        arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+        return ERR_CODE_COMMAND_LINE;
+    }
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    if (a_interface_n_port->count) {
+        if (!splitAddress(params.intf, params.port, std::string(*a_interface_n_port->sval)))
+            nerrors++;
+    } else
+        params.intf = "127.0.0.1";
+    if (a_gateways->count)
+        params.gateways = std::max(1, *a_gateways->ival);
+    if (a_devices->count)
+        params.devices = std::max(1, *a_devices->ival);
+    if (a_otaa->count)
+        params.otaaPercent = std::min(100, std::max(0, *a_otaa->ival));
+    if (a_confirmed->count)
+        params.confirmedPercent = std::min(100, std::max(0, *a_confirmed->ival));
+    if (a_rate->count)
+        params.rate = std::max(0.0, *a_rate->dval);
+    if (a_seconds->count)
+        params.seconds = std::max(1, *a_seconds->ival);
+    if (a_duplicates->count)
+        params.duplicates = std::max(1, *a_duplicates->ival);
+    if (a_payload_size->count)
+        params.payloadSize = std::min(242, std::max(0, *a_payload_size->ival));
+    if (a_threads->count)
+        params.threads = std::max(1, *a_threads->ival);
+    if (a_first_addr->count)
+        params.firstAddr = (uint32_t) strtoul(*a_first_addr->sval, nullptr, 16);
+    if (a_first_gateway->count)
+        params.firstGatewayId = strtoull(*a_first_gateway->sval, nullptr, 16);
+    if (a_master_key->count)
+        params.masterKey = *a_master_key->sval;
+    if (a_pull_interval->count)
+        params.pullIntervalMs = std::max(100, *a_pull_interval->ival);
+    if (a_ack_timeout->count)
+        params.ackTimeoutMs = std::max(1, *a_ack_timeout->ival);
+    if (a_rx1_delay->count)
+        params.rx1DelayMs = std::max(1, *a_rx1_delay->ival);
+    params.verbose = a_verbose->count;
+    // each thread needs at least one gateway
+    params.threads = std::min(params.threads, params.gateways);
+
+    if ((a_help->count) || nerrors) {
+        if (nerrors)
+            arg_print_errors(stderr, a_end, programName);
+        std::cerr << _("Usage: ") << programName << std::endl;
+        arg_print_syntax(stderr, argtable, "\n");
+        std::cerr << _("Semtech UDP packet forwarder load generator") << std::endl;
+        arg_print_glossary(stderr, argtable, "  %-27s %s\n");
+        arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+        return ERR_CODE_COMMAND_LINE;
+    }
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return run();
+}
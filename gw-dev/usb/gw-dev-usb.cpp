@@ -13,7 +13,10 @@
 #include <execinfo.h>
 #include <algorithm>
 #include <sys/un.h>
+#include "lorawan/task/task-unix-socket.h"
 #include "lorawan/task/task-unix-control-socket.h"
+#include "usb-gateway-supervisor.h"
+#include "usb-gateway-worker.h"
 
 #define DEF_CONTROL_SOCKET_FILE_NAME_OR_ADDRESS_N_PORT "/tmp/control.socket"
 #endif
@@ -35,6 +38,7 @@
 #include "lorawan/bridge/stdout-bridge.h"
 #include "lorawan/storage/service/device-best-gateway-mem.h"
 #include "lorawan/downlink/downlink-by-timer.h"
+#include "lorawan/task/metrics-http-listener.h"
 #include "gen/regional-parameters-3.h"
 #include "gateway-settings-helper.h"
 
@@ -45,14 +49,23 @@
 
 const std::string programName = _("lorawan-gateway");
 static TaskSocket *taskUSBSocket = nullptr;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+static UsbGatewaySupervisor *supervisor = nullptr;
+static UsbGatewayWorker *usbWorker = nullptr;
+#endif
 
 class LocalGatewayConfiguration {
 public:
     std::vector <std::string> devicePaths;
+    std::string programPath;            ///< argv[0] to start worker processes
+    std::string regionName;
     std::string identityFileName;
     std::string gatewayFileName;
     std::string pluginFilePath;
     std::vector<std::string> bridgePluginFiles;
+    size_t bridgeQueueSize;     ///< 0- deliver payloads to bridges synchronously
+    std::vector<std::string> bridgeOptions;     ///< <bridge-name>:<option>[:<option2>]
 
     size_t regionIdx;
     const RegionalParameterChannelPlan *regionChannelPlan;
@@ -62,8 +75,14 @@ public:
     int verbosity;
     std::string pidfile;
     std::string controlSocketFileNameOrAddressAndPort;
+    std::string metricsAddressAndPort;  ///< empty- do not serve Prometheus metrics over HTTP
+    size_t traceSampleRate;             ///< 0- do not trace packet stages
+    bool pinCpu;                        ///< pin upstream thread of each concentrator to own CPU core
+    int workerSocket;                   ///< run as worker process, socket pair end. -1- not a worker
+    int workerCpu;                      ///< worker pins upstream thread to CPU core, -1- do not pin
     LocalGatewayConfiguration()
-        : regionIdx(0), regionChannelPlan(nullptr), enableSend(true), enableBeacon(false), daemonize(false), verbosity(0)
+        : bridgeQueueSize(0), traceSampleRate(0), regionIdx(0), regionChannelPlan(nullptr), enableSend(true), enableBeacon(false), daemonize(false), verbosity(0),
+          pinCpu(false), workerSocket(-1), workerCpu(-1)
     {
     }
 };
@@ -107,6 +126,11 @@ static StdErrLog errLog(&dispatcher);
 
 static void stop()
 {
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+    if (usbWorker)
+        usbWorker->stop();
+#endif
     dispatcher.stop();
 }
 
@@ -137,6 +161,8 @@ int parseCmd(
     struct arg_str *a_gateway_file_name = arg_str0("g", "gw", _("<gw-file-name>"), _("Gateways JSON file name"));
 
     struct arg_str *a_bridge_plugin = arg_strn("o", "output", _("<directory>"), 0, 64, _("Output plugins directory"));
+    struct arg_str *a_bridge_options = arg_strn("O", "output-option", _("<name>:<option>[:<option2>]"), 0, 64, _("Output plugin init options, e.g. file-json-app-bridge:payload.json:rotate-size=1000000,compress"));
+    struct arg_int *a_bridge_queue_size = arg_int0("q", "bridge-queue", _("<size>"), _("Deliver payloads to each output plugin in own thread, queue size. Default 0- no queue"));
 
     struct arg_lit *a_disable_send = arg_lit0("s", "disable-send", _("Disable send"));
     struct arg_lit *a_enable_beacon = arg_lit0("b", "allow-beacon", _("Allow send beacon"));
@@ -146,17 +172,30 @@ int parseCmd(
 #else
     struct arg_str *a_control_socket_file_name_or_address_n_port = arg_str0("U", "control", _("<file>"), _("Socket file name. Default " DEF_CONTROL_SOCKET_FILE_NAME_OR_ADDRESS_N_PORT));
 #endif
+    struct arg_str *a_metrics = arg_str0("m", "metrics", _("<address:port>"), _("Serve Prometheus metrics over HTTP e.g. 0.0.0.0:9100. Default none"));
+    struct arg_int *a_trace = arg_int0("t", "trace", _("<N>"), _("Trace packet stage latencies, keep every N-th trace. Default 0- no trace"));
     struct arg_str *a_pidfile = arg_str0("p", "pidfile", _("<file>"), _("Check whether a process has created the file pidfile"));
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+    struct arg_lit *a_pin_cpu = arg_lit0("a", "affinity", _("Pin upstream thread of each concentrator to own CPU core"));
+    struct arg_int *a_worker = arg_int0(nullptr, "worker", _("<socket>"), _("Internal: run one concentrator for the parent process"));
+    struct arg_int *a_worker_cpu = arg_int0(nullptr, "cpu", _("<core>"), _("Internal: pin worker upstream thread to CPU core"));
+#endif
     struct arg_lit *a_verbosity = arg_litn("v", "verbose", 0, 7, _("Verbosity level 1- alert, 2-critical error, 3- error, 4- warning, 5- siginicant info, 6- info, 7- debug"));
     struct arg_lit *a_help = arg_lit0("?", "help", _("Show this help"));
     struct arg_end *a_end = arg_end(20);
 
     void *argtable[] = {
             a_device_path, a_region_name, a_identity_plugin_file, a_identity_file_name, a_gateway_file_name,
-            a_bridge_plugin,
+            a_bridge_plugin, a_bridge_options, a_bridge_queue_size,
             a_disable_send, a_enable_beacon,
-            a_daemonize, a_control_socket_file_name_or_address_n_port,
-            a_pidfile, a_verbosity, a_help, a_end
+            a_daemonize, a_control_socket_file_name_or_address_n_port, a_metrics, a_trace,
+            a_pidfile,
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+            a_pin_cpu, a_worker, a_worker_cpu,
+#endif
+            a_verbosity, a_help, a_end
     };
 
     // verify the argtable[] entries were allocated successfully
@@ -169,6 +208,7 @@ int parseCmd(
 
     for (int i = 0; i < a_device_path->count; i++)
         config->devicePaths.push_back(a_device_path->sval[i]);
+    config->programPath = argv[0];
 
     // try load shared library
     if (a_identity_plugin_file->count > 0) {
@@ -194,8 +234,19 @@ int parseCmd(
 
     for (int i = 0; i < a_bridge_plugin->count; i++)
         config->bridgePluginFiles.emplace_back(a_bridge_plugin->sval[i]);
+    for (int i = 0; i < a_bridge_options->count; i++) {
+        std::string o(a_bridge_options->sval[i]);
+        if (o.find(':') == std::string::npos) {
+            nErrors++;
+            std::cerr << ERR_MESSAGE << ERR_CODE_PARAM_INVALID << ": " << o << std::endl;
+        } else
+            config->bridgeOptions.push_back(o);
+    }
+    if (a_bridge_queue_size->count && *a_bridge_queue_size->ival > 0)
+        config->bridgeQueueSize = (size_t) *a_bridge_queue_size->ival;
 
     if (a_region_name->count) {
+        config->regionName = *a_region_name->sval;
         config->regionIdx = findGatewayRegionIndex(lorawanGatewaySettings, *a_region_name->sval);
         config->regionChannelPlan = regionalParameterChannelPlanMem.get(*a_region_name->sval);
     } else {
@@ -216,8 +267,20 @@ int parseCmd(
         config->controlSocketFileNameOrAddressAndPort = *a_control_socket_file_name_or_address_n_port->sval;
     else
         config->controlSocketFileNameOrAddressAndPort = DEF_CONTROL_SOCKET_FILE_NAME_OR_ADDRESS_N_PORT;
+    if (a_metrics->count)
+        config->metricsAddressAndPort = *a_metrics->sval;
+    if (a_trace->count && *a_trace->ival > 0)
+        config->traceSampleRate = (size_t) *a_trace->ival;
 
     config->verbosity = a_verbosity->count;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+    config->pinCpu = a_pin_cpu->count > 0;
+    if (a_worker->count)
+        config->workerSocket = *a_worker->ival;
+    if (a_worker_cpu->count)
+        config->workerCpu = *a_worker_cpu->ival;
+#endif
 
     // special case: '--help' takes precedence over error reporting
     if ((a_help->count) || nErrors) {
@@ -263,6 +326,7 @@ void signalHandler(int signal)
 {
     switch (signal) {
         case SIGINT:
+        case SIGTERM:   // supervisor stops worker process
             std::cerr << MSG_INTERRUPTED << std::endl;
             stop();
             std::cerr << MSG_GRACEFULLY_STOPPED << std::endl;
@@ -280,6 +344,11 @@ void signalHandler(int signal)
         case SIGHUP:
             std::cerr << ERR_HANGUP_DETECTED << std::endl;
             break;
+        case SIGUSR1:	// 10
+            // per-concentrator measurements, printed by the supervising thread
+            if (supervisor)
+                supervisor->requestReport();
+            break;
         case SIGUSR2:	// 12
             std::cerr << MSG_SIG_FLUSH_FILES << std::endl;
             // flushFiles();
@@ -315,6 +384,8 @@ void setSignalHandler()
     sigaction(SIGHUP, &action, nullptr);
     sigaction(SIGSEGV, &action, nullptr);
     sigaction(SIGABRT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGUSR1, &action, nullptr);
     sigaction(SIGUSR2, &action, nullptr);
     sigaction(42, &action, nullptr);
 #endif
@@ -341,6 +412,17 @@ static void run()
         // add simple output bridge
         dispatcher.addAppBridge(new StdoutBridge);
     }
+    dispatcher.setBridgeDelivery(localConfig.bridgeQueueSize);
+    for (auto &o : localConfig.bridgeOptions) {
+        // <bridge-name>:<option>[:<option2>]
+        size_t p = o.find(':');
+        size_t p2 = o.find(':', p + 1);
+        if (p2 == std::string::npos)
+            dispatcher.setBridgeOptions(o.substr(0, p), o.substr(p + 1), "");
+        else
+            dispatcher.setBridgeOptions(o.substr(0, p), o.substr(p + 1, p2 - p - 1), o.substr(p2 + 1));
+    }
+    dispatcher.setTracing(localConfig.traceSampleRate);
 
     identityClient.svcIdentity->init(localConfig.identityFileName, nullptr);
     identityClient.svcGateway->init(localConfig.gatewayFileName, nullptr);
@@ -446,9 +528,13 @@ static void run()
                 getsockname(taskSocket->sock, &addr, &sz);
                 GatewayIdentity gwId(id, addr);
 #else
+                // gateway worker process socket has no name, use device path
+                auto usbSocket = dynamic_cast<TaskUsbGatewaySocket *>(taskSocket);
+                const std::string &name = usbSocket ? usbSocket->socketNameOrAddress
+                    : ((TaskUsbWorkerSocket *) taskSocket)->devicePath;
                 struct sockaddr_un addr { AF_UNIX };
-                auto len = ((TaskUsbGatewaySocket *)taskSocket)->socketNameOrAddress.size();
-                memmove(addr.sun_path, ((TaskUsbGatewaySocket *)taskSocket)->socketNameOrAddress.c_str(), len);
+                auto len = std::min(name.size(), sizeof(addr.sun_path) - 1);
+                memmove(addr.sun_path, name.c_str(), len);
                 addr.sun_path[len] = 0;
                 GatewayIdentity gwId(id, (struct sockaddr &) addr);
 #endif
@@ -464,10 +550,40 @@ static void run()
 
     dispatcher.regionalPlan = localConfig.regionChannelPlan;
 
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+    if (localConfig.devicePaths.size() > 1) {
+        // libloragw drives one concentrator per process, run each concentrator in the worker process
+        std::vector<std::string> args { "-c", localConfig.regionName };
+        if (!localConfig.enableSend)
+            args.emplace_back("-s");
+        if (localConfig.enableBeacon)
+            args.emplace_back("-b");
+        if (localConfig.verbosity)
+            args.push_back("-" + std::string(localConfig.verbosity, 'v'));
+        supervisor = new UsbGatewaySupervisor(localConfig.programPath, args);
+        int cpuCount = (int) std::thread::hardware_concurrency();
+        for (int i = 0; i < localConfig.devicePaths.size(); i++) {
+            int cpu = (localConfig.pinCpu && cpuCount > 0) ? i % cpuCount : -1;
+            taskUSBSocket = supervisor->add(localConfig.devicePaths[i], cpu);
+            if (!taskUSBSocket) {
+                std::cerr << ERR_MESSAGE << ERR_CODE_SOCKET_CREATE << ": " << ERR_SOCKET_CREATE
+                    << " " << localConfig.devicePaths[i] << std::endl;
+                return;
+            }
+            std::cout << MSG_GATEWAY << localConfig.devicePaths[i] << std::endl;
+            dispatcher.sockets.push_back(taskUSBSocket);
+        }
+        // control socket connects to the listening socket
+        dispatcher.sockets.push_back(new TaskUnixSocket(localConfig.controlSocketFileNameOrAddressAndPort.c_str()));
+    } else
+#endif
     for (int i = 0; i < localConfig.devicePaths.size(); i++) {
         GatewaySettings *settings = getGatewayConfig(&localConfig, i);
         taskUSBSocket = new TaskUsbGatewaySocket(&dispatcher, localConfig.controlSocketFileNameOrAddressAndPort,
             settings,&errLog, localConfig.enableSend, localConfig.enableBeacon, localConfig.verbosity);
+        if (localConfig.pinCpu)
+            ((TaskUsbGatewaySocket *) taskUSBSocket)->setUpstreamCpu(0);
         std::cout << MSG_GATEWAY << ((TaskUsbGatewaySocket*) taskUSBSocket)->socketNameOrAddress << std::endl;
         dispatcher.sockets.push_back(taskUSBSocket);
     }
@@ -490,10 +606,55 @@ static void run()
     DownlinkByTimer downlinkByTimer(&dispatcher, &identityClient, 10);
     downlinkByTimer.start();
 
+    MetricsHttpListener metricsListener(&dispatcher.metrics);
+    if (!localConfig.metricsAddressAndPort.empty()) {
+        int r = metricsListener.start(localConfig.metricsAddressAndPort);
+        if (r)
+            std::cerr << ERR_MESSAGE << r << ": " << strerror_lorawan_ns(r)
+                << " " << localConfig.metricsAddressAndPort << std::endl;
+    }
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+    if (supervisor)
+        supervisor->start();
+#endif
     // run() in main thread
     dispatcher.runUplink();
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+    if (supervisor) {
+        // dispatcher has closed worker sockets
+        supervisor->stop();
+        delete supervisor;
+        supervisor = nullptr;
+    }
+#endif
+}
 
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+/**
+ * Run one concentrator in the worker process started by UsbGatewaySupervisor
+ */
+static int runWorker()
+{
+    if (localConfig.devicePaths.empty())
+        return ERR_CODE_PARAM_INVALID;
+    UsbGatewayWorker worker(localConfig.workerSocket);
+    usbWorker = &worker;
+    setSignalHandler();
+    StdErrLog workerLog(nullptr);
+    int r = worker.run(getGatewayConfig(&localConfig, 0), &workerLog,
+        (localConfig.enableSend ? 0 : FLAG_GATEWAY_LISTENER_NO_SEND) | (localConfig.enableBeacon ? 0 : FLAG_GATEWAY_LISTENER_NO_BEACON),
+        localConfig.verbosity, localConfig.workerCpu);
+    usbWorker = nullptr;
+    if (r)
+        std::cerr << ERR_MESSAGE << r << ": " << strerror_lorawan_ns(r)
+            << " " << localConfig.devicePaths[0] << std::endl;
+    return r;
 }
+#endif
 
 int main(
 	int argc,
@@ -503,6 +664,11 @@ int main(
     int r = parseCmd(&localConfig, argc, argv);
     if (r)
         return r;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+    if (localConfig.workerSocket >= 0)
+        return runWorker();
+#endif
 #ifdef _MSC_VER
     WSADATA wsaData;
     r = WSAStartup(MAKEWORD(2, 2), &wsaData);
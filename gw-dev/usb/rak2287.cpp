@@ -105,6 +105,7 @@ const char *MEASUREMENT_SHORT_NAME[MEASUREMENT_COUNT_SIZE] = {
 #define ERR_LORA_GATEWAY_STATUS_FAILED                  "Getting gateway status failed"
 #define ERR_LORA_GATEWAY_EMIT_ALLREADY                  "Concentrator is currently emitting"
 #define ERR_LORA_GATEWAY_SCHEDULED_ALLREADY             "Downlink was already scheduled on, overwriting it"
+#define ERR_LORA_GATEWAY_UPSTREAM_AFFINITY              "Can not pin upstream thread to CPU "
 #define ERR_LORA_GATEWAY_SPECTRAL_SCAN_ABORT_FAILED     "Spectral scan abort failed"
 #define ERR_LORA_GATEWAY_SPECTRAL_SCAN_RESULT           "Spectral scan getUplink results failed"
 #define MSG_SPECTRAL_SCAN_FINISHED      "Spectral scan thread finished"
@@ -291,10 +292,26 @@ void GatewayMeasurements::get(
     mAccess.unlock();
 }
 
+void GatewayMeasurements::set(
+    const uint32_t values[MEASUREMENT_COUNT_SIZE]
+)
+{
+    mAccess.lock();
+    memcpy(value, values, sizeof(value));
+    mAccess.unlock();
+}
+
 std::string GatewayMeasurements::toString() const
 {
     uint32_t m[MEASUREMENT_COUNT_SIZE];
     get(m);
+    return toString(m);
+}
+
+std::string GatewayMeasurements::toString(
+    const uint32_t values[MEASUREMENT_COUNT_SIZE]
+)
+{
     std::stringstream ss;
     ss << "{";
     bool isFirst = true;
@@ -303,17 +320,53 @@ std::string GatewayMeasurements::toString() const
             isFirst = false;
         else
             ss << ", ";
-        ss << "\"" << getMeasurementName(i) << "\": " << m[i];
+        ss << "\"" << getMeasurementName(i) << "\": " << values[i];
     }
     ss << "}";
     return ss.str();
 }
 
+#define STD_LORA_PREAMBLE           8
+#define STD_FSK_PREAMBLE            5
+
 TxPacket::TxPacket()
 {
     memset(&pkt, 0, sizeof(struct lgw_pkt_tx_s));
 }
 
+size_t TxPacket::set(
+    const GwPullData &pullData,
+    const NetworkIdentity *networkIdentity
+)
+{
+    pkt.freq_hz = pullData.txMetadata.freq_hz;          // uint32_t center frequency of TX
+    pkt.tx_mode = pullData.txMetadata.tx_mode;          // uint8_t select on what event/time the TX is triggered
+    pkt.count_us = pullData.txMetadata.count_us;        // uint32_t timestamp or delay in microseconds for TX trigger
+    pkt.rf_chain = pullData.txMetadata.rf_chain;        // uint8_t through which RF chain will the packet be sent
+    pkt.rf_power = pullData.txMetadata.rf_power;        // int8_t TX power, in dBm
+    pkt.modulation = pullData.txMetadata.modulation;    // uint8_t modulation to use for the packet
+    pkt.freq_offset = 0;                                // int8_t frequency offset from Radio Tx frequency (CW mode)
+    pkt.bandwidth = pullData.txMetadata.bandwidth;      // uint8_t modulation bandwidth (LoRa only)
+    pkt.datarate = pullData.txMetadata.datarate;        // uint32_t TX datarate (baudrate for FSK, SF for LoRa)
+    pkt.coderate = pullData.txMetadata.coderate;        // uint8_t error-correcting code of the packet (LoRa only)
+    pkt.invert_pol = pullData.txMetadata.invert_pol;    // bool invert signal polarity, for orthogonal downlinks (LoRa only)
+    pkt.f_dev = pullData.txMetadata.f_dev;              // uint8_t frequency deviation, in kHz (FSK only)
+    pkt.preamble = pullData.txMetadata.preamble;        // uint16_t set the preamble length, 0 for default
+    // check minimum preamble size
+    if (pkt.modulation == MODULATION_LORA) {
+        if (pkt.preamble == 0)
+            pkt.preamble = STD_LORA_PREAMBLE;
+    } else {
+        if (pkt.preamble == 0)
+            pkt.preamble = STD_FSK_PREAMBLE;
+    }
+    pkt.no_crc = pullData.txMetadata.no_crc;            // bool if true, do not send a CRC in the packet
+    pkt.no_header = pullData.txMetadata.no_header;      // bool if true, enable implicit header mode (LoRa), fixed length (FSK)
+    pkt.size = pullData.txMetadata.size;                // uint16_t payload size in bytes
+    // uint8_t buffer containing the payload
+    return pullData.txData.toArray(pkt.payload, sizeof(pkt.payload), networkIdentity);
+}
+
 static const char *DEF_GPS_FAMILY = "ubx7";
 
 int LoraGatewayListener::setSystemTime(
@@ -732,12 +785,20 @@ void LoraGatewayListener::upstreamRunner()
             ref_ok = false;
         }
 
+        // gateway src address is unix domain name address because socket family is AF_UNIX
+        struct sockaddr srcAddr; // sockaddr_un
+        memset(&srcAddr, 0, sizeof(srcAddr));
+        if (socket) {
+            socklen_t sz = sizeof(srcAddr);  // sockaddr_un
+            // getsockname() anyway truncate address to ~14 bytes
+            getsockname(socket->sock, (struct sockaddr *) &srcAddr, &sz);
+        }
+
         // serialize Lora packets metadata and payload
-        int pkt_in_dgram = 0;
         for (int i = 0; i < nb_pkt; ++i) {
             p = &rxpkt[i];
             if (onReceiveRawData)
-                onReceiveRawData(dispatcher, (const char*) p, sizeof(struct lgw_pkt_rx_s), std::chrono::system_clock::now());
+                onReceiveRawData(dispatcher, (const char*) p, sizeof(struct lgw_pkt_rx_s), TASK_CLOCK::now());
             // basic metadata filtering
             measurements.inc(meas_nb_rx_rcv);
             switch(p->status) {
@@ -900,33 +961,15 @@ void LoraGatewayListener::upstreamRunner()
                 continue;
             }
 
-            // payload = std::string((char *)p->payload, p->size);
-            pkt_in_dgram++;
-        }
+            // send each packet to the network server
+            if (onPushData)
+                onPushData(dispatcher, socket, (sockaddr &) srcAddr, metadata, p->payload, p->size);
 
-        // restart fetch sequence without empty call if all packets have been filtered out
-        if (pkt_in_dgram == 0)
-            continue;
-        // send to the network server, network server must call onValue
-        /*
-        MessageQueueItem mqi;
-        mqi.metadata[metadata.gatewayId] = metadata;
-        setLORAWAN_MESSAGE_STORAGE(mqi.radioPacket, payload);
-         */
-        // gateway src address is unix domain name address because socket family is AF_UNIX
-        struct sockaddr srcAddr; // sockaddr_un
-        if (socket) {
-            socklen_t sz = sizeof(srcAddr);  // sockaddr_un
-            // getsockname() anyway truncate address to ~14 bytes
-            getsockname(socket->sock, (struct sockaddr *) &srcAddr, &sz);
+            measurements.inc(meas_up_dgram_sent);
+            measurements.inc(meas_up_network_byte, p->size);    // no network traffic, return size of payload
+            // do not wait for ACK, let say it received
+            measurements.inc(meas_up_ack_rcv);
         }
-        if (onPushData)
-            onPushData(dispatcher, socket, (sockaddr &) srcAddr, metadata, p->payload, p->size);
-
-        measurements.inc(meas_up_dgram_sent);
-        measurements.inc(meas_up_network_byte, p->size);    // no network traffic, return size of payload
-        // do not wait for ACK, let say it received
-        measurements.inc(meas_up_ack_rcv);
     }
     upstreamThreadRunning = false;
     if (threadStartFinish)
@@ -936,9 +979,6 @@ void LoraGatewayListener::upstreamRunner()
 #define PROTOCOL_VERSION            2           // v1.6
 #define MIN_LORA_PREAMBLE_LEN       6           // minimum Lora preamble length
 #define MIN_FSK_PREAMBBLE_LEN       3           // minimum FSK preamble length
-#define STD_LORA_PREAMBLE           8
-#define STD_FSK_PREAMBLE            5
-
 static uint16_t crc16(
     const uint8_t *data,
     size_t size
@@ -1548,12 +1588,12 @@ void LoraGatewayListener::jitRunner() {
 }
 
 LoraGatewayListener::LoraGatewayListener()
-    : logVerbosity(0), dispatcher(nullptr), parser(nullptr),
+    : logVerbosity(0), dispatcher(nullptr), parser(nullptr), onReceiveRawData(nullptr),
     onPushData(nullptr), onPullResp(nullptr), onTxPkAck(nullptr),
     onSpectralScan(nullptr), onLog(nullptr), stopRequest(false),
     upstreamThreadRunning(false), downstreamBeaconThreadRunning(false), jitThreadRunning(false),
     gpsThreadRunning(false), gpsCheckTimeThreadRunning(false), spectralScanThreadRunning(false),
-    gps_ref_valid(false), lastLgwCode(0), config(nullptr), flags(0), fdGpsTty(-1), eui(0),
+    gps_ref_valid(false), lastLgwCode(0), config(nullptr), flags(0), upstreamCpu(-1), fdGpsTty(-1), eui(0),
     gpsCoordsLastSynced(0), gpsTimeLastSynced(0), gpsEnabled(false),
     xtal_correct_ok(false), xtal_correct(1.0),
     threadStartFinish(nullptr), socket(nullptr)
@@ -1572,6 +1612,8 @@ LoraGatewayListener::~LoraGatewayListener()
         helperOpenClose = nullptr;
     }
 #endif
+    jit_queue_free(&jit_queue[0]);
+    jit_queue_free(&jit_queue[1]);
 }
 
 void LoraGatewayListener::setLogVerbosity(
@@ -1693,6 +1735,8 @@ int LoraGatewayListener::start()
         upstreamThreadRunning = true;
         std::thread upstreamThread(&LoraGatewayListener::upstreamRunner, this);
         setThreadName(&upstreamThread, MODULE_NAME_GW_UPSTREAM);
+        if (upstreamCpu >= 0 && !setThreadAffinity(&upstreamThread, upstreamCpu))
+            log(LOG_WARNING, ERR_CODE_PARAM_INVALID, ERR_LORA_GATEWAY_UPSTREAM_AFFINITY + std::to_string(upstreamCpu));
         upstreamThread.detach();
     }
 
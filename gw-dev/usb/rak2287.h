@@ -70,7 +70,10 @@ typedef enum {
 
 const char *getMeasurementName(int index);
 
-// measurements to establish statistics
+/**
+ * Measurements to establish statistics.
+ * Values are guarded by the mutex, one thread can set them while other thread reads a copy by get()
+ */
 class GatewayMeasurements {
 private:
     uint32_t value[MEASUREMENT_COUNT_SIZE];
@@ -84,7 +87,11 @@ public:
     void inc(MEASUREMENT_ENUM index);
     void inc(MEASUREMENT_ENUM index, uint32_t v);
     void get(uint32_t retval[MEASUREMENT_COUNT_SIZE]) const;
+    // copy all values e.g. received from the gateway worker process
+    void set(const uint32_t values[MEASUREMENT_COUNT_SIZE]);
     std::string toString() const;
+    // JSON object of the values copied by get()
+    static std::string toString(const uint32_t values[MEASUREMENT_COUNT_SIZE]);
 };
 
 class LGWStatus {
@@ -98,6 +105,16 @@ class TxPacket {
 public:
     struct lgw_pkt_tx_s pkt;
     TxPacket();
+    /**
+     * Set packet from PULL_RESP parsed by the gateway protocol parser
+     * @param pullData parsed PULL_RESP
+     * @param networkIdentity device identity to encode payload
+     * @return payload size
+     */
+    size_t set(
+        const GwPullData &pullData,
+        const NetworkIdentity *networkIdentity
+    );
 };
 
 /**
@@ -180,6 +197,7 @@ public:
     int lastLgwCode;
     GatewaySettings *config;
     int flags;
+    int upstreamCpu;     ///< CPU core the upstream thread is pinned to, -1- do not pin
     GatewayMeasurements measurements;
 
     int fdGpsTty;        ///< file descriptor of the GPS TTY port
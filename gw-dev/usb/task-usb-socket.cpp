@@ -14,9 +14,6 @@
 #include "lorawan/lorawan-msg.h"
 #include "lorawan/lorawan-string.h"
 
-#define STD_LORA_PREAMBLE 8
-#define STD_FSK_PREAMBLE  5
-
 static void onPushData(
     MessageTaskDispatcher* dispatcher,
     const TaskSocket *taskSocket,
@@ -26,11 +23,17 @@ static void onPushData(
     size_t size
 )
 {
+    PacketTrace trace;
+    if (dispatcher->isTracing())
+        trace.mark(TRACE_STAGE_RECEIVED);
     GwPushData pd;
     setLORAWAN_MESSAGE_STORAGE(pd.rxData, radioPacket, size);
     pd.rxMetadata = metadata;
     ProtoGwParser *p = dispatcher->parsers.size() ? dispatcher->parsers[0] : nullptr;
-    dispatcher->pushData(taskSocket, sockAddr, pd, std::chrono::system_clock::now(), p);
+    if (dispatcher->isTracing())
+        trace.mark(TRACE_STAGE_PARSED);
+    dispatcher->pushData(taskSocket, sockAddr, pd, TASK_CLOCK::now(), p,
+        dispatcher->isTracing() ? &trace : nullptr);
 }
 
 static bool onReceiveRawData(
@@ -185,6 +188,13 @@ void TaskUsbGatewaySocket::closeSocket()
 #endif
 }
 
+void TaskUsbGatewaySocket::setUpstreamCpu(
+    int cpu
+)
+{
+    listener.upstreamCpu = cpu;
+}
+
 // virtual int onData(const char *buffer, size_t size) = 0;
 TaskUsbGatewaySocket::~TaskUsbGatewaySocket()
 {
@@ -201,41 +211,17 @@ void TaskUsbGatewaySocket::customWriteSocket(
     std::cerr << "TaskUsbGatewaySocket::customWriteSocket " << hexString(data, size) << std::endl;
     std::cerr << "TaskUsbGatewaySocket::customWriteSocket " << std::string((const char *) data + 12, size - 12) << std::endl;
     ParseResult pr;
-    TASK_TIME receivedTime = std::chrono::system_clock::now();
+    TASK_TIME receivedTime = TASK_CLOCK::now();
     proto->parse(pr, (const char *) data, size, receivedTime);
 
     TxPacket tx;
-    tx.pkt.freq_hz = pr.gwPullData.txMetadata.freq_hz;          // uint32_t center frequency of TX
-    tx.pkt.tx_mode = pr.gwPullData.txMetadata.tx_mode;          // uint8_t select on what event/time the TX is triggered
-    tx.pkt.count_us = pr.gwPullData.txMetadata.count_us;        // uint32_t timestamp or delay in microseconds for TX trigger
-    tx.pkt.rf_chain = pr.gwPullData.txMetadata.rf_chain;        // uint8_t through which RF chain will the packet be sent
-    tx.pkt.rf_power = pr.gwPullData.txMetadata.rf_power;        // int8_t TX power, in dBm
-    tx.pkt.modulation = pr.gwPullData.txMetadata.modulation;    // uint8_t modulation to use for the packet
-    tx.pkt.freq_offset = 0;                                     // int8_t frequency offset from Radio Tx frequency (CW mode)
-    tx.pkt.bandwidth = pr.gwPullData.txMetadata.bandwidth;      // uint8_t modulation bandwidth (LoRa only)
-    tx.pkt.datarate = pr.gwPullData.txMetadata.datarate;        // uint32_t TX datarate (baudrate for FSK, SF for LoRa)
-    tx.pkt.coderate = pr.gwPullData.txMetadata.coderate;        // uint8_t error-correcting code of the packet (LoRa only)
-    tx.pkt.invert_pol = pr.gwPullData.txMetadata.invert_pol;    // bool invert signal polarity, for orthogonal downlinks (LoRa only)
-    tx.pkt.f_dev = pr.gwPullData.txMetadata.f_dev;              // uint8_t frequency deviation, in kHz (FSK only)
-    tx.pkt.preamble = pr.gwPullData.txMetadata.preamble;        // uint16_t set the preamble length, 0 for default
-    // check minimum preamble size
-    if (tx.pkt.modulation == MODULATION_LORA) {
-        if (tx.pkt.preamble == 0)
-            tx.pkt.preamble = STD_LORA_PREAMBLE;
-    } else {
-        if (tx.pkt.preamble == 0)
-            tx.pkt.preamble = STD_FSK_PREAMBLE;
-    }
-    tx.pkt.no_crc = pr.gwPullData.txMetadata.no_crc;            // bool if true, do not send a CRC in the packet
-    tx.pkt.no_header = pr.gwPullData.txMetadata.no_header;      // bool if true, enable implicit header mode (LoRa), fixed length (FSK)
-    tx.pkt.size = pr.gwPullData.txMetadata.size;                // uint16_t payload size in bytes
+    size_t sz = tx.set(pr.gwPullData, networkIdentity);
     std::cerr << "RAK2287 enqueueTxPacket size "
         << (int) tx.pkt.size << " payload size " << (int) pr.gwPullData.txData.payloadSize << " header size "
         << (int) (tx.pkt.size - pr.gwPullData.txData.payloadSize)
         << "\nmetadata: " << SEMTECH_PROTOCOL_METADATA_TX2string(pr.gwPullData.txMetadata)
         << "\ntxData: " << pr.gwPullData.txData.toString()
         << std::endl;
-    size_t sz = pr.gwPullData.txData.toArray(tx.pkt.payload, sizeof(tx.pkt.payload), networkIdentity);      // uint8_t buffer containing the payload
     std::cerr << "payload: " << hexString(tx.pkt.payload, sz) << " size " << sz << std::endl;
     listener.enqueueTxPacket(tx);
 }
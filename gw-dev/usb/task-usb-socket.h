@@ -34,6 +34,13 @@ public:
         size_t size,
         ProtoGwParser *proto
     ) override;
+    /**
+     * Pin upstream thread to the CPU core, call before dispatcher opens socket
+     * @param cpu CPU core, -1- do not pin
+     */
+    void setUpstreamCpu(
+        int cpu
+    );
     ~TaskUsbGatewaySocket() override;
 };
 
@@ -0,0 +1,116 @@
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "task-usb-worker-socket.h"
+#include "lorawan/lorawan-error.h"
+
+#define INVALID_SOCKET  (-1)
+
+// read no more records at once to let dispatcher serve other sockets
+#define MAX_RECORDS_PER_READ    64
+
+TaskUsbWorkerSocket::TaskUsbWorkerSocket(
+    SOCKET socket,
+    const std::string &aDevicePath
+)
+    : TaskSocket(socket, SA_CUSTOM_READ), buffer {}, devicePath(aDevicePath), eui(0), uplinks(0), downlinks(0),
+      errors(0)
+{
+    // downlinks are sent by customWriteSocket()
+    customWrite = true;
+}
+
+SOCKET TaskUsbWorkerSocket::openSocket()
+{
+    // socket pair is created by the supervisor
+    if (sock == INVALID_SOCKET)
+        lastError = ERR_CODE_SOCKET_OPEN;
+    return sock;
+}
+
+void TaskUsbWorkerSocket::closeSocket()
+{
+    if (sock != INVALID_SOCKET) {
+        close(sock);
+        sock = INVALID_SOCKET;
+    }
+}
+
+TaskUsbWorkerSocket::~TaskUsbWorkerSocket()
+{
+    closeSocket();
+}
+
+ssize_t TaskUsbWorkerSocket::customReadSocket(
+    MessageTaskDispatcher *dispatcher,
+    const TASK_TIME &receivedTime
+)
+{
+    struct sockaddr addr {};
+    addr.sa_family = AF_UNIX;
+    UsbWorkerRecord r;
+    ssize_t c = 0;
+    for (; c < MAX_RECORDS_PER_READ; c++) {
+        ssize_t sz = recv(sock, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (sz < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return sz;
+        }
+        if (r.parse(buffer, (size_t) sz) != CODE_OK) {
+            errors++;
+            continue;
+        }
+        switch (r.type) {
+            case UWR_HELLO:
+                eui = r.eui;
+                dispatcher->gatewayPing(r.eui, this);
+                break;
+            case UWR_UPLINK: {
+                uplinks++;
+                PacketTrace trace;
+                if (dispatcher->isTracing())
+                    trace.mark(TRACE_STAGE_RECEIVED);
+                if (dispatcher->onReceiveRawData
+                    && !dispatcher->onReceiveRawData(dispatcher, r.payload, r.payloadSize, receivedTime))
+                    break;
+                GwPushData pd;
+                setLORAWAN_MESSAGE_STORAGE(pd.rxData, (void *) r.payload, r.payloadSize);
+                pd.rxMetadata = r.metadata;
+                ProtoGwParser *p = dispatcher->parsers.empty() ? nullptr : dispatcher->parsers[0];
+                if (dispatcher->isTracing())
+                    trace.mark(TRACE_STAGE_PARSED);
+                dispatcher->pushData(this, addr, pd, receivedTime, p, dispatcher->isTracing() ? &trace : nullptr);
+                break;
+            }
+            case UWR_MEASUREMENTS:
+                measurements.set(r.measurements);
+                break;
+            default:
+                errors++;
+                break;
+        }
+    }
+    return c;
+}
+
+void TaskUsbWorkerSocket::customWriteSocket(
+    const NetworkIdentity *networkIdentity,
+    const void* data,
+    size_t size,
+    ProtoGwParser *proto
+)
+{
+    ParseResult pr;
+    if (!proto || proto->parse(pr, (const char *) data, size, TASK_CLOCK::now()) != CODE_OK) {
+        errors++;
+        return;
+    }
+    TxPacket tx;
+    tx.set(pr.gwPullData, networkIdentity);
+    if (sendUsbWorkerTx(sock, eui, tx.pkt) < 0)
+        errors++;
+    else
+        downlinks++;
+}
@@ -0,0 +1,57 @@
+#ifndef TASK_USB_WORKER_SOCKET_H_
+#define TASK_USB_WORKER_SOCKET_H_ 1
+
+#include <atomic>
+#include <string>
+
+#include "lorawan/task/task-socket.h"
+#include "usb-worker-link.h"
+
+/**
+ * Dispatcher end of the socket pair connected to the gateway worker process.
+ * Worker process runs one concentrator and sends received radio packets (see usb-worker-link.h),
+ * dispatcher reads them in the uplink loop and sends downlinks back to the worker.
+ * Socket pair outlives worker process, supervisor restarts worker with the same socket.
+ * @see UsbGatewaySupervisor
+ */
+class TaskUsbWorkerSocket : public TaskSocket {
+private:
+    char buffer[USB_WORKER_RECORD_MAX_SIZE];
+public:
+    std::string devicePath;             ///< worker concentrator device e.g. /dev/ttyACM0
+    std::atomic<uint64_t> eui;          ///< concentrator EUI, 0- worker has not started concentrator yet
+    std::atomic<size_t> uplinks;        ///< received radio packets
+    std::atomic<size_t> downlinks;      ///< packets passed to the worker
+    std::atomic<size_t> errors;         ///< invalid records and downlinks failed to pass to the worker
+    GatewayMeasurements measurements;   ///< last concentrator counters reported by the worker, set and read under own mutex
+    /**
+     * @param socket dispatcher end of the SOCK_SEQPACKET socket pair
+     * @param devicePath concentrator device
+     */
+    TaskUsbWorkerSocket(
+        SOCKET socket,
+        const std::string &devicePath
+    );
+    SOCKET openSocket() override;
+    void closeSocket() override;
+    /**
+     * Read all available records, pass radio packets to the dispatcher
+     * @return count of records read
+     */
+    ssize_t customReadSocket(
+        MessageTaskDispatcher *dispatcher,
+        const TASK_TIME &receivedTime
+    ) override;
+    /**
+     * Convert PULL_RESP to the concentrator packet and pass it to the worker
+     */
+    void customWriteSocket(
+        const NetworkIdentity *networkIdentity,
+        const void* data,
+        size_t size,
+        ProtoGwParser *proto
+    ) override;
+    ~TaskUsbWorkerSocket() override;
+};
+
+#endif
@@ -0,0 +1,204 @@
+#include <csignal>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "usb-gateway-supervisor.h"
+#include "lorawan/lorawan-error.h"
+#include "lorawan/lorawan-string.h"
+
+#define DEF_MAX_RESTART_DELAY_SECONDS   30
+// worker running longer is restarted without delay
+#define STABLE_RUN_SECONDS              60
+#define SUPERVISE_INTERVAL_MS           200
+// absorb radio packet bursts while dispatcher is busy
+#define WORKER_SOCKET_BUFFER_SIZE       (1024 * 1024)
+
+UsbGatewayWorkerProcess::UsbGatewayWorkerProcess()
+    : cpu(-1), socket(nullptr), workerSocket(-1), pid(0), restarts(0), restartDelaySeconds(1)
+{
+}
+
+UsbGatewaySupervisor::UsbGatewaySupervisor(
+    const std::string &aProgram,
+    const std::vector<std::string> &aArgs
+)
+    : program(aProgram), args(aArgs), stopRequest(false), reportRequest(0), thread(nullptr),
+      maxRestartDelaySeconds(DEF_MAX_RESTART_DELAY_SECONDS)
+{
+}
+
+UsbGatewaySupervisor::~UsbGatewaySupervisor()
+{
+    stop();
+}
+
+TaskUsbWorkerSocket *UsbGatewaySupervisor::add(
+    const std::string &devicePath,
+    int cpu
+)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds))
+        return nullptr;
+    // do not pass sockets to other workers
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    int sz = WORKER_SOCKET_BUFFER_SIZE;
+    setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz));
+    UsbGatewayWorkerProcess w;
+    w.devicePath = devicePath;
+    w.cpu = cpu;
+    w.socket = new TaskUsbWorkerSocket(fds[0], devicePath);
+    w.workerSocket = fds[1];
+    workers.push_back(w);
+    return w.socket;
+}
+
+int UsbGatewaySupervisor::spawn(
+    UsbGatewayWorkerProcess &worker
+)
+{
+    std::vector<std::string> a;
+    a.push_back(program);
+    a.insert(a.end(), args.begin(), args.end());
+    a.push_back(worker.devicePath);
+    a.emplace_back("--worker");
+    a.push_back(std::to_string(worker.workerSocket));
+    if (worker.cpu >= 0) {
+        a.emplace_back("--cpu");
+        a.push_back(std::to_string(worker.cpu));
+    }
+    // prepare arguments before fork(), child calls async-signal-safe functions only
+    std::vector<char *> argv;
+    for (auto &s : a)
+        argv.push_back((char *) s.c_str());
+    argv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0)
+        return ERR_CODE_SOCKET_CREATE;
+    if (pid == 0) {
+        fcntl(worker.workerSocket, F_SETFD, 0);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    worker.pid = pid;
+    worker.started = std::chrono::steady_clock::now();
+    return CODE_OK;
+}
+
+int UsbGatewaySupervisor::start()
+{
+    std::lock_guard<std::mutex> lock(mutexWorkers);
+    int r = CODE_OK;
+    for (auto &w : workers) {
+        if (w.pid)
+            continue;
+        int sr = spawn(w);
+        if (sr) {
+            r = sr;
+            w.restartTime = std::chrono::steady_clock::now() + std::chrono::seconds(w.restartDelaySeconds);
+        }
+    }
+    stopRequest = false;
+    if (!thread)
+        thread = new std::thread(&UsbGatewaySupervisor::supervise, this);
+    return r;
+}
+
+void UsbGatewaySupervisor::supervise()
+{
+    while (!stopRequest) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(SUPERVISE_INTERVAL_MS));
+        if (reportRequest) {
+            reportRequest = 0;
+            std::cout << toJsonString() << std::endl;
+        }
+        std::lock_guard<std::mutex> lock(mutexWorkers);
+        auto t = std::chrono::steady_clock::now();
+        for (auto &w : workers) {
+            if (w.pid) {
+                int status;
+                if (waitpid(w.pid, &status, WNOHANG) != w.pid)
+                    continue;
+                // worker exited, restart it later
+                w.pid = 0;
+                if (t - w.started > std::chrono::seconds(STABLE_RUN_SECONDS))
+                    w.restartDelaySeconds = 1;
+                w.restartTime = t + std::chrono::seconds(w.restartDelaySeconds);
+                w.restartDelaySeconds *= 2;
+                if (w.restartDelaySeconds > maxRestartDelaySeconds)
+                    w.restartDelaySeconds = maxRestartDelaySeconds;
+                continue;
+            }
+            if (t >= w.restartTime && spawn(w) == CODE_OK)
+                w.restarts++;
+        }
+    }
+}
+
+void UsbGatewaySupervisor::stop()
+{
+    stopRequest = true;
+    if (thread) {
+        thread->join();
+        delete thread;
+        thread = nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutexWorkers);
+    for (auto &w : workers) {
+        if (w.pid)
+            kill(w.pid, SIGTERM);
+    }
+    for (auto &w : workers) {
+        if (w.pid) {
+            int status;
+            waitpid(w.pid, &status, 0);
+            w.pid = 0;
+        }
+        if (w.workerSocket >= 0) {
+            close(w.workerSocket);
+            w.workerSocket = -1;
+        }
+    }
+}
+
+void UsbGatewaySupervisor::requestReport()
+{
+    reportRequest = 1;
+}
+
+std::string UsbGatewaySupervisor::toJsonString() const
+{
+    std::lock_guard<std::mutex> lock(mutexWorkers);
+    std::stringstream ss;
+    ss << "[";
+    bool isFirst = true;
+    for (auto &w : workers) {
+        if (isFirst)
+            isFirst = false;
+        else
+            ss << ", ";
+        ss << "{\"device\": \"" << w.devicePath
+           << "\", \"pid\": " << w.pid
+           << ", \"restarts\": " << w.restarts
+           << ", \"cpu\": " << w.cpu;
+        if (w.socket) {
+            // dispatcher thread updates measurements, copy them under the measurements mutex
+            uint32_t measurements[MEASUREMENT_COUNT_SIZE];
+            w.socket->measurements.get(measurements);
+            ss << ", \"gwId\": \"" << gatewayId2str(w.socket->eui) << "\""
+               << ", \"uplinks\": " << w.socket->uplinks
+               << ", \"downlinks\": " << w.socket->downlinks
+               << ", \"errors\": " << w.socket->errors
+               << ", \"measurements\": " << GatewayMeasurements::toString(measurements);
+        }
+        ss << "}";
+    }
+    ss << "]";
+    return ss.str();
+}
@@ -0,0 +1,97 @@
+#ifndef USB_GATEWAY_SUPERVISOR_H_
+#define USB_GATEWAY_SUPERVISOR_H_ 1
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+#include "task-usb-worker-socket.h"
+
+/**
+ * Gateway worker process and socket pair connecting it to the dispatcher
+ */
+class UsbGatewayWorkerProcess {
+public:
+    std::string devicePath;         ///< concentrator device e.g. /dev/ttyACM0
+    int cpu;                        ///< CPU core to pin worker upstream thread to, -1- do not pin
+    TaskUsbWorkerSocket *socket;    ///< dispatcher end of the socket pair, owned by the dispatcher
+    SOCKET workerSocket;            ///< worker end of the socket pair, passed to each started worker
+    pid_t pid;                      ///< 0- worker is not running
+    size_t restarts;                ///< how many times worker has been restarted
+    int restartDelaySeconds;        ///< delay before next restart, doubled on each restart
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point restartTime;
+    UsbGatewayWorkerProcess();
+};
+
+/**
+ * Run each concentrator in own worker process (gw-dev-usb started with --worker option) and
+ * restart worker if it exits unexpectedly. Socket pair is created once, so dispatcher socket
+ * stays the same after worker restart.
+ *
+ * UsbGatewaySupervisor supervisor(argv[0], { "-c", "EU863" });
+ * dispatcher.sockets.push_back(supervisor.add("/dev/ttyACM0", 1));
+ * dispatcher.sockets.push_back(supervisor.add("/dev/ttyACM1", 2));
+ * supervisor.start();
+ * dispatcher.runUplink();
+ * supervisor.stop();
+ */
+class UsbGatewaySupervisor {
+private:
+    std::string program;
+    std::vector<std::string> args;
+    std::atomic<bool> stopRequest;
+    volatile sig_atomic_t reportRequest;
+    std::thread *thread;
+    mutable std::mutex mutexWorkers;
+    int spawn(
+        UsbGatewayWorkerProcess &worker
+    );
+    void supervise();
+public:
+    std::vector<UsbGatewayWorkerProcess> workers;
+    int maxRestartDelaySeconds;     ///< maximum delay before restart
+    /**
+     * @param program program file path, gw-dev-usb itself
+     * @param args arguments passed to each worker before device path
+     */
+    UsbGatewaySupervisor(
+        const std::string &program,
+        const std::vector<std::string> &args
+    );
+    /**
+     * Create socket pair for the concentrator. Call before start()
+     * @param devicePath concentrator device
+     * @param cpu CPU core to pin worker upstream thread to, -1- do not pin
+     * @return dispatcher socket, nullptr if socket pair has not been created
+     */
+    TaskUsbWorkerSocket *add(
+        const std::string &devicePath,
+        int cpu
+    );
+    /**
+     * Start workers and supervising thread
+     * @return CODE_OK- success, ERR_CODE_SOCKET_CREATE- worker has not been started
+     */
+    int start();
+    /**
+     * Stop supervising thread, send SIGTERM to workers and wait until they exit
+     */
+    void stop();
+    /**
+     * Workers and last measurements reported by concentrators. Call while dispatcher is running
+     */
+    std::string toJsonString() const;
+    /**
+     * Ask supervising thread to print toJsonString() to the stdout. Safe to call from the signal handler
+     */
+    void requestReport();
+    virtual ~UsbGatewaySupervisor();
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "usb-gateway-worker.h"
+#include "usb-worker-link.h"
+#include "lorawan/lorawan-error.h"
+
+#define DEF_MEASUREMENTS_INTERVAL_MS    10000
+#define POLL_INTERVAL_MS                200
+
+static void onPushData(
+    MessageTaskDispatcher* dispatcher,
+    const TaskSocket *taskSocket,
+    const sockaddr &sockAddr,
+    SEMTECH_PROTOCOL_METADATA_RX metadata,
+    void *radioPacket,
+    size_t size
+)
+{
+    auto w = (UsbGatewayWorker *) taskSocket;
+    // all concentrators share the same regional settings, concentrator EUI identifies gateway
+    metadata.gatewayId = w->listener.eui;
+    if (sendUsbWorkerUplink(w->sock, w->listener.eui, metadata, radioPacket, size) < 0)
+        w->dropped++;
+    else
+        w->uplinks++;
+}
+
+UsbGatewayWorker::UsbGatewayWorker(
+    SOCKET socket
+)
+    : TaskSocket(socket, SA_NONE), stopRequest(false), uplinks(0), dropped(0),
+      measurementsIntervalMs(DEF_MEASUREMENTS_INTERVAL_MS)
+{
+    listener.socket = this;
+}
+
+SOCKET UsbGatewayWorker::openSocket()
+{
+    return sock;
+}
+
+void UsbGatewayWorker::closeSocket()
+{
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+}
+
+UsbGatewayWorker::~UsbGatewayWorker()
+{
+    closeSocket();
+}
+
+int UsbGatewayWorker::run(
+    GatewaySettings *settings,
+    Log *log,
+    int flags,
+    int verbosity,
+    int cpu
+)
+{
+    listener.init(settings, log);
+    listener.flags = flags;
+    listener.upstreamCpu = cpu;
+    listener.setLogVerbosity(log ? verbosity : 0);
+    listener.setOnPushData(onPushData);
+    int r = listener.start();
+    if (r)
+        return r;
+    sendUsbWorkerHello(sock, listener.eui);
+
+    UsbWorkerRecord rec;
+    char buffer[USB_WORKER_RECORD_MAX_SIZE];
+    uint32_t m[MEASUREMENT_COUNT_SIZE];
+    auto measured = std::chrono::steady_clock::now();
+    while (!stopRequest) {
+        struct pollfd pfd { sock, POLLIN, 0 };
+        int p = poll(&pfd, 1, POLL_INTERVAL_MS);
+        if (p < 0 && errno != EINTR)
+            break;
+        auto t = std::chrono::steady_clock::now();
+        if (t - measured >= std::chrono::milliseconds(measurementsIntervalMs)) {
+            measured = t;
+            listener.measurements.get(m);
+            sendUsbWorkerMeasurements(sock, listener.eui, m);
+        }
+        if (p <= 0)
+            continue;
+        ssize_t sz = recv(sock, buffer, sizeof(buffer), 0);
+        if (sz <= 0)
+            break;  // gw-dev-usb process has finished
+        if (rec.parse(buffer, (size_t) sz) != CODE_OK || rec.type != UWR_TX)
+            continue;
+        TxPacket tx;
+        tx.pkt = rec.tx;
+        listener.enqueueTxPacket(tx);
+    }
+    listener.stop(0);
+    return CODE_OK;
+}
+
+void UsbGatewayWorker::stop()
+{
+    stopRequest = true;
+}
@@ -0,0 +1,56 @@
+#ifndef USB_GATEWAY_WORKER_H_
+#define USB_GATEWAY_WORKER_H_ 1
+
+#include <atomic>
+
+#include "lorawan/task/task-socket.h"
+#include "rak2287.h"
+
+/**
+ * Gateway worker process runs one concentrator: libloragw keeps concentrator state in the global variables,
+ * so each concentrator requires own process.
+ * Worker passes received radio packets to the gw-dev-usb process over the socket pair (see usb-worker-link.h),
+ * enqueue downlinks received from it and reports concentrator measurements periodically.
+ * Worker is a TaskSocket to pass socket pair end to the listener callbacks.
+ */
+class UsbGatewayWorker : public TaskSocket {
+private:
+    std::atomic<bool> stopRequest;
+public:
+    LoraGatewayListener listener;
+    std::atomic<size_t> uplinks;        ///< radio packets passed to the gw-dev-usb process
+    std::atomic<size_t> dropped;        ///< radio packets dropped because gw-dev-usb process is busy
+    int measurementsIntervalMs;         ///< how often send measurements
+
+    /**
+     * @param socket worker end of the SOCK_SEQPACKET socket pair
+     */
+    explicit UsbGatewayWorker(
+        SOCKET socket
+    );
+    SOCKET openSocket() override;
+    void closeSocket() override;
+    /**
+     * Start concentrator and serve the socket until stop() is called or gw-dev-usb process closes socket
+     * @param settings concentrator settings
+     * @param log log
+     * @param flags FLAG_GATEWAY_LISTENER_NO_SEND, FLAG_GATEWAY_LISTENER_NO_BEACON
+     * @param verbosity log verbosity
+     * @param cpu CPU core to pin upstream thread to, -1- do not pin
+     * @return CODE_OK- success, error code if concentrator has not been started
+     */
+    int run(
+        GatewaySettings *settings,
+        Log *log,
+        int flags,
+        int verbosity,
+        int cpu
+    );
+    /**
+     * Request run() to return. Can be called from the signal handler
+     */
+    void stop();
+    ~UsbGatewayWorker() override;
+};
+
+#endif
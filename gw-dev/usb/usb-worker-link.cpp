@@ -0,0 +1,128 @@
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "usb-worker-link.h"
+#include "lorawan/lorawan-error.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+typedef struct {
+    uint8_t type;
+    uint8_t reserved[7];
+    uint64_t eui;
+} USB_WORKER_RECORD_HEADER;
+
+static_assert(sizeof(USB_WORKER_RECORD_HEADER) == USB_WORKER_RECORD_HEADER_SIZE, "Invalid record header size");
+
+UsbWorkerRecord::UsbWorkerRecord()
+    : type(UWR_HELLO), eui(0), metadata {}, payload(nullptr), payloadSize(0), tx {}, measurements {}
+{
+}
+
+int UsbWorkerRecord::parse(
+    const char *buffer,
+    size_t size
+)
+{
+    if (size < sizeof(USB_WORKER_RECORD_HEADER))
+        return ERR_CODE_INVALID_PACKET;
+    USB_WORKER_RECORD_HEADER h;
+    memmove(&h, buffer, sizeof(h));
+    const char *body = buffer + sizeof(h);
+    size_t bodySize = size - sizeof(h);
+    eui = h.eui;
+    switch (h.type) {
+        case UWR_HELLO:
+            break;
+        case UWR_UPLINK:
+            if (bodySize < sizeof(metadata))
+                return ERR_CODE_INVALID_PACKET;
+            memmove(&metadata, body, sizeof(metadata));
+            payload = body + sizeof(metadata);
+            payloadSize = bodySize - sizeof(metadata);
+            break;
+        case UWR_TX:
+            if (bodySize != sizeof(tx))
+                return ERR_CODE_INVALID_PACKET;
+            memmove(&tx, body, sizeof(tx));
+            break;
+        case UWR_MEASUREMENTS:
+            if (bodySize != sizeof(measurements))
+                return ERR_CODE_INVALID_PACKET;
+            memmove(measurements, body, sizeof(measurements));
+            break;
+        default:
+            return ERR_CODE_INVALID_PACKET;
+    }
+    type = (USB_WORKER_RECORD_TYPE) h.type;
+    return CODE_OK;
+}
+
+/**
+ * Send header and up to two parts of the record body as one message
+ */
+static ssize_t sendRecord(
+    SOCKET sock,
+    USB_WORKER_RECORD_TYPE type,
+    uint64_t eui,
+    const void *body,
+    size_t bodySize,
+    const void *body2,
+    size_t body2Size,
+    int flags
+)
+{
+    USB_WORKER_RECORD_HEADER h {};
+    h.type = (uint8_t) type;
+    h.eui = eui;
+    struct iovec iov[3] = {
+        { &h, sizeof(h) },
+        { (void *) body, bodySize },
+        { (void *) body2, body2Size }
+    };
+    struct msghdr msg {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 3;
+    return sendmsg(sock, &msg, flags | MSG_NOSIGNAL);
+}
+
+ssize_t sendUsbWorkerHello(
+    SOCKET sock,
+    uint64_t eui
+)
+{
+    return sendRecord(sock, UWR_HELLO, eui, nullptr, 0, nullptr, 0, 0);
+}
+
+ssize_t sendUsbWorkerUplink(
+    SOCKET sock,
+    uint64_t eui,
+    const SEMTECH_PROTOCOL_METADATA_RX &metadata,
+    const void *payload,
+    size_t size
+)
+{
+    // upstream thread must not wait, concentrator FIFO overflows otherwise
+    return sendRecord(sock, UWR_UPLINK, eui, &metadata, sizeof(metadata), payload, size, MSG_DONTWAIT);
+}
+
+ssize_t sendUsbWorkerTx(
+    SOCKET sock,
+    uint64_t eui,
+    const struct lgw_pkt_tx_s &pkt
+)
+{
+    return sendRecord(sock, UWR_TX, eui, &pkt, sizeof(pkt), nullptr, 0, MSG_DONTWAIT);
+}
+
+ssize_t sendUsbWorkerMeasurements(
+    SOCKET sock,
+    uint64_t eui,
+    const uint32_t values[MEASUREMENT_COUNT_SIZE]
+)
+{
+    return sendRecord(sock, UWR_MEASUREMENTS, eui, values, sizeof(uint32_t) * MEASUREMENT_COUNT_SIZE, nullptr, 0, 0);
+}
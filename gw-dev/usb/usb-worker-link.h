@@ -0,0 +1,104 @@
+#ifndef USB_WORKER_LINK_H_
+#define USB_WORKER_LINK_H_ 1
+
+#include "rak2287.h"
+
+/**
+ * Records exchanged by the gateway worker process (one concentrator) and the gw-dev-usb process
+ * running the dispatcher over SOCK_SEQPACKET socket pair, one record per message.
+ * Both processes run on the same host, so records are in the host byte order.
+ *
+ * Record header: type (1 byte), reserved (7 bytes), concentrator EUI (8 bytes) followed by
+ *  UWR_HELLO           nothing
+ *  UWR_UPLINK          SEMTECH_PROTOCOL_METADATA_RX, radio packet
+ *  UWR_TX              struct lgw_pkt_tx_s
+ *  UWR_MEASUREMENTS    uint32_t[MEASUREMENT_COUNT_SIZE]
+ */
+enum USB_WORKER_RECORD_TYPE {
+    UWR_HELLO = 1,          ///< worker has started concentrator
+    UWR_UPLINK = 2,         ///< worker received radio packet
+    UWR_TX = 3,             ///< dispatcher sends downlink to the concentrator
+    UWR_MEASUREMENTS = 4    ///< worker concentrator counters
+};
+
+#define USB_WORKER_RECORD_HEADER_SIZE   16
+// large enough for any record: radio packet is less than lgw_pkt_tx_s
+#define USB_WORKER_RECORD_MAX_SIZE      (USB_WORKER_RECORD_HEADER_SIZE + sizeof(SEMTECH_PROTOCOL_METADATA_RX) + sizeof(struct lgw_pkt_tx_s))
+
+class UsbWorkerRecord {
+public:
+    USB_WORKER_RECORD_TYPE type;
+    uint64_t eui;                                   ///< concentrator EUI
+    SEMTECH_PROTOCOL_METADATA_RX metadata;          ///< UWR_UPLINK
+    const char *payload;                            ///< UWR_UPLINK radio packet, points to the parsed buffer
+    size_t payloadSize;
+    struct lgw_pkt_tx_s tx;                         ///< UWR_TX
+    uint32_t measurements[MEASUREMENT_COUNT_SIZE];  ///< UWR_MEASUREMENTS
+    UsbWorkerRecord();
+    /**
+     * Parse received record
+     * @param buffer record
+     * @param size record size
+     * @return CODE_OK- success, ERR_CODE_INVALID_PACKET- unknown type or invalid size
+     */
+    int parse(
+        const char *buffer,
+        size_t size
+    );
+};
+
+/**
+ * Send UWR_HELLO record
+ * @param sock socket
+ * @param eui concentrator EUI
+ * @return bytes sent, <0- error
+ */
+ssize_t sendUsbWorkerHello(
+    SOCKET sock,
+    uint64_t eui
+);
+
+/**
+ * Send UWR_UPLINK record. Do not block, radio packet is dropped if dispatcher does not read records
+ * @param sock socket
+ * @param eui concentrator EUI
+ * @param metadata radio packet metadata
+ * @param payload radio packet
+ * @param size radio packet size
+ * @return bytes sent, <0- error
+ */
+ssize_t sendUsbWorkerUplink(
+    SOCKET sock,
+    uint64_t eui,
+    const SEMTECH_PROTOCOL_METADATA_RX &metadata,
+    const void *payload,
+    size_t size
+);
+
+/**
+ * Send UWR_TX record
+ * @param sock socket
+ * @param eui concentrator EUI
+ * @param pkt packet to send
+ * @return bytes sent, <0- error
+ */
+ssize_t sendUsbWorkerTx(
+    SOCKET sock,
+    uint64_t eui,
+    const struct lgw_pkt_tx_s &pkt
+);
+
+/**
+ * Send UWR_MEASUREMENTS record
+ * @param sock socket
+ * @param eui concentrator EUI
+ * @param values counters
+ * @return bytes sent, <0- error
+ */
+ssize_t sendUsbWorkerMeasurements(
+    SOCKET sock,
+    uint64_t eui,
+    const uint32_t values[MEASUREMENT_COUNT_SIZE]
+);
+
+#endif
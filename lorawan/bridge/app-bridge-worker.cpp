@@ -0,0 +1,151 @@
+#include <sstream>
+#include <functional>
+
+#include "lorawan/bridge/app-bridge-worker.h"
+
+AppBridgeWorkerStat::AppBridgeWorkerStat()
+    : enqueued(0), delivered(0), dropped(0), batches(0), queued(0), maxQueued(0),
+    lagMicroseconds(0), maxLagMicroseconds(0)
+{
+}
+
+std::string AppBridgeWorkerStat::toJsonString() const
+{
+    std::stringstream ss;
+    ss << "{\"enqueued\": " << enqueued
+        << ", \"delivered\": " << delivered
+        << ", \"dropped\": " << dropped
+        << ", \"batches\": " << batches
+        << ", \"queued\": " << queued
+        << ", \"maxQueued\": " << maxQueued
+        << ", \"lag\": " << lagMicroseconds
+        << ", \"maxLag\": " << maxLagMicroseconds
+        << "}";
+    return ss.str();
+}
+
+AppBridgeWorker::AppBridgeWorker(
+    AppBridge *aBridge,
+    const void *aDispatcher,
+    size_t aCapacity,
+    BRIDGE_OVERFLOW_POLICY aPolicy,
+    size_t aMaxBatch
+)
+    : bridge(aBridge), dispatcher(aDispatcher), capacity(aCapacity ? aCapacity : 1),
+    maxBatch(aMaxBatch ? aMaxBatch : 1), policy(aPolicy), thread(nullptr), running(false)
+{
+}
+
+AppBridgeWorker::~AppBridgeWorker()
+{
+    stop();
+}
+
+void AppBridgeWorker::start()
+{
+    if (thread)
+        return;
+    running = true;
+    thread = new std::thread(std::bind(&AppBridgeWorker::run, this));
+}
+
+void AppBridgeWorker::stop()
+{
+    if (!thread)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutexQueue);
+        running = false;
+    }
+    cvNotEmpty.notify_all();
+    cvNotFull.notify_all();
+    thread->join();
+    delete thread;
+    thread = nullptr;
+}
+
+bool AppBridgeWorker::push(
+    const MessageQueueItem *item,
+    bool decoded,
+    bool micMatched
+)
+{
+    if (!item)
+        return false;
+    std::unique_lock<std::mutex> lock(mutexQueue);
+    if (queue.size() >= capacity) {
+        switch (policy) {
+            case BRIDGE_OVERFLOW_DROP_OLDEST:
+                queue.pop_front();
+                stat.dropped++;
+                break;
+            case BRIDGE_OVERFLOW_BLOCK:
+                cvNotFull.wait(lock, [this] {
+                    return queue.size() < capacity || !running;
+                });
+                if (!running) {
+                    stat.dropped++;
+                    return false;
+                }
+                break;
+            default:
+                stat.dropped++;
+                return false;
+        }
+    }
+    queue.emplace_back(*item, decoded, micMatched);
+    stat.enqueued++;
+    if (queue.size() > stat.maxQueued)
+        stat.maxQueued = queue.size();
+    lock.unlock();
+    cvNotEmpty.notify_one();
+    return true;
+}
+
+void AppBridgeWorker::run()
+{
+    std::vector<AppBridgePayload> batch;
+    batch.reserve(maxBatch);
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutexQueue);
+            cvNotEmpty.wait(lock, [this] {
+                return !queue.empty() || !running;
+            });
+            // deliver the rest of queue before exit
+            if (queue.empty() && !running)
+                break;
+            while (!queue.empty() && batch.size() < maxBatch) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+        cvNotFull.notify_all();
+        auto lag = std::chrono::duration_cast<std::chrono::microseconds>(
+            TASK_CLOCK::now() - batch.front().queued).count();
+        bridge->onPayloadBatch(dispatcher, batch);
+        {
+            std::lock_guard<std::mutex> lock(mutexQueue);
+            stat.delivered += batch.size();
+            stat.batches++;
+            stat.lagMicroseconds = lag;
+            if (lag > stat.maxLagMicroseconds)
+                stat.maxLagMicroseconds = lag;
+        }
+        batch.clear();
+    }
+}
+
+AppBridge *AppBridgeWorker::getBridge() const
+{
+    return bridge;
+}
+
+void AppBridgeWorker::getStat(
+    AppBridgeWorkerStat &retVal
+) const
+{
+    std::lock_guard<std::mutex> lock(mutexQueue);
+    retVal = stat;
+    retVal.queued = queue.size();
+}
@@ -0,0 +1,97 @@
+#ifndef TLNS_APP_BRIDGE_WORKER_H
+#define TLNS_APP_BRIDGE_WORKER_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "lorawan/bridge/app-bridge.h"
+
+/**
+ * Deliver payloads to the bridge in its own thread so slow bridge (MQTT, file, sockets)
+ * does not delay uplink loop.
+ *
+ * Dispatcher thread push() copy of the payload to the bounded queue, worker thread
+ * takes up to maxBatch payloads at once and calls AppBridge::onPayloadBatch().
+ */
+
+#define DEF_BRIDGE_QUEUE_SIZE   1024
+#define DEF_BRIDGE_MAX_BATCH    64
+
+typedef enum {
+    BRIDGE_OVERFLOW_DROP_NEWEST = 0,    ///< queue is full, drop payload being pushed
+    BRIDGE_OVERFLOW_DROP_OLDEST = 1,    ///< queue is full, drop oldest payload in the queue
+    BRIDGE_OVERFLOW_BLOCK = 2           ///< queue is full, wait until worker takes payload
+} BRIDGE_OVERFLOW_POLICY;
+
+class AppBridgeWorkerStat {
+public:
+    uint64_t enqueued;          ///< payloads pushed
+    uint64_t delivered;         ///< payloads passed to the bridge
+    uint64_t dropped;           ///< payloads dropped due queue overflow
+    uint64_t batches;           ///< onPayloadBatch() calls
+    size_t queued;              ///< payloads waiting in the queue
+    size_t maxQueued;           ///< max queue length
+    int64_t lagMicroseconds;    ///< last delivered payload queue waiting time
+    int64_t maxLagMicroseconds; ///< max queue waiting time
+    AppBridgeWorkerStat();
+    std::string toJsonString() const;
+};
+
+class AppBridgeWorker {
+private:
+    AppBridge *bridge;
+    const void *dispatcher;
+    size_t capacity;
+    size_t maxBatch;
+    BRIDGE_OVERFLOW_POLICY policy;
+    mutable std::mutex mutexQueue;
+    std::condition_variable cvNotEmpty;
+    std::condition_variable cvNotFull;
+    std::deque<AppBridgePayload> queue;
+    std::thread *thread;
+    bool running;
+    AppBridgeWorkerStat stat;
+    void run();
+public:
+    AppBridgeWorker(
+        AppBridge *bridge,
+        const void *dispatcher,
+        size_t capacity = DEF_BRIDGE_QUEUE_SIZE,
+        BRIDGE_OVERFLOW_POLICY policy = BRIDGE_OVERFLOW_DROP_NEWEST,
+        size_t maxBatch = DEF_BRIDGE_MAX_BATCH
+    );
+    virtual ~AppBridgeWorker();
+
+    void start();
+    /**
+     * Deliver payloads left in the queue and stop worker thread
+     */
+    void stop();
+
+    /**
+     * Copy payload to the queue
+     * @param item payload
+     * @param decoded true- payload decoded
+     * @param micMatched true- MIC matched
+     * @return false if payload dropped
+     */
+    bool push(
+        const MessageQueueItem *item,
+        bool decoded,
+        bool micMatched
+    );
+
+    AppBridge *getBridge() const;
+
+    /**
+     * Return copy of counters
+     * @param retVal counters
+     */
+    void getStat(
+        AppBridgeWorkerStat &retVal
+    ) const;
+};
+
+#endif
@@ -2,12 +2,36 @@
 #include "lorawan/lorawan-error.h"
 #include "lorawan/task/message-task-dispatcher.h"
 
+AppBridgePayload::AppBridgePayload()
+    : decoded(false), micMatched(false)
+{
+}
+
+AppBridgePayload::AppBridgePayload(
+    const MessageQueueItem &aItem,
+    bool aDecoded,
+    bool aMicMatched
+)
+    : item(aItem), decoded(aDecoded), micMatched(aMicMatched), queued(TASK_CLOCK::now())
+{
+}
+
 AppBridge::AppBridge()
     : dispatcher(nullptr)
 {
 
 }
 
+void AppBridge::onPayloadBatch(
+    const void *aDispatcher,
+    const std::vector<AppBridgePayload> &items
+)
+{
+    for (auto &i : items) {
+        onPayload(aDispatcher, &i.item, i.decoded, i.micMatched);
+    }
+}
+
 void AppBridge::setDispatcher(
     void *aDispatcher
 )
@@ -2,9 +2,28 @@
 #define TLNS_APP_BRIDGE_H
 
 #include <cstddef>
+#include <vector>
 #include "lorawan/task/message-queue-item.h"
 #include "lorawan/helper/plugin-helper.h"
 
+/**
+ * Copy of the payload queued for the bridge worker
+ * @see AppBridgeWorker
+ */
+class AppBridgePayload {
+public:
+    MessageQueueItem item;
+    bool decoded;
+    bool micMatched;
+    TASK_TIME queued;       ///< time when payload has been queued
+    AppBridgePayload();
+    AppBridgePayload(
+        const MessageQueueItem &item,
+        bool decoded,
+        bool micMatched
+    );
+};
+
 /**
  * Abstract class connects to application service
  * @see ServiceClient
@@ -34,6 +53,18 @@ public:
         bool decoded,
         bool micMatched
     ) = 0;
+
+    /**
+     * Called by the bridge worker thread with one or more payloads queued since last call.
+     * Default implementation calls onPayload() for each payload.
+     * Override if bridge can amortize I/O e.g. write all payloads at once.
+     * @param dispatcher Dispatcher. Can be NULL
+     * @param items payloads in order they were received
+     */
+    virtual void onPayloadBatch(
+        const void *dispatcher,
+        const std::vector<AppBridgePayload> &items
+    );
     /**
      * Initialize bridge. All options are optional.
      * @param option
@@ -1,13 +1,253 @@
 #include <iostream>
-#include <fstream>
+#include <sstream>
+#include <functional>
+#include <ctime>
+#include <algorithm>
 #include "lorawan/bridge/file-json-bridge.h"
 #include "lorawan/lorawan-string.h"
+#include "lorawan/lorawan-date.h"
 #include "lorawan/lorawan-error.h"
+#include "lorawan/helper/file-helper.h"
+
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
 
 static const char *APP_BRIDGE_NAME = "file-json-app-bridge";
 #define DEF_FILE_JSON_NAME "payload.json"
+#define SEGMENT_TIME_FORMAT "%Y%m%dT%H%M%S"
+#define COMPRESS_BUFFER_SIZE (64 * 1024)
+
+FileJsonBridgeOptions::FileJsonBridgeOptions()
+    : flushSize(DEF_FILE_JSON_FLUSH_SIZE), flushMilliseconds(DEF_FILE_JSON_FLUSH_MS),
+    rotateSize(DEF_FILE_JSON_ROTATE_SIZE), rotateHourly(false), compress(false)
+{
+}
 
-FileJsonBridge::FileJsonBridge() = default;
+bool FileJsonBridgeOptions::parse(
+    const std::string &value
+)
+{
+    std::stringstream ss(value);
+    std::string o;
+    while (std::getline(ss, o, ',')) {
+        std::string v;
+        size_t p = o.find('=');
+        if (p != std::string::npos) {
+            v = o.substr(p + 1);
+            o = o.substr(0, p);
+        }
+        if (o == "flush-size")
+            flushSize = strtoull(v.c_str(), nullptr, 10);
+        else if (o == "flush-ms")
+            flushMilliseconds = (uint32_t) strtoul(v.c_str(), nullptr, 10);
+        else if (o == "rotate-size")
+            rotateSize = strtoull(v.c_str(), nullptr, 10);
+        else if (o == "hourly")
+            rotateHourly = true;
+        else if (o == "compress")
+            compress = true;
+        else if (!o.empty())
+            return false;
+    }
+    return true;
+}
+
+FileJsonBridgeStat::FileJsonBridgeStat()
+    : records(0), bytes(0), flushes(0), segments(0), lostRecords(0), lostBytes(0),
+    recordsPerSecond(0.0), bytesPerSecond(0.0)
+{
+}
+
+std::string FileJsonBridgeStat::toJsonString() const
+{
+    std::stringstream ss;
+    ss << "{\"records\": " << records
+        << ", \"bytes\": " << bytes
+        << ", \"flushes\": " << flushes
+        << ", \"segments\": " << segments
+        << ", \"lostRecords\": " << lostRecords
+        << ", \"lostBytes\": " << lostBytes
+        << ", \"recordsPerSecond\": " << recordsPerSecond
+        << ", \"bytesPerSecond\": " << bytesPerSecond
+        << "}";
+    return ss.str();
+}
+
+static int currentHour()
+{
+    time_t t = time(nullptr);
+    return (int) (t / 3600);
+}
+
+#ifdef ENABLE_ZLIB
+/**
+ * Compress file to the <fileName>.gz and remove source file
+ * @param fileName file to compress
+ * @return true if success
+ */
+static bool gzipFile(
+    const std::string &fileName
+)
+{
+    FILE *src = fopen(fileName.c_str(), "rb");
+    if (!src)
+        return false;
+    std::string gzFileName = fileName + ".gz";
+    gzFile dest = gzopen(gzFileName.c_str(), "wb");
+    if (!dest) {
+        fclose(src);
+        return false;
+    }
+    char buf[COMPRESS_BUFFER_SIZE];
+    bool ok = true;
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), src)) > 0) {
+        if (gzwrite(dest, buf, (unsigned) n) != (int) n) {
+            ok = false;
+            break;
+        }
+    }
+    fclose(src);
+    if (gzclose(dest) != Z_OK)
+        ok = false;
+    if (ok)
+        remove(fileName.c_str());
+    else
+        remove(gzFileName.c_str());
+    return ok;
+}
+#endif
+
+FileJsonBridge::FileJsonBridge()
+    : flushThread(nullptr), running(false), bufferRecords(0), fileSize(0), fileHour(0), strm(nullptr)
+{
+}
+
+FileJsonBridge::~FileJsonBridge()
+{
+    done();
+}
+
+int FileJsonBridge::openFile()
+{
+    strm = fopen(fileName.c_str(), "ab");
+    if (!strm)
+        return ERR_CODE_OPEN_DEVICE;
+    // records are buffered by the bridge, fwrite() returns bytes written to the file
+    setvbuf(strm, nullptr, _IONBF, 0);
+    fseek(strm, 0, SEEK_END);
+    long sz = ftell(strm);
+    fileSize = sz > 0 ? (size_t) sz : 0;
+    fileHour = currentHour();
+    return CODE_OK;
+}
+
+void FileJsonBridge::closeFile()
+{
+    if (strm) {
+        fclose(strm);
+        strm = nullptr;
+    }
+}
+
+void FileJsonBridge::rotate()
+{
+    closeFile();
+    // payload.json -> payload-20240101T000000.json
+    std::string base(fileName);
+    std::string ext;
+    size_t p = fileName.find_last_of("./\\");
+    if (p != std::string::npos && fileName[p] == '.') {
+        base = fileName.substr(0, p);
+        ext = fileName.substr(p);
+    }
+    std::string segmentBase = base + "-" + ltimeString(time(nullptr), -1, SEGMENT_TIME_FORMAT);
+    std::string segmentName = segmentBase + ext;
+    // more than one segment per second
+    for (int i = 1; file::fileExists(segmentName) || file::fileExists(segmentName + ".gz"); i++) {
+        segmentName = segmentBase + "-" + std::to_string(i) + ext;
+    }
+    if (rename(fileName.c_str(), segmentName.c_str()) == 0) {
+        stat.segments++;
+#ifdef ENABLE_ZLIB
+        if (options.compress) {
+            // segment is compressed by the flush thread without the buffer lock
+            segmentsToCompress.push_back(segmentName);
+            cvFlush.notify_all();
+        }
+#endif
+    }
+    openFile();
+}
+
+void FileJsonBridge::compressSegments(
+    std::unique_lock<std::mutex> &lock
+)
+{
+#ifdef ENABLE_ZLIB
+    while (!segmentsToCompress.empty()) {
+        std::vector<std::string> segments;
+        segments.swap(segmentsToCompress);
+        lock.unlock();
+        for (auto &segmentName : segments) {
+            if (!gzipFile(segmentName))
+                std::cerr << "Error compress " << segmentName << std::endl;
+        }
+        lock.lock();
+    }
+#endif
+}
+
+void FileJsonBridge::flushBuffer()
+{
+    if (buffer.empty())
+        return;
+    if (!strm)
+        openFile();
+    size_t written = 0;
+    if (strm) {
+        written = fwrite(buffer.c_str(), 1, buffer.size(), strm);
+        if (written < buffer.size())
+            clearerr(strm);
+    }
+    if (written == buffer.size()) {
+        fileSize += written;
+        stat.bytes += written;
+        stat.records += bufferRecords;
+        stat.flushes++;
+        buffer.clear();
+        bufferRecords = 0;
+    } else {
+        // keep unwritten tail, records are separated by the new line
+        size_t writtenRecords = (size_t) std::count(buffer.begin(), buffer.begin() + written, '\n');
+        fileSize += written;
+        stat.bytes += written;
+        stat.records += writtenRecords;
+        bufferRecords -= writtenRecords;
+        buffer.erase(0, written);
+        if (buffer.size() > std::max(options.flushSize, (size_t) DEF_FILE_JSON_FLUSH_SIZE) * FILE_JSON_MAX_PENDING_FLUSHES) {
+            std::cerr << "Error write " << fileName << ", " << bufferRecords << " records lost" << std::endl;
+            stat.lostRecords += bufferRecords;
+            stat.lostBytes += buffer.size();
+            buffer.clear();
+            bufferRecords = 0;
+        }
+    }
+    // do not split record between segments
+    if (buffer.empty() && ((options.rotateSize && fileSize >= options.rotateSize)
+        || (options.rotateHourly && fileHour != currentHour())))
+        rotate();
+}
+
+void FileJsonBridge::append(
+    const MessageQueueItem *messageItem
+)
+{
+    buffer += messageItem->toJsonString();
+    buffer += '\n';
+    bufferRecords++;
+}
 
 void FileJsonBridge::onPayload(
     const void *dispatcher,
@@ -16,8 +256,41 @@ void FileJsonBridge::onPayload(
     bool micMatched
 )
 {
-    if (strm && messageItem)
-        *strm << messageItem->toJsonString() << std::endl;
+    if (!messageItem)
+        return;
+    std::lock_guard<std::mutex> lock(mutexBuffer);
+    append(messageItem);
+    if (buffer.size() >= options.flushSize)
+        flushBuffer();
+}
+
+void FileJsonBridge::onPayloadBatch(
+    const void *dispatcher,
+    const std::vector<AppBridgePayload> &items
+)
+{
+    std::lock_guard<std::mutex> lock(mutexBuffer);
+    for (auto &i : items) {
+        append(&i.item);
+    }
+    if (buffer.size() >= options.flushSize)
+        flushBuffer();
+}
+
+void FileJsonBridge::runFlush()
+{
+    std::unique_lock<std::mutex> lock(mutexBuffer);
+    while (running) {
+        if (options.flushMilliseconds) {
+            cvFlush.wait_for(lock, std::chrono::milliseconds(options.flushMilliseconds));
+            flushBuffer();
+            // rotate idle file too
+            if (options.rotateHourly && fileHour != currentHour() && fileSize && buffer.empty())
+                rotate();
+        } else
+            cvFlush.wait(lock);
+        compressSegments(lock);
+    }
 }
 
 int FileJsonBridge::init(
@@ -30,21 +303,48 @@ int FileJsonBridge::init(
         fileName = DEF_FILE_JSON_NAME;
     else
         fileName = option;
-    strm = new std::fstream(fileName, std::ios_base::out);
-    if (!strm || !strm->is_open()) {
-        delete strm;
-        strm = nullptr;
+    if (option3)
+        options = *(const FileJsonBridgeOptions *) option3;
+    else
+        if (!options.parse(option2))
+            return ERR_CODE_PARAM_INVALID;
+    buffer.reserve(options.flushSize + 1024);
+    started = std::chrono::steady_clock::now();
+    openFile();
+    bool compress = false;
+#ifdef ENABLE_ZLIB
+    compress = options.compress;
+#endif
+    if (options.flushMilliseconds || compress) {
+        running = true;
+        flushThread = new std::thread(std::bind(&FileJsonBridge::runFlush, this));
     }
     return CODE_OK;
 }
 
 void FileJsonBridge::done()
 {
-    if (strm) {
-        strm->flush();
-        delete strm;
-        strm = nullptr;
+    if (flushThread) {
+        {
+            std::lock_guard<std::mutex> lock(mutexBuffer);
+            running = false;
+        }
+        cvFlush.notify_all();
+        flushThread->join();
+        delete flushThread;
+        flushThread = nullptr;
+    }
+    std::unique_lock<std::mutex> lock(mutexBuffer);
+    flushBuffer();
+    if (!buffer.empty()) {
+        std::cerr << "Error write " << fileName << ", " << bufferRecords << " records lost" << std::endl;
+        stat.lostRecords += bufferRecords;
+        stat.lostBytes += buffer.size();
+        buffer.clear();
+        bufferRecords = 0;
     }
+    closeFile();
+    compressSegments(lock);
 }
 
 void FileJsonBridge::onSend(
@@ -57,11 +357,24 @@ void FileJsonBridge::onSend(
         std::cerr << "Sent " << item->toString() << " with code " << code << std::endl;
 }
 
-const char *FileJsonBridge::name()  
+const char *FileJsonBridge::name()
 {
     return APP_BRIDGE_NAME;
 }
 
+void FileJsonBridge::getStat(
+    FileJsonBridgeStat &retVal
+)
+{
+    std::lock_guard<std::mutex> lock(mutexBuffer);
+    retVal = stat;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (seconds > 0) {
+        retVal.recordsPerSecond = (double) stat.records / seconds;
+        retVal.bytesPerSecond = (double) stat.bytes / seconds;
+    }
+}
+
 EXPORT_SHARED_C_FUNC AppBridge* makeBridge2()
 {
     return new FileJsonBridge;
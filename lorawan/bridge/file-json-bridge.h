@@ -1,31 +1,120 @@
 #ifndef TLNS_STDOUT_BRIDGE_H
 #define TLNS_STDOUT_BRIDGE_H
 
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <condition_variable>
 #include "lorawan/bridge/app-bridge.h"
 
 /**
  * App bridge example. Write payload to "payload.json" file
  * (if first parameter of init() is empty).
  * This bridge cannot send data to another client.
+ *
+ * Records are collected in the memory buffer and written to the file when buffer exceeds flushSize
+ * bytes or every flushMilliseconds.
+ * When file exceeds rotateSize bytes (or hour changed if rotateHourly is set) file is renamed to
+ * <name>-YYYYMMDDTHHMMSS<ext> and new file is created. If compress is set and bridge is built with ENABLE_ZLIB,
+ * closed segment is compressed to <name>-YYYYMMDDTHHMMSS<ext>.gz by the flush thread, writers are not blocked.
+ * If file can not be written, unwritten records are kept in the buffer up to FILE_JSON_MAX_PENDING_FLUSHES
+ * flush sizes, then they are dropped and counted in FileJsonBridgeStat::lostRecords.
  */
+
+#define DEF_FILE_JSON_FLUSH_SIZE    (64 * 1024)
+#define DEF_FILE_JSON_FLUSH_MS      1000
+#define DEF_FILE_JSON_ROTATE_SIZE   (64 * 1024 * 1024)
+#define FILE_JSON_MAX_PENDING_FLUSHES   16
+
+class FileJsonBridgeOptions {
+public:
+    size_t flushSize;           ///< write buffer to the file when it exceeds flushSize bytes
+    uint32_t flushMilliseconds; ///< write buffer at least every flushMilliseconds. 0- on flushSize only
+    size_t rotateSize;          ///< rotate file when it exceeds rotateSize bytes. 0- do not rotate by size
+    bool rotateHourly;          ///< rotate file every hour
+    bool compress;              ///< compress closed segments
+    FileJsonBridgeOptions();
+    /**
+     * Parse comma separated options: flush-size=<bytes>,flush-ms=<ms>,rotate-size=<bytes>,hourly,compress
+     * @param value options string
+     * @return false if option is unknown
+     */
+    bool parse(const std::string &value);
+};
+
+class FileJsonBridgeStat {
+public:
+    uint64_t records;           ///< records written
+    uint64_t bytes;             ///< bytes written
+    uint64_t flushes;           ///< write calls
+    uint64_t segments;          ///< rotated segments
+    uint64_t lostRecords;       ///< records dropped because file can not be written
+    uint64_t lostBytes;         ///< bytes dropped because file can not be written
+    double recordsPerSecond;    ///< since start
+    double bytesPerSecond;      ///< since start
+    FileJsonBridgeStat();
+    std::string toJsonString() const;
+};
+
 class FileJsonBridge : public AppBridge {
+private:
+    std::mutex mutexBuffer;
+    std::condition_variable cvFlush;
+    std::thread *flushThread;
+    bool running;
+    std::string buffer;
+    size_t bufferRecords;
+    size_t fileSize;
+    int fileHour;
+    std::vector<std::string> segmentsToCompress;    ///< rotated segments, compressed by the flush thread
+    std::chrono::steady_clock::time_point started;
+    FileJsonBridgeStat stat;
+    int openFile();
+    void closeFile();
+    /**
+     * Write buffer to the file and rotate file if required. Call with locked mutexBuffer.
+     * Unwritten tail stays in the buffer
+     */
+    void flushBuffer();
+    void rotate();
+    void runFlush();
+    /**
+     * Compress rotated segments. Call with locked mutexBuffer, lock is released while files are compressed
+     */
+    void compressSegments(
+        std::unique_lock<std::mutex> &lock
+    );
+    void append(
+        const MessageQueueItem *messageItem
+    );
 protected:
     std::string fileName;
-    std::fstream *strm;
+    FILE *strm;
+    FileJsonBridgeOptions options;
 public:
     FileJsonBridge();
-    virtual ~FileJsonBridge() = default;
+    virtual ~FileJsonBridge();
     void onPayload(
         const void *dispatcher,
         const MessageQueueItem *messageItem,
         bool decoded,
         bool micMatched
     ) override;
+    void onPayloadBatch(
+        const void *dispatcher,
+        const std::vector<AppBridgePayload> &items
+    ) override;
     void onSend(
         const void *dispatcher,
         const MessageQueueItem *item,
         int code
     ) override;
+    /**
+     * @param option file name. Default "payload.json"
+     * @param option2 options string, see FileJsonBridgeOptions::parse(). Ignored if option3 is set
+     * @param option3 pointer to FileJsonBridgeOptions, can be NULL
+     */
     int init(
         const std::string& option,
         const std::string& option2,
@@ -33,6 +122,10 @@ public:
     ) override;
     void done() override;
     const char *name() override;
+
+    void getStat(
+        FileJsonBridgeStat &retVal
+    );
 };
 
 EXPORT_SHARED_C_FUNC AppBridge* makeBridge2();
@@ -0,0 +1,230 @@
+#include <iostream>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lorawan/bridge/shm-ring-bridge.h"
+#include "lorawan/lorawan-error.h"
+
+static const char *APP_BRIDGE_NAME = "shm-ring-app-bridge";
+
+// LORAWAN_MESSAGE_STORAGE without payloadSize
+#define MESSAGE_STORAGE_PACKET_SIZE (sizeof(LORAWAN_MESSAGE_STORAGE) - sizeof(int))
+// MHDR, DevAddr, FCtrl, FCnt
+#define PACKET_FHDR_SIZE            8
+
+static_assert(sizeof(shm_ring_header) == SHM_RING_HEADER_SIZE, "shm_ring_header size");
+static_assert(sizeof(shm_ring_record) == SHM_RING_RECORD_SIZE, "shm_ring_record size");
+static_assert(MESSAGE_STORAGE_PACKET_SIZE <= SHM_RING_PACKET_SIZE, "LORAWAN_MESSAGE_STORAGE does not fit record");
+
+ShmRingBridge::ShmRingBridge()
+    : fd(-1), map(nullptr), mapSize(0), header(nullptr), records(nullptr), mask(0), head(0),
+      wallClockOffset(0)
+{
+}
+
+ShmRingBridge::~ShmRingBridge()
+{
+    close();
+}
+
+int ShmRingBridge::open(
+    const std::string &fileName,
+    size_t capacity
+)
+{
+    close();
+    size_t c = 2;
+    while (c < capacity)
+        c <<= 1;
+    size_t sz = SHM_RING_HEADER_SIZE + c * SHM_RING_RECORD_SIZE;
+    fd = ::open(fileName.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return ERR_CODE_SHM_RING_OPEN;
+    struct stat st {};
+    if (fstat(fd, &st) || ((size_t) st.st_size != sz && ftruncate(fd, (off_t) sz))) {
+        close();
+        return ERR_CODE_SHM_RING_OPEN;
+    }
+    map = mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        map = nullptr;
+        close();
+        return ERR_CODE_SHM_RING_OPEN;
+    }
+    mapSize = sz;
+    header = (shm_ring_header *) map;
+    records = (shm_ring_record *) ((char *) map + SHM_RING_HEADER_SIZE);
+    mask = c - 1;
+    if (header->magic == SHM_RING_MAGIC && header->version == SHM_RING_VERSION
+        && header->record_size == SHM_RING_RECORD_SIZE && header->capacity == c) {
+        // continue after restart, readers keep their positions
+        head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+    } else {
+        memset(map, 0, sz);
+        header->version = SHM_RING_VERSION;
+        header->record_size = SHM_RING_RECORD_SIZE;
+        header->capacity = (uint32_t) c;
+        head = 0;
+        __atomic_store_n(&header->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+    }
+    return CODE_OK;
+}
+
+void ShmRingBridge::close()
+{
+    if (map) {
+        publish();
+        munmap(map, mapSize);
+        map = nullptr;
+        mapSize = 0;
+    }
+    header = nullptr;
+    records = nullptr;
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+uint64_t ShmRingBridge::written() const
+{
+    return head;
+}
+
+/**
+ * Write record. Call with locked mutexWrite.
+ */
+void ShmRingBridge::write(
+    const MessageQueueItem *messageItem,
+    bool decoded,
+    bool micMatched
+)
+{
+    shm_ring_record *r = &records[head & mask];
+    // readers copying this record see sequence changed
+    __atomic_store_n(&r->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    r->time = (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+        (messageItem->tim + wallClockOffset).time_since_epoch()).count();
+    // best gateway, see MessageQueueItem::getBestGatewayAddress(), without metadata copy
+    const SEMTECH_PROTOCOL_METADATA_RX *best = nullptr;
+    r->gateway_id = 0;
+    for (const auto &m : messageItem->metadata) {
+        if (!best || m.second.rx.lsnr > best->lsnr) {
+            best = &m.second.rx;
+            r->gateway_id = m.first;
+        }
+    }
+    if (best) {
+        r->freq = best->freq;
+        r->rssi = best->rssi;
+        r->lsnr = (int16_t) (best->lsnr * 10);
+        r->spreading_factor = (uint8_t) best->spreadingFactor;
+    } else {
+        r->freq = 0;
+        r->rssi = 0;
+        r->lsnr = 0;
+        r->spreading_factor = 0;
+    }
+    r->dev_eui = messageItem->task.deviceId.devEUI.u;
+    r->flags = (decoded ? SHM_RING_FLAG_DECODED : 0) | (micMatched ? SHM_RING_FLAG_MIC_MATCHED : 0);
+    r->gateways = (uint8_t) messageItem->metadata.size();
+    r->reserved = 0;
+    const LORAWAN_MESSAGE_STORAGE &p = messageItem->radioPacket;
+    r->payload_size = p.payloadSize;
+    // copy used bytes only: FHDR, FOpts, FPort, FRMPayload
+    size_t sz = PACKET_FHDR_SIZE + p.data.uplink.f.foptslen + 1 + (p.payloadSize > 0 ? p.payloadSize : 0);
+    if (sz > MESSAGE_STORAGE_PACKET_SIZE)
+        sz = MESSAGE_STORAGE_PACKET_SIZE;
+    memcpy(r->packet, &p, sz);
+
+    head++;
+    __atomic_store_n(&r->seq, head, __ATOMIC_RELEASE);
+}
+
+void ShmRingBridge::setWallClockOffset()
+{
+    wallClockOffset = std::chrono::duration_cast<TASK_TIME::duration>(
+        std::chrono::system_clock::now().time_since_epoch()) - TASK_CLOCK::now().time_since_epoch();
+}
+
+void ShmRingBridge::publish()
+{
+    if (header)
+        __atomic_store_n(&header->head, head, __ATOMIC_RELEASE);
+}
+
+void ShmRingBridge::onPayload(
+    const void *dispatcher,
+    const MessageQueueItem *messageItem,
+    bool decoded,
+    bool micMatched
+)
+{
+    if (!messageItem)
+        return;
+    std::lock_guard<std::mutex> lock(mutexWrite);
+    if (!map)
+        return;
+    setWallClockOffset();
+    write(messageItem, decoded, micMatched);
+    publish();
+}
+
+void ShmRingBridge::onPayloadBatch(
+    const void *dispatcher,
+    const std::vector<AppBridgePayload> &items
+)
+{
+    std::lock_guard<std::mutex> lock(mutexWrite);
+    if (!map)
+        return;
+    setWallClockOffset();
+    for (auto &i : items) {
+        write(&i.item, i.decoded, i.micMatched);
+    }
+    publish();
+}
+
+void ShmRingBridge::onSend(
+    const void *dispatcher,
+    const MessageQueueItem *item,
+    int code
+)
+{
+    if (item)
+        std::cerr << "Sent " << item->toString() << " with code " << code << std::endl;
+}
+
+int ShmRingBridge::init(
+    const std::string& option,
+    const std::string& option2,
+    const void *option3
+)
+{
+    size_t capacity = DEF_SHM_RING_CAPACITY;
+    if (!option2.empty())
+        capacity = strtoul(option2.c_str(), nullptr, 10);
+    std::lock_guard<std::mutex> lock(mutexWrite);
+    return open(option.empty() ? DEF_SHM_RING_FILE_NAME : option, capacity);
+}
+
+void ShmRingBridge::done()
+{
+    std::lock_guard<std::mutex> lock(mutexWrite);
+    close();
+}
+
+const char *ShmRingBridge::name()
+{
+    return APP_BRIDGE_NAME;
+}
+
+EXPORT_SHARED_C_FUNC AppBridge* makeBridge4()
+{
+    return new ShmRingBridge;
+}
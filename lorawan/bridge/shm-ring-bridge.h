@@ -0,0 +1,86 @@
+#ifndef TLNS_SHM_RING_BRIDGE_H
+#define TLNS_SHM_RING_BRIDGE_H
+
+#include <mutex>
+#include "lorawan/bridge/app-bridge.h"
+#include "lorawan/bridge/shm-ring.h"
+
+/**
+ * App bridge for co-located consumers. Write each payload to the memory mapped ring file
+ * (DEF_SHM_RING_FILE_NAME if first parameter of init() is empty) as the fixed size record:
+ * LORAWAN_MESSAGE_STORAGE and best gateway metadata. Consumers read ring with the C reader
+ * library (shm-ring.h) without system calls, each at own pace, slow consumer loses oldest records.
+ * This bridge cannot send data to another client.
+ *
+ * Ring is created if file does not exist or has other capacity, otherwise writer continues
+ * from the last written record.
+ */
+class ShmRingBridge : public AppBridge {
+private:
+    std::mutex mutexWrite;
+    int fd;
+    void *map;
+    size_t mapSize;
+    shm_ring_header *header;
+    shm_ring_record *records;
+    uint64_t mask;
+    uint64_t head;
+    TASK_TIME::duration wallClockOffset;    ///< wall clock minus monotonic clock, set once per call
+    void write(
+        const MessageQueueItem *messageItem,
+        bool decoded,
+        bool micMatched
+    );
+    void setWallClockOffset();
+    void publish();
+public:
+    ShmRingBridge();
+    virtual ~ShmRingBridge();
+    /**
+     * Create or map ring file
+     * @param fileName ring file
+     * @param capacity records, rounded up to the power of 2
+     * @return CODE_OK, ERR_CODE_SHM_RING_OPEN
+     */
+    int open(
+        const std::string &fileName,
+        size_t capacity
+    );
+    void close();
+    /**
+     * @return records written
+     */
+    uint64_t written() const;
+
+    void onPayload(
+        const void *dispatcher,
+        const MessageQueueItem *messageItem,
+        bool decoded,
+        bool micMatched
+    ) override;
+    void onPayloadBatch(
+        const void *dispatcher,
+        const std::vector<AppBridgePayload> &items
+    ) override;
+    void onSend(
+        const void *dispatcher,
+        const MessageQueueItem *item,
+        int code
+    ) override;
+    /**
+     * @param option ring file name. Default DEF_SHM_RING_FILE_NAME
+     * @param option2 capacity, records. Default DEF_SHM_RING_CAPACITY
+     * @param option3 not used
+     */
+    int init(
+        const std::string& option,
+        const std::string& option2,
+        const void *option3
+    ) override;
+    void done() override;
+    const char *name() override;
+};
+
+EXPORT_SHARED_C_FUNC AppBridge* makeBridge4();
+
+#endif //TLNS_SHM_RING_BRIDGE_H
@@ -0,0 +1,188 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "shm-ring.h"
+
+// packet offsets: MHDR, DevAddr, FCtrl, FCnt, FOpts
+#define OFFSET_ADDR     1
+#define OFFSET_FCTRL    5
+#define OFFSET_FCNT     6
+#define OFFSET_FOPTS    8
+
+static uint64_t load_acquire(
+    const uint64_t *value
+)
+{
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Writer has lapped the reader, skip to the oldest record which is not going to be overwritten soon
+ */
+static void skip_lost(
+    shm_ring_reader *reader
+)
+{
+    uint64_t head = load_acquire(&reader->header->head);
+    uint64_t capacity = reader->mask + 1;
+    uint64_t next = head > capacity / 2 ? head - capacity / 2 : 0;
+    if (next > reader->next) {
+        reader->lost += next - reader->next;
+        reader->next = next;
+    }
+}
+
+int shm_ring_open(
+    shm_ring_reader *reader,
+    const char *file_name
+)
+{
+    struct stat st;
+    const shm_ring_header *h;
+    memset(reader, 0, sizeof(shm_ring_reader));
+    reader->fd = open(file_name, O_RDONLY);
+    if (reader->fd < 0)
+        return -1;
+    if (fstat(reader->fd, &st) || (size_t) st.st_size < SHM_RING_HEADER_SIZE) {
+        close(reader->fd);
+        reader->fd = -1;
+        return -2;
+    }
+    reader->map_size = (size_t) st.st_size;
+    reader->map = mmap(NULL, reader->map_size, PROT_READ, MAP_SHARED, reader->fd, 0);
+    if (reader->map == MAP_FAILED) {
+        int e = errno;
+        close(reader->fd);
+        reader->fd = -1;
+        reader->map = NULL;
+        errno = e;
+        return -1;
+    }
+    h = (const shm_ring_header *) reader->map;
+    if (h->magic != SHM_RING_MAGIC || h->version != SHM_RING_VERSION || h->record_size != SHM_RING_RECORD_SIZE
+        || h->capacity == 0 || (h->capacity & (h->capacity - 1))
+        || reader->map_size < SHM_RING_HEADER_SIZE + (size_t) h->capacity * SHM_RING_RECORD_SIZE) {
+        shm_ring_close(reader);
+        return -2;
+    }
+    reader->header = (shm_ring_header *) reader->map;
+    reader->records = (shm_ring_record *) ((char *) reader->map + SHM_RING_HEADER_SIZE);
+    reader->mask = h->capacity - 1;
+    reader->next = load_acquire(&reader->header->head);
+    return 0;
+}
+
+void shm_ring_close(
+    shm_ring_reader *reader
+)
+{
+    if (reader->map) {
+        munmap(reader->map, reader->map_size);
+        reader->map = NULL;
+    }
+    if (reader->fd >= 0) {
+        close(reader->fd);
+        reader->fd = -1;
+    }
+    reader->header = NULL;
+    reader->records = NULL;
+}
+
+int shm_ring_read(
+    shm_ring_reader *reader,
+    shm_ring_record *ret_val
+)
+{
+    for (;;) {
+        const shm_ring_record *r = &reader->records[reader->next & reader->mask];
+        uint64_t expected = reader->next + 1;
+        uint64_t seq = load_acquire(&r->seq);
+        if (seq == expected) {
+            memcpy(ret_val, r, sizeof(shm_ring_record));
+            // record must not change while it is copied
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&r->seq, __ATOMIC_RELAXED) == expected) {
+                reader->next++;
+                return 1;
+            }
+            skip_lost(reader);
+            continue;
+        }
+        if (seq > expected) {
+            // overwritten by the writer
+            skip_lost(reader);
+            continue;
+        }
+        // previous lap record or record is being written
+        if (load_acquire(&reader->header->head) > reader->next + reader->mask + 1) {
+            skip_lost(reader);
+            continue;
+        }
+        return 0;
+    }
+}
+
+size_t shm_ring_read_batch(
+    shm_ring_reader *reader,
+    shm_ring_record *ret_val,
+    size_t count
+)
+{
+    size_t c = 0;
+    while (c < count && shm_ring_read(reader, ret_val + c) > 0)
+        c++;
+    return c;
+}
+
+uint64_t shm_ring_lag(
+    const shm_ring_reader *reader
+)
+{
+    uint64_t head = load_acquire(&reader->header->head);
+    return head > reader->next ? head - reader->next : 0;
+}
+
+uint32_t shm_ring_record_addr(
+    const shm_ring_record *record
+)
+{
+    uint32_t r;
+    memcpy(&r, record->packet + OFFSET_ADDR, sizeof(r));
+    return r;
+}
+
+uint16_t shm_ring_record_fcnt(
+    const shm_ring_record *record
+)
+{
+    uint16_t r;
+    memcpy(&r, record->packet + OFFSET_FCNT, sizeof(r));
+    return r;
+}
+
+uint8_t shm_ring_record_fport(
+    const shm_ring_record *record
+)
+{
+    if (record->payload_size <= 0)
+        return 0;
+    return record->packet[OFFSET_FOPTS + (record->packet[OFFSET_FCTRL] & 0xf)];
+}
+
+const uint8_t *shm_ring_record_payload(
+    const shm_ring_record *record,
+    size_t *ret_size
+)
+{
+    size_t offset = OFFSET_FOPTS + (record->packet[OFFSET_FCTRL] & 0xf) + 1;
+    size_t sz = record->payload_size > 0 ? (size_t) record->payload_size : 0;
+    if (offset + sz > SHM_RING_PACKET_SIZE)
+        sz = offset < SHM_RING_PACKET_SIZE ? SHM_RING_PACKET_SIZE - offset : 0;
+    if (ret_size)
+        *ret_size = sz;
+    return record->packet + offset;
+}
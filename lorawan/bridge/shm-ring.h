@@ -0,0 +1,163 @@
+#ifndef TLNS_SHM_RING_H
+#define TLNS_SHM_RING_H
+
+/**
+ * Shared memory ring of uplink records written by ShmRingBridge (see shm-ring-bridge.h)
+ * and read by the local processes with the C reader library (shm-ring-reader.c).
+ *
+ * File layout (host byte order):
+ *  header (128 bytes): magic "SRNG", version, record size, capacity (power of 2), records written (head)
+ *  records: capacity fixed size records, record number n is stored at n % capacity
+ *
+ * Writer stores 0 to the record sequence, writes the record, then stores record number + 1 to the sequence.
+ * Reader copies the record and checks sequence again, so each consumer reads at own pace without locks
+ * and system calls. If writer laps the reader, reader skips overwritten records and counts them as lost.
+ *
+ *  shm_ring_reader reader;
+ *  shm_ring_record record;
+ *  if (shm_ring_open(&reader, "/dev/shm/tlns-uplink.ring") == 0) {
+ *      while (running) {
+ *          if (shm_ring_read(&reader, &record) > 0)
+ *              process(&record);
+ *      }
+ *      shm_ring_close(&reader);
+ *  }
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHM_RING_MAGIC              0x474e5253  // "SRNG"
+#define SHM_RING_VERSION            1
+#define SHM_RING_HEADER_SIZE        128
+#define SHM_RING_PACKET_SIZE        272
+#define SHM_RING_RECORD_SIZE        320
+#define DEF_SHM_RING_FILE_NAME      "/dev/shm/tlns-uplink.ring"
+#define DEF_SHM_RING_CAPACITY       65536
+
+// record flags
+#define SHM_RING_FLAG_DECODED       1   ///< payload decrypted
+#define SHM_RING_FLAG_MIC_MATCHED   2   ///< MIC matched NwkSKey
+
+typedef struct shm_ring_header {
+    uint32_t magic;             ///< SHM_RING_MAGIC
+    uint32_t version;           ///< SHM_RING_VERSION
+    uint32_t record_size;       ///< SHM_RING_RECORD_SIZE
+    uint32_t capacity;          ///< records, power of 2
+    uint8_t reserved[48];
+    uint64_t head;              ///< records written. Own cache line, updated by the writer only
+    uint8_t reserved2[56];
+} shm_ring_header;
+
+typedef struct shm_ring_record {
+    uint64_t seq;               ///< record number + 1, 0- record is being written
+    uint64_t time;              ///< received time, wall clock microseconds since epoch
+    uint64_t gateway_id;        ///< best gateway
+    uint64_t dev_eui;           ///< end-device EUI, 0- unknown
+    uint32_t freq;              ///< best gateway RX frequency, Hz
+    int16_t rssi;               ///< best gateway RSSI, dBm
+    int16_t lsnr;               ///< best gateway SNR, 0.1 dB
+    uint8_t flags;              ///< SHM_RING_FLAG_DECODED, SHM_RING_FLAG_MIC_MATCHED
+    uint8_t gateways;           ///< gateways received the packet
+    uint8_t spreading_factor;   ///< 7..12
+    uint8_t reserved;
+    int32_t payload_size;       ///< FRMPayload size
+    uint8_t packet[SHM_RING_PACKET_SIZE];   ///< LORAWAN_MESSAGE_STORAGE: MHDR, FHDR, FPort, FRMPayload
+} shm_ring_record;
+
+typedef struct shm_ring_reader {
+    int fd;
+    void *map;
+    size_t map_size;
+    shm_ring_header *header;
+    shm_ring_record *records;
+    uint64_t mask;
+    uint64_t next;              ///< next record number to read
+    uint64_t lost;              ///< records overwritten before they have been read
+} shm_ring_reader;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Map ring file for reading. Reader starts with the next record written.
+ * @param reader reader to initialize
+ * @param file_name ring file e.g. DEF_SHM_RING_FILE_NAME
+ * @return 0- success, -1- file can not be opened or mapped (errno is set), -2- invalid ring file
+ */
+int shm_ring_open(
+    shm_ring_reader *reader,
+    const char *file_name
+);
+
+/**
+ * Unmap ring file
+ */
+void shm_ring_close(
+    shm_ring_reader *reader
+);
+
+/**
+ * Copy next record
+ * @param reader reader
+ * @param ret_val record copy
+ * @return 1- record copied, 0- no new records
+ */
+int shm_ring_read(
+    shm_ring_reader *reader,
+    shm_ring_record *ret_val
+);
+
+/**
+ * Copy up to count records
+ * @return records copied
+ */
+size_t shm_ring_read_batch(
+    shm_ring_reader *reader,
+    shm_ring_record *ret_val,
+    size_t count
+);
+
+/**
+ * @return records written but not read yet
+ */
+uint64_t shm_ring_lag(
+    const shm_ring_reader *reader
+);
+
+/**
+ * @return end-device address
+ */
+uint32_t shm_ring_record_addr(
+    const shm_ring_record *record
+);
+
+/**
+ * @return frame counter
+ */
+uint16_t shm_ring_record_fcnt(
+    const shm_ring_record *record
+);
+
+/**
+ * @return FPort, 0 if packet has no FPort
+ */
+uint8_t shm_ring_record_fport(
+    const shm_ring_record *record
+);
+
+/**
+ * @param ret_size FRMPayload size
+ * @return FRMPayload in the record packet
+ */
+const uint8_t *shm_ring_record_payload(
+    const shm_ring_record *record,
+    size_t *ret_size
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,7 +2,18 @@
 #include <functional>
 
 #define DEF_PORT                    4250
+#if defined(__linux__)
+#define DEF_MAX_CONNECTIONS         65536
+#else
 #define DEF_MAX_CONNECTIONS         1010
+#endif
+// per TCP client output buffer limit
+#define DEF_MAX_CLIENT_BUFFER_SIZE  (256 * 1024)
+// payloads waiting for the loop thread
+#define DEF_MAX_OUTBOX_SIZE         4096
+// sendmmsg() batch size
+#define UDP_BATCH_SIZE              64
+#define EPOLL_EVENTS_SIZE           256
 // UDP clients must ping every hour
 #define DEF_MAX_UDP_CONNECTION_EXPIRATION_SECONDS   3600
 #define DEF_ON_PAYLOAD_SOCKET_PATH  "/tmp/tcp-udp-v4-bridge.socket"
@@ -23,12 +34,19 @@
 #include <sys/un.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#endif
 
 #define INVALID_SOCKET  (-1)
 #endif
 
 #include <fcntl.h>
 #include <sstream>
+#include <map>
+#include <cstring>
 
 #include "lorawan/bridge/tcp-udp-v4-bridge.h"
 #include "lorawan/lorawan-string.h"
@@ -42,7 +60,8 @@ static const char *APP_BRIDGE_NAME = "tcp-udp-v4-app-bridge";
 TcpUdpV4Bridge::TcpUdpV4Bridge()
     : tcpListenSocket(INVALID_SOCKET), udpSocket(INVALID_SOCKET),
     onPayloadListenSocket(INVALID_SOCKET), onPayloadAcceptedSocket(INVALID_SOCKET), onPayloadClientSocket(INVALID_SOCKET),
-    running(false), stopped(true), thread(nullptr), onPayloadSocketPath(DEF_ON_PAYLOAD_SOCKET_PATH)
+    running(false), stopped(true), thread(nullptr), onPayloadSocketPath(DEF_ON_PAYLOAD_SOCKET_PATH),
+    slowClientPolicy(TUB_POLICY_DROP), droppedCount(0)
 {
 
 }
@@ -54,7 +73,12 @@ TcpUdpV4Bridge::~TcpUdpV4Bridge()
 
 int TcpUdpV4Bridge::openOnPayloadSocket()
 {
-#if defined(_MSC_VER) || defined(__MINGW32__)
+#if defined(TCP_UDP_BRIDGE_EPOLL)
+    // no relay socket, onPayload() put message to the outbox and wake up loop
+    onPayloadListenSocket = eventfd(0, EFD_NONBLOCK);
+    if (onPayloadListenSocket == INVALID_SOCKET)
+        return ERR_CODE_SOCKET_CREATE;
+#elif defined(_MSC_VER) || defined(__MINGW32__)
     onPayloadListenSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
     if (onPayloadListenSocket == INVALID_SOCKET)
         return ERR_CODE_SOCKET_CREATE;
@@ -153,10 +177,10 @@ int TcpUdpV4Bridge::openSockets()
     struct sockaddr_in srvAddr { AF_INET, 0, 0 };
     if (a.empty() || a == "*")
         srvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-    else
-        r = inet_pton(AF_INET, a.c_str(), &srvAddr.sin_addr);
-    if (r)
-        return ERR_CODE_SOCKET_ADDRESS;
+    else {
+        if (inet_pton(AF_INET, a.c_str(), &srvAddr.sin_addr) != 1)
+            return ERR_CODE_SOCKET_ADDRESS;
+    }
     if (port == 0)
         port = DEF_PORT;
     srvAddr.sin_port = htons(port);
@@ -227,7 +251,9 @@ void TcpUdpV4Bridge::closeOnPayloadSocket()
 {
     if (onPayloadListenSocket != INVALID_SOCKET) {
         close(onPayloadListenSocket);
+#ifndef TCP_UDP_BRIDGE_EPOLL
         unlink(onPayloadSocketPath.c_str());
+#endif
         onPayloadListenSocket = INVALID_SOCKET;
     }
 
@@ -252,6 +278,14 @@ void TcpUdpV4Bridge::closeSockets()
 
 int TcpUdpV4Bridge::start()
 {
+#ifdef TCP_UDP_BRIDGE_EPOLL
+    // allow up to DEF_MAX_CONNECTIONS sockets if hard limit permits
+    struct rlimit rl {};
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < DEF_MAX_CONNECTIONS + 16) {
+        rl.rlim_cur = rl.rlim_max < DEF_MAX_CONNECTIONS + 16 ? rl.rlim_max : DEF_MAX_CONNECTIONS + 16;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+#endif
     int r = openSockets();
     if (r)
         return r;
@@ -350,13 +384,13 @@ public:
         InAddrPort oldestKey;
         bool removed = false;
         for (auto a(udpClientAddress.begin()); a != udpClientAddress.end();) {
-            if (a->second.t > expTime) {
+            if (a->second.t < expTime) {
                 removeOldest = false; // element deleted, so do not delete extra items
                 a = udpClientAddress.erase(a);
                 removed = true;
                 continue;
             }
-            if (removeOldest && (a->second.t > oldest)) {
+            if (removeOldest && (oldest == 0 || a->second.t < oldest)) {
                 oldest = a->second.t;
                 oldestKey = a->first;
             }
@@ -412,8 +446,251 @@ public:
         return count;
     }
 
+#ifdef TCP_UDP_BRIDGE_EPOLL
+    /**
+     * Send to all UDP clients by sendmmsg() in batches of UDP_BATCH_SIZE messages
+     * @param socket UDP socket
+     * @param message message buffer
+     * @param size message buffer size
+     * @return count of successfully sent messages
+     */
+    size_t send2allBatch(
+        SOCKET socket,
+        void *message,
+        size_t size
+    ) {
+        struct iovec iov { message, size };
+        struct mmsghdr msgs[UDP_BATCH_SIZE];
+        InAddrPort keys[UDP_BATCH_SIZE];
+        size_t count = 0;
+        auto a(udpClientAddress.begin());
+        while (a != udpClientAddress.end()) {
+            int n = 0;
+            for (; n < UDP_BATCH_SIZE && a != udpClientAddress.end(); n++, a++) {
+                memset(&msgs[n], 0, sizeof(struct mmsghdr));
+                msgs[n].msg_hdr.msg_name = &a->second.addr;
+                msgs[n].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+                msgs[n].msg_hdr.msg_iov = &iov;
+                msgs[n].msg_hdr.msg_iovlen = 1;
+                keys[n] = a->first;
+            }
+            int sent = 0;
+            while (sent < n) {
+                int r = sendmmsg(socket, msgs + sent, n - sent, MSG_DONTWAIT);
+                if (r > 0) {
+                    sent += r;
+                    count += r;
+                    continue;
+                }
+                if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    break;  // socket buffer is full, skip the rest of batch
+                // smth wrong with this client, remove client address from the list
+                udpClientAddress.erase(keys[sent]);
+                sent++;
+            }
+        }
+        return count;
+    }
+#endif
+
 };
 
+#ifdef TCP_UDP_BRIDGE_EPOLL
+
+class TcpClient {
+public:
+    std::string out;    ///< bytes waiting for the socket
+    size_t offset;      ///< already sent bytes of out
+    TcpClient()
+        : offset(0)
+    {
+    }
+
+    size_t pending() const {
+        return out.size() - offset;
+    }
+
+    void append(
+        const std::string &message
+    ) {
+        // reclaim sent bytes
+        if (offset > 0 && offset >= out.size() / 2) {
+            out.erase(0, offset);
+            offset = 0;
+        }
+        out.append(message);
+    }
+
+    /**
+     * Send buffered bytes until socket buffer is full
+     * @param socket non-blocking client socket
+     * @return false if socket must be closed
+     */
+    bool flush(
+        SOCKET socket
+    ) {
+        while (pending()) {
+            ssize_t n = send(socket, out.c_str() + offset, pending(), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            offset += n;
+        }
+        out.clear();
+        offset = 0;
+        return true;
+    }
+};
+
+static void epollSet(
+    int epollFd,
+    int op,
+    SOCKET socket,
+    uint32_t events
+)
+{
+    struct epoll_event ev {};
+    ev.events = events;
+    ev.data.fd = socket;
+    epoll_ctl(epollFd, op, socket, &ev);
+}
+
+void TcpUdpV4Bridge::run()
+{
+    int epollFd = epoll_create1(0);
+    // accept all pending connections without blocking
+    fcntl(tcpListenSocket, F_SETFL, fcntl(tcpListenSocket, F_GETFL, 0) | O_NONBLOCK);
+    epollSet(epollFd, EPOLL_CTL_ADD, tcpListenSocket, EPOLLIN);
+    epollSet(epollFd, EPOLL_CTL_ADD, udpSocket, EPOLLIN);
+    epollSet(epollFd, EPOLL_CTL_ADD, onPayloadListenSocket, EPOLLIN);
+
+    std::map<SOCKET, TcpClient> tcpClients;
+    UdpClients udpClients(DEF_MAX_UDP_CONNECTION_EXPIRATION_SECONDS);
+    auto closeClient = [epollFd, &tcpClients] (std::map<SOCKET, TcpClient>::iterator it) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, it->first, nullptr);
+        close(it->first);
+        return tcpClients.erase(it);
+    };
+
+    struct epoll_event events[EPOLL_EVENTS_SIZE];
+    struct sockaddr_in clientAddr {AF_INET, 0, 0 };
+    socklen_t len;
+    char buffer[BUFFER_SIZE];
+    std::vector<std::string> messages;
+
+    while (running) {
+        int n = epoll_wait(epollFd, events, EPOLL_EVENTS_SIZE, 1000);
+        for (int i = 0; i < n; i++) {
+            SOCKET s = events[i].data.fd;
+            if (s == tcpListenSocket) {
+                // accept all pending connections
+                while (true) {
+                    len = sizeof(clientAddr);
+                    SOCKET c = accept4(tcpListenSocket, (struct sockaddr *) &clientAddr, &len, SOCK_NONBLOCK);
+                    if (c < 0)
+                        break;
+                    if (tcpClients.size() + udpClients.udpClientAddress.size() >= DEF_MAX_CONNECTIONS) {
+                        close(c);
+                        continue;
+                    }
+                    tcpClients[c];
+                    epollSet(epollFd, EPOLL_CTL_ADD, c, EPOLLIN);
+                }
+                continue;
+            }
+            if (s == udpSocket) {
+                while (true) {
+                    len = sizeof(clientAddr);
+                    ssize_t r = recvfrom(udpSocket, buffer, sizeof(buffer), MSG_DONTWAIT,
+                        (struct sockaddr *) &clientAddr, &len);
+                    if (r < 0)
+                        break;
+                    udpClients.push(clientAddr,
+                        tcpClients.size() + udpClients.udpClientAddress.size() >= DEF_MAX_CONNECTIONS);
+                    parseNsend2device((const char *) buffer, r);
+                }
+                continue;
+            }
+            if (s == onPayloadListenSocket) {
+                uint64_t v;
+                if (read(onPayloadListenSocket, &v, sizeof(v)) < 0)
+                    continue;
+                {
+                    std::lock_guard<std::mutex> lock(outboxMutex);
+                    messages.swap(outbox);
+                }
+                for (auto &m : messages) {
+                    // TCP clients
+                    for (auto it(tcpClients.begin()); it != tcpClients.end();) {
+                        TcpClient &c = it->second;
+                        if (c.pending() + m.size() > DEF_MAX_CLIENT_BUFFER_SIZE) {
+                            // slow client
+                            droppedCount++;
+                            if (slowClientPolicy == TUB_POLICY_DISCONNECT)
+                                it = closeClient(it);
+                            else
+                                it++;
+                            continue;
+                        }
+                        bool wasEmpty = c.pending() == 0;
+                        c.append(m);
+                        if (wasEmpty) {
+                            if (!c.flush(it->first)) {
+                                it = closeClient(it);
+                                continue;
+                            }
+                            // wait until socket is writable
+                            if (c.pending())
+                                epollSet(epollFd, EPOLL_CTL_MOD, it->first, EPOLLIN | EPOLLOUT);
+                        }
+                        it++;
+                    }
+                    // UDP clients
+                    udpClients.send2allBatch(udpSocket, (void *) m.c_str(), m.size());
+                }
+                messages.clear();
+                continue;
+            }
+            // client's TCP connection
+            auto it = tcpClients.find(s);
+            if (it == tcpClients.end())
+                continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeClient(it);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                if (!it->second.flush(s)) {
+                    closeClient(it);
+                    continue;
+                }
+                if (!it->second.pending())
+                    epollSet(epollFd, EPOLL_CTL_MOD, s, EPOLLIN);
+            }
+            if (events[i].events & EPOLLIN) {
+                ssize_t r = read(s, buffer, sizeof(buffer));
+                if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    continue;
+                if (r <= 0) {
+                    // error or connection closed by client
+                    closeClient(it);
+                    continue;
+                }
+                parseNsend2device((const char *) buffer, r);
+            }
+        }
+    }
+    for (auto it(tcpClients.begin()); it != tcpClients.end();) {
+        it = closeClient(it);
+    }
+    close(epollFd);
+    stopped = true;
+}
+
+#else
+
 void TcpUdpV4Bridge::run()
 {
     fd_set rset;
@@ -537,6 +814,8 @@ void TcpUdpV4Bridge::run()
     stopped = true;
 }
 
+#endif
+
 void TcpUdpV4Bridge::onPayload(
     const void *dispatcher,
     const MessageQueueItem *messageItem,
@@ -545,7 +824,7 @@ void TcpUdpV4Bridge::onPayload(
 )
 {
     if (messageItem) {
-        if (onPayloadClientSocket >= 0) {
+        if (onPayloadListenSocket != INVALID_SOCKET) {
             std::string s = messageItem->toJsonString();
             // remove "{"
             s.erase(0, 1);
@@ -554,18 +833,40 @@ void TcpUdpV4Bridge::onPayload(
             ss << "{\"payloadDecoded\": " << (decoded ? "true" : "false")
                 << ", \"payloadMicMatched\": " << (micMatched ? "true" : "false")
                 << ", " << s;
-            s = ss.str();
-            auto sz = s.size();
-            // Invalid in WIndows- it does not work with sockets
-            // ssize_t bytes = (ssize_t) write((SOCKET) onPayloadClientSocket, (const char *) s.c_str(), (int) sz);
-            ssize_t bytes = (ssize_t) send(onPayloadClientSocket, (const char *) s.c_str(), (int) sz, 0);
-            if (bytes < sz) {
-                std::cerr << "Error write " << bytes << ", errno: " << errno << std::endl;
-            }
+            relay(ss.str());
         }
     }
 }
 
+void TcpUdpV4Bridge::relay(
+    const std::string &message
+)
+{
+#ifdef TCP_UDP_BRIDGE_EPOLL
+    {
+        std::lock_guard<std::mutex> lock(outboxMutex);
+        if (outbox.size() >= DEF_MAX_OUTBOX_SIZE) {
+            // loop does not keep up
+            droppedCount++;
+            return;
+        }
+        outbox.push_back(message);
+    }
+    // wake up loop
+    uint64_t v = 1;
+    if (write(onPayloadListenSocket, &v, sizeof(v)) < 0)
+        std::cerr << "Error write eventfd, errno: " << errno << std::endl;
+#else
+    auto sz = message.size();
+    // Invalid in WIndows- it does not work with sockets
+    // ssize_t bytes = (ssize_t) write((SOCKET) onPayloadClientSocket, (const char *) s.c_str(), (int) sz);
+    ssize_t bytes = (ssize_t) send(onPayloadClientSocket, (const char *) message.c_str(), (int) sz, 0);
+    if (bytes < sz) {
+        std::cerr << "Error write " << bytes << ", errno: " << errno << std::endl;
+    }
+#endif
+}
+
 int TcpUdpV4Bridge::init(
     const std::string& option,
     const std::string& option2,
@@ -590,7 +891,7 @@ void TcpUdpV4Bridge::onSend(
 )
 {
     if (item) {
-        if (onPayloadClientSocket >= 0) {
+        if (onPayloadListenSocket != INVALID_SOCKET) {
             std::string s = item->toJsonString();
             // remove "{"
             s.erase(0, 1);
@@ -598,8 +899,7 @@ void TcpUdpV4Bridge::onSend(
             std::stringstream ss;
             ss << "{\"sendingResultCode\": " << code
                << ", " << s;
-            s = ss.str();
-            write((SOCKET) onPayloadClientSocket, (const char *) s.c_str(), (int) s.size());
+            relay(ss.str());
         }
     }
 
@@ -610,6 +910,18 @@ const char *TcpUdpV4Bridge::name()
     return APP_BRIDGE_NAME;
 }
 
+void TcpUdpV4Bridge::setSlowClientPolicy(
+    TCP_UDP_BRIDGE_SLOW_CLIENT_POLICY policy
+)
+{
+    slowClientPolicy = policy;
+}
+
+size_t TcpUdpV4Bridge::dropped() const
+{
+    return droppedCount;
+}
+
 size_t TcpUdpV4Bridge::parseNsend2device(
     const char *expression,
     size_t size
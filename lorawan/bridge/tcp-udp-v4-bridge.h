@@ -3,10 +3,17 @@
 
 /**
  * The application bridge example shows how to implement a TCP/UDP service.
- * Clients (up to 1010 in number) can connect to any network interface on port 4250 (the default port number).
+ * Clients (up to 1010 in number, up to 65536 in Linux) can connect to any network interface on port 4250 (the default port number).
  * If the first parameter of init() is empty, the bridge listens on all interfaces on port 4250.
  *
- * Files:
+ * Linux:
+ *      epoll() loop, payloads are passed from the dispatcher to the loop through in-memory queue and eventfd.
+ *      Each TCP client has its own output buffer (up to 256K), slow TCP client does not block others.
+ *      If client's buffer is full, new payloads are dropped for this client (TUB_POLICY_DROP, default)
+ *      or client is disconnected (TUB_POLICY_DISCONNECT), see setSlowClientPolicy().
+ *      UDP clients receive payloads by sendmmsg() in batches.
+ *
+ * Other systems, files:
  *      Unix socket "/tmp/tcp-udp-v4-bridge.socket" used internally to route payload from the gateway(s) to clients.
  * You can change Unix socket file name in second parameter of init()
  *
@@ -39,12 +46,24 @@
 #include <string>
 #include <cinttypes>
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
 
 #if defined(_MSC_VER) || defined(__MINGW32__)
 #else
 typedef int SOCKET;
 #endif
 
+#if defined(__linux__)
+#define TCP_UDP_BRIDGE_EPOLL    1
+#endif
+
+typedef enum {
+    TUB_POLICY_DROP = 0,        ///< drop payload for the slow TCP client
+    TUB_POLICY_DISCONNECT = 1   ///< disconnect slow TCP client
+} TCP_UDP_BRIDGE_SLOW_CLIENT_POLICY;
+
 class TcpUdpV4Bridge : public AppBridge {
 private:
     SOCKET tcpListenSocket;
@@ -57,6 +76,12 @@ private:
     std::thread *thread;
     bool running;
     bool stopped;
+    TCP_UDP_BRIDGE_SLOW_CLIENT_POLICY slowClientPolicy;
+    std::atomic<size_t> droppedCount;
+#ifdef TCP_UDP_BRIDGE_EPOLL
+    std::mutex outboxMutex;
+    std::vector<std::string> outbox;    ///< payloads waiting for the loop
+#endif
     int openOnPayloadSocket();
     void closeOnPayloadSocket();
     int openSockets();
@@ -65,6 +90,13 @@ private:
     int start();
     void stop();
     void run();
+    /**
+     * Pass message to the loop thread
+     * @param message JSON string
+     */
+    void relay(
+        const std::string &message
+    );
 
     /**
      * Parse received command: ("ping" or "send") and send to den-device payload/FOpts by address(es)
@@ -110,6 +142,19 @@ public:
     ) override;
 
     const char *name() override;
+
+    /**
+     * Set what to do if TCP client does not read payloads fast enough
+     * @param policy TUB_POLICY_DROP or TUB_POLICY_DISCONNECT
+     */
+    void setSlowClientPolicy(
+        TCP_UDP_BRIDGE_SLOW_CLIENT_POLICY policy
+    );
+
+    /**
+     * @return count of payloads dropped for slow TCP clients or if loop queue is full
+     */
+    size_t dropped() const;
 };
 
 EXPORT_SHARED_C_FUNC AppBridge* makeBridge3();
@@ -23,7 +23,7 @@ void DownlinkByTimer::run()
         if (index >= identities.size())
             index = 0;
         else {
-            TASK_TIME timeNow = std::chrono::system_clock::now();
+            TASK_TIME timeNow = TASK_CLOCK::now();
             DEVADDR devAddr = identities[index].value.devaddr;
 
             std::string s = getPassphrase();
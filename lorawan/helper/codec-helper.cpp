@@ -0,0 +1,534 @@
+#include "lorawan/helper/codec-helper.h"
+#include "lorawan/lorawan-error.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(ESP_PLATFORM)
+#define CODEC_X86
+#include <immintrin.h>
+#define TARGET_SSSE3 __attribute__((target("ssse3,sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+static const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char HEX_ALPHABET[] = "0123456789abcdef";
+
+// standard and URL-safe alphabet, -1- invalid character
+static const int8_t BASE64_DECODE[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, 62, -1, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, 63,
+    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+static const int8_t HEX_DECODE[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+static int detectCodecLevel()
+{
+#ifdef CODEC_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return CODEC_LEVEL_AVX2;
+    if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1"))
+        return CODEC_LEVEL_SSSE3;
+#endif
+    return CODEC_LEVEL_SCALAR;
+}
+
+// zero (scalar) until static initialization is done
+static int maxCodecLevel = detectCodecLevel();
+static int currentCodecLevel = maxCodecLevel;
+
+/*
+ * Bulk functions process whole blocks only and return count of source bytes (characters) processed,
+ * the rest is done by the scalar code.
+ * SIMD base64 follows W. Muła, D. Lemire "Faster Base64 Encoding and Decoding Using AVX2 Instructions"
+ * @see https://arxiv.org/abs/1704.00605
+ */
+
+#ifdef CODEC_X86
+
+TARGET_SSSE3 static inline __m128i base64EncodeReshuffle128(
+    __m128i in
+)
+{
+    // 12 bytes -> 16 6-bit indices
+    in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+TARGET_SSSE3 static inline __m128i base64EncodeTranslate128(
+    __m128i in
+)
+{
+    // offset to add for each range: A-Z, a-z, 0-9 (10 times), '+', '/'
+    const __m128i lut = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    __m128i indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+    indices = _mm_sub_epi8(indices, _mm_cmpgt_epi8(in, _mm_set1_epi8(25)));
+    return _mm_add_epi8(in, _mm_shuffle_epi8(lut, indices));
+}
+
+TARGET_SSSE3 static size_t base64EncodeSSSE3(
+    char *retVal,
+    const uint8_t *data,
+    size_t size
+)
+{
+    size_t i = 0;
+    // 16 bytes loaded, 12 used
+    for (; i + 16 <= size; i += 12) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+        v = base64EncodeTranslate128(base64EncodeReshuffle128(v));
+        _mm_storeu_si128((__m128i *) retVal, v);
+        retVal += 16;
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t base64EncodeAVX2(
+    char *retVal,
+    const uint8_t *data,
+    size_t size
+)
+{
+    const __m256i shuffle = _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i lut = _mm256_setr_epi8(
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    size_t i = 0;
+    // each 128-bit lane takes 12 bytes
+    for (; i + 28 <= size; i += 24) {
+        __m256i in = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) (data + i))),
+            _mm_loadu_si128((const __m128i *) (data + i + 12)), 1);
+        in = _mm256_shuffle_epi8(in, shuffle);
+        const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        in = _mm256_or_si256(t1, t3);
+        __m256i indices = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+        indices = _mm256_sub_epi8(indices, _mm256_cmpgt_epi8(in, _mm256_set1_epi8(25)));
+        in = _mm256_add_epi8(in, _mm256_shuffle_epi8(lut, indices));
+        _mm256_storeu_si256((__m256i *) retVal, in);
+        retVal += 32;
+    }
+    // avoid AVX-SSE transition penalty, compiler does not insert it for the target attribute functions
+    _mm256_zeroupper();
+    return i + base64EncodeSSSE3(retVal, data + i, size - i);
+}
+
+/**
+ * Translate 16 characters to 6-bit values
+ * @param v characters, 6-bit values if valid
+ * @return false if invalid character found
+ */
+TARGET_SSSE3 static inline bool base64DecodeTranslate128(
+    __m128i &v
+)
+{
+    const __m128i lutLo = _mm_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lutHi = _mm_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+    const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(v, 4), mask2F);
+    const __m128i lo = _mm_shuffle_epi8(lutLo, _mm_and_si128(v, mask2F));
+    const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())))
+        return false;
+    const __m128i eq2F = _mm_cmpeq_epi8(v, mask2F);
+    v = _mm_add_epi8(v, _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles)));
+    return true;
+}
+
+TARGET_SSSE3 static size_t base64DecodeSSSE3(
+    uint8_t *retVal,
+    size_t retSize,
+    const char *data,
+    size_t size
+)
+{
+    size_t i = 0;
+    // 16 bytes stored, 12 used
+    for (; i + 16 <= size && retSize >= 16; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+        // padding, URL-safe or invalid characters are left to the scalar code
+        if (!base64DecodeTranslate128(v))
+            break;
+        const __m128i ab = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+        v = _mm_madd_epi16(ab, _mm_set1_epi32(0x00011000));
+        v = _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128((__m128i *) retVal, v);
+        retVal += 12;
+        retSize -= 12;
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t base64DecodeAVX2(
+    uint8_t *retVal,
+    size_t retSize,
+    const char *data,
+    size_t size
+)
+{
+    const __m256i lutLo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lutHi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i pack = _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i mask2F = _mm256_set1_epi8(0x2F);
+    size_t i = 0;
+    // 32 bytes stored, 24 used
+    for (; i + 32 <= size && retSize >= 32; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (data + i));
+        const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask2F);
+        const __m256i lo = _mm256_shuffle_epi8(lutLo, _mm256_and_si256(v, mask2F));
+        const __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256())))
+            break;
+        const __m256i eq2F = _mm256_cmpeq_epi8(v, mask2F);
+        v = _mm256_add_epi8(v, _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2F, hiNibbles)));
+        const __m256i ab = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        v = _mm256_madd_epi16(ab, _mm256_set1_epi32(0x00011000));
+        v = _mm256_shuffle_epi8(v, pack);
+        // 12 bytes from each lane
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+        _mm256_storeu_si256((__m256i *) retVal, v);
+        retVal += 24;
+        retSize -= 24;
+    }
+    _mm256_zeroupper();
+    return i + base64DecodeSSSE3(retVal, retSize, data + i, size - i);
+}
+
+TARGET_SSSE3 static size_t hexEncodeSSSE3(
+    char *retVal,
+    const uint8_t *data,
+    size_t size
+)
+{
+    const __m128i lut = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+        '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+        const __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        const __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, mask));
+        _mm_storeu_si128((__m128i *) (retVal + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *) (retVal + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t hexEncodeAVX2(
+    char *retVal,
+    const uint8_t *data,
+    size_t size
+)
+{
+    const __m256i lut = _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+        '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+        '0', '1', '2', '3', '4', '5', '6', '7',
+        '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *) (data + i));
+        const __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+        const __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, mask));
+        // unpack works within lanes: lo has bytes 0-7, 16-23, hi has 8-15, 24-31
+        const __m256i l = _mm256_unpacklo_epi8(hi, lo);
+        const __m256i h = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i *) (retVal + 2 * i), _mm256_permute2x128_si256(l, h, 0x20));
+        _mm256_storeu_si256((__m256i *) (retVal + 2 * i + 32), _mm256_permute2x128_si256(l, h, 0x31));
+    }
+    _mm256_zeroupper();
+    return i + hexEncodeSSSE3(retVal + 2 * i, data + i, size - i);
+}
+
+TARGET_SSSE3 static size_t hexDecodeSSSE3(
+    uint8_t *retVal,
+    const char *data,
+    size_t size
+)
+{
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+        const __m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+        const __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+        const __m128i a = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        const __m128i isAlpha = _mm_cmpeq_epi8(_mm_min_epu8(a, _mm_set1_epi8(5)), a);
+        if (_mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) != 0xffff)
+            break;
+        const __m128i nibbles = _mm_or_si128(_mm_and_si128(isDigit, d),
+            _mm_and_si128(isAlpha, _mm_add_epi8(a, _mm_set1_epi8(10))));
+        // high nibble * 16 + low nibble
+        const __m128i w = _mm_maddubs_epi16(nibbles, _mm_set1_epi16(0x0110));
+        _mm_storel_epi64((__m128i *) (retVal + i / 2), _mm_packus_epi16(w, w));
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t hexDecodeAVX2(
+    uint8_t *retVal,
+    const char *data,
+    size_t size
+)
+{
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *) (data + i));
+        const __m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+        const __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+        const __m256i a = _mm256_sub_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+        const __m256i isAlpha = _mm256_cmpeq_epi8(_mm256_min_epu8(a, _mm256_set1_epi8(5)), a);
+        if (_mm256_movemask_epi8(_mm256_or_si256(isDigit, isAlpha)) != -1)
+            break;
+        const __m256i nibbles = _mm256_or_si256(_mm256_and_si256(isDigit, d),
+            _mm256_and_si256(isAlpha, _mm256_add_epi8(a, _mm256_set1_epi8(10))));
+        const __m256i w = _mm256_maddubs_epi16(nibbles, _mm256_set1_epi16(0x0110));
+        // 8 bytes in the low half of each lane
+        const __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi16(w, w), 0xD8);
+        _mm_storeu_si128((__m128i *) (retVal + i / 2), _mm256_castsi256_si128(p));
+    }
+    _mm256_zeroupper();
+    return i + hexDecodeSSSE3(retVal + i / 2, data + i, size - i);
+}
+
+#endif
+
+size_t base64Encode(
+    char *retVal,
+    const void *data,
+    size_t size
+)
+{
+    auto src = (const uint8_t *) data;
+    size_t i = 0;
+    char *o = retVal;
+#ifdef CODEC_X86
+    switch (currentCodecLevel) {
+        case CODEC_LEVEL_AVX2:
+            i = base64EncodeAVX2(o, src, size);
+            break;
+        case CODEC_LEVEL_SSSE3:
+            i = base64EncodeSSSE3(o, src, size);
+            break;
+        default:
+            break;
+    }
+    o += i / 3 * 4;
+#endif
+    for (; i + 3 <= size; i += 3) {
+        uint32_t v = ((uint32_t) src[i] << 16) | ((uint32_t) src[i + 1] << 8) | src[i + 2];
+        o[0] = BASE64_ALPHABET[v >> 18];
+        o[1] = BASE64_ALPHABET[(v >> 12) & 0x3f];
+        o[2] = BASE64_ALPHABET[(v >> 6) & 0x3f];
+        o[3] = BASE64_ALPHABET[v & 0x3f];
+        o += 4;
+    }
+    if (i < size) {
+        uint32_t v = (uint32_t) src[i] << 16;
+        if (i + 1 < size)
+            v |= (uint32_t) src[i + 1] << 8;
+        o[0] = BASE64_ALPHABET[v >> 18];
+        o[1] = BASE64_ALPHABET[(v >> 12) & 0x3f];
+        o[2] = i + 1 < size ? BASE64_ALPHABET[(v >> 6) & 0x3f] : '=';
+        o[3] = '=';
+        o += 4;
+    }
+    return o - retVal;
+}
+
+int base64Decode(
+    void *retVal,
+    size_t retSize,
+    const char *data,
+    size_t size
+)
+{
+    // up to 2 padding characters
+    for (int p = 0; p < 2 && size && (data[size - 1] == '=' || data[size - 1] == '.'); p++) {
+        size--;
+    }
+    size_t rest = size % 4;
+    if (rest == 1)
+        return ERR_CODE_INVALID_BASE64;
+    size_t r = size / 4 * 3 + (rest ? rest - 1 : 0);
+    if (r > retSize)
+        return ERR_CODE_INVALID_BUFFER_SIZE;
+    auto o = (uint8_t *) retVal;
+    size_t i = 0;
+#ifdef CODEC_X86
+    switch (currentCodecLevel) {
+        case CODEC_LEVEL_AVX2:
+            i = base64DecodeAVX2(o, retSize, data, size);
+            break;
+        case CODEC_LEVEL_SSSE3:
+            i = base64DecodeSSSE3(o, retSize, data, size);
+            break;
+        default:
+            break;
+    }
+    o += i / 4 * 3;
+#endif
+    auto s = (const uint8_t *) data;
+    for (; i + 4 <= size; i += 4) {
+        int8_t a = BASE64_DECODE[s[i]], b = BASE64_DECODE[s[i + 1]], c = BASE64_DECODE[s[i + 2]], d = BASE64_DECODE[s[i + 3]];
+        if ((a | b | c | d) < 0)
+            return ERR_CODE_INVALID_BASE64;
+        uint32_t v = ((uint32_t) a << 18) | ((uint32_t) b << 12) | ((uint32_t) c << 6) | (uint32_t) d;
+        o[0] = (uint8_t) (v >> 16);
+        o[1] = (uint8_t) (v >> 8);
+        o[2] = (uint8_t) v;
+        o += 3;
+    }
+    if (rest) {
+        int8_t a = BASE64_DECODE[s[i]], b = BASE64_DECODE[s[i + 1]], c = rest > 2 ? BASE64_DECODE[s[i + 2]] : 0;
+        if ((a | b | c) < 0)
+            return ERR_CODE_INVALID_BASE64;
+        uint32_t v = ((uint32_t) a << 18) | ((uint32_t) b << 12) | ((uint32_t) c << 6);
+        *o++ = (uint8_t) (v >> 16);
+        if (rest > 2)
+            *o++ = (uint8_t) (v >> 8);
+    }
+    return (int) r;
+}
+
+size_t hexEncode(
+    char *retVal,
+    const void *data,
+    size_t size
+)
+{
+    auto src = (const uint8_t *) data;
+    size_t i = 0;
+#ifdef CODEC_X86
+    switch (currentCodecLevel) {
+        case CODEC_LEVEL_AVX2:
+            i = hexEncodeAVX2(retVal, src, size);
+            break;
+        case CODEC_LEVEL_SSSE3:
+            i = hexEncodeSSSE3(retVal, src, size);
+            break;
+        default:
+            break;
+    }
+#endif
+    for (; i < size; i++) {
+        retVal[2 * i] = HEX_ALPHABET[src[i] >> 4];
+        retVal[2 * i + 1] = HEX_ALPHABET[src[i] & 0xf];
+    }
+    return size * 2;
+}
+
+int hexDecode(
+    void *retVal,
+    size_t retSize,
+    const char *data,
+    size_t size
+)
+{
+    if (size % 2)
+        return ERR_CODE_PARAM_INVALID;
+    if (size / 2 > retSize)
+        return ERR_CODE_INVALID_BUFFER_SIZE;
+    auto o = (uint8_t *) retVal;
+    size_t i = 0;
+#ifdef CODEC_X86
+    switch (currentCodecLevel) {
+        case CODEC_LEVEL_AVX2:
+            i = hexDecodeAVX2(o, data, size);
+            break;
+        case CODEC_LEVEL_SSSE3:
+            i = hexDecodeSSSE3(o, data, size);
+            break;
+        default:
+            break;
+    }
+#endif
+    auto s = (const uint8_t *) data;
+    for (; i < size; i += 2) {
+        int8_t hi = HEX_DECODE[s[i]], lo = HEX_DECODE[s[i + 1]];
+        if ((hi | lo) < 0)
+            return ERR_CODE_PARAM_INVALID;
+        o[i / 2] = (uint8_t) ((hi << 4) | lo);
+    }
+    return (int) (size / 2);
+}
+
+int codecLevel()
+{
+    return currentCodecLevel;
+}
+
+int setCodecLevel(
+    int level
+)
+{
+    if (level < CODEC_LEVEL_SCALAR)
+        level = CODEC_LEVEL_SCALAR;
+    if (level > maxCodecLevel)
+        level = maxCodecLevel;
+    currentCodecLevel = level;
+    return currentCodecLevel;
+}
+
+const char *codecLevelName(
+    int level
+)
+{
+    switch (level) {
+        case CODEC_LEVEL_SSSE3:
+            return "ssse3";
+        case CODEC_LEVEL_AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef LORAWAN_CODEC_HELPER_H
+#define LORAWAN_CODEC_HELPER_H
+
+#include <cstddef>
+#include <cinttypes>
+
+/**
+ * Base64 and hex encoders/decoders writing to the caller's buffer.
+ * On x86 built by GCC or Clang, SSSE3/SSE4.1 or AVX2 code is selected at runtime by CPUID,
+ * otherwise (ARM, ESP32, MSVC) scalar table code is used.
+ * Decoders accept standard and URL-safe base64 alphabets, '=' or '.' padding, upper and lower case hex.
+ */
+
+#define CODEC_LEVEL_SCALAR  0
+#define CODEC_LEVEL_SSSE3   1
+#define CODEC_LEVEL_AVX2    2
+
+// base64 characters required for size bytes
+#define BASE64_ENCODED_SIZE(size)   ((((size) + 2) / 3) * 4)
+// max bytes decoded from size base64 characters
+#define BASE64_DECODED_SIZE(size)   ((((size) + 3) / 4) * 3)
+
+/**
+ * Encode to base64 with padding. Trailing zero is not written.
+ * @param retVal buffer at least BASE64_ENCODED_SIZE(size) characters
+ * @param data bytes to encode
+ * @param size bytes count
+ * @return characters written
+ */
+size_t base64Encode(
+    char *retVal,
+    const void *data,
+    size_t size
+);
+
+/**
+ * Decode base64
+ * @param retVal buffer
+ * @param retSize buffer size. BASE64_DECODED_SIZE(size) is always enough
+ * @param data base64 characters
+ * @param size characters count
+ * @return bytes written, ERR_CODE_INVALID_BASE64 or ERR_CODE_INVALID_BUFFER_SIZE
+ */
+int base64Decode(
+    void *retVal,
+    size_t retSize,
+    const char *data,
+    size_t size
+);
+
+/**
+ * Encode to lower case hex. Trailing zero is not written.
+ * @param retVal buffer at least size * 2 characters
+ * @param data bytes to encode
+ * @param size bytes count
+ * @return characters written
+ */
+size_t hexEncode(
+    char *retVal,
+    const void *data,
+    size_t size
+);
+
+/**
+ * Decode hex
+ * @param retVal buffer
+ * @param retSize buffer size, size / 2 is enough
+ * @param data hex characters
+ * @param size characters count, must be even
+ * @return bytes written, ERR_CODE_PARAM_INVALID or ERR_CODE_INVALID_BUFFER_SIZE
+ */
+int hexDecode(
+    void *retVal,
+    size_t retSize,
+    const char *data,
+    size_t size
+);
+
+/**
+ * @return CODEC_LEVEL_SCALAR, CODEC_LEVEL_SSSE3 or CODEC_LEVEL_AVX2 in use
+ */
+int codecLevel();
+
+/**
+ * Limit code used by encoders/decoders e.g. to compare with scalar code. Not thread safe.
+ * @param level CODEC_LEVEL_SCALAR, CODEC_LEVEL_SSSE3 or CODEC_LEVEL_AVX2. Level is limited to the CPU supported
+ * @return level in use
+ */
+int setCodecLevel(
+    int level
+);
+
+/**
+ * @param level CODEC_LEVEL_SCALAR, CODEC_LEVEL_SSSE3 or CODEC_LEVEL_AVX2
+ * @return "scalar", "ssse3" or "avx2"
+ */
+const char *codecLevelName(
+    int level
+);
+
+#endif
@@ -1,4 +1,6 @@
 #include <string>
+#include <algorithm>
+#include <cstring>
 
 #include "lorawan/lorawan-error.h"
 #include "lorawan/helper/lmdb-helper.h"
@@ -89,6 +91,97 @@ int processMapFull(
     return r;
 }
 
+/**
+ * Default LMDB key order
+ */
+static bool keyLess(
+    const MDB_val &a,
+    const MDB_val &b
+)
+{
+    int c = memcmp(a.mv_data, b.mv_data, a.mv_size < b.mv_size ? a.mv_size : b.mv_size);
+    if (c)
+        return c < 0;
+    return a.mv_size < b.mv_size;
+}
+
+int putRecords(
+    dbenv *env,
+    std::vector<std::pair<MDB_val, MDB_val>> &records
+)
+{
+    std::stable_sort(records.begin(), records.end(), [] (const std::pair<MDB_val, MDB_val> &a, const std::pair<MDB_val, MDB_val> &b) {
+        return keyLess(a.first, b.first);
+    });
+    // MDB_APPEND fails on the same key, keep last record
+    size_t n = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (n && !keyLess(records[n - 1].first, records[i].first))
+            records[n - 1] = records[i];
+        else
+            records[n++] = records[i];
+    }
+    records.resize(n);
+
+    int r = mdb_txn_begin(env->env, nullptr, 0, &env->txn);
+    if (r)
+        return ERR_CODE_LMDB_TXN_BEGIN;
+    for (;;) {
+        unsigned int flags = 0;
+        if (!records.empty()) {
+            MDB_cursor *cursor;
+            if (mdb_cursor_open(env->txn, env->dbi, &cursor) == MDB_SUCCESS) {
+                MDB_val lastKey;
+                MDB_val lastData;
+                int c = mdb_cursor_get(cursor, &lastKey, &lastData, MDB_LAST);
+                if (c == MDB_NOTFOUND || (c == MDB_SUCCESS && keyLess(lastKey, records[0].first)))
+                    flags = MDB_APPEND;
+                mdb_cursor_close(cursor);
+            }
+        }
+        for (auto &rec : records) {
+            MDB_val dbKey = rec.first;
+            MDB_val dbData = rec.second;
+            r = mdb_put(env->txn, env->dbi, &dbKey, &dbData, flags);
+            if (r)
+                break;
+        }
+        if (r != MDB_MAP_FULL)
+            break;
+        // abort transaction, increase map size, begin new transaction and start over
+        if (processMapFull(env))
+            return ERR_CODE_LMDB_FULL;
+    }
+    if (r) {
+        mdb_txn_abort(env->txn);
+        return ERR_CODE_LMDB_PUT;
+    }
+    if (mdb_txn_commit(env->txn))
+        return ERR_CODE_LMDB_TXN_COMMIT;
+    return CODE_OK;
+}
+
+int delRecords(
+    dbenv *env,
+    const std::vector<MDB_val> &keys
+)
+{
+    int r = mdb_txn_begin(env->env, nullptr, 0, &env->txn);
+    if (r)
+        return ERR_CODE_LMDB_TXN_BEGIN;
+    for (auto &key : keys) {
+        MDB_val dbKey = key;
+        r = mdb_del(env->txn, env->dbi, &dbKey, nullptr);
+        if (r && r != MDB_NOTFOUND) {
+            mdb_txn_abort(env->txn);
+            return ERR_CODE_LMDB_PUT;
+        }
+    }
+    if (mdb_txn_commit(env->txn))
+        return ERR_CODE_LMDB_TXN_COMMIT;
+    return CODE_OK;
+}
+
 /**
  * @brief Opens LMDB database file
  * @param env created LMDB environment(transaction, cursor)
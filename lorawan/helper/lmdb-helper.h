@@ -1,6 +1,8 @@
 #ifndef LMDB_HELPER_H
 #define LMDB_HELPER_H
 
+#include <string>
+#include <vector>
 #include "lmdb.h"
 
 /**
@@ -27,6 +29,31 @@ int processMapFull(
     dbenv *env
 );
 
+/**
+ * @brief Put records in one transaction.
+ * Records are sorted in the default key order (memcmp), the last record of the same key wins.
+ * If the first key is greater than the last key of the database, records are appended (MDB_APPEND)
+ * without page splits.
+ * @param env opened database
+ * @param records key and data pairs, sorted in place
+ * @return CODE_OK- success
+ */
+int putRecords(
+    dbenv *env,
+    std::vector<std::pair<MDB_val, MDB_val>> &records
+);
+
+/**
+ * @brief Delete records in one transaction, absent keys are skipped
+ * @param env opened database
+ * @param keys keys to delete
+ * @return CODE_OK- success
+ */
+int delRecords(
+    dbenv *env,
+    const std::vector<MDB_val> &keys
+);
+
 /**
  * @brief Opens LMDB database file
  * @param env created LMDB environment(transaction, cursor)
@@ -38,3 +38,24 @@ int rowCallback(
     }
     return 0;
 }
+
+int execStatement(
+    sqlite3 *db,
+    const char *statement
+)
+{
+    char *zErrMsg = nullptr;
+    int r = sqlite3_exec(db, statement, nullptr, nullptr, &zErrMsg);
+    if (zErrMsg)
+        sqlite3_free(zErrMsg);
+    return r;
+}
+
+int bindText(
+    sqlite3_stmt *stmt,
+    int column,
+    const std::string &value
+)
+{
+    return sqlite3_bind_text(stmt, column, value.c_str(), (int) value.size(), SQLITE_TRANSIENT);
+}
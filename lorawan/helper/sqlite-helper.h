@@ -1,6 +1,9 @@
 #ifndef SQLITE_HELPER_H
 #define SQLITE_HELPER_H
 
+#include <string>
+#include <sqlite3.h>
+
 int tableCallback(
     void *env,
     int columns,
@@ -15,4 +18,23 @@ int rowCallback(
     char **column
 );
 
+/**
+ * Execute statement without result set e.g. BEGIN, COMMIT or ROLLBACK
+ * @return SQLITE_OK- success
+ */
+int execStatement(
+    sqlite3 *db,
+    const char *statement
+);
+
+/**
+ * Bind copy of the string to the prepared statement parameter
+ * @param column 1..
+ */
+int bindText(
+    sqlite3_stmt *stmt,
+    int column,
+    const std::string &value
+);
+
 #endif //SQLITE_HELPER_H
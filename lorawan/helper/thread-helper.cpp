@@ -1,5 +1,5 @@
 /**
- * Set thread name
+ * Set thread name, pin thread to the CPU core
  * @see https://stackoverflow.com/questions/10121560/stdthread-naming-your-thread
  * @see https://learn.microsoft.com/ru-ru/previous-versions/visualstudio/visual-studio-2015/debugger/how-to-set-a-thread-name-in-native-code?view=vs-2015&redirectedfrom=MSDN
  */
@@ -56,9 +56,21 @@ void setThreadName(
 #endif
 }
 
+bool setThreadAffinity(
+    std::thread *thread,
+    int cpu
+)
+{
+    if (!thread || cpu < 0 || cpu >= (int) (sizeof(DWORD_PTR) * 8))
+        return false;
+    return SetThreadAffinityMask(static_cast<HANDLE>(thread->native_handle()), ((DWORD_PTR) 1) << cpu) != 0;
+}
+
 #else
 
 #include <pthread.h>
+#include <sched.h>
+
 void setThreadName(
     std::thread* thread,
     const char* threadName
@@ -68,4 +80,21 @@ void setThreadName(
     pthread_setname_np(handle,threadName);
 }
 
+bool setThreadAffinity(
+    std::thread* thread,
+    int cpu
+)
+{
+#if defined(__linux__) && !defined(__ANDROID__)
+    if (!thread || cpu < 0 || cpu >= CPU_SETSIZE)
+        return false;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return pthread_setaffinity_np(thread->native_handle(), sizeof(cpu_set_t), &cpus) == 0;
+#else
+    return false;
+#endif
+}
+
 #endif
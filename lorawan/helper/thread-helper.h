@@ -8,4 +8,15 @@ void setThreadName(
     const char* threadName
 );
 
+/**
+ * Pin thread to the CPU core
+ * @param thread thread
+ * @param cpu CPU core number, 0..
+ * @return true- success, false- not supported or invalid core number
+ */
+bool setThreadAffinity(
+    std::thread* thread,
+    int cpu
+);
+
 #endif
@@ -1,5 +1,4 @@
 #include "lorawan/lorawan-builder.h"
-#include "base64/base64.h"
 
 MessageBuilder::MessageBuilder(
     const TaskDescriptor &aTaskDescriptor
@@ -34,9 +33,17 @@ size_t MessageBuilder::size() const
 
 std::string MessageBuilder::base64() const
 {
-    char buffer[300];
+    char r[MAX_BUILDER_BASE64_SIZE];
+    return std::string(r, base64(r));
+}
+
+size_t MessageBuilder::base64(
+    char *retVal
+) const
+{
+    char buffer[MAX_BUILDER_MESSAGE_SIZE];
     auto sz = msg.toArray(buffer, sizeof(buffer), &taskDescriptor.deviceId);
-    return base64_encode(std::string(buffer, sz));
+    return base64Encode(retVal, buffer, sz);
 }
 
 ConfirmationMessage::ConfirmationMessage(
@@ -56,6 +63,20 @@ ConfirmationMessage::ConfirmationMessage(
     msg.data.downlink.f.ack = 1;
 }
 
+ConfirmationMessage::ConfirmationMessage(
+    const LORAWAN_MESSAGE_STORAGE &message2confirm,
+    const TaskDescriptor &taskDescriptor,
+    const void *fopts,
+    uint8_t foptsSize
+)
+    : ConfirmationMessage(message2confirm, taskDescriptor)
+{
+    if (fopts && foptsSize > 0 && foptsSize <= 15) {
+        msg.data.downlink.f.foptslen = foptsSize;
+        msg.data.downlink.setFOpts(fopts, foptsSize);
+    }
+}
+
 // DownlinkMessage (from the server to the end-device)
 
 DownlinkMessageBuilder::DownlinkMessageBuilder(
@@ -77,11 +98,25 @@ DownlinkMessageBuilder::DownlinkMessageBuilder(
     // payload
     msg.payloadSize = payloadSize;
     msg.data.downlink.devaddr = taskDescriptor.deviceId.devaddr;
-    msg.data.downlink.setFport(fport);
+    // FOpts first, FPort follows FOpts
     if (fopts && foptsSize > 0) {
         msg.data.downlink.setFOpts(fopts, foptsSize);
     }
+    msg.data.downlink.setFport(fport);
     if (payload && payloadSize > 0) {
         msg.data.downlink.setPayload(payload, payloadSize);
     }
 }
+
+// Join-accept (from the server to the end-device)
+
+JoinAcceptMessage::JoinAcceptMessage(
+    const TaskDescriptor &taskDescriptor,
+    const JOIN_ACCEPT_FRAME &encryptedFrame
+)
+    : MessageBuilder(taskDescriptor)
+{
+    msg.mhdr.f.mtype = MTYPE_JOIN_ACCEPT;
+    msg.data.joinResponse = encryptedFrame;
+    msg.payloadSize = 0;
+}
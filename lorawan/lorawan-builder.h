@@ -3,6 +3,10 @@
 
 #include "lorawan/lorawan-packet-storage.h"
 #include "lorawan/task/task-descriptor.h"
+#include "lorawan/helper/codec-helper.h"
+
+#define MAX_BUILDER_MESSAGE_SIZE    300
+#define MAX_BUILDER_BASE64_SIZE     BASE64_ENCODED_SIZE(MAX_BUILDER_MESSAGE_SIZE)
 
 class MessageBuilder {
 public:
@@ -13,6 +17,12 @@ public:
     size_t get(void *buffer, size_t size) const;
     size_t size() const;
     std::string base64() const;
+    /**
+     * Write base64 encoded message without trailing zero
+     * @param retVal buffer at least MAX_BUILDER_BASE64_SIZE characters
+     * @return characters written
+     */
+    size_t base64(char *retVal) const;
 };
 
 /**
@@ -24,6 +34,17 @@ public:
         const LORAWAN_MESSAGE_STORAGE &message2confirm,
         const TaskDescriptor &taskDescriptor
     );
+    /**
+     * Confirmation with MAC commands piggy-backed in FOpts
+     * @param fopts MAC commands, up to 15 bytes
+     * @param foptsSize
+     */
+    ConfirmationMessage(
+        const LORAWAN_MESSAGE_STORAGE &message2confirm,
+        const TaskDescriptor &taskDescriptor,
+        const void *fopts,
+        uint8_t foptsSize
+    );
 };
 
 /**
@@ -50,4 +71,19 @@ public:
     );
 };
 
+/**
+ * 6.2.3 Join-accept message. Frame must be already encrypted, MIC is a part of the encrypted frame.
+ */
+class JoinAcceptMessage : public MessageBuilder {
+public:
+    /**
+     * @param taskDescriptor. Provide task to reply to
+     * @param encryptedFrame Join-accept header and MIC encrypted by NwkKey
+     */
+    JoinAcceptMessage(
+        const TaskDescriptor &taskDescriptor,
+        const JOIN_ACCEPT_FRAME &encryptedFrame
+    );
+};
+
 #endif
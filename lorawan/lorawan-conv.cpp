@@ -115,7 +115,8 @@ void int2JOINNONCE(
     int value
 )
 {
-    uint32_t r = NTOH4(value);
+    // inverse of JOINNONCE2int(), little endian
+    auto r = (uint32_t) value;
     retVal.c[0] = r & 0xff;
     retVal.c[1] = (r >> 8) & 0xff;
     retVal.c[2] = (r >> 16) & 0xff;
@@ -126,7 +127,8 @@ void int2APPNONCE(
     int value
 )
 {
-    uint32_t r = NTOH4(value);
+    // inverse of JOINNONCE2int(), little endian
+    auto r = (uint32_t) value;
     retVal.c[0] = r & 0xff;
     retVal.c[1] = (r >> 8) & 0xff;
     retVal.c[2] = (r >> 16) & 0xff;
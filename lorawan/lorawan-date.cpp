@@ -314,7 +314,8 @@ std::string taskTime2string(
     const bool local
 )
 {
-    std::time_t t = std::chrono::system_clock::to_time_t(time);
+    auto wallTime = taskTime2systemTime(time);
+    std::time_t t = std::chrono::system_clock::to_time_t(wallTime);
     std::tm *tm;
     if (local)
         tm = std::localtime(&t);
@@ -325,7 +326,7 @@ std::string taskTime2string(
     ss << std::put_time(tm, dateformat_gmtoff);
 
     // add milliseconds
-    auto duration = time.time_since_epoch();
+    auto duration = wallTime.time_since_epoch();
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration) - std::chrono::duration_cast<std::chrono::seconds>(duration);
     ss << "." << std::setw(3) << std::setfill('0') << ms.count();
 
@@ -208,6 +208,9 @@
 #define ERR_CODE_LORA_GATEWAY_SPECTRAL_SCAN_RESULT          (-5180)
 #define ERR_CODE_STOPPED                                    (-5181)
 #define ERR_CODE_ACCESS_DENIED                              (-5182)
+#define ERR_CODE_CAPTURE_OPEN                               (-5183)
+#define ERR_CODE_CAPTURE_WRITE                              (-5184)
+#define ERR_CODE_SHM_RING_OPEN                              (-5185)
 
 const char *logLevelString(
     int logLevel
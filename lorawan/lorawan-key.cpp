@@ -2,7 +2,6 @@
 
 #include <cstring>
 #include "system/crypto/aes.h"
-#include "system/crypto/cmac.h"
 #include "lorawan/helper/aes-const.h"
 
 /**
@@ -19,15 +18,11 @@ static void deriveKeyBlock(
     size_t size
 )
 {
+    // key = aes128_encrypt(key, block), block is one 16 bytes block
     aes_context aesContext;
     memset(aesContext.ksch, '\0', KSCH_SIZE);
     aes_set_key(nwkKey.c, sizeof(KEY128), &aesContext);
-
-    AES_CMAC_CTX aesCmacCtx;
-    AES_CMAC_Init(&aesCmacCtx);
-    AES_CMAC_SetKey(&aesCmacCtx, nwkKey.c);
-    AES_CMAC_Update(&aesCmacCtx, (const uint8_t *) &value, (std::uint32_t) size);
-    AES_CMAC_Final(retval.c, &aesCmacCtx);
+    aes_encrypt((const uint8_t *) value, retval.c, &aesContext);
 }
 
 // The network session keys are derived from the NwkKey:
@@ -1353,11 +1353,11 @@ MacDataClientLinkADR::MacDataClientLinkADR(
 	isClientSide = false;
 	MAC_COMMAND_LINK_ADR_REQ *v = (MAC_COMMAND_LINK_ADR_REQ*) &command;
 	v->command = LinkADR;
-	v->data.txpower = 0xf;		// ignore, keep the current parameter value. 
-	v->data.datarate = 0;		// LoRa: SF12 / 125 kHz
-	v->data.chmask = 0xffff;	// all 16 channels
-	v->data.nbtans = 1;			// The default value is 1 corresponding to a single transmission of each frame. 
-	v->data.chmaskcntl = 0;		// 0- mask, 6- all channels ON
+	v->data.txpower = txpower;
+	v->data.datarate = datarate;
+	v->data.chmask = chmask;
+	v->data.nbtans = nbtans;
+	v->data.chmaskcntl = chmaskcntl;
 	v->data.rfu = 0;
 }
 
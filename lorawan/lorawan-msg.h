@@ -246,6 +246,9 @@
 #define ERR_LORA_GATEWAY_SPECTRAL_SCAN_RESULT           "Spectral scan request results failed"
 #define ERR_STOPPED                                     "Stopped"
 #define ERR_ACCESS_DENIED                               "Access denied"
+#define ERR_CAPTURE_OPEN                                "Open packet capture file failed"
+#define ERR_CAPTURE_WRITE                               "Write packet capture file failed"
+#define ERR_SHM_RING_OPEN                               "Create or map shared memory ring file failed"
 
 // Message en-us locale strings
 #define MSG_COLON_N_SPACE               ": "
@@ -1,12 +1,11 @@
 #include <cstring>
 #include <sstream>
-#include <stdexcept>
 
 #include "lorawan/lorawan-packet-storage.h"
 #include "lorawan/lorawan-string.h"
 #include "lorawan/helper/aes-helper.h"
 
-#include "base64/base64.h"
+#include "lorawan/helper/codec-helper.h"
 #include "lorawan-conv.h"
 #include "lorawan-mic.h"
 
@@ -59,12 +58,11 @@ bool base64SetToLORAWAN_MESSAGE_STORAGE(
     const std::string &base64string
 )
 {
-    try {
-        std::string s = base64_decode(base64string);
-        setLORAWAN_MESSAGE_STORAGE(retVal, (void *) s.c_str(), s.size());
-    } catch (std::runtime_error &) {
+    unsigned char buffer[sizeof(LORAWAN_MESSAGE_STORAGE)];
+    int sz = base64Decode(buffer, sizeof(buffer), base64string.c_str(), base64string.size());
+    if (sz < 0)
         return false;
-    }
+    setLORAWAN_MESSAGE_STORAGE(retVal, buffer, (size_t) sz);
     return true;
 }
 
@@ -138,7 +136,8 @@ size_t LORAWAN_MESSAGE_STORAGE::toArray(
             if (b && (size >= retSize)) {
                 memmove(b, &data.u, SIZE_JOIN_ACCEPT_FRAME);
             }
-            break;
+            // MIC is a part of the encrypted frame
+            return retSize;
         case MTYPE_UNCONFIRMED_DATA_UP:
         case MTYPE_CONFIRMED_DATA_UP:
             retSize += SIZE_UPLINK_EMPTY_STORAGE;  // 7 bytes
@@ -158,10 +157,10 @@ size_t LORAWAN_MESSAGE_STORAGE::toArray(
             break;
         case MTYPE_UNCONFIRMED_DATA_DOWN:
         case MTYPE_CONFIRMED_DATA_DOWN:
-            retSize += SIZE_DOWNLINK_EMPTY_STORAGE;  // 7 bytes
+            retSize += SIZE_DOWNLINK_EMPTY_STORAGE + data.downlink.f.foptslen;  // 7 bytes + FOpts
             if (b && (size >= retSize)) {
-                memmove(b, &data.downlink.devaddr.c, SIZE_DOWNLINK_EMPTY_STORAGE);
-                b += SIZE_DOWNLINK_EMPTY_STORAGE;
+                memmove(b, &data.downlink.devaddr.c, SIZE_DOWNLINK_EMPTY_STORAGE + data.downlink.f.foptslen);
+                b += SIZE_DOWNLINK_EMPTY_STORAGE + data.downlink.f.foptslen;
             }
             if (payloadSize) {
                 retSize += payloadSize + 1; // + FPort
@@ -424,15 +423,25 @@ const std::string LORAWAN_MESSAGE_STORAGE::foptsString() const {
     return "";
 }
 
+static std::string bytesBase64(
+    const void *payload,
+    size_t size
+)
+{
+    std::string r(BASE64_ENCODED_SIZE(size), '\0');
+    base64Encode(&r[0], payload, size);
+    return r;
+}
+
 std::string LORAWAN_MESSAGE_STORAGE::payloadBase64() const
 {
     switch ((MTYPE) mhdr.f.mtype) {
         case MTYPE_UNCONFIRMED_DATA_UP:
         case MTYPE_CONFIRMED_DATA_UP:
-            return base64_encode(std::string((char *) data.uplink.payload(), payloadSize));
+            return bytesBase64(data.uplink.payload(), payloadSize);
         case MTYPE_UNCONFIRMED_DATA_DOWN:
         case MTYPE_CONFIRMED_DATA_DOWN:
-            return base64_encode(std::string((char *) data.downlink.payload(), payloadSize));
+            return bytesBase64(data.downlink.payload(), payloadSize);
         default:
             break;
     }
@@ -10,6 +10,7 @@
 #include "lorawan/lorawan-date.h"
 #include "lorawan/lorawan-mac.h"
 #include "lorawan/lorawan-error.h"
+#include "lorawan/helper/codec-helper.h"
 
 #ifdef ENABLE_UNICODE
 #include <unicode/unistr.h>
@@ -100,48 +101,16 @@ bool isDec(
     ) == value.end();
 }
 
-// http://stackoverflow.com/questions/673240/how-do-i-print-an-unsigned-char-as-hex-in-c-using-ostream
-struct HexCharStruct
-{
-    unsigned char c;
-    explicit HexCharStruct(unsigned char _c) : c(_c) { }
-};
-
-inline std::ostream& operator<<(std::ostream& o, const HexCharStruct& hs)
-{
-    return (o << std::setfill('0') << std::setw(2) << std::hex << (int) hs.c);
-}
-
-inline HexCharStruct hex(
-        unsigned char c
-)
-{
-    return HexCharStruct(c);
-}
-
-static void bufferPrintHex(
-        std::ostream &ostream,
-        const void* value, size_t size
-)
-{
-    if (!value)
-        return;
-    auto *p = (unsigned char*) value;
-    for (size_t i = 0; i < size; i++)
-    {
-        ostream << hex(*p);
-        p++;
-    }
-}
-
 std::string hexString(
     const void *buffer,
     size_t size
 )
 {
-    std::stringstream r;
-    bufferPrintHex(r, buffer, size);
-    return r.str();
+    if (!buffer)
+        return "";
+    std::string r(size * 2, '\0');
+    hexEncode(&r[0], buffer, size);
+    return r;
 }
 
 /**
@@ -176,6 +145,10 @@ std::string hex2string(
     const std::string &hex
 )
 {
+    std::string r(hex.size() / 2, '\0');
+    if (hexDecode(&r[0], r.size(), hex.c_str(), hex.size()) >= 0)
+        return r;
+    // odd length or non-hex characters
     std::stringstream ss(hex);
     return readHex(ss);
 }
@@ -1066,6 +1039,8 @@ void string2KEY(
 {
     if (!str)
         return;
+    if (strnlen(str, 33) == 32 && hexDecode(retVal.c, sizeof(retVal.c), str, 32) == 16)
+        return;
     char c[3] = {0, 0, 0};
     int i = 0;
     while (*str) {
@@ -2218,6 +2218,30 @@ static size_t getNetworkIdentityPropertySize(
 }
 
 
+/**
+ * Address and EUIs are compared as numbers, other properties byte by byte
+ */
+static int compareProperty(
+    const char *value,
+    const NETWORK_IDENTITY_FILTER &filter,
+    size_t size
+)
+{
+    if (filter.property == NIP_ADDRESS && size == sizeof(uint32_t)) {
+        uint32_t a, b;
+        memcpy(&a, value, sizeof(a));
+        memcpy(&b, filter.filterData, sizeof(b));
+        return a < b ? -1 : (a > b ? 1 : 0);
+    }
+    if ((filter.property == NIP_DEVEUI || filter.property == NIP_APPEUI) && size == sizeof(uint64_t)) {
+        uint64_t a, b;
+        memcpy(&a, value, sizeof(a));
+        memcpy(&b, filter.filterData, sizeof(b));
+        return a < b ? -1 : (a > b ? 1 : 0);
+    }
+    return memcmp(value, filter.filterData, size);
+}
+
 bool isIdentityFiltered(
     const NETWORKIDENTITY &identity,
     const NETWORK_IDENTITY_FILTER &filter
@@ -2226,11 +2250,7 @@ bool isIdentityFiltered(
     auto sz = getNetworkIdentityPropertySize(filter.property);
     if (filter.length < sz)
         sz = filter.length;
-    auto c = memcmp(
-        getNetworkIdentityPropertyPtr(identity, filter.property),
-        filter.filterData,
-        sz
-    );
+    auto c = compareProperty(getNetworkIdentityPropertyPtr(identity, filter.property), filter, sz);
 
     switch (filter.comparisonOperator) {
         case NICO_EQ:
@@ -2263,9 +2283,9 @@ bool isIdentityFiltered2(
     int c = 0;
 
     if (filter.property == NIP_ADDRESS)
-        c = memcmp(&addr.u, &filter.filterData, sz);
+        c = compareProperty((const char *) &addr.u, filter, sz);
     else
-        c = memcmp(getDeviceIdPropertyPtr(deviceId, filter.property), filter.filterData,sz);
+        c = compareProperty(getDeviceIdPropertyPtr(deviceId, filter.property), filter, sz);
 
     switch (filter.comparisonOperator) {
         case NICO_EQ:
@@ -2298,8 +2318,6 @@ bool isIdentityFilteredV(
             r |= c;
         else
             r &= c;
-        if (!r)
-            break;
     }
     return r;
 }
@@ -2317,8 +2335,6 @@ bool isIdentityFilteredV2(
             r |= c;
         else
             r &= c;
-        if (!r)
-            break;
     }
     return r;
 }
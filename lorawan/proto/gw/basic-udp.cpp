@@ -8,7 +8,6 @@
 #include "lorawan/lorawan-string.h"
 #include "lorawan/lorawan-date.h"
 #include "lorawan/power-dbm.h"
-#include "base64/base64.h"
 
 // LNS- Basic communication protocol between Lora gateway and server
 static const char *GATEWAY_BASIC_UDP_PROTOCOL_NAME = "LNS";
@@ -68,7 +67,7 @@ public:
         : nameIndex(0), startItem(0), item(retVal), parseError(CODE_OK)
     {
         item->rxMetadata.gatewayId = gwId.u;
-        item->rxMetadata.t = std::chrono::duration_cast<std::chrono::seconds>(receivedTime.time_since_epoch()).count();
+        item->rxMetadata.t = std::chrono::duration_cast<std::chrono::seconds>(taskTime2systemTime(receivedTime).time_since_epoch()).count();
     }
 
     bool null() override {
@@ -704,7 +703,8 @@ bool GatewayBasicUdpProtocol::makePullStream(
     SEMTECH_PREFIX_GW pullPrefix { 2, token, SEMTECH_GW_PULL_DATA, gwId };
     ss << std::string((const char *) &pullPrefix, sizeof(SEMTECH_PREFIX_GW))
        << "{\"" << SAX_METADATA_TX_NAMES[0] << "\":{"; // txpk
-    std::string radioPacketBase64 = msgBuilder.base64();
+    char radioPacketBase64[MAX_BUILDER_BASE64_SIZE];
+    size_t radioPacketBase64Size = msgBuilder.base64(radioPacketBase64);
 
     if (txMetadata) {
         // tmst
@@ -724,12 +724,14 @@ bool GatewayBasicUdpProtocol::makePullStream(
            << DATA_RATE2string((BANDWIDTH) txMetadata->bandwidth, (SPREADING_FACTOR) txMetadata->datarate)
            << "\",\"" << SAX_METADATA_TX_NAMES[9] << "\":\"" << codingRate2string((CODING_RATE) txMetadata->coderate)
            << "\",\"" << SAX_METADATA_TX_NAMES[10] << "\": " << (int) txMetadata->f_dev // FSK frequency deviation (unsigned integer, in Hz)
-           << "\",\"" << SAX_METADATA_TX_NAMES[11] << "\": " << (txMetadata->invert_pol ? "true" : "false") // Lora modulation polarization inversion
+           << ",\"" << SAX_METADATA_TX_NAMES[11] << "\": " << (txMetadata->invert_pol ? "true" : "false") // Lora modulation polarization inversion
            << ",\"" << SAX_METADATA_TX_NAMES[12] << "\": " << txMetadata->preamble // RF preamble size (unsigned integer)
            << ",\"" << SAX_METADATA_TX_NAMES[15] << "\": " << (txMetadata->no_crc ? "true" : "false") // Check CRC
            << ",\"" << SAX_METADATA_TX_NAMES[13] << "\":" << msgBuilder.size();
-        if (!radioPacketBase64.empty())
-            ss << ",\"" << SAX_METADATA_TX_NAMES[14] << "\":\"" << radioPacketBase64;
+        if (radioPacketBase64Size) {
+            ss << ",\"" << SAX_METADATA_TX_NAMES[14] << "\":\"";
+            ss.write(radioPacketBase64, radioPacketBase64Size);
+        }
     } else {
         if (!regionalPlan)
             return false;
@@ -760,8 +762,10 @@ bool GatewayBasicUdpProtocol::makePullStream(
            << ",\"" << SAX_METADATA_TX_NAMES[12] << "\": " << preamble_size // RF preamble size (unsigned integer)
            << ",\"" << SAX_METADATA_TX_NAMES[15] << "\": " << (no_crc ? "true" : "false") // Check CRC
            << ",\"" << SAX_METADATA_TX_NAMES[13] << "\":" << msgBuilder.size();
-        if (!radioPacketBase64.empty())
-            ss << ",\"" << SAX_METADATA_TX_NAMES[14] << "\":\"" << radioPacketBase64;
+        if (radioPacketBase64Size) {
+            ss << ",\"" << SAX_METADATA_TX_NAMES[14] << "\":\"";
+            ss.write(radioPacketBase64, radioPacketBase64Size);
+        }
     }
     ss << "\"}}";
     return true;
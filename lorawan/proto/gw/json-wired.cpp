@@ -63,7 +63,7 @@ public:
     )
         : nameIndex(0), startItem(0), rslt(aRslt), parseError(CODE_OK)
     {
-        rslt->gwPushData.rxMetadata.t = std::chrono::duration_cast<std::chrono::seconds>(receivedTime.time_since_epoch()).count();
+        rslt->gwPushData.rxMetadata.t = std::chrono::duration_cast<std::chrono::seconds>(taskTime2systemTime(receivedTime).time_since_epoch()).count();
     }
 
     bool null() override {
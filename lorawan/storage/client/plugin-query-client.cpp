@@ -164,13 +164,15 @@ ServiceMessage* PluginQueryClient::request(
 void PluginQueryClient::start() {
     IdentityBinarySerialization identitySerialization(svcIdentity, code, accessCode);
     GatewayBinarySerialization gatewaySerialization(svcGateway, code, accessCode);
+    // largest request is identity batch request
+    std::vector<unsigned char> qBufVector(SIZE_MAX_BATCH_REQUEST);
+    unsigned char *qBuf = qBufVector.data();
     while (status != ERR_CODE_STOPPED) {
         if (!query) {
             status = ERR_CODE_STOPPED;
             break;
         }
         unsigned char rBuf[307];
-        unsigned char qBuf[307];
         size_t qSize = query->serialize(qBuf);
         size_t sz = identitySerialization.query(rBuf, sizeof(rBuf), qBuf, qSize);
         if (sz == 0) {
@@ -119,7 +119,9 @@ void UDPClient::start() {
 #endif
         setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *) &timeout, sizeof timeout);
 
-        unsigned char sendBuffer[110];
+        // largest request is identity batch request
+        std::vector<unsigned char> sendBufferVector(SIZE_MAX_BATCH_REQUEST);
+        unsigned char *sendBuffer = sendBufferVector.data();
         while (status != ERR_CODE_STOPPED) {
             if (!query) {
                 status = ERR_CODE_STOPPED;
@@ -9,12 +9,14 @@ typedef SSIZE_T ssize_t;
 #include <string>
 #include <uv.h>
 #include "query-client.h"
+#include "lorawan/storage/serialization/identity-binary-serialization.h"
 
-#define SEND_BUFFER_SIZE 155
+// largest request is identity batch request
+#define SEND_BUFFER_SIZE SIZE_MAX_BATCH_REQUEST
 
 class UvClient : public QueryClient {
 private:
-    char sendBuffer[SEND_BUFFER_SIZE];    // max request size is 40 bytes
+    char sendBuffer[SEND_BUFFER_SIZE];
     bool useTcp;
     struct sockaddr serverAddress;
     uv_udp_t udpSocket;
@@ -23,6 +23,15 @@
 #endif
 
 #define MHD_START_FLAGS 	(MHD_USE_POLL | MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_SUPPRESS_DATE_NO_CLOCK | MHD_USE_TCP_FASTOPEN | MHD_USE_TURBO)
+#ifdef __linux__
+#if MHD_VERSION < 0x00095300
+#define MHD_USE_EPOLL MHD_USE_EPOLL_LINUX_ONLY
+#endif
+// each pool thread waits on own epoll set
+#define MHD_POOL_FLAGS 	(MHD_USE_EPOLL | MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_SUPPRESS_DATE_NO_CLOCK | MHD_USE_TCP_FASTOPEN | MHD_USE_TURBO)
+#else
+#define MHD_POOL_FLAGS 	MHD_START_FLAGS
+#endif
 #define DEF_HTML_INDEX_FILE_NAME "index.html"
 
 const static char *CE_GZIP = "gzip";
@@ -36,6 +45,15 @@ const static char *CT_CSS = "text/css";
 const static char *CT_TEXT = "text/plain;charset=UTF-8";
 const static char *CT_TTF = "font/ttf";
 const static char *CT_BIN = "application/octet";
+const static char *CT_NDJSON = "application/x-ndjson";
+
+// GET /export/identity?code=<n>&accessCode=<hex>[&cursor=<addr>&limit=<n>], GET /export/gateway?...[&cursor=<id>&limit=<n>]
+// code and access code can be passed in the X-Code and X-Access-Code headers instead
+#define EXPORT_URL_PREFIX       "/export/"
+#define EXPORT_IDENTITY         "identity"
+#define EXPORT_GATEWAY          "gateway"
+#define EXPORT_PAGE_SIZE        1024
+#define EXPORT_BLOCK_SIZE       (32 * 1024)
 
 // Caution: version may be different, if microhttpd dependency not compiled, revise version humber
 #if MHD_VERSION <= 0x00096600
@@ -113,6 +131,8 @@ const static char* HDR_CORS_HEADERS = "Authorization, Access-Control-Allow-Heade
 "Origin, Accept, X-Requested-With, Content-Type, Access-Control-Request-Method, Access-Control-Request-Headers";
 
 const static char* HTTP_ERROR_404 = "Not found";
+const static char* HTTP_ERROR_401 = "Unauthorized";
+const static char* HTTP_ERROR_403 = "Forbidden";
 const static char* HTTP_ERROR_501 = "Not implemented";
 
 static void addCORS(MHD_Response *response) {
@@ -178,6 +198,203 @@ static void free_file_reader_callback(
     fclose ((FILE *) cls);
 }
 
+/**
+ * Export state between MHD reader callback calls. Each callback call reads next page
+ * after cursor, so export does not hold storage lock and does not buffer whole table.
+ */
+class ExportContext {
+public:
+    IdentityService *identityService;
+    GatewayService *gatewayService;
+    bool hasCursor;
+    DEVADDR addrCursor;
+    uint64_t gatewayCursor;
+    size_t limit;           ///< 0- all
+    size_t count;
+    std::string pending;    ///< NDJSON lines not sent yet
+    size_t pendingOffset;
+    bool eof;
+    ExportContext()
+        : identityService(nullptr), gatewayService(nullptr), hasCursor(false), gatewayCursor(0),
+        limit(0), count(0), pendingOffset(0), eof(false)
+    {
+    }
+
+    /**
+     * Read next page after the cursor
+     */
+    void readPage()
+    {
+        size_t sz = EXPORT_PAGE_SIZE;
+        if (limit && limit - count < sz)
+            sz = limit - count;
+        if (sz == 0) {
+            eof = true;
+            return;
+        }
+        size_t c = 0;
+        if (identityService) {
+            std::vector<NETWORKIDENTITY> page;
+            if (identityService->listFrom(page, hasCursor ? &addrCursor : nullptr, sz) == 0) {
+                for (auto &i : page) {
+                    pending += i.value.devid.toJsonString(i.value.devaddr);
+                    pending += '\n';
+                }
+                c = page.size();
+                if (c)
+                    addrCursor = page.back().value.devaddr;
+            }
+        } else if (gatewayService) {
+            std::vector<GatewayIdentity> page;
+            if (gatewayService->listFrom(page, hasCursor ? &gatewayCursor : nullptr, sz) == 0) {
+                for (auto &i : page) {
+                    pending += i.toJsonString();
+                    pending += '\n';
+                }
+                c = page.size();
+                if (c)
+                    gatewayCursor = page.back().gatewayId;
+            }
+        }
+        hasCursor = true;
+        count += c;
+        if (c < sz)
+            eof = true;
+    }
+};
+
+static ssize_t export_reader_callback(
+    void *cls,
+    uint64_t pos,
+    char *buf,
+    size_t max
+)
+{
+    auto *ctx = (ExportContext *) cls;
+    while (ctx->pending.size() - ctx->pendingOffset < max && !ctx->eof) {
+        if (ctx->pendingOffset) {
+            ctx->pending.erase(0, ctx->pendingOffset);
+            ctx->pendingOffset = 0;
+        }
+        ctx->readPage();
+    }
+    size_t sz = ctx->pending.size() - ctx->pendingOffset;
+    if (sz == 0)
+        return MHD_CONTENT_READER_END_OF_STREAM;
+    if (sz > max)
+        sz = max;
+    memmove(buf, ctx->pending.c_str() + ctx->pendingOffset, sz);
+    ctx->pendingOffset += sz;
+    return (ssize_t) sz;
+}
+
+static void free_export_reader_callback(
+    void *cls
+)
+{
+    delete (ExportContext *) cls;
+}
+
+/**
+ * Lookup query parameter, then header
+ * @return nullptr if not found
+ */
+static const char *lookupCredential(
+    struct MHD_Connection *connection,
+    const char *argument,
+    const char *header
+)
+{
+    const char *v = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, argument);
+    if (!v || !*v)
+        v = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, header);
+    if (v && !*v)
+        v = nullptr;
+    return v;
+}
+
+/**
+ * Check code (decimal or hexadecimal) and hexadecimal access code as JSON requests do
+ * @return MHD_HTTP_OK, MHD_HTTP_UNAUTHORIZED if credentials missed or MHD_HTTP_FORBIDDEN if they are wrong
+ */
+static unsigned int checkExportCredentials(
+    struct MHD_Connection *connection,
+    int32_t code,
+    uint64_t accessCode
+)
+{
+    const char *c = lookupCredential(connection, "code", "X-Code");
+    const char *a = lookupCredential(connection, "accessCode", "X-Access-Code");
+    if (!c || !a)
+        return MHD_HTTP_UNAUTHORIZED;
+    if (code != (int32_t) strtoll(c, nullptr, 10) && code != (int32_t) strtoll(c, nullptr, 16))
+        return MHD_HTTP_FORBIDDEN;
+    if (accessCode != (uint64_t) strtoull(a, nullptr, 16))
+        return MHD_HTTP_FORBIDDEN;
+    return MHD_HTTP_OK;
+}
+
+/**
+ * Stream identity or gateway table as NDJSON, one JSON object per line, chunked.
+ * To read next page pass address (gateway identifier) of the last line as cursor
+ * @param table "identity" or "gateway"
+ */
+static MHD_Result processExport(
+    struct MHD_Connection *connection,
+    HTTPListener *listener,
+    const char *table
+)
+{
+    IdentityService *identityService = nullptr;
+    GatewayService *gatewayService = nullptr;
+    unsigned int hc = MHD_HTTP_NOT_FOUND;
+    if (strcmp(table, EXPORT_IDENTITY) == 0 && listener->identitySerialization) {
+        identityService = listener->identitySerialization->svc;
+        hc = checkExportCredentials(connection, listener->identitySerialization->code,
+            listener->identitySerialization->accessCode);
+    } else
+        if (strcmp(table, EXPORT_GATEWAY) == 0 && listener->gatewaySerialization) {
+            gatewayService = listener->gatewaySerialization->svc;
+            hc = checkExportCredentials(connection, listener->gatewaySerialization->code,
+                listener->gatewaySerialization->accessCode);
+        }
+    struct MHD_Response *response;
+    MHD_Result ret;
+    if ((!identityService && !gatewayService) || hc != MHD_HTTP_OK) {
+        const char *msg = hc == MHD_HTTP_UNAUTHORIZED ? HTTP_ERROR_401 : (hc == MHD_HTTP_FORBIDDEN ? HTTP_ERROR_403 : HTTP_ERROR_404);
+        response = MHD_create_response_from_buffer(strlen(msg), (void *) msg, MHD_RESPMEM_PERSISTENT);
+        ret = MHD_queue_response(connection, hc, response);
+        MHD_destroy_response(response);
+        return ret;
+    }
+    auto ctx = new ExportContext;
+    ctx->identityService = identityService;
+    ctx->gatewayService = gatewayService;
+    const char *v = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "cursor");
+    if (v && *v) {
+        ctx->hasCursor = true;
+        if (ctx->identityService)
+            string2DEVADDR(ctx->addrCursor, v);
+        else
+            ctx->gatewayCursor = strtoull(v, nullptr, 16);
+    }
+    v = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "limit");
+    if (v && *v)
+        ctx->limit = strtoull(v, nullptr, 10);
+    // size unknown, HTTP/1.1 chunked encoding
+    response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, EXPORT_BLOCK_SIZE,
+        &export_reader_callback, ctx, &free_export_reader_callback);
+    if (!response) {
+        delete ctx;
+        return MHD_NO;
+    }
+    MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, CT_NDJSON);
+    addCORS(response);
+    ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
 /**
  * Translate Url to the file name
  */
@@ -313,6 +530,12 @@ static MHD_Result cbRequest(
 
     int hc;
     auto *l = (HTTPListener *) cls;
+    if (strcmp(method, "GET") == 0 && strncmp(url, EXPORT_URL_PREFIX, strlen(EXPORT_URL_PREFIX)) == 0) {
+        MHD_Result r = processExport(connection, l, url + strlen(EXPORT_URL_PREFIX));
+        delete requestCtx;
+        *ptr = nullptr;
+        return r;
+    }
 #ifdef ENABLE_QRCODE
     URN_TYPE retSVG = URN_TYPE_NONE;
     if (strstr(url, "/qr")) {
@@ -403,6 +626,19 @@ static MHD_Result cbRequest(
 	return ret;
 }
 
+void HTTPListener::setThreadPool(
+    unsigned int threads
+)
+{
+    if (threads > 1) {
+        threadCount = threads;
+        flags = MHD_POOL_FLAGS;
+    } else {
+        threadCount = 1;
+        flags = MHD_START_FLAGS;
+    }
+}
+
 int HTTPListener::run()
 {
     struct MHD_Daemon *d = MHD_start_daemon(
@@ -44,6 +44,12 @@ public:
     int run() override;
     void stop() override;
     void setLog(int verbose, Log* log) override;
+    /**
+     * Serve requests by the pool of threads, each thread polls its own epoll set (poll on other systems).
+     * Serialization services must be thread-safe. Call before run()
+     * @param threads 1- one polling thread (default)
+     */
+    void setThreadPool(unsigned int threads);
 };
 
 #endif
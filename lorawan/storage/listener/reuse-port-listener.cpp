@@ -0,0 +1,124 @@
+#include "lorawan/storage/listener/reuse-port-listener.h"
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#include <WinSock2.h>
+#else
+#include <sys/socket.h>
+#endif
+
+#include "lorawan/lorawan-error.h"
+
+ReusePortListener::ReusePortListener(
+    IdentitySerialization *aIdentitySerialization,
+    GatewaySerialization *aSerializationWrapper
+)
+    : StorageListener(aIdentitySerialization, aSerializationWrapper)
+{
+    addUDPLoop(aIdentitySerialization, aSerializationWrapper);
+}
+
+ReusePortListener::~ReusePortListener()
+{
+    stop();
+    for (auto l : loops) {
+        delete l;
+    }
+    for (auto s : owned) {
+        delete s;
+    }
+}
+
+void ReusePortListener::addLoop(
+    IdentitySerialization *aIdentitySerialization,
+    GatewaySerialization *aSerializationWrapper
+)
+{
+    owned.push_back(aIdentitySerialization);
+    if (aSerializationWrapper)
+        owned.push_back(aSerializationWrapper);
+    addUDPLoop(aIdentitySerialization, aSerializationWrapper);
+}
+
+void ReusePortListener::addUDPLoop(
+    IdentitySerialization *aIdentitySerialization,
+    GatewaySerialization *aSerializationWrapper
+)
+{
+    auto l = new UDPListener(aIdentitySerialization, aSerializationWrapper);
+    l->setReusePort(true);
+    loops.push_back(l);
+}
+
+size_t ReusePortListener::size() const
+{
+    return loops.size();
+}
+
+bool ReusePortListener::supported()
+{
+#ifdef SO_REUSEPORT
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ReusePortListener::setAddress(
+    const std::string &host,
+    uint16_t port
+)
+{
+    for (auto l : loops) {
+        l->setAddress(host, port);
+    }
+}
+
+void ReusePortListener::setAddress(
+    uint32_t &ipv4,
+    uint16_t port
+)
+{
+    for (auto l : loops) {
+        l->setAddress(ipv4, port);
+    }
+}
+
+int ReusePortListener::run()
+{
+    std::vector<int> codes(loops.size(), CODE_OK);
+    for (size_t i = 0; i < loops.size(); i++) {
+        threads.push_back(new std::thread([this, i, &codes] {
+            codes[i] = loops[i]->run();
+            // one loop can not bind, stop others
+            if (codes[i] != CODE_OK)
+                stop();
+        }));
+    }
+    for (auto t : threads) {
+        t->join();
+        delete t;
+    }
+    threads.clear();
+    for (auto c : codes) {
+        if (c != CODE_OK)
+            return c;
+    }
+    return CODE_OK;
+}
+
+void ReusePortListener::stop()
+{
+    for (auto l : loops) {
+        l->stop();
+    }
+}
+
+void ReusePortListener::setLog(
+    int verbose,
+    Log *log
+)
+{
+    for (auto l : loops) {
+        l->setLog(verbose, log);
+    }
+}
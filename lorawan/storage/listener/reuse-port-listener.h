@@ -0,0 +1,74 @@
+#ifndef REUSE_PORT_LISTENER_H_
+#define REUSE_PORT_LISTENER_H_	1
+
+#include <vector>
+#include <thread>
+
+#include "lorawan/storage/listener/udp-listener.h"
+
+/**
+ * Run several UDP listeners bound to the same address and port with SO_REUSEPORT,
+ * each in its own thread. Kernel distributes datagrams between sockets so
+ * query throughput scales with CPU cores.
+ *
+ * Each loop has its own serialization objects. Services behind serialization
+ * objects are shared by loops and must be thread-safe.
+ */
+class ReusePortListener : public StorageListener {
+private:
+    std::vector<UDPListener *> loops;
+    std::vector<std::thread *> threads;
+    std::vector<Serialization *> owned;     ///< serialization objects of loops added by addLoop()
+    void addUDPLoop(
+        IdentitySerialization *aIdentitySerialization,
+        GatewaySerialization *aSerializationWrapper
+    );
+public:
+    /**
+     * First loop. Serialization objects are not owned by the listener
+     */
+    explicit ReusePortListener(
+        IdentitySerialization *aIdentitySerialization,
+        GatewaySerialization *aSerializationWrapper
+    );
+    ~ReusePortListener() override;
+
+    /**
+     * Add loop. Call before setAddress() and run()
+     * Listener owns serialization objects and deletes them
+     * @param aIdentitySerialization loop's own identity serialization
+     * @param aSerializationWrapper loop's own gateway serialization
+     */
+    void addLoop(
+        IdentitySerialization *aIdentitySerialization,
+        GatewaySerialization *aSerializationWrapper
+    );
+
+    /**
+     * @return count of loops
+     */
+    size_t size() const;
+
+    /**
+     * @return true if system supports SO_REUSEPORT
+     */
+    static bool supported();
+
+    void setAddress(
+        const std::string &host,
+        uint16_t port
+    ) override;
+    void setAddress(
+        uint32_t &ipv4,
+        uint16_t port
+    ) override;
+    /**
+     * Start loops and wait until all of them stop
+     * @return CODE_OK or first loop error code
+     */
+    int run() override;
+    void stop() override;
+    void setLog(int verbose, Log *log) override;
+};
+
+#endif
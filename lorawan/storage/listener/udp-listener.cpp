@@ -37,9 +37,17 @@
 #include "lorawan/lorawan-error.h"
 #include "lorawan/lorawan-msg.h"
 #include "lorawan/helper/ip-address.h"
+#include "lorawan/storage/serialization/identity-binary-serialization.h"
 
 #define DEF_KEEPALIVE_SECS 60
 
+// largest request is identity batch request
+#ifdef ESP_PLATFORM
+#define SIZE_RX_BUFFER 307
+#else
+#define SIZE_RX_BUFFER (SIZE_MAX_BATCH_REQUEST + 1)
+#endif
+
 #ifdef _MSC_VER
 #define SOCKET_ERRNO WSAGetLastError()
 #define SOCKET_ERROR_TIMEOUT WSAETIMEDOUT
@@ -56,7 +64,7 @@ UDPListener::UDPListener(
     IdentitySerialization *aIdentitySerialization,
     GatewaySerialization *aSerializationWrapper
 )
-    : StorageListener(aIdentitySerialization, aSerializationWrapper), destAddr({}), log(nullptr), verbose(0), status(CODE_OK)
+    : StorageListener(aIdentitySerialization, aSerializationWrapper), destAddr({}), log(nullptr), verbose(0), reusePort(false), status(CODE_OK)
 {
 }
 
@@ -69,6 +77,19 @@ void UDPListener::setLog(
     log = aLog;
 }
 
+bool UDPListener::setReusePort(
+    bool value
+)
+{
+#ifdef SO_REUSEPORT
+    reusePort = value;
+    return true;
+#else
+    reusePort = false;
+    return !value;
+#endif
+}
+
 // http://stackoverflow.com/questions/25615340/closing-libuv-handles-correctly
 void UDPListener::stop()
 {
@@ -107,7 +128,8 @@ void UDPListener::setAddress(
 
 int UDPListener::run()
 {
-    unsigned char rxBuf[307];
+    std::vector<unsigned char> rxBufVector(SIZE_RX_BUFFER);
+    unsigned char *rxBuf = rxBufVector.data();
 
     int proto = isIPv6(&destAddr) ? IPPROTO_IPV6 : IPPROTO_IP;
     int af = isIPv6(&destAddr) ? AF_INET6 : AF_INET;
@@ -147,6 +169,19 @@ int UDPListener::run()
             setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, (const char*) &opt, sizeof(opt));
         }
 
+#ifdef SO_REUSEPORT
+        if (reusePort) {
+            int opt = 1;
+            if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (const char*) &opt, sizeof(opt))) {
+                if (log) {
+                    log->strm(LOG_ERR) << ERR_SOCKET_SET
+                        << MSG_SPACE << ERR_MESSAGE << SOCKET_ERRNO;
+                    log->flush();
+                }
+            }
+        }
+#endif
+
         // Set timeout
 #ifdef _MSC_VER
         DWORD timeout = 1000;   // ms
@@ -177,7 +212,7 @@ int UDPListener::run()
         // 307 bytes for IPv4 up to 18, IPv6 up to 10
         unsigned char rBuf[2048];
         while (status != ERR_CODE_STOPPED) {
-            ssize_t len = recvfrom(sock, (char*) rxBuf, sizeof(rxBuf) - 1, 0, (struct sockaddr*)&source_addr, & socklen);
+            ssize_t len = recvfrom(sock, (char*) rxBuf, rxBufVector.size() - 1, 0, (struct sockaddr*)&source_addr, & socklen);
             // Error occurred during receiving
             if (len < 0) {
                 if (SOCKET_ERRNO == SOCKET_ERROR_TIMEOUT) {    // timeout occurs
@@ -15,6 +15,7 @@ private:
     struct sockaddr destAddr;
     Log *log;
     int verbose;
+    bool reusePort;
 public:
     int status; // ERR_CODE_STOPPED - stop request
     explicit UDPListener(
@@ -33,6 +34,13 @@ public:
     int run() override;
     void stop() override;
     void setLog(int verbose, Log *log) override;
+    /**
+     * Allow other listeners bind the same address and port (SO_REUSEPORT),
+     * kernel distributes datagrams between them. Call before run()
+     * @param value true- allow
+     * @return false if SO_REUSEPORT is not supported
+     */
+    bool setReusePort(bool value);
 };
 
 #endif
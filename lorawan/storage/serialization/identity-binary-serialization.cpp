@@ -98,6 +98,19 @@ static void deserializeNETWORKIDENTITY(
     memmove(&retVal.value.devid.id.name, p, 8);	            // 8 total 106
 }
 
+static void ntohNETWORKIDENTITY(
+    NETWORKIDENTITY &value
+)
+{
+    value.value.devaddr.u = NTOH4(value.value.devaddr.u);
+    value.value.devid.id.devEUI.u = NTOH8(value.value.devid.id.devEUI.u);
+    // OTAA
+    value.value.devid.id.appEUI.u = NTOH8(value.value.devid.id.appEUI.u);
+    value.value.devid.id.devNonce.u = NTOH2(value.value.devid.id.devNonce.u);
+    // token
+    value.value.devid.id.token = NTOH4(value.value.devid.id.token);
+}
+
 IdentityEUIRequest::IdentityEUIRequest()
     : ServiceMessage(QUERY_IDENTITY_ADDR, 0, 0), eui(0)
 {
@@ -245,6 +258,158 @@ std::string IdentityAssignRequest::toJsonString() const
     return ss.str();
 }
 
+/**
+ * Read count of the batch items, count is limited by the buffer size
+ */
+static size_t batchCount(
+    const unsigned char *buf,
+    size_t sz,
+    size_t itemSize
+)
+{
+    if (sz < SIZE_BATCH_REQUEST_HEADER)
+        return 0;
+    uint16_t c;
+    memmove(&c, buf + SIZE_SERVICE_MESSAGE, sizeof(c));
+    c = NTOH2(c);
+    size_t r = (sz - SIZE_BATCH_REQUEST_HEADER) / itemSize;
+    return c < r ? c : r;
+}
+
+IdentityAssignBatchRequest::IdentityAssignBatchRequest()
+    : ServiceMessage(QUERY_IDENTITY_ASSIGN_BATCH, 0, 0)
+{
+}
+
+IdentityAssignBatchRequest::IdentityAssignBatchRequest(
+    int32_t code,
+    uint64_t accessCode
+)
+    : ServiceMessage(QUERY_IDENTITY_ASSIGN_BATCH, code, accessCode)
+{
+}
+
+IdentityAssignBatchRequest::IdentityAssignBatchRequest(
+    const unsigned char *buf,
+    size_t sz
+)
+    : ServiceMessage(buf, sz)   // 13
+{
+    size_t c = batchCount(buf, sz, SIZE_NETWORK_IDENTITY);  // 2
+    identities.resize(c);
+    for (size_t i = 0; i < c; i++) {
+        deserializeNETWORKIDENTITY(identities[i], buf + SIZE_BATCH_REQUEST_HEADER + i * SIZE_NETWORK_IDENTITY);  // 106
+    }
+}
+
+void IdentityAssignBatchRequest::ntoh()
+{
+    ServiceMessage::ntoh();
+    for (auto &i : identities) {
+        ntohNETWORKIDENTITY(i);
+    }
+}
+
+size_t IdentityAssignBatchRequest::serialize(
+    unsigned char *retBuf
+) const
+{
+    ServiceMessage::serialize(retBuf);      // 13
+    if (retBuf) {
+        uint16_t c = NTOH2((uint16_t) identities.size());
+        memmove(retBuf + SIZE_SERVICE_MESSAGE, &c, sizeof(c));  // 2
+        unsigned char *p = retBuf + SIZE_BATCH_REQUEST_HEADER;
+        for (auto &i : identities) {
+            serializeNETWORKIDENTITY(p, i);     // 106
+            p += SIZE_NETWORK_IDENTITY;
+        }
+    }
+    return SIZE_BATCH_REQUEST_HEADER + identities.size() * SIZE_NETWORK_IDENTITY;
+}
+
+std::string IdentityAssignBatchRequest::toJsonString() const
+{
+    std::stringstream ss;
+    ss << R"({"identities": [)";
+    bool isFirst = true;
+    for (auto &i : identities) {
+        if (isFirst)
+            isFirst = false;
+        else
+            ss << ", ";
+        ss << i.toJsonString();
+    }
+    ss << "]}";
+    return ss.str();
+}
+
+IdentityRmBatchRequest::IdentityRmBatchRequest()
+    : ServiceMessage(QUERY_IDENTITY_RM_BATCH, 0, 0)
+{
+}
+
+IdentityRmBatchRequest::IdentityRmBatchRequest(
+    int32_t code,
+    uint64_t accessCode
+)
+    : ServiceMessage(QUERY_IDENTITY_RM_BATCH, code, accessCode)
+{
+}
+
+IdentityRmBatchRequest::IdentityRmBatchRequest(
+    const unsigned char *buf,
+    size_t sz
+)
+    : ServiceMessage(buf, sz)   // 13
+{
+    size_t c = batchCount(buf, sz, sizeof(uint32_t));  // 2
+    addrs.resize(c);
+    for (size_t i = 0; i < c; i++) {
+        memmove(&addrs[i].u, buf + SIZE_BATCH_REQUEST_HEADER + i * sizeof(uint32_t), sizeof(uint32_t));  // 4
+    }
+}
+
+void IdentityRmBatchRequest::ntoh()
+{
+    ServiceMessage::ntoh();
+    for (auto &a : addrs) {
+        a.u = NTOH4(a.u);
+    }
+}
+
+size_t IdentityRmBatchRequest::serialize(
+    unsigned char *retBuf
+) const
+{
+    ServiceMessage::serialize(retBuf);      // 13
+    if (retBuf) {
+        uint16_t c = NTOH2((uint16_t) addrs.size());
+        memmove(retBuf + SIZE_SERVICE_MESSAGE, &c, sizeof(c));  // 2
+        unsigned char *p = retBuf + SIZE_BATCH_REQUEST_HEADER;
+        for (auto &a : addrs) {
+            memmove(p, &a.u, sizeof(uint32_t)); // 4
+            p += sizeof(uint32_t);
+        }
+    }
+    return SIZE_BATCH_REQUEST_HEADER + addrs.size() * sizeof(uint32_t);
+}
+
+std::string IdentityRmBatchRequest::toJsonString() const
+{
+    std::stringstream ss;
+    ss << R"({"addrs": [)";
+    bool isFirst = true;
+    for (auto &a : addrs) {
+        if (isFirst)
+            isFirst = false;
+        else
+            ss << ", ";
+        ss << "\"" << DEVADDR2string(a) << "\"";
+    }
+    ss << "]}";
+    return ss.str();
+}
+
 IdentityOperationRequest::IdentityOperationRequest()
     : ServiceMessage(QUERY_IDENTITY_LIST, 0, 0),
       offset(0), size(0)
@@ -316,19 +481,6 @@ IdentityGetResponse::IdentityGetResponse(
     accessCode = request.accessCode;
 }
 
-static void ntohNETWORKIDENTITY(
-    NETWORKIDENTITY &value
-)
-{
-    value.value.devaddr.u = NTOH4(value.value.devaddr.u);
-    value.value.devid.id.devEUI.u = NTOH8(value.value.devid.id.devEUI.u);
-    // OTAA
-    value.value.devid.id.appEUI.u = NTOH8(value.value.devid.id.appEUI.u);
-    value.value.devid.id.devNonce.u = NTOH2(value.value.devid.id.devNonce.u);
-    // token
-    value.value.devid.id.token = NTOH4(value.value.devid.id.token);
-}
-
 IdentityGetResponse::IdentityGetResponse(
     const unsigned char* buf,
     size_t sz
@@ -439,6 +591,20 @@ IdentityOperationResponse::IdentityOperationResponse(
 
 }
 
+IdentityOperationResponse::IdentityOperationResponse(
+    const IdentityAssignBatchRequest &request
+)
+    : IdentityOperationRequest(request.tag, 0, 0, request.code, request.accessCode), response(0)
+{
+}
+
+IdentityOperationResponse::IdentityOperationResponse(
+    const IdentityRmBatchRequest &request
+)
+    : IdentityOperationRequest(request.tag, 0, 0, request.code, request.accessCode), response(0)
+{
+}
+
 void IdentityOperationResponse::ntoh() {
     IdentityOperationRequest::ntoh();
     response = NTOH4(response);
@@ -638,6 +804,22 @@ size_t IdentitySerialization::query(
                     ((IdentityOperationResponse *) r)->size = 1;    // count of deleted entries
                 break;
             }
+        case QUERY_IDENTITY_ASSIGN_BATCH:   // assign (put) identities at once
+            {
+                auto gr = (IdentityAssignBatchRequest *) pMsg;
+                r = new IdentityOperationResponse(*gr);
+                int rc = svc->putBatch(gr->identities);
+                ((IdentityOperationResponse*) r)->response = rc ? rc : (int32_t) gr->identities.size();    // count of placed entries
+                break;
+            }
+        case QUERY_IDENTITY_RM_BATCH:   // Remove entries at once
+            {
+                auto gr = (IdentityRmBatchRequest *) pMsg;
+                r = new IdentityOperationResponse(*gr);
+                int rc = svc->rmBatch(gr->addrs);
+                ((IdentityOperationResponse*) r)->response = rc ? rc : (int32_t) gr->addrs.size();    // count of processed entries
+                break;
+            }
         case QUERY_IDENTITY_LIST:   // List entries
         {
             auto gr = (IdentityOperationRequest *) pMsg;
@@ -723,6 +905,14 @@ enum IdentityQueryTag validateIdentityQuery(
             if (size < SIZE_DEVICE_ADDR_REQUEST)
                 return QUERY_IDENTITY_NONE;
             return QUERY_IDENTITY_RM;
+        case QUERY_IDENTITY_ASSIGN_BATCH:   // assign (put) identities at once
+            if (size < SIZE_BATCH_REQUEST_HEADER)
+                return QUERY_IDENTITY_NONE;
+            return QUERY_IDENTITY_ASSIGN_BATCH;
+        case QUERY_IDENTITY_RM_BATCH:   // Remove entries at once
+            if (size < SIZE_BATCH_REQUEST_HEADER)
+                return QUERY_IDENTITY_NONE;
+            return QUERY_IDENTITY_RM_BATCH;
         case QUERY_IDENTITY_LIST:   // List entries
             if (size < SIZE_OPERATION_REQUEST)
                 return QUERY_IDENTITY_NONE;
@@ -779,6 +969,14 @@ enum IdentityQueryTag validateIdentityResponse(
             if (size < SIZE_OPERATION_RESPONSE)
                 return QUERY_IDENTITY_NONE;
             return QUERY_IDENTITY_RM;
+        case QUERY_IDENTITY_ASSIGN_BATCH:   // assign (put) identities at once
+            if (size < SIZE_OPERATION_RESPONSE)
+                return QUERY_IDENTITY_NONE;
+            return QUERY_IDENTITY_ASSIGN_BATCH;
+        case QUERY_IDENTITY_RM_BATCH:   // Remove entries at once
+            if (size < SIZE_OPERATION_RESPONSE)
+                return QUERY_IDENTITY_NONE;
+            return QUERY_IDENTITY_RM_BATCH;
         case QUERY_IDENTITY_LIST:   // List entries
             if (size < SIZE_GET_RESPONSE)   // at least
                 return QUERY_IDENTITY_NONE;
@@ -867,6 +1065,16 @@ ServiceMessage* deserializeIdentity(
                 return nullptr;
             r = new IdentityAddrRequest(buf, sz);
             break;
+        case QUERY_IDENTITY_ASSIGN_BATCH:   // assign (put) identities at once
+            if (sz < SIZE_BATCH_REQUEST_HEADER)
+                return nullptr;
+            r = new IdentityAssignBatchRequest(buf, sz);
+            break;
+        case QUERY_IDENTITY_RM_BATCH:   // Remove entries at once
+            if (sz < SIZE_BATCH_REQUEST_HEADER)
+                return nullptr;
+            r = new IdentityRmBatchRequest(buf, sz);
+            break;
         case QUERY_IDENTITY_LIST:   // List entries
             if (sz < SIZE_OPERATION_REQUEST)
                 return nullptr;
@@ -919,6 +1127,10 @@ const char* identityTag2string(
             return "assign";
         case QUERY_IDENTITY_RM:
             return "remove";
+        case QUERY_IDENTITY_ASSIGN_BATCH:
+            return "assign batch";
+        case QUERY_IDENTITY_RM_BATCH:
+            return "remove batch";
         case QUERY_IDENTITY_FORCE_SAVE:
             return "save";
         case QUERY_IDENTITY_CLOSE_RESOURCES:
@@ -956,6 +1168,8 @@ bool isIdentityTag(
         case QUERY_IDENTITY_RM:
         case QUERY_IDENTITY_FORCE_SAVE:
         case QUERY_IDENTITY_CLOSE_RESOURCES:
+        case QUERY_IDENTITY_ASSIGN_BATCH:
+        case QUERY_IDENTITY_RM_BATCH:
             return true;
         default:
             return false;
@@ -1048,6 +1262,22 @@ size_t IdentityBinarySerialization::query(
             ((IdentityOperationResponse*)r)->size = 1;    // count of deleted entries
         break;
     }
+    case QUERY_IDENTITY_ASSIGN_BATCH:   // assign (put) identities at once
+    {
+        auto gr = (IdentityAssignBatchRequest*)pMsg;
+        r = new IdentityOperationResponse(*gr);
+        int rc = svc->putBatch(gr->identities);
+        ((IdentityOperationResponse*)r)->response = rc ? rc : (int32_t)gr->identities.size();    // count of placed entries
+        break;
+    }
+    case QUERY_IDENTITY_RM_BATCH:   // Remove entries at once
+    {
+        auto gr = (IdentityRmBatchRequest*)pMsg;
+        r = new IdentityOperationResponse(*gr);
+        int rc = svc->rmBatch(gr->addrs);
+        ((IdentityOperationResponse*)r)->response = rc ? rc : (int32_t)gr->addrs.size();    // count of processed entries
+        break;
+    }
     case QUERY_IDENTITY_LIST:   // List entries
     {
         auto gr = (IdentityOperationRequest*)pMsg;
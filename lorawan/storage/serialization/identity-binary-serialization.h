@@ -22,7 +22,9 @@ enum IdentityQueryTag {
     QUERY_IDENTITY_RM = 'r',
     QUERY_IDENTITY_FORCE_SAVE = 's',
     QUERY_IDENTITY_CLOSE_RESOURCES = 'e',
-    QUERY_IDENTITY_FILTER = 'f'
+    QUERY_IDENTITY_FILTER = 'f',
+    QUERY_IDENTITY_ASSIGN_BATCH = 'b',
+    QUERY_IDENTITY_RM_BATCH = 'd'
 };
 
 // Operation request: service + size + offset :  13 + 4 + 1
@@ -40,6 +42,11 @@ enum IdentityQueryTag {
 #define SIZE_ASSIGN_REQUEST 119
 // Device get identity: service + identity (including address) :  13 + 106
 #define SIZE_GET_RESPONSE 119
+// Batch request header: service + count :  13 + 2
+#define SIZE_BATCH_REQUEST_HEADER 15
+// Max identities or addresses in the batch request, assign batch fits UDP datagram: 15 + 512 * 106 = 54287
+#define MAX_IDENTITY_BATCH_SIZE 512
+#define SIZE_MAX_BATCH_REQUEST (SIZE_BATCH_REQUEST_HEADER + MAX_IDENTITY_BATCH_SIZE * SIZE_NETWORK_IDENTITY)
 
 class IdentityEUIRequest : public ServiceMessage {
 public:
@@ -78,6 +85,36 @@ public:
     std::string toJsonString() const override;
 };
 
+/**
+ * Bulk assign: count (2 bytes) and identities (106 bytes each), up to MAX_IDENTITY_BATCH_SIZE
+ */
+class IdentityAssignBatchRequest : public ServiceMessage {
+public:
+    std::vector<NETWORKIDENTITY> identities;
+    IdentityAssignBatchRequest();
+    IdentityAssignBatchRequest(int32_t code, uint64_t accessCode);
+    IdentityAssignBatchRequest(const unsigned char *buf, size_t sz);
+    ~IdentityAssignBatchRequest() override = default;
+    void ntoh() override;
+    size_t serialize(unsigned char *retBuf) const override;
+    std::string toJsonString() const override;
+};
+
+/**
+ * Bulk remove: count (2 bytes) and addresses (4 bytes each), up to MAX_IDENTITY_BATCH_SIZE
+ */
+class IdentityRmBatchRequest : public ServiceMessage {
+public:
+    std::vector<DEVADDR> addrs;
+    IdentityRmBatchRequest();
+    IdentityRmBatchRequest(int32_t code, uint64_t accessCode);
+    IdentityRmBatchRequest(const unsigned char *buf, size_t sz);
+    ~IdentityRmBatchRequest() override = default;
+    void ntoh() override;
+    size_t serialize(unsigned char *retBuf) const override;
+    std::string toJsonString() const override;
+};
+
 class IdentityOperationRequest : public ServiceMessage {
 public:
     uint32_t offset;
@@ -119,7 +156,7 @@ public:
 
 class IdentityOperationResponse : public IdentityOperationRequest {
 public:
-    int32_t response;   // <0 - error
+    int32_t response;   // <0 - error, batch requests return count of processed entries
     IdentityOperationResponse();
     IdentityOperationResponse(const IdentityOperationResponse& resp);
     IdentityOperationResponse(const unsigned char *buf, size_t sz);
@@ -127,6 +164,8 @@ public:
     explicit IdentityOperationResponse(const IdentityAssignRequest &request);
     explicit IdentityOperationResponse(const IdentityAddrRequest &request);
     explicit IdentityOperationResponse(const IdentityOperationRequest &request);
+    explicit IdentityOperationResponse(const IdentityAssignBatchRequest &request);
+    explicit IdentityOperationResponse(const IdentityRmBatchRequest &request);
     void ntoh() override;
     size_t serialize(unsigned char *retBuf) const override;
     std::string toJsonString() const override;
@@ -176,89 +176,10 @@ size_t IdentityTextJSONSerialization::query(
         case 'p':
             // assign
         {
-            DEVADDR deviceAddr;
-            if (!js.contains("addr"))
-                return 0;
-            auto jAddr = js["addr"];
-            if (!jAddr.is_string())
+            NETWORKIDENTITY ni;
+            if (!json2NETWORKIDENTITY(ni, js))
                 return 0;
-            string2DEVADDR(deviceAddr, jAddr);
-
-            DEVICEID deviceId;
-            if (js.contains("activation")) {
-                auto jsv = js["activation"];
-                if (jsv.is_string())
-                    deviceId.id.activation = string2activation(jsv);
-            }
-
-            if (js.contains("class")) {
-                auto jsv = js["class"];
-                if (jsv.is_string())
-                    deviceId.setClass(string2deviceclass(jsv));
-            }
-
-            if (js.contains("deveui")) {
-                auto jsv = js["deveui"];
-                if (jsv.is_string())
-                    string2DEVEUI(deviceId.id.devEUI, jsv);
-            }
-
-            if (js.contains("nwkSKey")) {
-                auto jsv = js["nwkSKey"];
-                if (jsv.is_string())
-                    string2KEY(deviceId.id.nwkSKey, jsv);
-            }
-            if (js.contains("appSKey")) {
-                auto jsv = js["appSKey"];
-                if (jsv.is_string())
-                    string2KEY(deviceId.id.appSKey, jsv);
-            }
-
-            if (js.contains("version")) {
-                auto jsv = js["version"];
-                if (jsv.is_string())
-                    deviceId.id.version = string2LORAWAN_VERSION(jsv);
-            }
-
-            if (js.contains("appeui")) {
-                auto jsv = js["appeui"];
-                if (jsv.is_string())
-                    string2DEVEUI(deviceId.id.appEUI, jsv);
-            }
-
-            if (js.contains("appKey")) {
-                auto jsv = js["appKey"];
-                if (jsv.is_string())
-                    string2KEY(deviceId.id.appKey, jsv);
-            }
-
-            if (js.contains("nwkKey")) {
-                auto jsv = js["nwkKey"];
-                if (jsv.is_string())
-                    string2KEY(deviceId.id.nwkKey, jsv);
-            }
-
-            if (js.contains("devNonce")) {
-                auto jsv = js["devNonce"];
-                if (jsv.is_string())
-                    deviceId.id.devNonce = string2DEVNONCE(jsv);
-            }
-
-            if (js.contains("joinNonce")) {
-                auto jsv = js["joinNonce"];
-                if (jsv.is_string())
-                    string2JOINNONCE(deviceId.id.joinNonce, jsv);
-            }
-
-            if (js.contains("name")) {
-                auto jsv = js["name"];
-                if (jsv.is_string()) {
-                    std::string s(jsv);
-                    string2DEVICENAME(deviceId.id.name, s.c_str());
-                }
-            }
-
-            auto r = svc->put(deviceAddr, deviceId);
+            auto r = svc->put(ni.value.devaddr, ni.value.devid);
             return retStatusCode(retBuf, retSize, r);
         }
         case 'r':
@@ -276,6 +197,45 @@ size_t IdentityTextJSONSerialization::query(
             auto r = svc->rm(deviceAddr);
             return retStatusCode(retBuf, retSize, r);
         }
+        case 'b':
+            // assign identities at once
+        {
+            if (!js.contains("identities"))
+                return 0;
+            auto &jIdentities = js["identities"];
+            if (!jIdentities.is_array())
+                return 0;
+            std::vector<NETWORKIDENTITY> nis;
+            nis.reserve(jIdentities.size());
+            for (auto &e : jIdentities) {
+                NETWORKIDENTITY ni;
+                if (!json2NETWORKIDENTITY(ni, e))
+                    return retStatusCode(retBuf, retSize, ERR_CODE_PARAM_INVALID);
+                nis.push_back(ni);
+            }
+            auto r = svc->putBatch(nis);
+            return retStatusCode(retBuf, retSize, r);
+        }
+        case 'd':
+            // remove entries at once
+        {
+            if (!js.contains("addrs"))
+                return retStatusCode(retBuf, retSize, ERR_CODE_DEVICE_ADDRESS_NOTFOUND);
+            auto &jAddrs = js["addrs"];
+            if (!jAddrs.is_array())
+                return retStatusCode(retBuf, retSize, ERR_CODE_DEVICE_ADDRESS_NOTFOUND);
+            std::vector<DEVADDR> addrs;
+            addrs.reserve(jAddrs.size());
+            for (auto &e : jAddrs) {
+                if (!e.is_string())
+                    return retStatusCode(retBuf, retSize, ERR_CODE_PARAM_INVALID);
+                DEVADDR a;
+                string2DEVADDR(a, e);
+                addrs.push_back(a);
+            }
+            auto r = svc->rmBatch(addrs);
+            return retStatusCode(retBuf, retSize, r);
+        }
         case 's':
             // force save
             return retStatusCode(retBuf, retSize, CODE_OK);
@@ -1,4 +1,5 @@
 #include "lorawan/storage/serialization/json-helper.h"
+#include "lorawan/lorawan-string.h"
 
 size_t retJs(
     unsigned char* retBuf,
@@ -81,3 +82,90 @@ bool checkCredentials(
     }
     return true;
 }
+
+bool json2NETWORKIDENTITY(
+    NETWORKIDENTITY &retVal,
+    const nlohmann::json &js
+)
+{
+    if (!js.contains("addr"))
+        return false;
+    auto jAddr = js["addr"];
+    if (!jAddr.is_string())
+        return false;
+    string2DEVADDR(retVal.value.devaddr, jAddr);
+
+    if (js.contains("activation")) {
+        auto jsv = js["activation"];
+        if (jsv.is_string())
+            retVal.value.devid.id.activation = string2activation(jsv);
+    }
+
+    if (js.contains("class")) {
+        auto jsv = js["class"];
+        if (jsv.is_string())
+            retVal.value.devid.setClass(string2deviceclass(jsv));
+    }
+
+    if (js.contains("deveui")) {
+        auto jsv = js["deveui"];
+        if (jsv.is_string())
+            string2DEVEUI(retVal.value.devid.id.devEUI, jsv);
+    }
+
+    if (js.contains("nwkSKey")) {
+        auto jsv = js["nwkSKey"];
+        if (jsv.is_string())
+            string2KEY(retVal.value.devid.id.nwkSKey, jsv);
+    }
+    if (js.contains("appSKey")) {
+        auto jsv = js["appSKey"];
+        if (jsv.is_string())
+            string2KEY(retVal.value.devid.id.appSKey, jsv);
+    }
+
+    if (js.contains("version")) {
+        auto jsv = js["version"];
+        if (jsv.is_string())
+            retVal.value.devid.id.version = string2LORAWAN_VERSION(jsv);
+    }
+
+    if (js.contains("appeui")) {
+        auto jsv = js["appeui"];
+        if (jsv.is_string())
+            string2DEVEUI(retVal.value.devid.id.appEUI, jsv);
+    }
+
+    if (js.contains("appKey")) {
+        auto jsv = js["appKey"];
+        if (jsv.is_string())
+            string2KEY(retVal.value.devid.id.appKey, jsv);
+    }
+
+    if (js.contains("nwkKey")) {
+        auto jsv = js["nwkKey"];
+        if (jsv.is_string())
+            string2KEY(retVal.value.devid.id.nwkKey, jsv);
+    }
+
+    if (js.contains("devNonce")) {
+        auto jsv = js["devNonce"];
+        if (jsv.is_string())
+            retVal.value.devid.id.devNonce = string2DEVNONCE(jsv);
+    }
+
+    if (js.contains("joinNonce")) {
+        auto jsv = js["joinNonce"];
+        if (jsv.is_string())
+            string2JOINNONCE(retVal.value.devid.id.joinNonce, jsv);
+    }
+
+    if (js.contains("name")) {
+        auto jsv = js["name"];
+        if (jsv.is_string()) {
+            std::string s(jsv);
+            string2DEVICENAME(retVal.value.devid.id.name, s.c_str());
+        }
+    }
+    return true;
+}
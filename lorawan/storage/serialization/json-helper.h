@@ -2,6 +2,7 @@
 #define LORAWAN_STORAGE_JSON_HELPER_H
 
 #include <nlohmann/json.hpp>
+#include "lorawan/lorawan-types.h"
 
 size_t retJs(
     unsigned char* retBuf,
@@ -27,4 +28,16 @@ bool checkCredentials(
     uint64_t accessCode
 );
 
+/**
+ * Read identity from JSON object with keys "addr", "activation", "class", "deveui", "nwkSKey", "appSKey", "version",
+ * "appeui", "appKey", "nwkKey", "devNonce", "joinNonce", "name". Missing keys are left default.
+ * @param retVal return identity
+ * @param js JSON object
+ * @return false if object does not have "addr" string
+ */
+bool json2NETWORKIDENTITY(
+    NETWORKIDENTITY &retVal,
+    const nlohmann::json &js
+);
+
 #endif
@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -6,6 +7,8 @@
 #include "lorawan/helper/ip-address.h"
 #include "lorawan/lorawan-error.h"
 #include "lorawan/lorawan-string.h"
+#include "lorawan/lorawan-msg.h"
+#include "lorawan/storage/service/storage-snapshot.h"
 #include "nlohmann/json.hpp"
 
 #ifdef ESP_PLATFORM
@@ -29,6 +32,7 @@ int JsonGatewayService::get(
     const GatewayIdentity &request
 )
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
     if (request.gatewayId) {
         // find out by gateway identifier
         auto r = storage.find(request.gatewayId);
@@ -57,6 +61,7 @@ int  JsonGatewayService::list(
     uint32_t offset,
     uint8_t size
 ) {
+    std::lock_guard<std::mutex> lock(storageMutex);
     size_t o = 0;
     size_t sz = 0;
     for (auto & it : storage) {
@@ -76,6 +81,7 @@ int  JsonGatewayService::list(
 // Entries count
 size_t JsonGatewayService::size()
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
     return storage.size();
 }
 
@@ -83,34 +89,34 @@ int JsonGatewayService::put(
     const GatewayIdentity &request
 )
 {
-    storage[request.gatewayId] = request;
-    return CODE_OK;
+    return MemoryGatewayService::put(request);
 }
 
 int JsonGatewayService::rm(
     const GatewayIdentity &request
 )
 {
-    if (request.gatewayId) {
-        // find out by gateway identifier
-        auto r = storage.find(request.gatewayId);
-        if (r != storage.end()) {
-            storage.erase(r);
-            return CODE_OK;
-        }
-    } else {
-        // reverse find out by address
-        for (auto it(storage.begin()); it != storage.end(); it++) {
-            if (sameSocketAddress(&request.sockaddr, &it->second.sockaddr)) {
-                storage.erase(it);
-                return CODE_OK;
-            }
+    return MemoryGatewayService::rm(request);
+}
+
+/**
+ * Load binary snapshot if it exists and it is not older than JSON file, otherwise import JSON file.
+ * Journal is replayed over loaded gateways by init()
+ * @return true if success
+ */
+bool JsonGatewayService::load()
+{
+    if (isSnapshotActual(snapshotFileName, fileName)) {
+        GatewaySnapshot snapshot;
+        if (snapshot.open(snapshotFileName) == CODE_OK) {
+            snapshot.load(storage);
+            return true;
         }
     }
-    return ERR_CODE_GATEWAY_NOT_FOUND;
+    return loadJson();
 }
 
-bool JsonGatewayService::load()
+bool JsonGatewayService::loadJson()
 {
     std::ifstream f(fileName);
     nlohmann::json js;
@@ -139,12 +145,17 @@ bool JsonGatewayService::load()
     return true;
 }
 
-bool JsonGatewayService::store()
+bool JsonGatewayService::store(
+    const std::map<uint64_t, GatewayIdentity> &values,
+    const std::string &jsonFileName
+)
 {
-    std::ofstream f(fileName);
+    // write temporary file then rename, file is never left partially written
+    std::string tempFileName = jsonFileName + ".tmp";
+    std::ofstream f(tempFileName);
     bool isFirst = true;
     f << "[\n";
-    for (auto& e : this->storage) {
+    for (auto& e : values) {
         if (isFirst)
             isFirst = false;
         else
@@ -153,6 +164,10 @@ bool JsonGatewayService::store()
     }
     f << "]\n";
     f.close();
+    if (!f.good() || std::rename(tempFileName.c_str(), jsonFileName.c_str())) {
+        std::remove(tempFileName.c_str());
+        return false;
+    }
     return true;
 }
 
@@ -162,18 +177,38 @@ int JsonGatewayService::init(
 )
 {
     fileName = option;
+    snapshotFileName = option + SNAPSHOT_FILE_SUFFIX;
     load();
-    return CODE_OK;
+    return openJournal(option);
 }
 
-void JsonGatewayService::flush()
+bool JsonGatewayService::exportJson(
+    const std::string &jsonFileName
+)
 {
-    store();
+    // do not hold storage while JSON file is written
+    std::map<uint64_t, GatewayIdentity> values;
+    {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        values = storage;
+    }
+    return store(values, jsonFileName);
 }
 
+/**
+ * Rewrite own JSON file, then compact journal into the binary snapshot.
+ * Snapshot is not older than JSON file, so it is loaded next time unless JSON file is edited
+ */
 void JsonGatewayService::done()
 {
-    clear();
+    // JSON file is not touched if init() failed
+    if (journal && !fileName.empty()) {
+        if (!exportJson(fileName))
+            std::cerr << ERR_MESSAGE << ERR_CODE_INVALID_JSON << " " << fileName << std::endl;
+        flush();
+    }
+    fileName = "";
+    MemoryGatewayService::done();
 }
 
 void JsonGatewayService::setOption(
@@ -10,7 +10,8 @@
 class JsonGatewayService: public MemoryGatewayService {
 private:
     bool load();
-    bool store();
+    bool loadJson();
+    static bool store(const std::map<uint64_t, GatewayIdentity> &values, const std::string &jsonFileName);
 protected:
     std::string fileName;
 public:
@@ -28,9 +29,17 @@ public:
     int rm(const GatewayIdentity &addr) override;
 
     int init(const std::string &option, void *data) override;
-    void flush() override;
     void done() override;
     void setOption(int option, void *value) override;
+
+    /**
+     * Export gateways to the JSON file.
+     * Storage is copied, it is not locked while the file is written.
+     * flush() compacts journal into the binary snapshot only, done() rewrites own JSON file.
+     * @param jsonFileName JSON file name
+     * @return true if success
+     */
+    bool exportJson(const std::string &jsonFileName);
 };
 
 EXPORT_SHARED_C_FUNC GatewayService* makeGatewayService1();
@@ -86,6 +86,46 @@ int  LMDBGatewayService::list(
     return r;
 }
 
+/**
+ * Position the cursor at the key of the previous page with MDB_SET_RANGE instead of counting offset.
+ * Entries are returned in key (byte) order
+ */
+int LMDBGatewayService::listFrom(
+    std::vector<GatewayIdentity> &retVal,
+    const uint64_t *cursor,
+    size_t size
+)
+{
+    int r = mdb_txn_begin(env.env, nullptr, MDB_RDONLY, &env.txn);
+    if (r)
+        return ERR_CODE_LMDB_TXN_BEGIN;
+    MDB_cursor *dbCursor;
+    r = mdb_cursor_open(env.txn, env.dbi, &dbCursor);
+    if (r != MDB_SUCCESS) {
+        mdb_txn_abort(env.txn);
+        return r;
+    }
+    uint64_t start = cursor ? *cursor : 0;
+    MDB_val dbKey {sizeof(uint64_t), (void *) &start };
+    MDB_val dbVal {};
+    r = mdb_cursor_get(dbCursor, &dbKey, &dbVal, cursor ? MDB_SET_RANGE : MDB_FIRST);
+    // skip the last entry of the previous page
+    if (r == MDB_SUCCESS && cursor && dbKey.mv_size == sizeof(uint64_t) && memcmp(dbKey.mv_data, cursor, sizeof(uint64_t)) == 0)
+        r = mdb_cursor_get(dbCursor, &dbKey, &dbVal, MDB_NEXT);
+    while (r == MDB_SUCCESS && retVal.size() < size) {
+        if (dbKey.mv_size != sizeof(uint64_t) || dbVal.mv_size != sizeof(struct sockaddr))
+            break;  // error, database corrupted
+        GatewayIdentity id;
+        memmove(&id.gatewayId, dbKey.mv_data, sizeof(uint64_t));
+        memmove(&id.sockaddr, dbVal.mv_data, sizeof(struct sockaddr));
+        retVal.emplace_back(id);
+        r = mdb_cursor_get(dbCursor, &dbKey, &dbVal, MDB_NEXT);
+    }
+    mdb_cursor_close(dbCursor);
+    r = mdb_txn_commit(env.txn);
+    return r;
+}
+
 // Entries count
 size_t LMDBGatewayService::size()
 {
@@ -187,6 +227,48 @@ int LMDBGatewayService::rm(
     return r;
 }
 
+/**
+ * One write transaction, see putRecords()
+ */
+int LMDBGatewayService::putBatch(
+    const std::vector<GatewayIdentity> &values
+)
+{
+    std::vector<std::pair<MDB_val, MDB_val>> records;
+    records.reserve(values.size());
+    for (auto &v : values) {
+        records.emplace_back(MDB_val { sizeof(uint64_t), (void *) &v.gatewayId },
+            MDB_val { sizeof(struct sockaddr), (void *) &v.sockaddr });
+    }
+    return putRecords(&env, records);
+}
+
+/**
+ * Remove by gateway identifiers in one transaction, entries without identifier are removed by address one by one
+ */
+int LMDBGatewayService::rmBatch(
+    const std::vector<GatewayIdentity> &values
+)
+{
+    std::vector<MDB_val> keys;
+    keys.reserve(values.size());
+    for (auto &v : values) {
+        if (v.gatewayId)
+            keys.push_back(MDB_val { sizeof(uint64_t), (void *) &v.gatewayId });
+    }
+    int r = delRecords(&env, keys);
+    if (r)
+        return r;
+    for (auto &v : values) {
+        if (!v.gatewayId) {
+            r = rm(v);
+            if (r && r != MDB_NOTFOUND)
+                return r;
+        }
+    }
+    return CODE_OK;
+}
+
 int LMDBGatewayService::init(
     const std::string &databaseName,
     void *data
@@ -1,20 +1,27 @@
 #include <cstring>
+#include <iostream>
 
 #include "gateway-service-mem.h"
 #include "lorawan/helper/ip-address.h"
 #include "lorawan/lorawan-types.h"
 #include "lorawan/lorawan-error.h"
 #include "lorawan/lorawan-string.h"
+#include "lorawan/lorawan-msg.h"
+#include "lorawan/storage/service/storage-snapshot.h"
 
 #ifdef ESP_PLATFORM
-#include <iostream>
 #include "platform-defs.h"
 #endif
 
 MemoryGatewayService::MemoryGatewayService()
-= default;
+    : journal(nullptr), persistent(false)
+{
+}
 
-MemoryGatewayService::~MemoryGatewayService() = default;
+MemoryGatewayService::~MemoryGatewayService()
+{
+    closeJournal();
+}
 
 void MemoryGatewayService::clear()
 {
@@ -32,6 +39,7 @@ int MemoryGatewayService::get(
     const GatewayIdentity &request
 )
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
     if (request.gatewayId) {
         // find out by gateway identifier
         auto r = storage.find(request.gatewayId);
@@ -61,6 +69,7 @@ int  MemoryGatewayService::list(
     uint8_t size
 )
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
     size_t o = 0;
     size_t sz = 0;
     for (auto & it : storage) {
@@ -77,9 +86,24 @@ int  MemoryGatewayService::list(
     return CODE_OK;
 }
 
+int MemoryGatewayService::listFrom(
+    std::vector<GatewayIdentity> &retVal,
+    const uint64_t *cursor,
+    size_t size
+)
+{
+    std::lock_guard<std::mutex> lock(storageMutex);
+    auto it = cursor ? storage.upper_bound(*cursor) : storage.begin();
+    for (; it != storage.end() && size; it++, size--) {
+        retVal.push_back(it->second);
+    }
+    return CODE_OK;
+}
+
 // Entries count
 size_t MemoryGatewayService::size()
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
     return storage.size();
 }
 
@@ -87,57 +111,201 @@ int MemoryGatewayService::put(
     const GatewayIdentity &request
 )
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
     storage[request.gatewayId] = request;
+    if (journal) {
+        char rec[SIZE_SNAPSHOT_GATEWAY_RECORD];
+        GatewaySnapshot::toRecord(rec, request);
+        int r = journal->append(JOURNAL_OP_PUT, rec);
+        if (r)
+            return r;
+        if (journal->needCompact())
+            return compact();
+    }
     return CODE_OK;
 }
 
-int MemoryGatewayService::rm(
+std::map<uint64_t, GatewayIdentity>::iterator MemoryGatewayService::find(
     const GatewayIdentity &request
 )
 {
     if (request.gatewayId) {
         // find out by gateway identifier
-        auto r = storage.find(request.gatewayId);
-        if (r != storage.end()) {
-            storage.erase(r);
-            return CODE_OK;
-        }
-    } else {
-        // reverse find out by address
-        for (auto it(storage.begin()); it != storage.end(); it++) {
-            if (sameSocketAddress(&request.sockaddr, &it->second.sockaddr)) {
-                storage.erase(it);
-                return CODE_OK;
-            }
+        return storage.find(request.gatewayId);
+    }
+    // reverse find out by address
+    for (auto it(storage.begin()); it != storage.end(); it++) {
+        if (sameSocketAddress(&request.sockaddr, &it->second.sockaddr))
+            return it;
+    }
+    return storage.end();
+}
+
+int MemoryGatewayService::rm(
+    const GatewayIdentity &request
+)
+{
+    std::lock_guard<std::mutex> lock(storageMutex);
+    auto r = find(request);
+    if (r == storage.end())
+        return ERR_CODE_GATEWAY_NOT_FOUND;
+    if (journal) {
+        char rec[SIZE_SNAPSHOT_GATEWAY_RECORD];
+        GatewaySnapshot::toRecord(rec, r->second);
+        storage.erase(r);
+        int jr = journal->append(JOURNAL_OP_RM, rec);
+        if (jr)
+            return jr;
+        if (journal->needCompact())
+            return compact();
+    } else
+        storage.erase(r);
+    return CODE_OK;
+}
+
+int MemoryGatewayService::putBatch(
+    const std::vector<GatewayIdentity> &values
+)
+{
+    std::lock_guard<std::mutex> lock(storageMutex);
+    std::vector<char> recs;
+    if (journal)
+        recs.resize(values.size() * SIZE_SNAPSHOT_GATEWAY_RECORD);
+    char *rec = recs.data();
+    for (auto &v : values) {
+        storage[v.gatewayId] = v;
+        if (journal) {
+            GatewaySnapshot::toRecord(rec, v);
+            rec += SIZE_SNAPSHOT_GATEWAY_RECORD;
         }
     }
-    return ERR_CODE_GATEWAY_NOT_FOUND;
+    if (journal) {
+        int r = journal->appendBatch(JOURNAL_OP_PUT, recs.data(), values.size());
+        if (r)
+            return r;
+        if (journal->needCompact())
+            return compact();
+    }
+    return CODE_OK;
+}
+
+int MemoryGatewayService::rmBatch(
+    const std::vector<GatewayIdentity> &values
+)
+{
+    std::lock_guard<std::mutex> lock(storageMutex);
+    std::vector<char> recs;
+    if (journal)
+        recs.resize(values.size() * SIZE_SNAPSHOT_GATEWAY_RECORD);
+    size_t removed = 0;
+    for (auto &v : values) {
+        auto r = find(v);
+        if (r == storage.end())
+            continue;
+        if (journal)
+            GatewaySnapshot::toRecord(recs.data() + removed * SIZE_SNAPSHOT_GATEWAY_RECORD, r->second);
+        storage.erase(r);
+        removed++;
+    }
+    if (journal) {
+        int r = journal->appendBatch(JOURNAL_OP_RM, recs.data(), removed);
+        if (r)
+            return r;
+        if (journal->needCompact())
+            return compact();
+    }
+    return CODE_OK;
+}
+
+int MemoryGatewayService::openJournal(
+    const std::string &databaseName
+)
+{
+    closeJournal();
+    journal = new StorageJournal(JOURNAL_MAGIC_GATEWAY, SIZE_SNAPSHOT_GATEWAY_RECORD);
+    int r = journal->open(databaseName + JOURNAL_FILE_SUFFIX, [this] (char op, const char *record) {
+        GatewayIdentity gi;
+        GatewaySnapshot::fromRecord(gi, record);
+        if (op == JOURNAL_OP_PUT)
+            storage[gi.gatewayId] = gi;
+        else
+            storage.erase(gi.gatewayId);
+    });
+    if (r) {
+        delete journal;
+        journal = nullptr;
+    }
+    return r;
+}
+
+void MemoryGatewayService::closeJournal()
+{
+    if (journal) {
+        delete journal;
+        journal = nullptr;
+    }
+}
+
+int MemoryGatewayService::compact()
+{
+    int r = GatewaySnapshot::save(snapshotFileName, storage);
+    if (r) {
+        std::cerr << ERR_MESSAGE << r << " " << snapshotFileName << std::endl;
+        return r;
+    }
+    // snapshot contains all journal records
+    if (journal)
+        r = journal->reset();
+    return r;
 }
 
+/**
+ * @param option if persistent is set, load <option>.snapshot and replay <option>.journal, otherwise not used
+ * @param data not used
+ * @return CODE_OK- success
+ */
 int MemoryGatewayService::init(
     const std::string &option,
     void *data
 )
 {
-    return CODE_OK;
+    if (!persistent || option.empty())
+        return CODE_OK;
+    snapshotFileName = option + SNAPSHOT_FILE_SUFFIX;
+    GatewaySnapshot snapshot;
+    if (snapshot.open(snapshotFileName) == CODE_OK)
+        snapshot.load(storage);
+    return openJournal(option);
 }
 
 void MemoryGatewayService::flush()
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
+    if (journal)
+        compact();
 }
 
 void MemoryGatewayService::done()
 {
+    closeJournal();
     clear();
 }
 
+/**
+ * Set options
+ * @param option 3- journal
+ * @param value 3- bool, set before init()
+ */
 void MemoryGatewayService::setOption(
     int option,
     void *value
 )
 
 {
-    // nothing to do
+    if (!value)
+        return;
+    if (option == 3)
+        persistent = *(bool *) value;
 }
 
 EXPORT_SHARED_C_FUNC GatewayService* makeGatewayService()
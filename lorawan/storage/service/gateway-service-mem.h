@@ -6,12 +6,29 @@
 #include <map>
 #include "lorawan/storage/service/gateway-service.h"
 #include "lorawan/helper/plugin-helper.h"
+#include "lorawan/storage/service/storage-journal.h"
 
+/**
+ * In-memory gateway storage.
+ * If persistent is set (or option 3 by setOption()) and init() option is not empty, put/rm are appended to the <option>.journal file and
+ * journal is compacted into the <option>.snapshot file, see StorageJournal.
+ */
 class MemoryGatewayService: public GatewayService {
 protected:
     std::map<uint64_t, GatewayIdentity> storage;
+    std::mutex storageMutex;    ///< storage can be shared by listener threads
+    std::string snapshotFileName;
+    StorageJournal *journal;    ///< nullptr if storage is not persistent
     void clear();
+    /**
+     * Find entry by gateway identifier, or by address if identifier is 0
+     */
+    std::map<uint64_t, GatewayIdentity>::iterator find(const GatewayIdentity &request);
+    int openJournal(const std::string &databaseName);
+    void closeJournal();
+    int compact();
 public:
+    bool persistent;            ///< init() opens journal, default false. Set before init()
     MemoryGatewayService();
     ~MemoryGatewayService() override;
     int get(GatewayIdentity &retVal, const GatewayIdentity &request) override;
@@ -20,10 +37,16 @@ public:
         uint32_t offset,
         uint8_t size
     ) override;
+    int listFrom(std::vector<GatewayIdentity> &retVal,
+        const uint64_t *cursor,
+        size_t size
+    ) override;
     // Entries count
     size_t size() override;
     int put(const GatewayIdentity &request) override;
     int rm(const GatewayIdentity &addr) override;
+    int putBatch(const std::vector<GatewayIdentity> &values) override;
+    int rmBatch(const std::vector<GatewayIdentity> &values) override;
 
     int init(const std::string &option, void *data) override;
     void flush() override;
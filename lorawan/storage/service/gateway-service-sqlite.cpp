@@ -87,6 +87,46 @@ int SqliteGatewayService::list(
     return CODE_OK;
 }
 
+/**
+ * Seek to the cursor by primary key instead of OFFSET.
+ * Identifier is stored as hex string without leading zeroes, shorter string is less
+ */
+int SqliteGatewayService::listFrom(
+    std::vector<GatewayIdentity> &retVal,
+    const uint64_t *cursor,
+    size_t size
+)
+{
+    if (!db)
+        return ERR_CODE_DB_DATABASE_NOT_FOUND;
+    char *zErrMsg = nullptr;
+    std::stringstream statement;
+    statement << "SELECT id, addr FROM gateway";
+    if (cursor) {
+        std::string id = gatewayId2str(*cursor);
+        statement << " WHERE length(id) > " << id.size()
+            << " OR (length(id) = " << id.size() << " AND id > '" << id << "')";
+    }
+    statement << " ORDER BY length(id), id LIMIT " << size;
+    std::vector<std::vector<std::string>> table;
+    int r = sqlite3_exec(db, statement.str().c_str(), tableCallback, &table, &zErrMsg);
+    if (r != SQLITE_OK) {
+        if (zErrMsg) {
+            sqlite3_free(zErrMsg);
+        }
+        return ERR_CODE_DB_SELECT;
+    }
+    for (auto &row : table) {
+        if (row.size() < 2)
+            continue;
+        GatewayIdentity gi;
+        gi.gatewayId = string2gatewayId(row[0]);
+        string2sockaddr(&gi.sockaddr, row[1]);
+        retVal.push_back(gi);
+    }
+    return CODE_OK;
+}
+
 // Entries count
 size_t SqliteGatewayService::size()
 {
@@ -189,6 +229,85 @@ static int createDatabaseFile(
     return r;
 }
 
+/**
+ * One transaction, statement is prepared once and re-used for each gateway
+ */
+int SqliteGatewayService::putBatch(
+    const std::vector<GatewayIdentity> &values
+)
+{
+    if (!db)
+        return ERR_CODE_DB_DATABASE_NOT_FOUND;
+    if (execStatement(db, "BEGIN") != SQLITE_OK)
+        return ERR_CODE_DB_START_TRANSACTION;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "INSERT INTO gateway (id, addr) VALUES (?, ?) ON CONFLICT(id) DO UPDATE SET addr=excluded.addr",
+        -1, &stmt, nullptr) != SQLITE_OK) {
+        execStatement(db, "ROLLBACK");
+        return ERR_CODE_DB_INSERT;
+    }
+    for (auto &v : values) {
+        bindText(stmt, 1, gatewayId2str(v.gatewayId));
+        bindText(stmt, 2, sockaddr2string(&v.sockaddr));
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            sqlite3_finalize(stmt);
+            execStatement(db, "ROLLBACK");
+            return ERR_CODE_DB_INSERT;
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if (execStatement(db, "COMMIT") != SQLITE_OK) {
+        execStatement(db, "ROLLBACK");
+        return ERR_CODE_DB_COMMIT_TRANSACTION;
+    }
+    return CODE_OK;
+}
+
+int SqliteGatewayService::rmBatch(
+    const std::vector<GatewayIdentity> &values
+)
+{
+    if (!db)
+        return ERR_CODE_DB_DATABASE_NOT_FOUND;
+    if (execStatement(db, "BEGIN") != SQLITE_OK)
+        return ERR_CODE_DB_START_TRANSACTION;
+    sqlite3_stmt *byId;
+    sqlite3_stmt *byAddr;
+    if (sqlite3_prepare_v2(db, "DELETE FROM gateway WHERE id = ?", -1, &byId, nullptr) != SQLITE_OK) {
+        execStatement(db, "ROLLBACK");
+        return ERR_CODE_DB_EXEC;
+    }
+    if (sqlite3_prepare_v2(db, "DELETE FROM gateway WHERE addr = ?", -1, &byAddr, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(byId);
+        execStatement(db, "ROLLBACK");
+        return ERR_CODE_DB_EXEC;
+    }
+    int r = CODE_OK;
+    for (auto &v : values) {
+        sqlite3_stmt *stmt;
+        if (v.gatewayId) {
+            stmt = byId;
+            bindText(stmt, 1, gatewayId2str(v.gatewayId));
+        } else {
+            stmt = byAddr;
+            bindText(stmt, 1, sockaddr2string(&v.sockaddr));
+        }
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            r = ERR_CODE_DB_EXEC;
+            break;
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(byId);
+    sqlite3_finalize(byAddr);
+    if (r == CODE_OK && execStatement(db, "COMMIT") != SQLITE_OK)
+        r = ERR_CODE_DB_COMMIT_TRANSACTION;
+    if (r)
+        execStatement(db, "ROLLBACK");
+    return r;
+}
+
 int SqliteGatewayService::init(
     const std::string &databaseName,
     void *database
@@ -18,10 +18,16 @@ public:
         uint32_t offset,
         uint8_t size
     ) override;
+    int listFrom(std::vector<GatewayIdentity> &retVal,
+        const uint64_t *cursor,
+        size_t size
+    ) override;
     // Entries count
     size_t size() override;
     int put(const GatewayIdentity &request) override;
     int rm(const GatewayIdentity &addr) override;
+    int putBatch(const std::vector<GatewayIdentity> &values) override;
+    int rmBatch(const std::vector<GatewayIdentity> &values) override;
 
     int init(const std::string &dbName, void *db) override;
     void flush() override;
@@ -1,6 +1,64 @@
 #include "lorawan/lorawan-conv.h"
 #include "gateway-service.h"
+#include "lorawan/lorawan-error.h"
 
 GatewayService::GatewayService() = default;
 
 GatewayService::~GatewayService() = default;
+
+/**
+ * Default implementation pages over list(), it expects list() returns entries in identifier order
+ */
+int GatewayService::listFrom(
+    std::vector<GatewayIdentity> &retVal,
+    const uint64_t *cursor,
+    size_t size
+)
+{
+    uint32_t offset = 0;
+    std::vector<GatewayIdentity> page;
+    while (retVal.size() < size) {
+        page.clear();
+        int r = list(page, offset, 255);
+        if (r)
+            return r;
+        if (page.empty())
+            break;
+        offset += (uint32_t) page.size();
+        for (auto &i : page) {
+            if (cursor && i.gatewayId <= *cursor)
+                continue;
+            retVal.push_back(i);
+            if (retVal.size() >= size)
+                break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Default implementation puts entries one by one and stops at the first error
+ */
+int GatewayService::putBatch(
+    const std::vector<GatewayIdentity> &values
+)
+{
+    for (auto &v : values) {
+        int r = put(v);
+        if (r)
+            return r;
+    }
+    return CODE_OK;
+}
+
+int GatewayService::rmBatch(
+    const std::vector<GatewayIdentity> &values
+)
+{
+    for (auto &v : values) {
+        int r = rm(v);
+        if (r && r != ERR_CODE_GATEWAY_NOT_FOUND)
+            return r;
+    }
+    return CODE_OK;
+}
@@ -30,6 +30,20 @@ public:
     // Remove entry
     virtual int rm(const GatewayIdentity &identity) = 0;
 
+    /**
+     * Add or replace entries at once, backend applies batch in one transaction if it can
+     * @param values gateway identifiers and addresses
+     * @return CODE_OK- success
+     */
+    virtual int putBatch(const std::vector<GatewayIdentity> &values);
+
+    /**
+     * Remove entries at once, absent entries are skipped
+     * @param values gateway identifiers, or addresses if identifier is 0
+     * @return CODE_OK- success
+     */
+    virtual int rmBatch(const std::vector<GatewayIdentity> &values);
+
     /**
      * List entries
      * @param retVal return values
@@ -44,6 +58,19 @@ public:
         uint8_t size
     ) = 0;
 
+    /**
+     * Cursor based list
+     * @param retVal return values in gateway identifier order
+     * @param cursor last gateway identifier of the previous page, NULL- first page
+     * @param size max entries to return
+     * @return CODE_OK- success
+     */
+    virtual int listFrom(
+        std::vector<GatewayIdentity> &retVal,
+        const uint64_t *cursor,
+        size_t size
+    );
+
     // Entries count
     virtual size_t size() = 0;
 
@@ -56,6 +83,11 @@ public:
     // close resources
     virtual void done() = 0;
 
+    /**
+     * Set options
+     * @param option 3- journal
+     * @param value 3- bool
+     */
     virtual void setOption(int option, void *value) = 0;
 };
 
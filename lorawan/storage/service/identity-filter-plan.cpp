@@ -0,0 +1,304 @@
+#include <cstddef>
+#include <cstring>
+
+#include "lorawan/storage/service/identity-filter-plan.h"
+
+#define NIP_COUNT 14
+
+static const size_t DEVICE_ID_PROPERTY_OFFSETS[NIP_COUNT] {
+    offsetof(DEVICE_ID, activation),
+    0,  // address is not a part of DEVICE_ID
+    offsetof(DEVICE_ID, activation),
+    offsetof(DEVICE_ID, deviceclass),
+    offsetof(DEVICE_ID, devEUI),
+    offsetof(DEVICE_ID, nwkSKey),
+    offsetof(DEVICE_ID, appSKey),
+    offsetof(DEVICE_ID, version),
+    // OTAA
+    offsetof(DEVICE_ID, appEUI),
+    offsetof(DEVICE_ID, appKey),
+    offsetof(DEVICE_ID, nwkKey),
+    offsetof(DEVICE_ID, devNonce),
+    offsetof(DEVICE_ID, joinNonce),
+    // added for searching
+    offsetof(DEVICE_ID, name)
+};
+
+static const size_t DEVICE_ID_PROPERTY_SIZES[NIP_COUNT] {
+    0,
+    sizeof(DEVADDR::u),
+    sizeof(DEVICE_ID::activation),
+    sizeof(DEVICE_ID::deviceclass),
+    sizeof(DEVICE_ID::devEUI.u),
+    sizeof(DEVICE_ID::nwkSKey.u),
+    sizeof(DEVICE_ID::appSKey.u),
+    sizeof(DEVICE_ID::version.c),
+    // OTAA
+    sizeof(DEVICE_ID::appEUI.u),
+    sizeof(DEVICE_ID::appKey.u),
+    sizeof(DEVICE_ID::nwkKey.u),
+    sizeof(DEVICE_ID::devNonce.u),
+    sizeof(DEVICE_ID::joinNonce.c),
+    // added for searching
+    sizeof(DEVICE_ID::name.c)
+};
+
+template <int OP, typename T>
+static inline bool compareValues(
+    T a,
+    T b
+)
+{
+    switch (OP) {
+        case NICO_EQ:
+            return a == b;
+        case NICO_NE:
+            return a != b;
+        case NICO_GT:
+            return a > b;
+        case NICO_LT:
+            return a < b;
+        case NICO_GE:
+            return a >= b;
+        case NICO_LE:
+            return a <= b;
+        default:
+            return false;
+    }
+}
+
+template <int OP>
+static inline bool compareResult(
+    int c
+)
+{
+    return compareValues<OP, int>(c, 0);
+}
+
+static bool matchNone(
+    const IdentityFilterTerm &term,
+    const DEVADDR &addr,
+    const DEVICE_ID &deviceId
+)
+{
+    return false;
+}
+
+template <int OP>
+static bool matchAddress(
+    const IdentityFilterTerm &term,
+    const DEVADDR &addr,
+    const DEVICE_ID &deviceId
+)
+{
+    return compareValues<OP, uint32_t>(addr.u, (uint32_t) term.value);
+}
+
+template <int OP>
+static bool matchAddressBytes(
+    const IdentityFilterTerm &term,
+    const DEVADDR &addr,
+    const DEVICE_ID &deviceId
+)
+{
+    return compareResult<OP>(memcmp(&addr.u, term.data, term.size));
+}
+
+template <int OP>
+static bool matchEUI(
+    const IdentityFilterTerm &term,
+    const DEVADDR &addr,
+    const DEVICE_ID &deviceId
+)
+{
+    uint64_t v;
+    memcpy(&v, (const char *) &deviceId + term.offset, sizeof(v));
+    return compareValues<OP, uint64_t>(v, term.value);
+}
+
+template <int OP, size_t N>
+static bool matchBytes(
+    const IdentityFilterTerm &term,
+    const DEVADDR &addr,
+    const DEVICE_ID &deviceId
+)
+{
+    return compareResult<OP>(memcmp((const char *) &deviceId + term.offset, term.data, N));
+}
+
+template <int OP>
+static bool matchBytesN(
+    const IdentityFilterTerm &term,
+    const DEVADDR &addr,
+    const DEVICE_ID &deviceId
+)
+{
+    return compareResult<OP>(memcmp((const char *) &deviceId + term.offset, term.data, term.size));
+}
+
+template <int OP>
+static IdentityFilterMatch termMatch(
+    enum NETWORK_IDENTITY_PROPERTY property,
+    size_t size
+)
+{
+    if (property == NIP_ADDRESS)
+        return size == sizeof(uint32_t) ? matchAddress<OP> : matchAddressBytes<OP>;
+    if ((property == NIP_DEVEUI || property == NIP_APPEUI) && size == sizeof(uint64_t))
+        return matchEUI<OP>;
+    switch (size) {
+        case 1:
+            return matchBytes<OP, 1>;
+        case 2:
+            return matchBytes<OP, 2>;
+        case 4:
+            return matchBytes<OP, 4>;
+        case 8:
+            return matchBytes<OP, 8>;
+        case 16:
+            return matchBytes<OP, 16>;
+        default:
+            return matchBytesN<OP>;
+    }
+}
+
+static IdentityFilterMatch termMatch(
+    enum NETWORK_IDENTITY_COMPARISON_OPERATOR op,
+    enum NETWORK_IDENTITY_PROPERTY property,
+    size_t size
+)
+{
+    switch (op) {
+        case NICO_EQ:
+            return termMatch<NICO_EQ>(property, size);
+        case NICO_NE:
+            return termMatch<NICO_NE>(property, size);
+        case NICO_GT:
+            return termMatch<NICO_GT>(property, size);
+        case NICO_LT:
+            return termMatch<NICO_LT>(property, size);
+        case NICO_GE:
+            return termMatch<NICO_GE>(property, size);
+        case NICO_LE:
+            return termMatch<NICO_LE>(property, size);
+        default:
+            return matchNone;
+    }
+}
+
+/**
+ * Narrow inclusive range [low, high] by comparison with value
+ * @return false if range is empty
+ */
+template <typename T>
+static bool narrowRange(
+    T &low,
+    T &high,
+    enum NETWORK_IDENTITY_COMPARISON_OPERATOR op,
+    T value
+)
+{
+    switch (op) {
+        case NICO_EQ:
+            if (value > low)
+                low = value;
+            if (value < high)
+                high = value;
+            break;
+        case NICO_GT:
+            if (value == (T) ~(T) 0)
+                return false;
+            if (value + 1 > low)
+                low = value + 1;
+            break;
+        case NICO_GE:
+            if (value > low)
+                low = value;
+            break;
+        case NICO_LT:
+            if (value == 0)
+                return false;
+            if (value - 1 < high)
+                high = value - 1;
+            break;
+        case NICO_LE:
+            if (value < high)
+                high = value;
+            break;
+        default:
+            break;
+    }
+    return low <= high;
+}
+
+IdentityFilterPlan::IdentityFilterPlan(
+    const std::vector<NETWORK_IDENTITY_FILTER> &filters
+)
+    : hasOr(false), empty(false), addrLow(0), addrHigh(UINT32_MAX), euiLow(0), euiHigh(UINT64_MAX)
+{
+    terms.reserve(filters.size());
+    for (auto &f : filters) {
+        if (f.pre == NILPO_OR)
+            hasOr = true;
+    }
+    for (auto &f : filters) {
+        IdentityFilterTerm t {};
+        int p = (int) f.property;
+        if (p < 0 || p >= NIP_COUNT)
+            p = NIP_NONE;
+        t.pre = f.pre;
+        t.offset = DEVICE_ID_PROPERTY_OFFSETS[p];
+        t.size = DEVICE_ID_PROPERTY_SIZES[p];
+        if (f.length < t.size)
+            t.size = f.length;
+        memmove(t.data, f.filterData, sizeof(t.data));
+        t.match = termMatch(f.comparisonOperator, (enum NETWORK_IDENTITY_PROPERTY) p, t.size);
+        if (p == NIP_ADDRESS && t.size == sizeof(uint32_t)) {
+            uint32_t v;
+            memcpy(&v, f.filterData, sizeof(v));
+            t.value = v;
+            if (!hasOr && !narrowRange<uint32_t>(addrLow, addrHigh, f.comparisonOperator, v))
+                empty = true;
+        }
+        if ((p == NIP_DEVEUI || p == NIP_APPEUI) && t.size == sizeof(uint64_t)) {
+            memcpy(&t.value, f.filterData, sizeof(t.value));
+            if (p == NIP_DEVEUI && !hasOr && !narrowRange<uint64_t>(euiLow, euiHigh, f.comparisonOperator, t.value))
+                empty = true;
+        }
+        terms.push_back(t);
+    }
+}
+
+bool IdentityFilterPlan::match(
+    const DEVADDR &addr,
+    const DEVICE_ID &deviceId
+) const
+{
+    bool r = true;
+    for (auto &t : terms) {
+        bool c = t.match(t, addr, deviceId);
+        if (t.pre == NILPO_OR)
+            r |= c;
+        else {
+            r &= c;
+            if (!r && !hasOr)
+                return false;
+        }
+    }
+    return r;
+}
+
+bool IdentityFilterPlan::isAddressRange() const
+{
+    return addrLow > 0 || addrHigh < UINT32_MAX;
+}
+
+bool IdentityFilterPlan::isEUIRange() const
+{
+    return euiLow > 0 || euiHigh < UINT64_MAX;
+}
+
+bool IdentityFilterPlan::isEUIEqual() const
+{
+    return euiLow == euiHigh;
+}
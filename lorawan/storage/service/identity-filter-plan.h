@@ -0,0 +1,63 @@
+#ifndef IDENTITY_FILTER_PLAN_H_
+#define IDENTITY_FILTER_PLAN_H_ 1
+
+#include <vector>
+#include "lorawan/lorawan-types.h"
+
+/**
+ * Filters compiled once per IdentityService::filter() call.
+ * Each filter is turned to the term with the comparison function specialized for the property type and operator:
+ * address and EUIs are compared as numbers, other properties are compared by memcmp() of fixed size.
+ * If filters are joined by AND only, range of address and DevEUI is extracted so backend can seek
+ * ordered index instead of full scan.
+ */
+
+#define IDENTITY_FILTER_PARALLEL_SIZE   65536   ///< scan storage in parallel threads if it has more entries
+#define IDENTITY_FILTER_MAX_THREADS     8
+
+class IdentityFilterTerm;
+
+typedef bool (*IdentityFilterMatch)(
+    const IdentityFilterTerm &term,
+    const DEVADDR &addr,
+    const DEVICE_ID &deviceId
+);
+
+class IdentityFilterTerm {
+public:
+    enum NETWORK_IDENTITY_LOGICAL_PRE_OPERATOR pre;
+    IdentityFilterMatch match;
+    size_t offset;          ///< property offset in the DEVICE_ID
+    size_t size;            ///< bytes to compare
+    uint64_t value;         ///< address or EUI
+    char data[16];
+};
+
+class IdentityFilterPlan {
+public:
+    std::vector<IdentityFilterTerm> terms;
+    bool hasOr;             ///< at least one filter joined by OR, ranges are not used
+    bool empty;             ///< ranges can not match any identity
+    // inclusive ranges, whole space if filters do not restrict it
+    uint32_t addrLow;
+    uint32_t addrHigh;
+    uint64_t euiLow;
+    uint64_t euiHigh;
+
+    explicit IdentityFilterPlan(
+        const std::vector<NETWORK_IDENTITY_FILTER> &filters
+    );
+    /**
+     * Filters are joined left to right, AND and OR have equal priority
+     * @return true if identity matches all filters
+     */
+    bool match(
+        const DEVADDR &addr,
+        const DEVICE_ID &deviceId
+    ) const;
+    bool isAddressRange() const;
+    bool isEUIRange() const;
+    bool isEUIEqual() const;
+};
+
+#endif
@@ -1,10 +1,13 @@
+#include <cstdio>
 #include <sstream>
 #include <iostream>
 #include <fstream>
 #include "lorawan/storage/service/identity-service-json.h"
 #include "lorawan/lorawan-error.h"
 #include "lorawan/lorawan-string.h"
+#include "lorawan/lorawan-msg.h"
 #include "lorawan/helper/file-helper.h"
+#include "lorawan/storage/service/storage-snapshot.h"
 
 #ifdef ESP_PLATFORM
 #include <iostream>
@@ -15,31 +18,13 @@ JsonIdentityService::JsonIdentityService() = default;
 
 JsonIdentityService::~JsonIdentityService() = default;
 
-/**
- * request device identifier by network address. Return 0 if success, retval = EUI and keys
- * @param retval device identifier
- * @param devaddr network address
- * @return CODE_OK- success
- */
-int JsonIdentityService::get(
-    DEVICEID &retVal,
-    const DEVADDR &request
-)
-{
-    auto r = storage.find(request);
-    if (r != storage.end())
-        retVal = r->second;
-    else
-        return ERR_CODE_GATEWAY_NOT_FOUND;
-    return CODE_OK;
-}
-
 // List entries
 int JsonIdentityService::list(
     std::vector<NETWORKIDENTITY> &retVal,
     uint32_t offset,
     uint8_t size
 ) {
+    std::lock_guard<std::mutex> lock(storageMutex);
     size_t o = 0;
     size_t sz = 0;
     for (auto & it : storage) {
@@ -59,6 +44,7 @@ int JsonIdentityService::list(
 // Entries count
 size_t JsonIdentityService::size()
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
     return storage.size();
 }
 
@@ -73,6 +59,7 @@ int JsonIdentityService::getNetworkIdentity(
     const DEVEUI &eui
 )
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
     for(auto & it : storage) {
         if (it.second.id.devEUI.u == eui.u) {
             retVal.value.devaddr = it.first;
@@ -93,24 +80,34 @@ int JsonIdentityService::put(
     const DEVICEID &id
 )
 {
-    storage[devAddr] = id;
-    return CODE_OK;
+    return MemoryIdentityService::put(devAddr, id);
 }
 
 int JsonIdentityService::rm(
     const DEVADDR &addr
 )
 {
-    // find out by gateway identifier
-    auto r = storage.find(addr);
-    if (r != storage.end()) {
-        storage.erase(r);
-        return CODE_OK;
-    }
-    return ERR_CODE_DEVICE_ADDRESS_NOTFOUND;
+    return MemoryIdentityService::rm(addr);
 }
 
+/**
+ * Load binary snapshot if it exists and it is not older than JSON file, otherwise import JSON file.
+ * Journal is replayed over loaded identities by init()
+ * @return true if success
+ */
 bool JsonIdentityService::load()
+{
+    if (isSnapshotActual(snapshotFileName, fileName)) {
+        IdentitySnapshot snapshot;
+        if (snapshot.open(snapshotFileName) == CODE_OK) {
+            snapshot.load(storage);
+            return true;
+        }
+    }
+    return loadJson();
+}
+
+bool JsonIdentityService::loadJson()
 {
     std::ifstream f(fileName);
     nlohmann::json js;
@@ -160,12 +157,17 @@ bool JsonIdentityService::load()
     return true;
 }
 
-bool JsonIdentityService::store()
+bool JsonIdentityService::store(
+    const std::map<DEVADDR, DEVICEID> &values,
+    const std::string &jsonFileName
+)
 {
-    std::ofstream f(fileName);
+    // write temporary file then rename, file is never left partially written
+    std::string tempFileName = jsonFileName + ".tmp";
+    std::ofstream f(tempFileName);
     bool isFirst = true;
     f << "[\n";
-    for (auto& e : this->storage) {
+    for (auto& e : values) {
         if (isFirst)
             isFirst = false;
         else
@@ -174,6 +176,10 @@ bool JsonIdentityService::store()
     }
     f << "]\n";
     f.close();
+    if (!f.good() || std::rename(tempFileName.c_str(), jsonFileName.c_str())) {
+        std::remove(tempFileName.c_str());
+        return false;
+    }
     return true;
 }
 
@@ -183,17 +189,41 @@ int JsonIdentityService::init(
 )
 {
     fileName = databaseName;
-    return load() ? CODE_OK : ERR_CODE_INVALID_JSON;
+    snapshotFileName = databaseName + SNAPSHOT_FILE_SUFFIX;
+    if (!load())
+        return ERR_CODE_INVALID_JSON;
+    int r = openJournal(databaseName);
+    reindex();
+    return r;
 }
 
-void JsonIdentityService::flush()
+bool JsonIdentityService::exportJson(
+    const std::string &jsonFileName
+)
 {
-    store();
+    // do not hold storage while JSON file is written
+    std::map<DEVADDR, DEVICEID> values;
+    {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        values = storage;
+    }
+    return store(values, jsonFileName);
 }
 
+/**
+ * Rewrite own JSON file, then compact journal into the binary snapshot.
+ * Snapshot is not older than JSON file, so it is loaded next time unless JSON file is edited
+ */
 void JsonIdentityService::done()
 {
-    storage.clear();
+    // JSON file is not touched if init() failed
+    if (journal && !fileName.empty()) {
+        if (!exportJson(fileName))
+            std::cerr << ERR_MESSAGE << ERR_CODE_INVALID_JSON << " " << fileName << std::endl;
+        flush();
+    }
+    fileName = "";
+    MemoryIdentityService::done();
 }
 
 /**
@@ -8,13 +8,13 @@
 class JsonIdentityService: public MemoryIdentityService {
 private:
     bool load();
-    bool store();
+    bool loadJson();
+    static bool store(const std::map<DEVADDR, DEVICEID> &values, const std::string &jsonFileName);
 protected:
     std::string fileName;
 public:
     JsonIdentityService();
     ~JsonIdentityService() override;
-    int get(DEVICEID &retVal, const DEVADDR &request) override;
     // List entries
     int list(std::vector<NETWORKIDENTITY> &retVal, uint32_t offset, uint8_t size) override;
     size_t size() override;
@@ -24,7 +24,6 @@ public:
     int rm(const DEVADDR &addr) override;
 
     int init(const std::string &dbName, void *db) override;
-    void flush() override;
     void done() override;
 
     /**
@@ -33,6 +32,15 @@ public:
      */
     int next(NETWORKIDENTITY &retVal) override;
     void setOption(int option, void *value) override;
+
+    /**
+     * Export identities to the JSON file.
+     * Storage is copied, it is not locked while the file is written.
+     * flush() compacts journal into the binary snapshot only, done() rewrites own JSON file.
+     * @param jsonFileName JSON file name
+     * @return true if success
+     */
+    bool exportJson(const std::string &jsonFileName);
 };
 
 EXPORT_SHARED_C_FUNC IdentityService* makeIdentityService1();
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <cstring>
 #include "lorawan/storage/service/identity-service-lmdb.h"
+#include "lorawan/storage/service/identity-filter-plan.h"
 #include "lorawan/lorawan-error.h"
 #include "lorawan/lorawan-string.h"
 #include "lorawan/helper/file-helper.h"
@@ -90,6 +91,47 @@ int LMDBIdentityService::list(
     return r;
 }
 
+/**
+ * Position the cursor at the key of the previous page with MDB_SET_RANGE instead of counting offset.
+ * Entries are returned in key (byte) order
+ */
+int LMDBIdentityService::listFrom(
+    std::vector<NETWORKIDENTITY> &retVal,
+    const DEVADDR *cursor,
+    size_t size
+) {
+    int r = mdb_txn_begin(env.env, nullptr, MDB_RDONLY, &env.txn);
+    if (r)
+        return ERR_CODE_LMDB_TXN_BEGIN;
+    MDB_cursor *dbCursor;
+    r = mdb_cursor_open(env.txn, env.dbi, &dbCursor);
+    if (r != MDB_SUCCESS) {
+        mdb_txn_abort(env.txn);
+        return r;
+    }
+    DEVADDR start;
+    if (cursor)
+        start = *cursor;
+    MDB_val dbKey {SIZE_DEVADDR, (void *) &start.u };
+    MDB_val dbVal {};
+    r = mdb_cursor_get(dbCursor, &dbKey, &dbVal, cursor ? MDB_SET_RANGE : MDB_FIRST);
+    // skip the last entry of the previous page
+    if (r == MDB_SUCCESS && cursor && dbKey.mv_size == SIZE_DEVADDR && memcmp(dbKey.mv_data, &cursor->u, SIZE_DEVADDR) == 0)
+        r = mdb_cursor_get(dbCursor, &dbKey, &dbVal, MDB_NEXT);
+    while (r == MDB_SUCCESS && retVal.size() < size) {
+        if (dbKey.mv_size != SIZE_DEVADDR)
+            break;  // error, database corrupted
+        NETWORKIDENTITY nid;
+        memmove((void*) &nid.value.devaddr, dbKey.mv_data, SIZE_DEVADDR);
+        memmove((void*) &nid.value.devid, dbVal.mv_data, dbVal.mv_size < sizeof(DEVICE_ID) ? dbVal.mv_size : sizeof(DEVICE_ID));
+        retVal.emplace_back(nid.value.devaddr, nid.value.devid);
+        r = mdb_cursor_get(dbCursor, &dbKey, &dbVal, MDB_NEXT);
+    }
+    mdb_cursor_close(dbCursor);
+    r = mdb_txn_commit(env.txn);
+    return r;
+}
+
 // Entries count
 size_t LMDBIdentityService::size()
 {
@@ -223,6 +265,34 @@ int LMDBIdentityService::rm(
     return r;
 }
 
+/**
+ * One write transaction, see putRecords()
+ */
+int LMDBIdentityService::putBatch(
+    const std::vector<NETWORKIDENTITY> &values
+)
+{
+    std::vector<std::pair<MDB_val, MDB_val>> records;
+    records.reserve(values.size());
+    for (auto &v : values) {
+        records.emplace_back(MDB_val { SIZE_DEVADDR, (void *) &v.value.devaddr.u },
+            MDB_val { sizeof(DEVICE_ID), (void *) &v.value.devid.id });
+    }
+    return putRecords(&env, records);
+}
+
+int LMDBIdentityService::rmBatch(
+    const std::vector<DEVADDR> &addrs
+)
+{
+    std::vector<MDB_val> keys;
+    keys.reserve(addrs.size());
+    for (auto &a : addrs) {
+        keys.push_back(MDB_val { SIZE_DEVADDR, (void *) &a.u });
+    }
+    return delRecords(&env, keys);
+}
+
 int LMDBIdentityService::init(
     const std::string &databaseName,
     void *database
@@ -325,13 +395,30 @@ int LMDBIdentityService::filter(
     uint8_t size
 )
 {
+    IdentityFilterPlan plan(filters);
+    if (plan.empty || size == 0)
+        return CODE_OK;
     // start transaction
     int r = mdb_txn_begin(env.env, nullptr, MDB_RDONLY, &env.txn);
     if (r)
         return ERR_CODE_LMDB_TXN_BEGIN;
 
-    size_t o = 0;
-    size_t sz = 0;
+    MDB_val dbKey {};
+    MDB_val dbVal {};
+    if (plan.addrLow == plan.addrHigh) {
+        // single address, no scan
+        dbKey.mv_size = SIZE_DEVADDR;
+        dbKey.mv_data = (void *) &plan.addrLow;
+        if (offset == 0 && mdb_get(env.txn, env.dbi, &dbKey, &dbVal) == MDB_SUCCESS
+            && dbVal.mv_size == sizeof(DEVICE_ID)
+            && plan.match(DEVADDR(plan.addrLow), *(DEVICE_ID*) dbVal.mv_data)) {
+            NETWORKIDENTITY nid;
+            nid.value.devaddr.u = plan.addrLow;
+            memmove((void*) &nid.value.devid, dbVal.mv_data, sizeof(DEVICE_ID));
+            retVal.emplace_back(nid.value.devaddr, nid.value.devid);
+        }
+        return mdb_txn_commit(env.txn);
+    }
 
     MDB_cursor *cursor;
     r = mdb_cursor_open(env.txn, env.dbi, &cursor);
@@ -340,38 +427,29 @@ int LMDBIdentityService::filter(
         return r;
     }
 
-    MDB_val dbKey {};
-    MDB_val dbVal {};
-
-    while ((r = mdb_cursor_get(cursor, &dbKey, &dbVal, MDB_NEXT)) == 0) {
-        if (o < offset) {
-            // skip first
-            o++;
-            continue;
-        }
-        sz++;
-        if (sz > size)
-            break;
-
+    // keys are ordered byte by byte, address range can not be used to seek
+    size_t o = 0;
+    size_t sz = 0;
+    while (mdb_cursor_get(cursor, &dbKey, &dbVal, MDB_NEXT) == MDB_SUCCESS) {
         if (dbKey.mv_size != SIZE_DEVADDR || dbVal.mv_size != sizeof(DEVICE_ID))
             break;  // error, database corrupted
-
-        if (!isIdentityFilteredV2(*(DEVADDR*) dbKey.mv_data, *(DEVICE_ID*) dbVal.mv_data, filters))
+        DEVADDR a(*(uint32_t *) dbKey.mv_data);
+        if (!plan.match(a, *(DEVICE_ID*) dbVal.mv_data))
             continue;
+        // offset is applied to the filtered identities
         if (o < offset) {
-            // skip first
             o++;
             continue;
         }
-        sz++;
-        if (sz > size)
-            break;
         NETWORKIDENTITY nid;
-        memmove((void*) &nid.value.devaddr.u, dbKey.mv_data, dbKey.mv_size < SIZE_DEVADDR ? dbKey.mv_size : SIZE_DEVADDR);
-        memmove((void*) &nid.value.devid, dbVal.mv_data, dbVal.mv_size < sizeof(DEVICE_ID) ? dbVal.mv_size : sizeof(DEVICE_ID));
+        nid.value.devaddr = a;
+        memmove((void*) &nid.value.devid, dbVal.mv_data, sizeof(DEVICE_ID));
         retVal.emplace_back(nid.value.devaddr, nid.value.devid);
-    } while (mdb_cursor_get(cursor, &dbKey, &dbVal, MDB_NEXT) == MDB_SUCCESS);
-
+        sz++;
+        if (sz >= size)
+            break;
+    }
+    mdb_cursor_close(cursor);
     r = mdb_txn_commit(env.txn);
     return r;
 }
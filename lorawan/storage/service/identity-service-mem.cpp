@@ -1,19 +1,28 @@
 #include <sstream>
 #include <iostream>
+#include <thread>
 #include "lorawan/storage/service/identity-service-mem.h"
 #include "lorawan/lorawan-error.h"
 #include "lorawan/lorawan-string.h"
 #include "lorawan/helper/file-helper.h"
+#include "lorawan/lorawan-msg.h"
 #include "lorawan/storage/serialization/identity-binary-serialization.h"
+#include "lorawan/storage/service/storage-snapshot.h"
 
 #ifdef ESP_PLATFORM
 #include <iostream>
 #include "platform-defs.h"
 #endif
 
-MemoryIdentityService::MemoryIdentityService() = default;
+MemoryIdentityService::MemoryIdentityService()
+    : journal(nullptr), filterThreads(0), persistent(false)
+{
+}
 
-MemoryIdentityService::~MemoryIdentityService() = default;
+MemoryIdentityService::~MemoryIdentityService()
+{
+    closeJournal();
+}
 
 /**
  * request device identifier by network address. Return 0 if success, retval = EUI and keys
@@ -26,10 +35,7 @@ int MemoryIdentityService::get(
     const DEVADDR &request
 )
 {
-    auto r = storage.find(request);
-    if (r != storage.end())
-        retVal = r->second;
-    else
+    if (!addrIndex.get(retVal, request.u))
         return ERR_CODE_GATEWAY_NOT_FOUND;
     return CODE_OK;
 }
@@ -40,6 +46,7 @@ int MemoryIdentityService::list(
     uint32_t offset,
     uint8_t size
 ) {
+    std::lock_guard<std::mutex> lock(storageMutex);
     size_t o = 0;
     size_t sz = 0;
     for (auto & it : storage) {
@@ -56,9 +63,24 @@ int MemoryIdentityService::list(
     return CODE_OK;
 }
 
+int MemoryIdentityService::listFrom(
+    std::vector<NETWORKIDENTITY> &retVal,
+    const DEVADDR *cursor,
+    size_t size
+)
+{
+    std::lock_guard<std::mutex> lock(storageMutex);
+    auto it = cursor ? storage.upper_bound(*cursor) : storage.begin();
+    for (; it != storage.end() && size; it++, size--) {
+        retVal.emplace_back(it->first, it->second);
+    }
+    return CODE_OK;
+}
+
 // Entries count
 size_t MemoryIdentityService::size()
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
     return storage.size();
 }
 
@@ -73,14 +95,17 @@ int MemoryIdentityService::getNetworkIdentity(
     const DEVEUI &eui
 )
 {
-    for(auto & it : storage) {
-        if (it.second.id.devEUI.u == eui.u) {
-            retVal.value.devaddr = it.first;
-            retVal.value.devid = it.second;
-            return CODE_OK;
-        }
-    }
-    return ERR_CODE_DEVICE_EUI_NOT_FOUND;
+    std::lock_guard<std::mutex> lock(storageMutex);
+    // device may have more than one address, return the lowest one
+    auto i = euiIndex.lower_bound(std::make_pair(eui.u, (uint32_t) 0));
+    if (i == euiIndex.end() || i->first != eui.u)
+        return ERR_CODE_DEVICE_EUI_NOT_FOUND;
+    auto it = storage.find(DEVADDR(i->second));
+    if (it == storage.end())
+        return ERR_CODE_DEVICE_EUI_NOT_FOUND;
+    retVal.value.devaddr = it->first;
+    retVal.value.devid = it->second;
+    return CODE_OK;
 }
 
 /**
@@ -93,7 +118,22 @@ int MemoryIdentityService::put(
     const DEVICEID &id
 )
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
+    auto f = storage.find(devAddr);
+    if (f != storage.end())
+        euiIndex.erase(std::make_pair((uint64_t) f->second.id.devEUI.u, devAddr.u));
     storage[devAddr] = id;
+    addrIndex.put(devAddr.u, id);
+    euiIndex.insert(std::make_pair((uint64_t) id.id.devEUI.u, devAddr.u));
+    if (journal) {
+        char rec[SIZE_SNAPSHOT_IDENTITY_RECORD];
+        IdentitySnapshot::toRecord(rec, devAddr, id);
+        int r = journal->append(JOURNAL_OP_PUT, rec);
+        if (r)
+            return r;
+        if (journal->needCompact())
+            return compact();
+    }
     return CODE_OK;
 }
 
@@ -101,30 +141,181 @@ int MemoryIdentityService::rm(
     const DEVADDR &addr
 )
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
     // find out by gateway identifier
     auto r = storage.find(addr);
-    if (r != storage.end()) {
+    if (r == storage.end())
+        return ERR_CODE_DEVICE_ADDRESS_NOTFOUND;
+    euiIndex.erase(std::make_pair((uint64_t) r->second.id.devEUI.u, addr.u));
+    addrIndex.rm(addr.u);
+    if (journal) {
+        char rec[SIZE_SNAPSHOT_IDENTITY_RECORD];
+        IdentitySnapshot::toRecord(rec, r->first, r->second);
         storage.erase(r);
-        return CODE_OK;
+        int jr = journal->append(JOURNAL_OP_RM, rec);
+        if (jr)
+            return jr;
+        if (journal->needCompact())
+            return compact();
+    } else
+        storage.erase(r);
+    return CODE_OK;
+}
+
+/**
+ * Lock storage once, reserve address table for the batch, write journal records at once with one fsync()
+ */
+int MemoryIdentityService::putBatch(
+    const std::vector<NETWORKIDENTITY> &values
+)
+{
+    std::lock_guard<std::mutex> lock(storageMutex);
+    addrIndex.reserve(addrIndex.size() + values.size());
+    std::vector<char> recs;
+    if (journal)
+        recs.resize(values.size() * SIZE_SNAPSHOT_IDENTITY_RECORD);
+    char *rec = recs.data();
+    for (auto &v : values) {
+        const DEVADDR &devAddr = v.value.devaddr;
+        const DEVICEID &id = v.value.devid;
+        auto f = storage.find(devAddr);
+        if (f != storage.end())
+            euiIndex.erase(std::make_pair((uint64_t) f->second.id.devEUI.u, devAddr.u));
+        storage[devAddr] = id;
+        addrIndex.put(devAddr.u, id);
+        euiIndex.insert(std::make_pair((uint64_t) id.id.devEUI.u, devAddr.u));
+        if (journal) {
+            IdentitySnapshot::toRecord(rec, devAddr, id);
+            rec += SIZE_SNAPSHOT_IDENTITY_RECORD;
+        }
+    }
+    if (journal) {
+        int r = journal->appendBatch(JOURNAL_OP_PUT, recs.data(), values.size());
+        if (r)
+            return r;
+        if (journal->needCompact())
+            return compact();
+    }
+    return CODE_OK;
+}
+
+int MemoryIdentityService::rmBatch(
+    const std::vector<DEVADDR> &addrs
+)
+{
+    std::lock_guard<std::mutex> lock(storageMutex);
+    std::vector<char> recs;
+    if (journal)
+        recs.resize(addrs.size() * SIZE_SNAPSHOT_IDENTITY_RECORD);
+    size_t removed = 0;
+    for (auto &addr : addrs) {
+        auto r = storage.find(addr);
+        if (r == storage.end())
+            continue;
+        euiIndex.erase(std::make_pair((uint64_t) r->second.id.devEUI.u, addr.u));
+        addrIndex.rm(addr.u);
+        if (journal)
+            IdentitySnapshot::toRecord(recs.data() + removed * SIZE_SNAPSHOT_IDENTITY_RECORD, r->first, r->second);
+        storage.erase(r);
+        removed++;
+    }
+    if (journal) {
+        int r = journal->appendBatch(JOURNAL_OP_RM, recs.data(), removed);
+        if (r)
+            return r;
+        if (journal->needCompact())
+            return compact();
+    }
+    return CODE_OK;
+}
+
+int MemoryIdentityService::openJournal(
+    const std::string &databaseName
+)
+{
+    closeJournal();
+    journal = new StorageJournal(JOURNAL_MAGIC_IDENTITY, SIZE_SNAPSHOT_IDENTITY_RECORD);
+    int r = journal->open(databaseName + JOURNAL_FILE_SUFFIX, [this] (char op, const char *record) {
+        DEVADDR a;
+        DEVICEID id;
+        IdentitySnapshot::fromRecord(a, id, record);
+        if (op == JOURNAL_OP_PUT)
+            storage[a] = id;
+        else
+            storage.erase(a);
+    });
+    if (r) {
+        delete journal;
+        journal = nullptr;
+    }
+    return r;
+}
+
+void MemoryIdentityService::closeJournal()
+{
+    if (journal) {
+        delete journal;
+        journal = nullptr;
+    }
+}
+
+int MemoryIdentityService::compact()
+{
+    int r = IdentitySnapshot::save(snapshotFileName, storage);
+    if (r) {
+        std::cerr << ERR_MESSAGE << r << " " << snapshotFileName << std::endl;
+        return r;
     }
-    return ERR_CODE_DEVICE_ADDRESS_NOTFOUND;
+    // snapshot contains all journal records
+    if (journal)
+        r = journal->reset();
+    return r;
 }
 
+/**
+ * @param databaseName if persistent is set, load <name>.snapshot and replay <name>.journal, otherwise not used
+ * @param database not used
+ * @return CODE_OK- success
+ */
 int MemoryIdentityService::init(
     const std::string &databaseName,
     void *database
 )
 {
-    return CODE_OK;
+    if (!persistent || databaseName.empty())
+        return CODE_OK;
+    snapshotFileName = databaseName + SNAPSHOT_FILE_SUFFIX;
+    IdentitySnapshot snapshot;
+    if (snapshot.open(snapshotFileName) == CODE_OK)
+        snapshot.load(storage);
+    int r = openJournal(databaseName);
+    reindex();
+    return r;
+}
+
+void MemoryIdentityService::reindex()
+{
+    euiIndex.clear();
+    for (auto &it : storage) {
+        euiIndex.insert(std::make_pair((uint64_t) it.second.id.devEUI.u, it.first.u));
+    }
+    addrIndex.assign(storage);
 }
 
 void MemoryIdentityService::flush()
 {
+    std::lock_guard<std::mutex> lock(storageMutex);
+    if (journal)
+        compact();
 }
 
 void MemoryIdentityService::done()
 {
+    closeJournal();
+    std::lock_guard<std::mutex> lock(storageMutex);
     storage.clear();
+    euiIndex.clear();
+    addrIndex.clear();
 }
 
 /**
@@ -138,13 +329,21 @@ int MemoryIdentityService::next(
     return ERR_CODE_ADDR_SPACE_FULL;
 }
 
+/**
+ * Set options
+ * @param option 3- journal
+ * @param value 3- bool, set before init()
+ */
 void MemoryIdentityService::setOption(
     int option,
     void *value
 )
 
 {
-    // nothing to do
+    if (!value)
+        return;
+    if (option == 3)
+        persistent = *(bool *) value;
 }
 
 EXPORT_SHARED_C_FUNC IdentityService* makeMemoryIdentityService()
@@ -203,6 +402,70 @@ int MemoryIdentityService::cList(
    return CODE_OK;
 }
 
+/**
+ * Collect identities matched the plan
+ * @return false if limit reached
+ */
+static bool addFiltered(
+    std::vector<NETWORKIDENTITY> &retVal,
+    const IdentityFilterPlan &plan,
+    const DEVADDR &addr,
+    const DEVICEID &id,
+    size_t limit
+)
+{
+    if (!plan.match(addr, id.id))
+        return true;
+    retVal.emplace_back(addr, id);
+    return retVal.size() < limit;
+}
+
+void MemoryIdentityService::parallelFilter(
+    std::vector<NETWORKIDENTITY> &retVal,
+    const IdentityFilterPlan &plan,
+    size_t limit
+)
+{
+    size_t threads = filterThreads ? filterThreads : std::thread::hardware_concurrency();
+    if (threads > IDENTITY_FILTER_MAX_THREADS)
+        threads = IDENTITY_FILTER_MAX_THREADS;
+    if (threads < 2 || storage.size() < IDENTITY_FILTER_PARALLEL_SIZE) {
+        for (auto &it : storage) {
+            if (!addFiltered(retVal, plan, it.first, it.second, limit))
+                break;
+        }
+        return;
+    }
+    // split address space between first and last address
+    uint64_t first = storage.begin()->first.u;
+    uint64_t last = storage.rbegin()->first.u;
+    uint64_t step = (last - first) / threads + 1;
+    std::vector<std::vector<NETWORKIDENTITY>> found(threads);
+    std::vector<std::thread> workers;
+    auto from = storage.begin();
+    for (size_t t = 0; t < threads; t++) {
+        uint64_t bound = first + step * (t + 1);
+        auto to = (t + 1 == threads || bound > last) ? storage.end() : storage.lower_bound(DEVADDR((uint32_t) bound));
+        workers.emplace_back([from, to, &plan, &found, t, limit] {
+            for (auto it = from; it != to; ++it) {
+                if (!addFiltered(found[t], plan, it->first, it->second, limit))
+                    break;
+            }
+        });
+        from = to;
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    for (size_t t = 0; t < threads; t++) {
+        for (auto &f : found[t]) {
+            if (retVal.size() >= limit)
+                return;
+            retVal.push_back(f);
+        }
+    }
+}
+
 int MemoryIdentityService::filter(
     std::vector<NETWORKIDENTITY> &retVal,
     const std::vector<NETWORK_IDENTITY_FILTER> &filters,
@@ -210,20 +473,32 @@ int MemoryIdentityService::filter(
     uint8_t size
 )
 {
-    size_t o = 0;
-    size_t sz = 0;
-    for (auto & it : storage) {
-        if (!isIdentityFilteredV2(it.first, it.second.id, filters))
-            continue;
-        if (o < offset) {
-            // skip first
-            o++;
-            continue;
+    IdentityFilterPlan plan(filters);
+    if (plan.empty || size == 0)
+        return CODE_OK;
+    // offset is applied to the filtered identities
+    size_t limit = (size_t) offset + size;
+    std::vector<NETWORKIDENTITY> found;
+    std::lock_guard<std::mutex> lock(storageMutex);
+    if (plan.isEUIRange() && (plan.isEUIEqual() || !plan.isAddressRange())) {
+        // seek DevEUI index
+        for (auto it = euiIndex.lower_bound(std::make_pair(plan.euiLow, (uint32_t) 0));
+            it != euiIndex.end() && it->first <= plan.euiHigh; ++it) {
+            auto f = storage.find(DEVADDR(it->second));
+            if (f != storage.end() && !addFiltered(found, plan, f->first, f->second, limit))
+                break;
         }
-        sz++;
-        if (sz > size)
-            break;
-        retVal.emplace_back(it.first, it.second);
+    } else if (plan.isAddressRange()) {
+        // seek address
+        auto last = storage.upper_bound(DEVADDR(plan.addrHigh));
+        for (auto it = storage.lower_bound(DEVADDR(plan.addrLow)); it != last; ++it) {
+            if (!addFiltered(found, plan, it->first, it->second, limit))
+                break;
+        }
+    } else
+        parallelFilter(found, plan, limit);
+    for (size_t i = offset; i < found.size(); i++) {
+        retVal.push_back(found[i]);
     }
     return CODE_OK;
 }
@@ -1,13 +1,58 @@
 #ifndef IDENTITY_SERVICE_MEM_H_
 #define IDENTITY_SERVICE_MEM_H_ 1
 
+#include <map>
+#include <set>
+#include <mutex>
 #include "lorawan/storage/service/identity-service.h"
 #include "lorawan/helper/plugin-helper.h"
+#include "lorawan/storage/service/storage-journal.h"
+#include "lorawan/storage/service/identity-filter-plan.h"
+#include "lorawan/storage/service/identity-table.h"
 
+/**
+ * In-memory identity storage.
+ * If persistent is set (or option 3 by setOption()) and init() database name is not empty, put/rm are appended to the <name>.journal file and
+ * journal is compacted into the <name>.snapshot file, see StorageJournal.
+ * get() does not lock storage, it looks up address in the concurrent table (see ConcurrentIdentityTable)
+ * updated by put() and rm() along with the ordered storage.
+ */
 class MemoryIdentityService: public IdentityService {
 protected:
     std::map<DEVADDR, DEVICEID> storage;
+    /// DevEUI and address pairs, Join-request lookup and filter range seek. Lowest address of the same DevEUI goes first
+    std::set<std::pair<uint64_t, uint32_t>> euiIndex;
+    ConcurrentIdentityTable addrIndex;      ///< address to identity, lock-free get()
+    std::mutex storageMutex;    ///< storage can be shared by listener threads
+    std::string snapshotFileName;
+    StorageJournal *journal;    ///< nullptr if storage is not persistent
+    /**
+     * Open and replay journal
+     * @param databaseName journal file name prefix
+     * @return CODE_OK- success
+     */
+    int openJournal(const std::string &databaseName);
+    void closeJournal();
+    /**
+     * Write snapshot and truncate journal
+     */
+    int compact();
+    /**
+     * Re-create DevEUI index and address table after storage is loaded
+     */
+    void reindex();
+    /**
+     * Scan storage in parallel threads, each thread scans own address range
+     * @param limit stop each thread after limit identities found
+     */
+    void parallelFilter(
+        std::vector<NETWORKIDENTITY> &retVal,
+        const IdentityFilterPlan &plan,
+        size_t limit
+    );
 public:
+    size_t filterThreads;       ///< threads to scan storage, 0- hardware concurrency
+    bool persistent;            ///< init() opens journal, default false. Set before init()
     MemoryIdentityService();
     ~MemoryIdentityService() override;
 
@@ -16,7 +61,10 @@ public:
     int getNetworkIdentity(NETWORKIDENTITY &retVal, const DEVEUI &eui) override;
     int put(const DEVADDR &devAddr, const DEVICEID &id) override;
     int rm(const DEVADDR &devAddr) override;
+    int putBatch(const std::vector<NETWORKIDENTITY> &values) override;
+    int rmBatch(const std::vector<DEVADDR> &addrs) override;
     int list(std::vector<NETWORKIDENTITY> &retVal, uint32_t offset, uint8_t size) override;
+    int listFrom(std::vector<NETWORKIDENTITY> &retVal, const DEVADDR *cursor, size_t size) override;
     size_t size() override;
     int next(NETWORKIDENTITY &retVal) override;
     // asynchronous imitation
@@ -14,6 +14,11 @@
 #include "lorawan/storage/serialization/identity-binary-serialization.h"
 
 #define FIELD_LIST "addr, activation, class, deveui, nwkskey, appskey, version, appeui, appkey, nwkkey, devnonce, joinnonce, name"
+#define UPSERT_CLAUSE "ON CONFLICT(addr) DO UPDATE SET " \
+    "activation=excluded.activation, class=excluded.class, deveui=excluded.deveui, " \
+    "nwkskey=excluded.nwkskey, appskey=excluded.appskey, version=excluded.version, " \
+    "appeui=excluded.appeui, appkey=excluded.appkey, nwkkey=excluded.nwkkey, " \
+    "devnonce=excluded.devnonce, joinnonce=excluded.joinnonce, name=excluded.name"
 
 SqliteIdentityService::SqliteIdentityService()
     : db(nullptr)
@@ -107,6 +112,42 @@ int SqliteIdentityService::list(
     return CODE_OK;
 }
 
+/**
+ * Seek to the cursor by primary key instead of OFFSET.
+ * Address is stored as fixed width hex string, so text order is address order
+ */
+int SqliteIdentityService::listFrom(
+    std::vector<NETWORKIDENTITY> &retVal,
+    const DEVADDR *cursor,
+    size_t size
+) {
+    if (!db)
+        return ERR_CODE_DB_DATABASE_NOT_FOUND;
+    char *zErrMsg = nullptr;
+    std::stringstream statement;
+    statement << "SELECT " FIELD_LIST " FROM device";
+    if (cursor)
+        statement << " WHERE addr > '" << DEVADDR2string(*cursor) << "'";
+    statement << " ORDER BY addr LIMIT " << size;
+    std::vector<std::vector<std::string>> table;
+    int r = sqlite3_exec(db, statement.str().c_str(), tableCallback, &table, &zErrMsg);
+    if (r != SQLITE_OK) {
+        if (zErrMsg) {
+            sqlite3_free(zErrMsg);
+        }
+        return ERR_CODE_DB_SELECT;
+    }
+    for (auto &row : table) {
+        if (row.size() < 13)
+            continue;
+        NETWORKIDENTITY ni;
+        row2DEVICEID(ni.value.devid, row);
+        ni.value.devaddr = row[0];
+        retVal.push_back(ni);
+    }
+    return CODE_OK;
+}
+
 // Entries count
 size_t SqliteIdentityService::size()
 {
@@ -193,11 +234,7 @@ int SqliteIdentityService::put(
         << "'" << DEVNONCE2string(id.id.devNonce) << "', "
         << "'" << JOINNONCE2string(id.id.joinNonce) << "', "
         << "'" << DEVICENAME2string(id.id.name)
-        << "') ON CONFLICT(addr) DO UPDATE SET "
-        "activation=excluded.activation, class=excluded.class, deveui=excluded.deveui, "
-        "nwkskey=excluded.nwkskey, appskey=excluded.appskey, version=excluded.version, "
-        "appeui=excluded.appeui, appkey=excluded.appkey, nwkkey=excluded.nwkkey, "
-        "devnonce=excluded.devnonce, joinnonce=excluded.joinnonce, name=excluded.name";
+        << "') " UPSERT_CLAUSE;
     int r = sqlite3_exec(db, statement.str().c_str(), nullptr, nullptr, &zErrMsg);
     if (r != SQLITE_OK) {
         if (zErrMsg) {
@@ -229,6 +266,85 @@ int SqliteIdentityService::rm(
     return CODE_OK;
 }
 
+/**
+ * One transaction, statement is prepared once and re-used for each identity
+ * @param values identities
+ * @return CODE_OK- success
+ */
+int SqliteIdentityService::putBatch(
+    const std::vector<NETWORKIDENTITY> &values
+)
+{
+    if (!db)
+        return ERR_CODE_DB_DATABASE_NOT_FOUND;
+    if (execStatement(db, "BEGIN") != SQLITE_OK)
+        return ERR_CODE_DB_START_TRANSACTION;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "INSERT INTO device(" FIELD_LIST ") VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
+        UPSERT_CLAUSE, -1, &stmt, nullptr) != SQLITE_OK) {
+        execStatement(db, "ROLLBACK");
+        return ERR_CODE_DB_INSERT;
+    }
+    for (auto &v : values) {
+        const DEVICEID &id = v.value.devid;
+        bindText(stmt, 1, DEVADDR2string(v.value.devaddr));
+        bindText(stmt, 2, activation2string(id.id.activation));
+        bindText(stmt, 3, deviceclass2string(id.id.deviceclass));
+        bindText(stmt, 4, DEVEUI2string(id.id.devEUI));
+        bindText(stmt, 5, KEY2string(id.id.nwkSKey));
+        bindText(stmt, 6, KEY2string(id.id.appSKey));
+        bindText(stmt, 7, LORAWAN_VERSION2string(id.id.version));
+        bindText(stmt, 8, DEVEUI2string(id.id.appEUI));
+        bindText(stmt, 9, KEY2string(id.id.appKey));
+        bindText(stmt, 10, KEY2string(id.id.nwkKey));
+        bindText(stmt, 11, DEVNONCE2string(id.id.devNonce));
+        bindText(stmt, 12, JOINNONCE2string(id.id.joinNonce));
+        bindText(stmt, 13, DEVICENAME2string(id.id.name));
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            sqlite3_finalize(stmt);
+            execStatement(db, "ROLLBACK");
+            return ERR_CODE_DB_INSERT;
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if (execStatement(db, "COMMIT") != SQLITE_OK) {
+        execStatement(db, "ROLLBACK");
+        return ERR_CODE_DB_COMMIT_TRANSACTION;
+    }
+    return CODE_OK;
+}
+
+int SqliteIdentityService::rmBatch(
+    const std::vector<DEVADDR> &addrs
+)
+{
+    if (!db)
+        return ERR_CODE_DB_DATABASE_NOT_FOUND;
+    if (execStatement(db, "BEGIN") != SQLITE_OK)
+        return ERR_CODE_DB_START_TRANSACTION;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "DELETE FROM device WHERE addr = ?", -1, &stmt, nullptr) != SQLITE_OK) {
+        execStatement(db, "ROLLBACK");
+        return ERR_CODE_DB_EXEC;
+    }
+    for (auto &a : addrs) {
+        bindText(stmt, 1, DEVADDR2string(a));
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            sqlite3_finalize(stmt);
+            execStatement(db, "ROLLBACK");
+            return ERR_CODE_DB_EXEC;
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if (execStatement(db, "COMMIT") != SQLITE_OK) {
+        execStatement(db, "ROLLBACK");
+        return ERR_CODE_DB_COMMIT_TRANSACTION;
+    }
+    return CODE_OK;
+}
+
 /**
  * "CREATE DATABASE IF NOT EXISTS \"device\" USE \"db_name\"",
  */
@@ -18,7 +18,10 @@ public:
     int getNetworkIdentity(NETWORKIDENTITY &retVal, const DEVEUI &eui) override;
     int put(const DEVADDR &devAddr, const DEVICEID &id) override;
     int rm(const DEVADDR &addr) override;
+    int putBatch(const std::vector<NETWORKIDENTITY> &values) override;
+    int rmBatch(const std::vector<DEVADDR> &addrs) override;
     int list(std::vector<NETWORKIDENTITY> &retVal, uint32_t offset, uint8_t size) override;
+    int listFrom(std::vector<NETWORKIDENTITY> &retVal, const DEVADDR *cursor, size_t size) override;
     size_t size() override;
     int next(NETWORKIDENTITY &retVal) override;
 
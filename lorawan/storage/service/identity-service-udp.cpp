@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 
 #include "lorawan/helper/ip-address.h"
 #include "lorawan/storage/service/identity-service-udp.h"
@@ -22,6 +23,8 @@ QUERY_IDENTITY_ASSIGN = 'p',
 QUERY_IDENTITY_RM = 'r',
 QUERY_IDENTITY_FORCE_SAVE = 's',
 QUERY_IDENTITY_CLOSE_RESOURCES = 'e'
+QUERY_IDENTITY_ASSIGN_BATCH = 'b'
+QUERY_IDENTITY_RM_BATCH = 'd'
 */
 
 class ResponseService : public ResponseClient {
@@ -246,6 +249,35 @@ int ClientUDPIdentityService::rm(
     return CODE_OK;
 }
 
+/**
+ * Send identities in batch requests up to MAX_IDENTITY_BATCH_SIZE identities each
+ */
+int ClientUDPIdentityService::putBatch(
+    const std::vector<NETWORKIDENTITY> &values
+)
+{
+    for (size_t i = 0; i < values.size(); i += MAX_IDENTITY_BATCH_SIZE) {
+        IdentityAssignBatchRequest req(code, accessCode);
+        size_t last = std::min(values.size(), i + MAX_IDENTITY_BATCH_SIZE);
+        req.identities.assign(values.begin() + i, values.begin() + last);
+        syncClient.request(&req);
+    }
+    return CODE_OK;
+}
+
+int ClientUDPIdentityService::rmBatch(
+    const std::vector<DEVADDR> &addrs
+)
+{
+    for (size_t i = 0; i < addrs.size(); i += MAX_IDENTITY_BATCH_SIZE) {
+        IdentityRmBatchRequest req(code, accessCode);
+        size_t last = std::min(addrs.size(), i + MAX_IDENTITY_BATCH_SIZE);
+        req.addrs.assign(addrs.begin() + i, addrs.begin() + last);
+        syncClient.request(&req);
+    }
+    return CODE_OK;
+}
+
 int ClientUDPIdentityService::init(
     const std::string &addrPort,
     void *database
@@ -1,6 +1,7 @@
 #include <cstring>
 #include "lorawan/storage/service/identity-service.h"
 #include "lorawan/lorawan-conv.h"
+#include "lorawan/lorawan-error.h"
 
 IdentityService::IdentityService()
     : responseClient(nullptr)
@@ -57,6 +58,65 @@ int IdentityService::joinAccept(
     return 0;
 }
 
+/**
+ * Default implementation pages over list(), it expects list() returns entries in address order.
+ * Override it if backend can seek to the cursor.
+ */
+int IdentityService::listFrom(
+    std::vector<NETWORKIDENTITY> &retVal,
+    const DEVADDR *cursor,
+    size_t size
+)
+{
+    uint32_t offset = 0;
+    std::vector<NETWORKIDENTITY> page;
+    while (retVal.size() < size) {
+        page.clear();
+        int r = list(page, offset, 255);
+        if (r)
+            return r;
+        if (page.empty())
+            break;
+        offset += (uint32_t) page.size();
+        for (auto &i : page) {
+            if (cursor && i.value.devaddr <= *cursor)
+                continue;
+            retVal.push_back(i);
+            if (retVal.size() >= size)
+                break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Default implementation puts identities one by one and stops at the first error.
+ * Override it if backend can write batch in one transaction.
+ */
+int IdentityService::putBatch(
+    const std::vector<NETWORKIDENTITY> &values
+)
+{
+    for (auto &v : values) {
+        int r = put(v.value.devaddr, v.value.devid);
+        if (r)
+            return r;
+    }
+    return CODE_OK;
+}
+
+int IdentityService::rmBatch(
+    const std::vector<DEVADDR> &addrs
+)
+{
+    for (auto &a : addrs) {
+        int r = rm(a);
+        if (r && r != ERR_CODE_DEVICE_ADDRESS_NOTFOUND)
+            return r;
+    }
+    return CODE_OK;
+}
+
 NETID *IdentityService::getNetworkId() {
     return &netid;
 }
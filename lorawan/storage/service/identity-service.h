@@ -21,6 +21,9 @@
  * list(std::vector<NETWORKIDENTITY> &retVal, size_t offset, size_t size) cList(size_t offset, size_t size)
  * filter(std::vector<NETWORKIDENTITY> &retVal, const std::vector<NETWORK_IDENTITY_FILTER> &filters, size_t offset, size_t size)
  *  cFilter(const std::vector<NETWORK_IDENTITY_FILTER> &filters, size_t offset, size_t size)
+ * listFrom(std::vector<NETWORKIDENTITY> &retVal, const DEVADDR *cursor, size_t size)
+ * putBatch(const std::vector<NETWORKIDENTITY> &values)
+ * rmBatch(const std::vector<DEVADDR> &addrs)
  * size()                                                                 cSize()
  * next(NETWORKIDENTITY &retVal                                           cNext()
  */
@@ -104,6 +107,20 @@ public:
      */
     virtual int cRm(const DEVADDR &addr) = 0;
 
+    /**
+     * synchronous add or replace identities at once, e.g. bulk provisioning.
+     * Backend applies batch in one transaction if it can.
+     * @param values identities with addresses
+     * @return CODE_OK- success
+     */
+    virtual int putBatch(const std::vector<NETWORKIDENTITY> &values);
+    /**
+     * synchronous remove entries at once, absent addresses are skipped
+     * @param addrs addresses to remove
+     * @return CODE_OK- success
+     */
+    virtual int rmBatch(const std::vector<DEVADDR> &addrs);
+
     /**
      * synchronous list entries
      * @param retVal return values
@@ -117,6 +134,20 @@ public:
         uint8_t size
     ) = 0;
 
+    /**
+     * synchronous cursor based list. Unlike list() it does not count offset from the beginning
+     * on each page, so it can walk millions of entries
+     * @param retVal return values in address order
+     * @param cursor last address of the previous page, NULL- first page
+     * @param size max entries to return
+     * @return 0- success
+     */
+    virtual int listFrom(
+        std::vector<NETWORKIDENTITY> &retVal,
+        const DEVADDR *cursor,
+        size_t size
+    );
+
     /**
      * synchronous list entries with filter(s)
      * @param retVal return values
@@ -203,8 +234,8 @@ public:
 
     /**
      * Set options
-     * @param option 0- masterkey 1- code 2- accesscode
-     * @param value 0- string 1- int32_t 2- uint64_t
+     * @param option 0- masterkey 1- code 2- accesscode 3- journal
+     * @param value 0- string 1- int32_t 2- uint64_t 3- bool
      */
     virtual void setOption(int option, void *value) = 0;
 
@@ -0,0 +1,259 @@
+#include <cstring>
+#include <thread>
+#include "lorawan/storage/service/identity-table.h"
+
+// Fibonacci hashing multiplier
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+static std::atomic<size_t> readerThreads(0);
+
+/**
+ * @return reader counter index of the current thread
+ */
+static size_t readerSlot()
+{
+    static thread_local size_t slot = readerThreads.fetch_add(1, std::memory_order_relaxed) % IDENTITY_TABLE_READER_SLOTS;
+    return slot;
+}
+
+IdentityTableSlot::IdentityTableSlot()
+    : seq(0), state(IDENTITY_SLOT_EMPTY), addr(0)
+{
+}
+
+IdentityTableSlots::IdentityTableSlots(
+    size_t capacity
+)
+    : mask(0), shift(64), used(0), removed(0)
+{
+    size_t c = IDENTITY_TABLE_MIN_CAPACITY;
+    while (c < capacity)
+        c <<= 1;
+    mask = (uint32_t) (c - 1);
+    for (size_t i = c; i > 1; i >>= 1) {
+        shift--;
+    }
+    slots.reset(new IdentityTableSlot[c]);
+}
+
+uint32_t IdentityTableSlots::index(
+    uint32_t addr
+) const
+{
+    return (uint32_t) ((addr * HASH_MULTIPLIER) >> shift) & mask;
+}
+
+IdentityTableReaders::IdentityTableReaders()
+    : active {{0}, {0}}, padding {}
+{
+}
+
+ConcurrentIdentityTable::ConcurrentIdentityTable()
+    : table(new IdentityTableSlots(IDENTITY_TABLE_MIN_CAPACITY)), epoch(0)
+{
+}
+
+ConcurrentIdentityTable::~ConcurrentIdentityTable()
+{
+    delete table.load();
+}
+
+bool ConcurrentIdentityTable::get(
+    DEVICEID &retVal,
+    uint32_t addr
+)
+{
+    IdentityTableReaders &r = readers[readerSlot()];
+    uint32_t e = epoch.load() & 1;
+    r.active[e].fetch_add(1);
+    const IdentityTableSlots *t = table.load();
+    bool found = false;
+    uint32_t i = t->index(addr);
+    for (uint32_t n = 0; n <= t->mask; n++, i = (i + 1) & t->mask) {
+        IdentityTableSlot &s = t->slots[i];
+        uint32_t state;
+        for (;;) {
+            uint32_t seq = s.seq.load(std::memory_order_acquire);
+            if (seq & 1) {
+                // writer is changing this slot
+                std::this_thread::yield();
+                continue;
+            }
+            state = s.state.load(std::memory_order_relaxed);
+            found = state == IDENTITY_SLOT_USED && s.addr.load(std::memory_order_relaxed) == addr;
+            if (found)
+                memcpy((void *) &retVal, (const void *) &s.id, sizeof(DEVICEID));
+            // slot must not change while it is copied
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) == seq)
+                break;
+        }
+        if (found || state == IDENTITY_SLOT_EMPTY)
+            break;
+    }
+    r.active[e].fetch_sub(1, std::memory_order_release);
+    return found;
+}
+
+void ConcurrentIdentityTable::write(
+    IdentityTableSlot &slot,
+    uint32_t state,
+    uint32_t addr,
+    const DEVICEID *id
+)
+{
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.state.store(state, std::memory_order_relaxed);
+    slot.addr.store(addr, std::memory_order_relaxed);
+    if (id)
+        memcpy((void *) &slot.id, (const void *) id, sizeof(DEVICEID));
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+void ConcurrentIdentityTable::insert(
+    IdentityTableSlots &t,
+    uint32_t addr,
+    const DEVICEID &id
+)
+{
+    IdentityTableSlot *removed = nullptr;
+    uint32_t i = t.index(addr);
+    for (uint32_t n = 0; n <= t.mask; n++, i = (i + 1) & t.mask) {
+        IdentityTableSlot &s = t.slots[i];
+        uint32_t state = s.state.load(std::memory_order_relaxed);
+        if (state == IDENTITY_SLOT_USED) {
+            if (s.addr.load(std::memory_order_relaxed) == addr) {
+                write(s, IDENTITY_SLOT_USED, addr, &id);
+                return;
+            }
+            continue;
+        }
+        if (state == IDENTITY_SLOT_REMOVED) {
+            // address can be found later in the probe chain
+            if (!removed)
+                removed = &s;
+            continue;
+        }
+        break;
+    }
+    if (removed) {
+        // re-use removed slot
+        write(*removed, IDENTITY_SLOT_USED, addr, &id);
+        t.removed--;
+    } else
+        write(t.slots[i], IDENTITY_SLOT_USED, addr, &id);
+    t.used++;
+}
+
+void ConcurrentIdentityTable::put(
+    uint32_t addr,
+    const DEVICEID &id
+)
+{
+    IdentityTableSlots *t = table.load(std::memory_order_relaxed);
+    if ((t->used + t->removed + 1) * 2 > (size_t) t->mask + 1) {
+        // rebuild without removed slots, at most third of the new table is used
+        auto n = new IdentityTableSlots((t->used + 1) * 3);
+        for (uint32_t i = 0; i <= t->mask; i++) {
+            IdentityTableSlot &s = t->slots[i];
+            if (s.state.load(std::memory_order_relaxed) == IDENTITY_SLOT_USED)
+                insert(*n, s.addr.load(std::memory_order_relaxed), s.id);
+        }
+        insert(*n, addr, id);
+        replace(n);
+        return;
+    }
+    insert(*t, addr, id);
+}
+
+bool ConcurrentIdentityTable::rm(
+    uint32_t addr
+)
+{
+    IdentityTableSlots *t = table.load(std::memory_order_relaxed);
+    uint32_t i = t->index(addr);
+    for (uint32_t n = 0; n <= t->mask; n++, i = (i + 1) & t->mask) {
+        IdentityTableSlot &s = t->slots[i];
+        uint32_t state = s.state.load(std::memory_order_relaxed);
+        if (state == IDENTITY_SLOT_EMPTY)
+            break;
+        if (state == IDENTITY_SLOT_USED && s.addr.load(std::memory_order_relaxed) == addr) {
+            write(s, IDENTITY_SLOT_REMOVED, addr, nullptr);
+            t->used--;
+            t->removed++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ConcurrentIdentityTable::reserve(
+    size_t count
+)
+{
+    IdentityTableSlots *t = table.load(std::memory_order_relaxed);
+    if (count < t->used)
+        count = t->used;
+    if ((count + t->removed) * 2 <= (size_t) t->mask + 1)
+        return;
+    auto n = new IdentityTableSlots(count * 3);
+    for (uint32_t i = 0; i <= t->mask; i++) {
+        IdentityTableSlot &s = t->slots[i];
+        if (s.state.load(std::memory_order_relaxed) == IDENTITY_SLOT_USED)
+            insert(*n, s.addr.load(std::memory_order_relaxed), s.id);
+    }
+    replace(n);
+}
+
+void ConcurrentIdentityTable::assign(
+    const std::map<DEVADDR, DEVICEID> &values
+)
+{
+    auto n = new IdentityTableSlots(values.size() * 3);
+    for (auto &v : values) {
+        insert(*n, v.first.u, v.second);
+    }
+    replace(n);
+}
+
+void ConcurrentIdentityTable::clear()
+{
+    replace(new IdentityTableSlots(IDENTITY_TABLE_MIN_CAPACITY));
+}
+
+void ConcurrentIdentityTable::replace(
+    IdentityTableSlots *value
+)
+{
+    IdentityTableSlots *old = table.exchange(value);
+    synchronize();
+    delete old;
+}
+
+/**
+ * Wait readers of the previous epochs. Readers after epoch flip count in another counter,
+ * then old counters go to zero even if readers never stop.
+ * Reader entered before the table is exchanged is counted in one of the epochs.
+ */
+void ConcurrentIdentityTable::synchronize()
+{
+    for (int flip = 0; flip < 2; flip++) {
+        uint32_t e = epoch.fetch_add(1) & 1;
+        for (auto &r : readers) {
+            while (r.active[e].load() != 0)
+                std::this_thread::yield();
+        }
+    }
+}
+
+size_t ConcurrentIdentityTable::size() const
+{
+    return table.load(std::memory_order_relaxed)->used;
+}
+
+size_t ConcurrentIdentityTable::capacity() const
+{
+    return (size_t) table.load(std::memory_order_relaxed)->mask + 1;
+}
@@ -0,0 +1,121 @@
+#ifndef IDENTITY_TABLE_H_
+#define IDENTITY_TABLE_H_ 1
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include "lorawan/lorawan-types.h"
+
+#define IDENTITY_TABLE_MIN_CAPACITY     64
+// reader counters, threads share counter if there are more threads
+#define IDENTITY_TABLE_READER_SLOTS     64
+
+#define IDENTITY_SLOT_EMPTY     0
+#define IDENTITY_SLOT_USED      1
+#define IDENTITY_SLOT_REMOVED   2
+
+/**
+ * Hash table slot. Sequence is odd while writer changes the slot,
+ * reader copies the slot and re-reads sequence to detect torn copy.
+ */
+class IdentityTableSlot {
+public:
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> state;    ///< IDENTITY_SLOT_EMPTY, IDENTITY_SLOT_USED or IDENTITY_SLOT_REMOVED
+    std::atomic<uint32_t> addr;
+    DEVICEID id;
+    IdentityTableSlot();
+};
+
+/**
+ * Open addressing table with linear probing. Slots of the table are never moved,
+ * removed slot keeps probe chain until the table is rebuilt.
+ */
+class IdentityTableSlots {
+public:
+    uint32_t mask;
+    int shift;                  ///< 64 - log2(capacity)
+    size_t used;
+    size_t removed;
+    std::unique_ptr<IdentityTableSlot[]> slots;
+    explicit IdentityTableSlots(size_t capacity);
+    uint32_t index(uint32_t addr) const;
+};
+
+/**
+ * Reader counters of the even and odd epochs, padded to own cache line
+ */
+class IdentityTableReaders {
+public:
+    std::atomic<uint32_t> active[2];
+    char padding[64 - 2 * sizeof(std::atomic<uint32_t>)];
+    IdentityTableReaders();
+};
+
+/**
+ * Address to device identifier table for many reader threads and one writer.
+ * get() does not lock: reader copies slot protected by slot sequence (seqlock) and retries only
+ * if writer changes the same slot at the same time.
+ * Writer rebuilds table when it is half full of used and removed slots, publishes the new table and frees old one
+ * when readers of the old table leave it (RCU grace period over per-thread reader counters).
+ * put(), rm(), reserve(), assign() and clear() must be serialized by the caller.
+ */
+class ConcurrentIdentityTable {
+private:
+    std::atomic<IdentityTableSlots *> table;
+    std::atomic<uint32_t> epoch;
+    IdentityTableReaders readers[IDENTITY_TABLE_READER_SLOTS];
+    /**
+     * Write slot, readers see sequence changed
+     */
+    static void write(
+        IdentityTableSlot &slot,
+        uint32_t state,
+        uint32_t addr,
+        const DEVICEID *id
+    );
+    static void insert(
+        IdentityTableSlots &t,
+        uint32_t addr,
+        const DEVICEID &id
+    );
+    /**
+     * Publish new table, wait until readers leave old table and delete it
+     */
+    void replace(IdentityTableSlots *value);
+    void synchronize();
+public:
+    ConcurrentIdentityTable();
+    virtual ~ConcurrentIdentityTable();
+    /**
+     * Lookup device by address
+     * @return true if found
+     */
+    bool get(
+        DEVICEID &retVal,
+        uint32_t addr
+    );
+    void put(
+        uint32_t addr,
+        const DEVICEID &id
+    );
+    /**
+     * @return true if address removed
+     */
+    bool rm(uint32_t addr);
+    /**
+     * Rebuild table once for the expected identities count, e.g. before batch of put()
+     * @param count identities count
+     */
+    void reserve(size_t count);
+    /**
+     * Replace all identities, e.g. after snapshot and journal are loaded
+     */
+    void assign(const std::map<DEVADDR, DEVICEID> &values);
+    void clear();
+    // writer only
+    size_t size() const;
+    size_t capacity() const;
+};
+
+#endif
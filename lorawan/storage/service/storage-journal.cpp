@@ -0,0 +1,249 @@
+#include <cstring>
+
+#include "lorawan/storage/service/storage-journal.h"
+#include "lorawan/lorawan-error.h"
+#include "lorawan/helper/crc-helper.h"
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#include <io.h>
+#define fsync(fd) _commit(fd)
+#define fileno _fileno
+#define ftruncate(fd, size) _chsize_s(fd, size)
+#else
+#include <unistd.h>
+#endif
+
+#define SIZE_JOURNAL_CRC    2
+
+StorageJournal::StorageJournal(
+    uint32_t magic,
+    uint16_t recordSize
+)
+    : f(nullptr), header { magic, SNAPSHOT_VERSION, recordSize, 0 }, count(0), pending(0),
+    syncThread(nullptr), stopSync(false),
+    syncRecords(DEF_JOURNAL_SYNC_RECORDS), syncMillis(DEF_JOURNAL_SYNC_MS), compactRecords(DEF_JOURNAL_COMPACT_RECORDS)
+{
+    buffer = new char[1 + recordSize + SIZE_JOURNAL_CRC];
+}
+
+StorageJournal::~StorageJournal()
+{
+    close();
+    delete[] buffer;
+}
+
+int StorageJournal::writeHeader()
+{
+    if (fseek(f, 0, SEEK_SET)
+        || fwrite(&header, SIZE_SNAPSHOT_HEADER, 1, f) != 1
+        || fflush(f)
+        || ftruncate(fileno(f), SIZE_SNAPSHOT_HEADER)
+        || fsync(fileno(f)))
+        return ERR_CODE_DB_CREATE;
+    return CODE_OK;
+}
+
+int StorageJournal::open(
+    const std::string &aFileName,
+    const OnJournalRecord &onRecord
+)
+{
+    close();
+    std::lock_guard<std::mutex> lock(mutexFile);
+    fileName = aFileName;
+    f = fopen(fileName.c_str(), "r+b");
+    if (!f) {
+        f = fopen(fileName.c_str(), "w+b");
+        if (!f)
+            return ERR_CODE_DB_DATABASE_OPEN;
+    }
+    SNAPSHOT_HEADER h;
+    if (fread(&h, SIZE_SNAPSHOT_HEADER, 1, f) != 1) {
+        // new or empty file
+        int r = writeHeader();
+        if (r) {
+            closeFile();
+            return ERR_CODE_DB_DATABASE_OPEN;
+        }
+    } else {
+        if (h.magic != header.magic || h.version != header.version || h.recordSize != header.recordSize) {
+            closeFile();
+            return ERR_CODE_DB_DATABASE_OPEN;
+        }
+        // replay
+        size_t sz = 1 + header.recordSize + SIZE_JOURNAL_CRC;
+        long validSize = SIZE_SNAPSHOT_HEADER;
+        while (fread(buffer, sz, 1, f) == 1) {
+            uint16_t crc;
+            memmove(&crc, buffer + 1 + header.recordSize, SIZE_JOURNAL_CRC);
+            if ((buffer[0] != JOURNAL_OP_PUT && buffer[0] != JOURNAL_OP_RM)
+                || crc != crc16xmodem((const uint8_t *) buffer, 1 + header.recordSize))
+                break;
+            onRecord(buffer[0], buffer + 1);
+            validSize += (long) sz;
+            count++;
+        }
+        // discard torn tail if any
+        fseek(f, 0, SEEK_END);
+        if (ftell(f) > validSize) {
+            fflush(f);
+            if (ftruncate(fileno(f), validSize)) {
+                closeFile();
+                return ERR_CODE_DB_DATABASE_OPEN;
+            }
+        }
+    }
+    fseek(f, 0, SEEK_END);
+    pending = 0;
+    lastSync = std::chrono::steady_clock::now();
+    if (syncMillis) {
+        stopSync = false;
+        syncThread = new std::thread(&StorageJournal::runSync, this);
+    }
+    return CODE_OK;
+}
+
+void StorageJournal::close()
+{
+    if (syncThread) {
+        {
+            std::lock_guard<std::mutex> lock(mutexFile);
+            stopSync = true;
+        }
+        cvSync.notify_all();
+        syncThread->join();
+        delete syncThread;
+        syncThread = nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutexFile);
+    closeFile();
+}
+
+void StorageJournal::closeFile()
+{
+    if (!f)
+        return;
+    syncFile();
+    fclose(f);
+    f = nullptr;
+    count = 0;
+}
+
+/**
+ * Sync records appended after the last group commit when syncMillis passed, storage may not append more
+ */
+void StorageJournal::runSync()
+{
+    std::unique_lock<std::mutex> lock(mutexFile);
+    while (!stopSync) {
+        if (!pending) {
+            cvSync.wait(lock);
+            continue;
+        }
+        auto due = lastSync + std::chrono::milliseconds(syncMillis);
+        if (std::chrono::steady_clock::now() < due) {
+            cvSync.wait_until(lock, due);
+            continue;
+        }
+        syncFile();
+    }
+}
+
+int StorageJournal::append(
+    char op,
+    const void *record
+)
+{
+    std::lock_guard<std::mutex> lock(mutexFile);
+    if (!f)
+        return ERR_CODE_DB_INSERT;
+    buffer[0] = op;
+    memmove(buffer + 1, record, header.recordSize);
+    uint16_t crc = crc16xmodem((const uint8_t *) buffer, 1 + header.recordSize);
+    memmove(buffer + 1 + header.recordSize, &crc, SIZE_JOURNAL_CRC);
+    // write through stdio buffer immediately, process crash does not lose record
+    if (fwrite(buffer, 1 + header.recordSize + SIZE_JOURNAL_CRC, 1, f) != 1 || fflush(f))
+        return ERR_CODE_DB_INSERT;
+    count++;
+    pending++;
+    // group commit
+    if (pending >= syncRecords
+        || std::chrono::steady_clock::now() - lastSync >= std::chrono::milliseconds(syncMillis))
+        return syncFile();
+    // first record of the group starts sync thread timer
+    if (pending == 1)
+        cvSync.notify_one();
+    return CODE_OK;
+}
+
+int StorageJournal::appendBatch(
+    char op,
+    const void *records,
+    size_t recordCount
+)
+{
+    std::lock_guard<std::mutex> lock(mutexFile);
+    if (!f)
+        return ERR_CODE_DB_INSERT;
+    if (!recordCount)
+        return CODE_OK;
+    buffer[0] = op;
+    const char *record = (const char *) records;
+    for (size_t i = 0; i < recordCount; i++, record += header.recordSize) {
+        memmove(buffer + 1, record, header.recordSize);
+        uint16_t crc = crc16xmodem((const uint8_t *) buffer, 1 + header.recordSize);
+        memmove(buffer + 1 + header.recordSize, &crc, SIZE_JOURNAL_CRC);
+        if (fwrite(buffer, 1 + header.recordSize + SIZE_JOURNAL_CRC, 1, f) != 1)
+            return ERR_CODE_DB_INSERT;
+    }
+    // crash in the middle of the batch keeps complete records, torn tail is discarded on open()
+    if (fflush(f))
+        return ERR_CODE_DB_INSERT;
+    count += recordCount;
+    pending += recordCount;
+    return syncFile();
+}
+
+int StorageJournal::sync()
+{
+    std::lock_guard<std::mutex> lock(mutexFile);
+    return syncFile();
+}
+
+int StorageJournal::syncFile()
+{
+    if (!f)
+        return ERR_CODE_DB_COMMIT_TRANSACTION;
+    if (pending) {
+        if (fflush(f) || fsync(fileno(f)))
+            return ERR_CODE_DB_COMMIT_TRANSACTION;
+        pending = 0;
+    }
+    lastSync = std::chrono::steady_clock::now();
+    return CODE_OK;
+}
+
+int StorageJournal::reset()
+{
+    std::lock_guard<std::mutex> lock(mutexFile);
+    if (!f)
+        return ERR_CODE_DB_COMMIT_TRANSACTION;
+    int r = writeHeader();
+    fseek(f, 0, SEEK_END);
+    count = 0;
+    pending = 0;
+    lastSync = std::chrono::steady_clock::now();
+    return r;
+}
+
+size_t StorageJournal::size() const
+{
+    std::lock_guard<std::mutex> lock(mutexFile);
+    return count;
+}
+
+bool StorageJournal::needCompact() const
+{
+    std::lock_guard<std::mutex> lock(mutexFile);
+    return count >= compactRecords;
+}
@@ -0,0 +1,127 @@
+#ifndef STORAGE_JOURNAL_H_
+#define STORAGE_JOURNAL_H_ 1
+
+#include <string>
+#include <functional>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "lorawan/storage/service/storage-snapshot.h"
+
+/**
+ * Append-only journal of put/rm operations over the in-memory storage.
+ *
+ * File layout:
+ *  SNAPSHOT_HEADER (16 bytes), count is not used
+ *  records: operation (1 byte) + record (recordSize bytes, same as snapshot record) + CRC16 XMODEM (2 bytes)
+ *
+ * Each append is written to the file immediately, so process crash does not lose updates.
+ * fsync() is grouped: journal syncs the file to the disk when DEF_JOURNAL_SYNC_RECORDS records are pending or
+ * DEF_JOURNAL_SYNC_MS milliseconds passed since the last sync, or on sync()/reset().
+ * Sync thread started by open() syncs pending records when no more appends arrive, so records
+ * are on the disk in DEF_JOURNAL_SYNC_MS even if storage is idle. On power loss the last unsynced group may be lost.
+ *
+ * Storage compacts journal: it writes snapshot and then reset() journal.
+ * Torn record at the end of file (crash in the middle of write) is discarded on open().
+ */
+
+#define JOURNAL_MAGIC_IDENTITY          0x4a49544c  ///< "LTIJ" in little endian
+#define JOURNAL_MAGIC_GATEWAY           0x4a47544c  ///< "LTGJ" in little endian
+#define JOURNAL_FILE_SUFFIX             ".journal"
+
+#define JOURNAL_OP_PUT                  'P'
+#define JOURNAL_OP_RM                   'R'
+
+#define DEF_JOURNAL_SYNC_RECORDS        256
+#define DEF_JOURNAL_SYNC_MS             100
+// compact journal to the snapshot when journal records count exceeds
+#define DEF_JOURNAL_COMPACT_RECORDS     65536
+
+typedef std::function<void(char op, const char *record)> OnJournalRecord;
+
+class StorageJournal {
+private:
+    std::string fileName;
+    FILE *f;
+    SNAPSHOT_HEADER header;
+    char *buffer;               ///< op + record + CRC
+    size_t count;               ///< records in the journal
+    size_t pending;             ///< records written after last fsync()
+    std::chrono::steady_clock::time_point lastSync;
+    mutable std::mutex mutexFile;
+    std::condition_variable cvSync;
+    std::thread *syncThread;
+    bool stopSync;
+    int writeHeader();
+    void closeFile();
+    int syncFile();
+    void runSync();
+public:
+    size_t syncRecords;         ///< fsync() every syncRecords records
+    uint32_t syncMillis;        ///< or every syncMillis milliseconds, 0- no sync thread. Set before open()
+    size_t compactRecords;      ///< compact threshold, see needCompact()
+
+    StorageJournal(
+        uint32_t magic,
+        uint16_t recordSize
+    );
+    virtual ~StorageJournal();
+    /**
+     * Open journal, replay valid records, discard torn tail and position file for append.
+     * Create an empty journal if file does not exist. Start sync thread.
+     * @param fileName journal file name
+     * @param onRecord called for each valid record in the order they were appended
+     * @return CODE_OK- success, ERR_CODE_DB_DATABASE_OPEN- can not open or create file
+     */
+    int open(
+        const std::string &fileName,
+        const OnJournalRecord &onRecord
+    );
+    /**
+     * Stop sync thread, sync and close file
+     */
+    void close();
+    /**
+     * Append operation
+     * @param op JOURNAL_OP_PUT or JOURNAL_OP_RM
+     * @param record recordSize bytes
+     * @return CODE_OK- success, ERR_CODE_DB_INSERT- write error
+     */
+    int append(
+        char op,
+        const void *record
+    );
+    /**
+     * Append the same operation over the records, flush and fsync() once per batch
+     * @param op JOURNAL_OP_PUT or JOURNAL_OP_RM
+     * @param records count * recordSize bytes
+     * @param count records count
+     * @return CODE_OK- success, ERR_CODE_DB_INSERT- write error
+     */
+    int appendBatch(
+        char op,
+        const void *records,
+        size_t count
+    );
+    /**
+     * Flush pending records to the disk
+     */
+    int sync();
+    /**
+     * Truncate journal after its content is stored in the snapshot
+     */
+    int reset();
+    /**
+     * @return records count in the journal
+     */
+    size_t size() const;
+    /**
+     * @return true if journal is large enough to be compacted into the snapshot
+     */
+    bool needCompact() const;
+};
+
+#endif
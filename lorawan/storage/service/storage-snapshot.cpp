@@ -0,0 +1,417 @@
+#include <cstring>
+#include <cstdlib>
+#include <sys/stat.h>
+
+#include "lorawan/storage/service/storage-snapshot.h"
+#include "lorawan/lorawan-error.h"
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#include <windows.h>
+#include <io.h>
+#define fsync(fd) _commit(fd)
+#define fileno _fileno
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#ifndef ESP_PLATFORM
+#include <sys/mman.h>
+#endif
+#endif
+
+#define TEMP_FILE_SUFFIX    ".tmp"
+
+SnapshotFile::SnapshotFile(
+    uint32_t aMagic,
+    uint16_t aRecordSize
+)
+    : data(nullptr), dataSize(0),
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    hFile(INVALID_HANDLE_VALUE), hMapping(nullptr),
+#else
+    fd(-1),
+#endif
+    magic(aMagic), recordSize(aRecordSize), count(0)
+{
+}
+
+SnapshotFile::~SnapshotFile()
+{
+    close();
+}
+
+int SnapshotFile::open(
+    const std::string &fileName
+)
+{
+    close();
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    hFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return ERR_CODE_DB_DATABASE_OPEN;
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(hFile, &sz) || sz.QuadPart < SIZE_SNAPSHOT_HEADER) {
+        close();
+        return ERR_CODE_DB_DATABASE_OPEN;
+    }
+    dataSize = (size_t) sz.QuadPart;
+    hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMapping) {
+        close();
+        return ERR_CODE_DB_DATABASE_OPEN;
+    }
+    data = (const char *) MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return ERR_CODE_DB_DATABASE_OPEN;
+    struct stat st {};
+    if (fstat(fd, &st) || st.st_size < SIZE_SNAPSHOT_HEADER) {
+        close();
+        return ERR_CODE_DB_DATABASE_OPEN;
+    }
+    dataSize = (size_t) st.st_size;
+#ifdef ESP_PLATFORM
+    // no mmap(), read whole file
+    char *m = (char *) malloc(dataSize);
+    if (m && ::read(fd, m, dataSize) != (ssize_t) dataSize) {
+        free(m);
+        m = nullptr;
+    }
+    data = m;
+#else
+    void *m = mmap(nullptr, dataSize, PROT_READ, MAP_SHARED, fd, 0);
+    data = (m == MAP_FAILED) ? nullptr : (const char *) m;
+#endif
+#endif
+    if (!data) {
+        close();
+        return ERR_CODE_DB_DATABASE_OPEN;
+    }
+    // validate header
+    SNAPSHOT_HEADER h;
+    memmove(&h, data, SIZE_SNAPSHOT_HEADER);
+    // count is read from the file, do not multiply it
+    if (h.magic != magic || h.version != SNAPSHOT_VERSION || h.recordSize != recordSize
+        || h.count > (dataSize - SIZE_SNAPSHOT_HEADER) / recordSize) {
+        close();
+        return ERR_CODE_DB_DATABASE_OPEN;
+    }
+    count = h.count;
+    return CODE_OK;
+}
+
+void SnapshotFile::close()
+{
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    if (data)
+        UnmapViewOfFile(data);
+    if (hMapping)
+        CloseHandle(hMapping);
+    if (hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(hFile);
+    hMapping = nullptr;
+    hFile = INVALID_HANDLE_VALUE;
+#else
+    if (data)
+#ifdef ESP_PLATFORM
+        free((void *) data);
+#else
+        munmap((void *) data, dataSize);
+#endif
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+#endif
+    data = nullptr;
+    dataSize = 0;
+    count = 0;
+}
+
+size_t SnapshotFile::size() const
+{
+    return (size_t) count;
+}
+
+const char *SnapshotFile::record(
+    size_t index
+) const
+{
+    return data + SIZE_SNAPSHOT_HEADER + index * recordSize;
+}
+
+SnapshotWriter::SnapshotWriter(
+    uint32_t magic,
+    uint16_t recordSize
+)
+    : f(nullptr), header { magic, SNAPSHOT_VERSION, recordSize, 0 }
+{
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    rollback();
+}
+
+int SnapshotWriter::open(
+    const std::string &aFileName
+)
+{
+    fileName = aFileName;
+    tempFileName = aFileName + TEMP_FILE_SUFFIX;
+    f = fopen(tempFileName.c_str(), "wb");
+    if (!f)
+        return ERR_CODE_DB_CREATE;
+    header.count = 0;
+    // reserve header, count is unknown yet
+    if (fwrite(&header, SIZE_SNAPSHOT_HEADER, 1, f) != 1) {
+        rollback();
+        return ERR_CODE_DB_INSERT;
+    }
+    return CODE_OK;
+}
+
+int SnapshotWriter::append(
+    const void *record
+)
+{
+    if (!f)
+        return ERR_CODE_DB_INSERT;
+    if (fwrite(record, header.recordSize, 1, f) != 1)
+        return ERR_CODE_DB_INSERT;
+    header.count++;
+    return CODE_OK;
+}
+
+int SnapshotWriter::commit()
+{
+    if (!f)
+        return ERR_CODE_DB_COMMIT_TRANSACTION;
+    bool ok = fseek(f, 0, SEEK_SET) == 0
+        && fwrite(&header, SIZE_SNAPSHOT_HEADER, 1, f) == 1
+        && fflush(f) == 0
+        && fsync(fileno(f)) == 0;
+    fclose(f);
+    f = nullptr;
+    if (ok) {
+#if defined(_MSC_VER) || defined(__MINGW32__)
+        ok = MoveFileExA(tempFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        ok = rename(tempFileName.c_str(), fileName.c_str()) == 0;
+#endif
+    }
+    if (!ok) {
+        remove(tempFileName.c_str());
+        return ERR_CODE_DB_COMMIT_TRANSACTION;
+    }
+    return CODE_OK;
+}
+
+void SnapshotWriter::rollback()
+{
+    if (f) {
+        fclose(f);
+        f = nullptr;
+        remove(tempFileName.c_str());
+    }
+}
+
+IdentitySnapshot::IdentitySnapshot()
+    : SnapshotFile(SNAPSHOT_MAGIC_IDENTITY, SIZE_SNAPSHOT_IDENTITY_RECORD)
+{
+}
+
+int IdentitySnapshot::get(
+    DEVICEID &retVal,
+    const DEVADDR &addr
+) const
+{
+    size_t lo = 0;
+    size_t hi = size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const char *r = record(mid);
+        DEVADDR a;
+        memmove(&a.u, r, SIZE_DEVADDR);
+        if (a < addr)
+            lo = mid + 1;
+        else if (addr < a)
+            hi = mid;
+        else {
+            retVal.fromArray(r + SIZE_DEVADDR, SIZE_DEVICEID);
+            return CODE_OK;
+        }
+    }
+    return ERR_CODE_DEVICE_ADDRESS_NOTFOUND;
+}
+
+void IdentitySnapshot::at(
+    DEVADDR &retAddr,
+    DEVICEID &retVal,
+    size_t index
+) const
+{
+    fromRecord(retAddr, retVal, record(index));
+}
+
+size_t IdentitySnapshot::load(
+    std::map<DEVADDR, DEVICEID> &retVal
+) const
+{
+    size_t c = size();
+    for (size_t i = 0; i < c; i++) {
+        DEVADDR a;
+        DEVICEID id;
+        at(a, id, i);
+        // records are sorted, insert at the end in constant time
+        retVal.emplace_hint(retVal.end(), a, id);
+    }
+    return c;
+}
+
+int IdentitySnapshot::save(
+    const std::string &fileName,
+    const std::map<DEVADDR, DEVICEID> &values
+)
+{
+    SnapshotWriter w(SNAPSHOT_MAGIC_IDENTITY, SIZE_SNAPSHOT_IDENTITY_RECORD);
+    int r = w.open(fileName);
+    if (r)
+        return r;
+    char rec[SIZE_SNAPSHOT_IDENTITY_RECORD];
+    for (auto &v : values) {
+        toRecord(rec, v.first, v.second);
+        r = w.append(rec);
+        if (r)
+            return r;
+    }
+    return w.commit();
+}
+
+void IdentitySnapshot::toRecord(
+    char *retVal,
+    const DEVADDR &addr,
+    const DEVICEID &id
+)
+{
+    memmove(retVal, &addr.u, SIZE_DEVADDR);
+    id.toArray(retVal + SIZE_DEVADDR, SIZE_DEVICEID);
+}
+
+void IdentitySnapshot::fromRecord(
+    DEVADDR &retAddr,
+    DEVICEID &retVal,
+    const char *record
+)
+{
+    memmove(&retAddr.u, record, SIZE_DEVADDR);
+    retVal.fromArray(record + SIZE_DEVADDR, SIZE_DEVICEID);
+}
+
+GatewaySnapshot::GatewaySnapshot()
+    : SnapshotFile(SNAPSHOT_MAGIC_GATEWAY, SIZE_SNAPSHOT_GATEWAY_RECORD)
+{
+}
+
+int GatewaySnapshot::get(
+    GatewayIdentity &retVal,
+    uint64_t gatewayId
+) const
+{
+    size_t lo = 0;
+    size_t hi = size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        uint64_t id;
+        memmove(&id, record(mid), sizeof(uint64_t));
+        if (id < gatewayId)
+            lo = mid + 1;
+        else if (gatewayId < id)
+            hi = mid;
+        else {
+            at(retVal, mid);
+            return CODE_OK;
+        }
+    }
+    return ERR_CODE_GATEWAY_NOT_FOUND;
+}
+
+void GatewaySnapshot::at(
+    GatewayIdentity &retVal,
+    size_t index
+) const
+{
+    fromRecord(retVal, record(index));
+}
+
+size_t GatewaySnapshot::load(
+    std::map<uint64_t, GatewayIdentity> &retVal
+) const
+{
+    size_t c = size();
+    for (size_t i = 0; i < c; i++) {
+        GatewayIdentity gi;
+        at(gi, i);
+        retVal.emplace_hint(retVal.end(), gi.gatewayId, gi);
+    }
+    return c;
+}
+
+int GatewaySnapshot::save(
+    const std::string &fileName,
+    const std::map<uint64_t, GatewayIdentity> &values
+)
+{
+    SnapshotWriter w(SNAPSHOT_MAGIC_GATEWAY, SIZE_SNAPSHOT_GATEWAY_RECORD);
+    int r = w.open(fileName);
+    if (r)
+        return r;
+    char rec[SIZE_SNAPSHOT_GATEWAY_RECORD];
+    for (auto &v : values) {
+        toRecord(rec, v.second);
+        r = w.append(rec);
+        if (r)
+            return r;
+    }
+    return w.commit();
+}
+
+void GatewaySnapshot::toRecord(
+    char *retVal,
+    const GatewayIdentity &value
+)
+{
+    memmove(retVal, &value.gatewayId, sizeof(uint64_t));
+    memmove(retVal + sizeof(uint64_t), &value.sockaddr, sizeof(struct sockaddr));
+}
+
+void GatewaySnapshot::fromRecord(
+    GatewayIdentity &retVal,
+    const char *record
+)
+{
+    memmove(&retVal.gatewayId, record, sizeof(uint64_t));
+    memmove(&retVal.sockaddr, record + sizeof(uint64_t), sizeof(struct sockaddr));
+}
+
+bool isSnapshotActual(
+    const std::string &snapshotFileName,
+    const std::string &jsonFileName
+)
+{
+    struct stat snapshotStat {};
+    if (stat(snapshotFileName.c_str(), &snapshotStat))
+        return false;
+    struct stat jsonStat {};
+    if (stat(jsonFileName.c_str(), &jsonStat))
+        return true;
+#ifdef __linux__
+    // JSON file is written just before the snapshot on exit, compare nanoseconds
+    if (snapshotStat.st_mtim.tv_sec != jsonStat.st_mtim.tv_sec)
+        return snapshotStat.st_mtim.tv_sec > jsonStat.st_mtim.tv_sec;
+    return snapshotStat.st_mtim.tv_nsec >= jsonStat.st_mtim.tv_nsec;
+#else
+    // one second resolution, JSON file modified in the same second is loaded
+    return snapshotStat.st_mtime > jsonStat.st_mtime;
+#endif
+}
@@ -0,0 +1,235 @@
+#ifndef STORAGE_SNAPSHOT_H_
+#define STORAGE_SNAPSHOT_H_ 1
+
+#include <string>
+#include <map>
+#include <cstdio>
+
+#include "lorawan/lorawan-types.h"
+#include "lorawan/storage/gateway-identity.h"
+
+/**
+ * Compact binary snapshot of the identity and gateway storage.
+ *
+ * File layout:
+ *  SNAPSHOT_HEADER (16 bytes)
+ *  count * recordSize bytes of fixed size records sorted by the key in ascending order
+ *
+ * Identity record: DEVADDR (4 bytes) + DEVICEID::toArray() (102 bytes)
+ * Gateway record:  gateway identifier (8 bytes) + struct sockaddr (16 bytes)
+ *
+ * Keys and integers are stored in the host byte order, snapshot is not intended to be copied
+ * between hosts. Use JSON files to import/export.
+ *
+ * Snapshot is written to the temporary file first then renamed, so readers never see partially written file.
+ * Reader maps file into memory. Services copy records to the map at startup (sorted records are appended
+ * in linear time without parsing), get() does binary search over mapped records for the read-only lookups.
+ */
+
+#define SNAPSHOT_VERSION                1
+#define SNAPSHOT_MAGIC_IDENTITY         0x5349544c  ///< "LTIS" in little endian
+#define SNAPSHOT_MAGIC_GATEWAY          0x5347544c  ///< "LTGS" in little endian
+#define SNAPSHOT_FILE_SUFFIX            ".snapshot"
+
+#define SIZE_SNAPSHOT_IDENTITY_RECORD   (SIZE_DEVADDR + SIZE_DEVICEID)      // 106 bytes
+#define SIZE_SNAPSHOT_GATEWAY_RECORD    (8 + 16)                            // 24 bytes
+
+typedef PACK(struct {
+    uint32_t magic;         ///< SNAPSHOT_MAGIC_IDENTITY or SNAPSHOT_MAGIC_GATEWAY
+    uint16_t version;       ///< SNAPSHOT_VERSION
+    uint16_t recordSize;    ///< record size in bytes
+    uint64_t count;         ///< records count
+}) SNAPSHOT_HEADER;         // 16 bytes
+
+#define SIZE_SNAPSHOT_HEADER 16
+
+/**
+ * Read-only memory mapped snapshot file
+ */
+class SnapshotFile {
+protected:
+    const char *data;           ///< mapped file
+    size_t dataSize;            ///< mapped file size
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    void *hFile;
+    void *hMapping;
+#else
+    int fd;
+#endif
+    uint32_t magic;
+    uint16_t recordSize;
+    uint64_t count;
+public:
+    SnapshotFile(
+        uint32_t magic,
+        uint16_t recordSize
+    );
+    virtual ~SnapshotFile();
+    /**
+     * Map snapshot file into memory and validate header
+     * @param fileName snapshot file name
+     * @return CODE_OK- success, ERR_CODE_DB_DATABASE_OPEN- file not found or invalid
+     */
+    int open(
+        const std::string &fileName
+    );
+    void close();
+    /**
+     * @return records count, 0 if snapshot is not open
+     */
+    size_t size() const;
+    /**
+     * Return pointer to the record
+     * @param index 0..size() - 1
+     * @return record
+     */
+    const char *record(
+        size_t index
+    ) const;
+};
+
+/**
+ * Write snapshot to the temporary file, then rename it.
+ *  SnapshotWriter w(SNAPSHOT_MAGIC_IDENTITY, SIZE_SNAPSHOT_IDENTITY_RECORD);
+ *  w.open(fileName);
+ *  w.append(record)...
+ *  w.commit();
+ */
+class SnapshotWriter {
+private:
+    std::string fileName;
+    std::string tempFileName;
+    FILE *f;
+    SNAPSHOT_HEADER header;
+public:
+    SnapshotWriter(
+        uint32_t magic,
+        uint16_t recordSize
+    );
+    virtual ~SnapshotWriter();
+    int open(
+        const std::string &fileName
+    );
+    int append(
+        const void *record
+    );
+    /**
+     * Write records count, flush file to the disk and atomically replace snapshot file
+     * @return CODE_OK- success
+     */
+    int commit();
+    /**
+     * Remove temporary file
+     */
+    void rollback();
+};
+
+/**
+ * Identity snapshot
+ */
+class IdentitySnapshot : public SnapshotFile {
+public:
+    IdentitySnapshot();
+    /**
+     * Binary search record by the address
+     * @param retVal device identifier
+     * @param addr address
+     * @return CODE_OK- success, ERR_CODE_DEVICE_ADDRESS_NOTFOUND- not found
+     */
+    int get(
+        DEVICEID &retVal,
+        const DEVADDR &addr
+    ) const;
+    /**
+     * Read record by index
+     */
+    void at(
+        DEVADDR &retAddr,
+        DEVICEID &retVal,
+        size_t index
+    ) const;
+    /**
+     * Copy all records to the map
+     * @param retVal destination
+     * @return records count
+     */
+    size_t load(
+        std::map<DEVADDR, DEVICEID> &retVal
+    ) const;
+    /**
+     * Atomically write map to the snapshot file
+     * @param fileName snapshot file name
+     * @param values map sorted by address
+     * @return CODE_OK- success
+     */
+    static int save(
+        const std::string &fileName,
+        const std::map<DEVADDR, DEVICEID> &values
+    );
+    /**
+     * Serialize identity to the SIZE_SNAPSHOT_IDENTITY_RECORD bytes record
+     */
+    static void toRecord(
+        char *retVal,
+        const DEVADDR &addr,
+        const DEVICEID &id
+    );
+    static void fromRecord(
+        DEVADDR &retAddr,
+        DEVICEID &retVal,
+        const char *record
+    );
+};
+
+/**
+ * Gateway snapshot
+ */
+class GatewaySnapshot : public SnapshotFile {
+public:
+    GatewaySnapshot();
+    /**
+     * Binary search record by the gateway identifier
+     * @param retVal gateway identity
+     * @param gatewayId gateway identifier
+     * @return CODE_OK- success, ERR_CODE_GATEWAY_NOT_FOUND- not found
+     */
+    int get(
+        GatewayIdentity &retVal,
+        uint64_t gatewayId
+    ) const;
+    void at(
+        GatewayIdentity &retVal,
+        size_t index
+    ) const;
+    size_t load(
+        std::map<uint64_t, GatewayIdentity> &retVal
+    ) const;
+    static int save(
+        const std::string &fileName,
+        const std::map<uint64_t, GatewayIdentity> &values
+    );
+    /**
+     * Serialize gateway to the SIZE_SNAPSHOT_GATEWAY_RECORD bytes record
+     */
+    static void toRecord(
+        char *retVal,
+        const GatewayIdentity &value
+    );
+    static void fromRecord(
+        GatewayIdentity &retVal,
+        const char *record
+    );
+};
+
+/**
+ * Return true if snapshot file exists and it is not older than JSON file
+ * @param snapshotFileName snapshot file name
+ * @param jsonFileName JSON file name
+ * @return true if snapshot must be loaded instead of JSON file
+ */
+bool isSnapshotActual(
+    const std::string &snapshotFileName,
+    const std::string &jsonFileName
+);
+
+#endif
@@ -0,0 +1,287 @@
+#include <cmath>
+#include <cstring>
+
+#include "lorawan/task/adr-engine.h"
+#include "lorawan/task/message-queue-item.h"
+#include "lorawan/lorawan-mac.h"
+
+// channels mask control: 6- all defined channels ON
+#define CHMASKCNTL_ALL_ON   6
+
+AdrDevice::AdrDevice()
+    : samples {}, fcnt(0), count(0), next(0), dataRate(0), txPower(0)
+{
+
+}
+
+void AdrDevice::add(
+    uint16_t aFcnt,
+    float snr,
+    int16_t rssi
+)
+{
+    float s = snr * ADR_SNR_SCALE;
+    if (s > INT8_MAX)
+        s = INT8_MAX;
+    if (s < INT8_MIN)
+        s = INT8_MIN;
+    if (count && aFcnt == fcnt) {
+        // same uplink received by other gateway
+        ADR_SAMPLE &last = samples[(next + ADR_HISTORY_SIZE - 1) % ADR_HISTORY_SIZE];
+        if (s > last.snr) {
+            last.snr = (int8_t) s;
+            last.rssi = rssi;
+        }
+        return;
+    }
+    fcnt = aFcnt;
+    samples[next].snr = (int8_t) s;
+    samples[next].rssi = rssi;
+    next = (next + 1) % ADR_HISTORY_SIZE;
+    if (count < ADR_HISTORY_SIZE)
+        count++;
+}
+
+float AdrDevice::maxSnr() const
+{
+    int r = INT8_MIN;
+    for (uint8_t i = 0; i < count; i++) {
+        if (samples[i].snr > r)
+            r = samples[i].snr;
+    }
+    return (float) r / ADR_SNR_SCALE;
+}
+
+void AdrDevice::clear()
+{
+    count = 0;
+    next = 0;
+}
+
+AdrEngine::AdrEngine()
+    : installationMargin(DEF_ADR_INSTALLATION_MARGIN), minSamples(DEF_ADR_MIN_SAMPLES), nbTrans(1)
+{
+
+}
+
+AdrEngine::AdrEngine(
+    const AdrEngine &value
+)
+    : installationMargin(value.installationMargin), minSamples(value.minSamples), nbTrans(value.nbTrans)
+{
+    std::lock_guard<std::mutex> lock(const_cast<AdrEngine &>(value).devicesMutex);
+    devices = value.devices;
+}
+
+AdrEngine::~AdrEngine() = default;
+
+bool AdrEngine::add(
+    const DEVADDR &addr,
+    uint16_t fcnt,
+    const SEMTECH_PROTOCOL_METADATA_RX &rx,
+    const RegionalParameterChannelPlan *plan
+)
+{
+    if (rx.modu != MODULATION_LORA)
+        return false;
+    int dr = dataRateIndex(plan, rx.bandwidth, rx.spreadingFactor);
+    if (dr < 0)
+        return false;
+    std::lock_guard<std::mutex> lock(devicesMutex);
+    AdrDevice &d = devices[addr.u];
+    // SNR measured at other data rate is useless
+    if (d.dataRate != dr) {
+        d.clear();
+        d.dataRate = (uint8_t) dr;
+    }
+    d.add(fcnt, rx.lsnr, rx.rssi);
+    return true;
+}
+
+bool AdrEngine::add(
+    const MessageQueueItem &item,
+    const RegionalParameterChannelPlan *plan
+)
+{
+    auto mtype = item.radioPacket.mhdr.f.mtype;
+    if (mtype != MTYPE_UNCONFIRMED_DATA_UP && mtype != MTYPE_CONFIRMED_DATA_UP)
+        return false;
+    const UPLINK_STORAGE &uplink = item.radioPacket.data.uplink;
+    if (!uplink.f.adr)
+        return false;
+    GatewayMetadata gwm;
+    if (!item.getBestGatewayAddress(gwm))
+        return false;
+    return add(uplink.devaddr, uplink.fcnt, gwm.rx, plan);
+}
+
+bool AdrEngine::calculate(
+    uint8_t &retDataRate,
+    uint8_t &retTxPower,
+    const DEVADDR &addr,
+    const RegionalParameterChannelPlan *plan
+)
+{
+    if (!plan)
+        return false;
+    const REGIONAL_PARAMETER_CHANNEL_PLAN *p = plan->get();
+    std::lock_guard<std::mutex> lock(devicesMutex);
+    auto f = devices.find(addr.u);
+    if (f == devices.end())
+        return false;
+    const AdrDevice &d = f->second;
+    if (d.count < minSamples || d.dataRate >= p->dataRates.size())
+        return false;
+    const DATA_RATE &current = p->dataRates[d.dataRate].value;
+    // highest data rate uplink channels allow
+    int maxChannelDR = -1;
+    for (auto &c : p->uplinkChannels) {
+        if (c.value.enabled && c.value.maxDR > maxChannelDR)
+            maxChannelDR = c.value.maxDR;
+    }
+    int maxTxPower = p->txPowerOffsets.empty() ? 0 : (int) p->txPowerOffsets.size() - 1;
+
+    float margin = d.maxSnr() - requiredSnr(current.spreadingFactor) - installationMargin;
+    int steps = (int) std::floor(margin / ADR_STEP_DB);
+    int dr = d.dataRate;
+    int pwr = d.txPower;
+    // faster data rate first, keep modulation and bandwidth
+    while (steps > 0) {
+        int n = dr + 1;
+        if (n >= (int) p->dataRates.size() || (maxChannelDR >= 0 && n > maxChannelDR))
+            break;
+        const DATA_RATE &r = p->dataRates[n].value;
+        if (!r.uplink || r.modulation != MODULATION_LORA || r.bandwidth != current.bandwidth)
+            break;
+        dr = n;
+        steps--;
+    }
+    // then lower TX power, raise it if margin is negative
+    while (steps > 0 && pwr < maxTxPower) {
+        pwr++;
+        steps--;
+    }
+    while (steps < 0 && pwr > 0) {
+        pwr--;
+        steps++;
+    }
+    retDataRate = (uint8_t) dr;
+    retTxPower = (uint8_t) pwr;
+    return dr != d.dataRate || pwr != d.txPower;
+}
+
+size_t AdrEngine::linkADRReq(
+    void *retVal,
+    size_t size,
+    const DEVADDR &addr,
+    const RegionalParameterChannelPlan *plan
+)
+{
+    if (size < MAC_LINK_ADR_REQ_SIZE)
+        return 0;
+    uint8_t dr, pwr;
+    if (!calculate(dr, pwr, addr, plan))
+        return 0;
+    uint16_t chMask = 0;
+    auto &channels = plan->get()->uplinkChannels;
+    for (size_t i = 0; i < channels.size() && i < 16; i++) {
+        if (channels[i].value.enabled)
+            chMask |= (uint16_t) (1 << i);
+    }
+    MacDataClientLinkADR m(pwr, dr, chMask, nbTrans, chMask ? 0 : CHMASKCNTL_ALL_ON);
+    memmove(retVal, &m.command, MAC_LINK_ADR_REQ_SIZE);
+
+    std::lock_guard<std::mutex> lock(devicesMutex);
+    auto f = devices.find(addr.u);
+    if (f != devices.end()) {
+        f->second.dataRate = dr;
+        f->second.txPower = pwr;
+        f->second.clear();
+    }
+    return MAC_LINK_ADR_REQ_SIZE;
+}
+
+void AdrEngine::rm(
+    const DEVADDR &addr
+)
+{
+    std::lock_guard<std::mutex> lock(devicesMutex);
+    devices.erase(addr.u);
+}
+
+size_t AdrEngine::size()
+{
+    std::lock_guard<std::mutex> lock(devicesMutex);
+    return devices.size();
+}
+
+float AdrEngine::requiredSnr(
+    SPREADING_FACTOR spreadingFactor
+)
+{
+    // SF7 -7.5 dB, each next spreading factor requires 2.5 dB less
+    return -7.5f - 2.5f * (float) ((int) spreadingFactor - DRLORA_SF7);
+}
+
+int AdrEngine::dataRateIndex(
+    const RegionalParameterChannelPlan *plan,
+    BANDWIDTH bandwidth,
+    SPREADING_FACTOR spreadingFactor
+)
+{
+    if (!plan)
+        return -1;
+    auto &rates = plan->get()->dataRates;
+    for (size_t i = 0; i < rates.size(); i++) {
+        const DATA_RATE &r = rates[i].value;
+        if (r.modulation == MODULATION_LORA && r.bandwidth == bandwidth && r.spreadingFactor == spreadingFactor)
+            return (int) i;
+    }
+    return -1;
+}
+
+static double bandwidthHz(
+    BANDWIDTH bandwidth
+)
+{
+    switch (bandwidth) {
+        case BANDWIDTH_INDEX_7KHZ:
+            return 7800;
+        case BANDWIDTH_INDEX_10KHZ:
+            return 10400;
+        case BANDWIDTH_INDEX_15KHZ:
+            return 15600;
+        case BANDWIDTH_INDEX_20KHZ:
+            return 20800;
+        case BANDWIDTH_INDEX_31KHZ:
+            return 31250;
+        case BANDWIDTH_INDEX_41KHZ:
+            return 41700;
+        case BANDWIDTH_INDEX_62KHZ:
+            return 62500;
+        case BANDWIDTH_INDEX_250KHZ:
+            return 250000;
+        case BANDWIDTH_INDEX_500KHZ:
+            return 500000;
+        default:
+            return 125000;
+    }
+}
+
+double AdrEngine::airtimeMilliseconds(
+    SPREADING_FACTOR spreadingFactor,
+    BANDWIDTH bandwidth,
+    size_t payloadSize
+)
+{
+    double bw = bandwidthHz(bandwidth);
+    int sf = (int) spreadingFactor;
+    double symbolMs = (double) (1 << sf) / bw * 1000.0;
+    // low data rate optimization
+    int de = (sf >= 11 && bw <= 125000) ? 1 : 0;
+    // explicit header, CRC on, CR 4/5
+    int n = 8 * (int) payloadSize - 4 * sf + 28 + 16;
+    int d = 4 * (sf - 2 * de);
+    int payloadSymbols = 8 + (n > 0 ? (n + d - 1) / d * 5 : 0);
+    return (8 + 4.25) * symbolMs + payloadSymbols * symbolMs;
+}
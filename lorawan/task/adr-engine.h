@@ -0,0 +1,148 @@
+#ifndef ADR_ENGINE_H
+#define ADR_ENGINE_H
+
+#include <mutex>
+#include <unordered_map>
+
+#include "lorawan/lorawan-types.h"
+#include "lorawan/regional-parameters/regional-parameter-channel-plan.h"
+
+/**
+ * Server-side adaptive data rate.
+ * Dispatcher adds the best gateway SNR/RSSI of each uplink with ADR bit set to the per-device ring.
+ * When enough uplinks are collected, engine computes the fastest data rate and the lowest TX power
+ * the link budget allows (Semtech recommended algorithm) and dispatcher piggy-backs LinkADRReq
+ * in FOpts of the next downlink to the device.
+ */
+
+class MessageQueueItem;
+
+#define ADR_HISTORY_SIZE                20      ///< uplinks remembered per device
+#define DEF_ADR_MIN_SAMPLES             20      ///< uplinks required to compute data rate
+#define DEF_ADR_INSTALLATION_MARGIN     10.0f   ///< dB
+#define ADR_STEP_DB                     3.0f    ///< one data rate or TX power step
+#define ADR_SNR_SCALE                   4       ///< SNR stored in 0.25 dB units
+
+/**
+ * Uplink reception conditions
+ */
+typedef PACK( struct {
+    int16_t rssi;           ///< dBm
+    int8_t snr;             ///< dB * ADR_SNR_SCALE
+} ) ADR_SAMPLE;
+
+class AdrDevice {
+public:
+    ADR_SAMPLE samples[ADR_HISTORY_SIZE];
+    uint16_t fcnt;          ///< frame counter of the last sample, duplicates update it
+    uint8_t count;
+    uint8_t next;
+    uint8_t dataRate;       ///< data rate index of the last uplink
+    uint8_t txPower;        ///< TX power index requested last time, 0- max EIRP
+    AdrDevice();
+    /**
+     * Add uplink. Uplink with the same frame counter received by other gateway replaces sample if better
+     */
+    void add(
+        uint16_t fcnt,
+        float snr,
+        int16_t rssi
+    );
+    float maxSnr() const;
+    void clear();
+};
+
+class AdrEngine {
+private:
+    std::mutex devicesMutex;
+    std::unordered_map<uint32_t, AdrDevice> devices;
+public:
+    float installationMargin;       ///< dB
+    size_t minSamples;
+    uint8_t nbTrans;                ///< transmissions of each uplink requested in LinkADRReq
+
+    AdrEngine();
+    AdrEngine(
+        const AdrEngine &value
+    );
+    virtual ~AdrEngine();
+
+    /**
+     * Add uplink reception conditions
+     * @param addr device address
+     * @param fcnt frame counter
+     * @param rx metadata of the gateway
+     * @param plan regional plan to map spreading factor and bandwidth to the data rate
+     * @return false if data rate is not found in the plan
+     */
+    bool add(
+        const DEVADDR &addr,
+        uint16_t fcnt,
+        const SEMTECH_PROTOCOL_METADATA_RX &rx,
+        const RegionalParameterChannelPlan *plan
+    );
+    /**
+     * Add uplink received by the gateway with the best SNR if device set ADR bit
+     * @return false if ADR bit is not set or data rate is not found in the plan
+     */
+    bool add(
+        const MessageQueueItem &item,
+        const RegionalParameterChannelPlan *plan
+    );
+    /**
+     * Compute optimal data rate and TX power
+     * @param retDataRate data rate index
+     * @param retTxPower TX power index
+     * @return true if device must change data rate or TX power
+     */
+    bool calculate(
+        uint8_t &retDataRate,
+        uint8_t &retTxPower,
+        const DEVADDR &addr,
+        const RegionalParameterChannelPlan *plan
+    );
+    /**
+     * Write LinkADRReq MAC command if device must change data rate or TX power.
+     * Device is expected to apply new settings, history is cleared to collect uplinks with new settings.
+     * @param retVal FOpts buffer
+     * @param size FOpts buffer size
+     * @return bytes written, 0 if nothing to send or there is no room
+     */
+    size_t linkADRReq(
+        void *retVal,
+        size_t size,
+        const DEVADDR &addr,
+        const RegionalParameterChannelPlan *plan
+    );
+    void rm(
+        const DEVADDR &addr
+    );
+    size_t size();
+
+    /**
+     * @return demodulation floor SNR in dB
+     */
+    static float requiredSnr(
+        SPREADING_FACTOR spreadingFactor
+    );
+    /**
+     * @return data rate index in the regional plan, -1 if not found
+     */
+    static int dataRateIndex(
+        const RegionalParameterChannelPlan *plan,
+        BANDWIDTH bandwidth,
+        SPREADING_FACTOR spreadingFactor
+    );
+    /**
+     * LoRa time on air, explicit header, CR 4/5, 8 symbols preamble
+     * @param payloadSize PHYPayload size
+     * @return milliseconds
+     */
+    static double airtimeMilliseconds(
+        SPREADING_FACTOR spreadingFactor,
+        BANDWIDTH bandwidth,
+        size_t payloadSize
+    );
+};
+
+#endif
@@ -0,0 +1,408 @@
+#include <sstream>
+
+#include "lorawan/task/dispatcher-metrics.h"
+
+static const double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+static const char *QUANTILE_NAMES[] = { "0.5", "0.9", "0.99", "0.999" };
+static const char *QUANTILE_JSON_NAMES[] = { "p50", "p90", "p99", "p999" };
+
+/**
+ * Each thread gets own counter shard on first use
+ */
+static size_t shardIndex()
+{
+    static std::atomic<size_t> nextShard(0);
+    static thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % METRICS_COUNTER_SHARDS;
+    return shard;
+}
+
+static int mostSignificantBit(
+    uint64_t value
+)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int r = 0;
+    while (value >>= 1)
+        r++;
+    return r;
+#endif
+}
+
+MetricsCounter::MetricsCounter()
+{
+    reset();
+}
+
+void MetricsCounter::inc(
+    uint64_t value
+)
+{
+    shards[shardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t MetricsCounter::get() const
+{
+    uint64_t r = 0;
+    for (auto &s : shards) {
+        r += s.value.load(std::memory_order_relaxed);
+    }
+    return r;
+}
+
+void MetricsCounter::reset()
+{
+    for (auto &s : shards) {
+        s.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+MetricsGauge::MetricsGauge()
+    : value(0)
+{
+}
+
+void MetricsGauge::set(
+    int64_t aValue
+)
+{
+    value.store(aValue, std::memory_order_relaxed);
+}
+
+void MetricsGauge::add(
+    int64_t aValue
+)
+{
+    value.fetch_add(aValue, std::memory_order_relaxed);
+}
+
+int64_t MetricsGauge::get() const
+{
+    return value.load(std::memory_order_relaxed);
+}
+
+MetricsHistogram::MetricsHistogram()
+{
+    reset();
+}
+
+size_t MetricsHistogram::bucketIndex(
+    uint64_t value
+)
+{
+    if (value < METRICS_HISTOGRAM_SUB_COUNT)
+        return (size_t) value;
+    int msb = mostSignificantBit(value);
+    int shift = msb - METRICS_HISTOGRAM_SUB_BITS;
+    return (size_t) (shift + 1) * METRICS_HISTOGRAM_SUB_COUNT
+        + (size_t) ((value >> shift) & (METRICS_HISTOGRAM_SUB_COUNT - 1));
+}
+
+uint64_t MetricsHistogram::bucketUpperBound(
+    size_t index
+)
+{
+    if (index < METRICS_HISTOGRAM_SUB_COUNT)
+        return index;
+    size_t shift = index / METRICS_HISTOGRAM_SUB_COUNT - 1;
+    uint64_t lower = (uint64_t) (METRICS_HISTOGRAM_SUB_COUNT + index % METRICS_HISTOGRAM_SUB_COUNT) << shift;
+    return lower + (((uint64_t) 1 << shift) - 1);
+}
+
+void MetricsHistogram::record(
+    int64_t value
+)
+{
+    uint64_t v = value < 0 ? 0 : (uint64_t) value;
+    buckets[bucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(v, std::memory_order_relaxed);
+    uint64_t m = maxValue.load(std::memory_order_relaxed);
+    while (v > m && !maxValue.compare_exchange_weak(m, v, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t MetricsHistogram::getCount() const
+{
+    return count.load(std::memory_order_relaxed);
+}
+
+uint64_t MetricsHistogram::getSum() const
+{
+    return sum.load(std::memory_order_relaxed);
+}
+
+uint64_t MetricsHistogram::getMax() const
+{
+    return maxValue.load(std::memory_order_relaxed);
+}
+
+uint64_t MetricsHistogram::quantile(
+    double q
+) const
+{
+    // sum buckets instead of count, writers may be in the middle of record()
+    uint64_t total = 0;
+    for (auto &b : buckets) {
+        total += b.load(std::memory_order_relaxed);
+    }
+    if (!total)
+        return 0;
+    auto rank = (uint64_t) (q * (double) total);
+    if (rank >= total)
+        rank = total - 1;
+    uint64_t c = 0;
+    for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        c += buckets[i].load(std::memory_order_relaxed);
+        if (c > rank) {
+            uint64_t r = bucketUpperBound(i);
+            uint64_t m = getMax();
+            return r < m ? r : m;
+        }
+    }
+    return getMax();
+}
+
+void MetricsHistogram::reset()
+{
+    for (auto &b : buckets) {
+        b.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+DispatcherMetrics::DispatcherMetrics() = default;
+
+void DispatcherMetrics::reset()
+{
+    packets.reset();
+    parseErrors.reset();
+    pushData.reset();
+    pullData.reset();
+    txAck.reset();
+    uplinks.reset();
+    duplicates.reset();
+    micFailures.reset();
+    bridgePayloads.reset();
+    downlinks.reset();
+    downlinkErrors.reset();
+    acks.reset();
+    joinRequests.reset();
+    joinUnknown.reset();
+    joinReplays.reset();
+    joinRateLimited.reset();
+    joinLate.reset();
+    joinAccepts.reset();
+    joinErrors.reset();
+    adrRequests.reset();
+    ackLatency.reset();
+    bridgeDelivery.reset();
+    for (auto &s : stages) {
+        s.reset();
+    }
+    traceTotal.reset();
+    for (auto &s : joinStages) {
+        s.reset();
+    }
+    joinLatency.reset();
+}
+
+void DispatcherMetrics::recordTrace(
+    const PacketTrace &trace
+)
+{
+    for (int s = TRACE_STAGE_RECEIVED; s < TRACE_STAGE_COUNT; s++) {
+        int64_t d = trace.duration((TRACE_STAGE) s);
+        if (d >= 0)
+            stages[s].record(d);
+    }
+    traceTotal.record(trace.total());
+}
+
+static void histogram2json(
+    std::ostream &strm,
+    const MetricsHistogram &value
+)
+{
+    strm << "{\"count\": " << value.getCount() << ", \"sum\": " << value.getSum();
+    for (size_t i = 0; i < sizeof(QUANTILES) / sizeof(QUANTILES[0]); i++) {
+        strm << ", \"" << QUANTILE_JSON_NAMES[i] << "\": " << value.quantile(QUANTILES[i]);
+    }
+    strm << ", \"max\": " << value.getMax() << "}";
+}
+
+std::string DispatcherMetrics::toJsonString() const
+{
+    std::stringstream ss;
+    ss << "{\"packets\": " << packets.get()
+        << ", \"parseErrors\": " << parseErrors.get()
+        << ", \"pushData\": " << pushData.get()
+        << ", \"pullData\": " << pullData.get()
+        << ", \"txAck\": " << txAck.get()
+        << ", \"uplinks\": " << uplinks.get()
+        << ", \"duplicates\": " << duplicates.get()
+        << ", \"micFailures\": " << micFailures.get()
+        << ", \"bridgePayloads\": " << bridgePayloads.get()
+        << ", \"downlinks\": " << downlinks.get()
+        << ", \"downlinkErrors\": " << downlinkErrors.get()
+        << ", \"acks\": " << acks.get()
+        << ", \"uplinkQueueSize\": " << uplinkQueueSize.get()
+        << ", \"downlinkQueueSize\": " << downlinkQueueSize.get()
+        << ", \"gateways\": " << gateways.get()
+        << ", \"sockets\": " << sockets.get()
+        << ", \"joinRequests\": " << joinRequests.get()
+        << ", \"joinUnknown\": " << joinUnknown.get()
+        << ", \"joinReplays\": " << joinReplays.get()
+        << ", \"joinRateLimited\": " << joinRateLimited.get()
+        << ", \"joinLate\": " << joinLate.get()
+        << ", \"joinAccepts\": " << joinAccepts.get()
+        << ", \"joinErrors\": " << joinErrors.get()
+        << ", \"adrRequests\": " << adrRequests.get()
+        << ", \"joinQueueSize\": " << joinQueueSize.get()
+        << ", \"ackLatency\": ";
+    histogram2json(ss, ackLatency);
+    ss << ", \"bridgeDelivery\": ";
+    histogram2json(ss, bridgeDelivery);
+    if (traceTotal.getCount()) {
+        ss << ", \"stages\": {";
+        for (int s = TRACE_STAGE_RECEIVED; s < TRACE_STAGE_COUNT; s++) {
+            ss << "\"" << PacketTrace::stageName((TRACE_STAGE) s) << "\": ";
+            histogram2json(ss, stages[s]);
+            ss << ", ";
+        }
+        ss << "\"total\": ";
+        histogram2json(ss, traceTotal);
+        ss << "}";
+    }
+    if (joinRequests.get()) {
+        ss << ", \"joinStages\": {";
+        for (int s = 0; s < JOIN_STAGE_COUNT; s++) {
+            ss << "\"" << JoinPipeline::stageName((JOIN_STAGE) s) << "\": ";
+            histogram2json(ss, joinStages[s]);
+            ss << ", ";
+        }
+        ss << "\"latency\": ";
+        histogram2json(ss, joinLatency);
+        ss << "}";
+    }
+    ss << "}";
+    return ss.str();
+}
+
+static void counter2prometheus(
+    std::ostream &strm,
+    const std::string &prefix,
+    const char *name,
+    const char *help,
+    uint64_t value
+)
+{
+    strm << "# HELP " << prefix << name << "_total " << help << "\n"
+        << "# TYPE " << prefix << name << "_total counter\n"
+        << prefix << name << "_total " << value << "\n";
+}
+
+static void gauge2prometheus(
+    std::ostream &strm,
+    const std::string &prefix,
+    const char *name,
+    const char *help,
+    int64_t value
+)
+{
+    strm << "# HELP " << prefix << name << ' ' << help << "\n"
+        << "# TYPE " << prefix << name << " gauge\n"
+        << prefix << name << ' ' << value << "\n";
+}
+
+/**
+ * @param label optional label e.g. stage="parsed" or empty string
+ */
+static void summary2prometheus(
+    std::ostream &strm,
+    const std::string &prefix,
+    const char *name,
+    const std::string &label,
+    const MetricsHistogram &value
+)
+{
+    std::string sep = label.empty() ? "" : ",";
+    for (size_t i = 0; i < sizeof(QUANTILES) / sizeof(QUANTILES[0]); i++) {
+        strm << prefix << name << "{" << label << sep << "quantile=\"" << QUANTILE_NAMES[i] << "\"} "
+            << value.quantile(QUANTILES[i]) << "\n";
+    }
+    std::string labels = label.empty() ? "" : "{" + label + "}";
+    strm << prefix << name << "_sum" << labels << ' ' << value.getSum() << "\n"
+        << prefix << name << "_count" << labels << ' ' << value.getCount() << "\n";
+}
+
+static void histogram2prometheus(
+    std::ostream &strm,
+    const std::string &prefix,
+    const char *name,
+    const char *help,
+    const MetricsHistogram &value
+)
+{
+    strm << "# HELP " << prefix << name << ' ' << help << "\n"
+        << "# TYPE " << prefix << name << " summary\n";
+    summary2prometheus(strm, prefix, name, "", value);
+}
+
+std::string DispatcherMetrics::toPrometheus(
+    const std::string &prefix
+) const
+{
+    std::stringstream ss;
+    counter2prometheus(ss, prefix, "packets", "Packets received from the gateways", packets.get());
+    counter2prometheus(ss, prefix, "parse_errors", "Packets rejected by the protocol parsers", parseErrors.get());
+    counter2prometheus(ss, prefix, "push_data", "PUSH_DATA packets", pushData.get());
+    counter2prometheus(ss, prefix, "pull_data", "PULL_DATA packets", pullData.get());
+    counter2prometheus(ss, prefix, "tx_ack", "TX_ACK packets", txAck.get());
+    counter2prometheus(ss, prefix, "uplinks", "Radio packets received", uplinks.get());
+    counter2prometheus(ss, prefix, "duplicates", "Radio packets received by more than one gateway", duplicates.get());
+    counter2prometheus(ss, prefix, "mic_failures", "Uplinks with MIC mismatch", micFailures.get());
+    counter2prometheus(ss, prefix, "bridge_payloads", "Uplinks passed to the application bridges", bridgePayloads.get());
+    counter2prometheus(ss, prefix, "downlinks", "Downlinks sent to the gateways", downlinks.get());
+    counter2prometheus(ss, prefix, "downlink_errors", "Downlinks failed", downlinkErrors.get());
+    counter2prometheus(ss, prefix, "acks", "ACK packets sent to the gateways", acks.get());
+    counter2prometheus(ss, prefix, "join_requests", "Join-requests processed", joinRequests.get());
+    counter2prometheus(ss, prefix, "join_unknown", "Join-requests from unknown devices", joinUnknown.get());
+    counter2prometheus(ss, prefix, "join_replays", "Join-requests with already used DevNonce", joinReplays.get());
+    counter2prometheus(ss, prefix, "join_rate_limited", "Join-requests dropped by the gateway rate limit", joinRateLimited.get());
+    counter2prometheus(ss, prefix, "join_late", "Join-requests missed RX2 window", joinLate.get());
+    counter2prometheus(ss, prefix, "join_accepts", "Join-accepts sent", joinAccepts.get());
+    counter2prometheus(ss, prefix, "join_errors", "Join-accepts failed", joinErrors.get());
+    counter2prometheus(ss, prefix, "adr_requests", "LinkADRReq sent to the devices", adrRequests.get());
+    gauge2prometheus(ss, prefix, "uplink_queue_size", "Uplinks in the message queue", uplinkQueueSize.get());
+    gauge2prometheus(ss, prefix, "downlink_queue_size", "Downlinks in the message queue", downlinkQueueSize.get());
+    gauge2prometheus(ss, prefix, "gateways", "Gateways known by the dispatcher", gateways.get());
+    gauge2prometheus(ss, prefix, "sockets", "Sockets listened by the dispatcher", sockets.get());
+    gauge2prometheus(ss, prefix, "join_queue_size", "Join-requests waiting for the join pipeline", joinQueueSize.get());
+    histogram2prometheus(ss, prefix, "ack_latency_microseconds", "Time from packet receive to ACK", ackLatency);
+    histogram2prometheus(ss, prefix, "bridge_delivery_microseconds", "Time spent to deliver uplink to the bridges", bridgeDelivery);
+    if (traceTotal.getCount()) {
+        const char *name = "stage_latency_microseconds";
+        ss << "# HELP " << prefix << name << " Time spent by traced packets in each stage since previous stage\n"
+            << "# TYPE " << prefix << name << " summary\n";
+        for (int s = TRACE_STAGE_RECEIVED; s < TRACE_STAGE_COUNT; s++) {
+            summary2prometheus(ss, prefix, name,
+                std::string("stage=\"") + PacketTrace::stageName((TRACE_STAGE) s) + "\"", stages[s]);
+        }
+        histogram2prometheus(ss, prefix, "trace_total_microseconds", "Time from packet receive to delivery", traceTotal);
+    }
+    if (joinRequests.get()) {
+        const char *name = "join_stage_nanoseconds";
+        ss << "# HELP " << prefix << name << " Time spent by Join-request in each join pipeline stage\n"
+            << "# TYPE " << prefix << name << " summary\n";
+        for (int s = 0; s < JOIN_STAGE_COUNT; s++) {
+            summary2prometheus(ss, prefix, name,
+                std::string("stage=\"") + JoinPipeline::stageName((JOIN_STAGE) s) + "\"", joinStages[s]);
+        }
+        histogram2prometheus(ss, prefix, "join_latency_microseconds", "Time from Join-request receive to Join-accept sent", joinLatency);
+    }
+    return ss.str();
+}
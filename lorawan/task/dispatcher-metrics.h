@@ -0,0 +1,143 @@
+#ifndef DISPATCHER_METRICS_H
+#define DISPATCHER_METRICS_H
+
+#include <atomic>
+#include <string>
+#include <cinttypes>
+
+#include "lorawan/task/packet-trace.h"
+#include "lorawan/task/join-pipeline.h"
+
+/**
+ * Lock-free counters, gauges and latency histograms updated by the dispatcher on the hot path.
+ * Readers (control socket, HTTP endpoint) take a relaxed snapshot without stopping the writers.
+ */
+
+#define METRICS_COUNTER_SHARDS      8
+#define METRICS_CACHE_LINE_SIZE     64
+// HDR-style histogram: 2^METRICS_HISTOGRAM_SUB_BITS linear sub-buckets per power of two, ~12% precision
+#define METRICS_HISTOGRAM_SUB_BITS  3
+#define METRICS_HISTOGRAM_SUB_COUNT (1 << METRICS_HISTOGRAM_SUB_BITS)
+#define METRICS_HISTOGRAM_BUCKETS   ((64 - METRICS_HISTOGRAM_SUB_BITS + 1) * METRICS_HISTOGRAM_SUB_COUNT)
+
+/**
+ * Counter is split to the shards on separate cache lines, each thread increments own shard
+ */
+class MetricsCounter {
+private:
+    struct Shard {
+        std::atomic<uint64_t> value;
+        char padding[METRICS_CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)];
+    };
+    Shard shards[METRICS_COUNTER_SHARDS];
+public:
+    MetricsCounter();
+    void inc(
+        uint64_t value = 1
+    );
+    uint64_t get() const;
+    void reset();
+};
+
+class MetricsGauge {
+private:
+    std::atomic<int64_t> value;
+public:
+    MetricsGauge();
+    void set(
+        int64_t value
+    );
+    void add(
+        int64_t value
+    );
+    int64_t get() const;
+};
+
+/**
+ * Log-linear histogram of non-negative values e.g. latency in microseconds
+ */
+class MetricsHistogram {
+private:
+    std::atomic<uint64_t> buckets[METRICS_HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> maxValue;
+public:
+    MetricsHistogram();
+    void record(
+        int64_t value
+    );
+    uint64_t getCount() const;
+    uint64_t getSum() const;
+    uint64_t getMax() const;
+    /**
+     * @param q quantile 0..1
+     * @return bucket upper bound value, 0 if histogram is empty
+     */
+    uint64_t quantile(
+        double q
+    ) const;
+    void reset();
+    static size_t bucketIndex(
+        uint64_t value
+    );
+    static uint64_t bucketUpperBound(
+        size_t index
+    );
+};
+
+class DispatcherMetrics {
+public:
+    // counters
+    MetricsCounter packets;             ///< packets received from the gateways
+    MetricsCounter parseErrors;         ///< packets rejected by all parsers
+    MetricsCounter pushData;            ///< PUSH_DATA packets
+    MetricsCounter pullData;            ///< PULL_DATA packets
+    MetricsCounter txAck;               ///< TX_ACK packets
+    MetricsCounter uplinks;             ///< radio packets in PUSH_DATA
+    MetricsCounter duplicates;          ///< radio packets received by another gateway merged in the queue
+    MetricsCounter micFailures;         ///< uplinks with MIC mismatch
+    MetricsCounter bridgePayloads;      ///< uplinks passed to the application bridges
+    MetricsCounter downlinks;           ///< downlinks sent to the gateways
+    MetricsCounter downlinkErrors;      ///< downlinks failed
+    MetricsCounter acks;                ///< ACK sent to the gateways
+    MetricsCounter joinRequests;        ///< Join-requests processed by the join pipeline
+    MetricsCounter joinUnknown;         ///< Join-requests from unknown DevEUI
+    MetricsCounter joinReplays;         ///< Join-requests with already used DevNonce
+    MetricsCounter joinRateLimited;     ///< Join-requests dropped by the per-gateway rate limit
+    MetricsCounter joinLate;            ///< Join-requests expired before RX2 window
+    MetricsCounter joinAccepts;         ///< Join-accepts sent
+    MetricsCounter joinErrors;          ///< Join-accepts failed
+    MetricsCounter adrRequests;         ///< LinkADRReq piggy-backed to the downlinks
+    // gauges
+    MetricsGauge uplinkQueueSize;
+    MetricsGauge downlinkQueueSize;
+    MetricsGauge gateways;              ///< gateways sent PULL_DATA
+    MetricsGauge sockets;
+    MetricsGauge joinQueueSize;         ///< Join-requests waiting for the join pipeline
+    // histograms, microseconds
+    MetricsHistogram ackLatency;        ///< from packet receive to ACK sent
+    MetricsHistogram bridgeDelivery;    ///< time spent in bridges (or pushing to bridge workers)
+    // traced packets only, time spent in each stage since previous stage (stage 0 is unused)
+    MetricsHistogram stages[TRACE_STAGE_COUNT];
+    MetricsHistogram traceTotal;        ///< from kernel receive (or read) to delivery
+    // join pipeline: nanoseconds per request in each stage, microseconds from receive to Join-accept sent
+    MetricsHistogram joinStages[JOIN_STAGE_COUNT];
+    MetricsHistogram joinLatency;
+
+    DispatcherMetrics();
+    void reset();
+    void recordTrace(
+        const PacketTrace &trace
+    );
+    std::string toJsonString() const;
+    /**
+     * Prometheus text exposition format 0.0.4
+     * @param prefix metric name prefix
+     */
+    std::string toPrometheus(
+        const std::string &prefix = "tlns_"
+    ) const;
+};
+
+#endif
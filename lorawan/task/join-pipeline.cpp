@@ -0,0 +1,456 @@
+#include <algorithm>
+#include <cstring>
+
+#include "join-pipeline.h"
+#include "lorawan/task/message-task-dispatcher.h"
+#include "lorawan/lorawan-builder.h"
+#include "lorawan/lorawan-conv.h"
+#include "lorawan/lorawan-error.h"
+#include "lorawan/lorawan-key.h"
+#include "lorawan/lorawan-mic.h"
+#include "lorawan/helper/aes-helper.h"
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#include <WinSock2.h>
+#else
+#include <sys/socket.h>
+#endif
+
+#define JOIN_PREAMBLE_SIZE  8
+
+static const char *JOIN_STAGE_NAMES[JOIN_STAGE_COUNT] = {
+    "lookup", "replay", "gateway", "accept", "derive", "build", "send"
+};
+
+/**
+ * LoRaWAN 1.1 device has NwkKey, 1.0 device has AppKey only
+ */
+static const KEY128 &joinRootKey(
+    const NETWORKIDENTITY &identity
+)
+{
+    const KEY128 &nwkKey = identity.value.devid.id.nwkKey;
+    if (nwkKey.u[0] || nwkKey.u[1])
+        return nwkKey;
+    return identity.value.devid.id.appKey;
+}
+
+JoinTask::JoinTask()
+    : frame {}, acceptHeader {}, gatewayId(0), buffer(nullptr), size(0), window(0), rejected(false)
+{
+}
+
+JoinBufferPool::JoinBufferPool() = default;
+
+JoinBufferPool::~JoinBufferPool()
+{
+    for (auto b : buffers) {
+        delete[] b;
+    }
+}
+
+char *JoinBufferPool::acquire()
+{
+    if (buffers.empty())
+        return new char[JOIN_BUFFER_SIZE];
+    char *r = buffers.back();
+    buffers.pop_back();
+    return r;
+}
+
+void JoinBufferPool::release(
+    char *buffer
+)
+{
+    if (buffer)
+        buffers.push_back(buffer);
+}
+
+JoinDevNonceHistory::JoinDevNonceHistory()
+    : nonces {}, count(0), next(0)
+{
+}
+
+bool JoinDevNonceHistory::add(
+    uint16_t devNonce
+)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        if (nonces[i] == devNonce)
+            return false;
+    }
+    nonces[next] = devNonce;
+    next = (uint8_t) ((next + 1) % JOIN_DEVNONCE_HISTORY);
+    if (count < JOIN_DEVNONCE_HISTORY)
+        count++;
+    return true;
+}
+
+JoinPipeline::JoinPipeline(
+    MessageTaskDispatcher *aDispatcher
+)
+    : dispatcher(aDispatcher), token(0), collectMilliseconds(DEF_JOIN_COLLECT_MS), batchSize(DEF_JOIN_BATCH_SIZE),
+      ratePerGateway(DEF_JOIN_RATE_PER_GATEWAY), burstPerGateway(DEF_JOIN_BURST_PER_GATEWAY),
+      txMarginMilliseconds(DEF_JOIN_TX_MARGIN_MS)
+{
+}
+
+JoinPipeline::JoinPipeline(
+    MessageTaskDispatcher *aDispatcher,
+    const JoinPipeline &value
+)
+    : dispatcher(aDispatcher), token(0), collectMilliseconds(value.collectMilliseconds), batchSize(value.batchSize),
+      ratePerGateway(value.ratePerGateway), burstPerGateway(value.burstPerGateway),
+      txMarginMilliseconds(value.txMarginMilliseconds)
+{
+}
+
+JoinPipeline::~JoinPipeline() = default;
+
+bool JoinPipeline::push(
+    const TASK_TIME &receivedTime,
+    const JOIN_REQUEST_FRAME &frame
+)
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    bool wasEmpty = pending.empty();
+    pending.emplace_back(receivedTime, frame);
+    return wasEmpty;
+}
+
+size_t JoinPipeline::process(
+    TASK_TIME now
+)
+{
+    batch.clear();
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        auto collect = std::chrono::milliseconds(collectMilliseconds);
+        while (!pending.empty() && batch.size() < batchSize) {
+            if (now - pending.front().first < collect)
+                break;
+            batch.emplace_back();
+            batch.back().frame = pending.front().second;
+            pending.pop_front();
+        }
+    }
+    if (batch.empty())
+        return 0;
+    dispatcher->metrics.joinRequests.inc(batch.size());
+    lookup();
+    checkReplay();
+    selectGateway(now);
+    accept();
+    derive();
+    build(now);
+    send();
+    return batch.size();
+}
+
+int64_t JoinPipeline::waitMicroseconds(
+    TASK_TIME now
+)
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    if (pending.empty())
+        return -1;
+    auto r = std::chrono::duration_cast<std::chrono::microseconds>(
+        pending.front().first + std::chrono::milliseconds(collectMilliseconds) - now).count();
+    return r < 0 ? 0 : r;
+}
+
+size_t JoinPipeline::size()
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    return pending.size();
+}
+
+const char *JoinPipeline::stageName(
+    JOIN_STAGE stage
+)
+{
+    if (stage < 0 || stage >= JOIN_STAGE_COUNT)
+        return "";
+    return JOIN_STAGE_NAMES[stage];
+}
+
+/**
+ * Record average time spent by one request in the stage
+ */
+void JoinPipeline::recordStage(
+    JOIN_STAGE stage,
+    std::chrono::steady_clock::time_point &started
+)
+{
+    auto t = std::chrono::steady_clock::now();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t - started).count();
+    dispatcher->metrics.joinStages[stage].record(ns / (int64_t) batch.size());
+    started = t;
+}
+
+void JoinPipeline::lookup()
+{
+    auto started = std::chrono::steady_clock::now();
+    for (auto &t : batch) {
+        // copy item, another thread can add metadata
+        dispatcher->queueMutex.lock();
+        MessageQueueItem *qi = dispatcher->queue.getJoinRequest(t.frame);
+        if (qi)
+            t.item = *qi;
+        dispatcher->queueMutex.unlock();
+        if (!qi) {
+            // expired
+            t.rejected = true;
+            dispatcher->metrics.joinLate.inc();
+            continue;
+        }
+        if (!dispatcher->identityClient
+            || dispatcher->identityClient->svcIdentity->getNetworkIdentity(t.identity, t.frame.devEUI) != CODE_OK) {
+            t.rejected = true;
+            dispatcher->metrics.joinUnknown.inc();
+            continue;
+        }
+        auto h = (const JOIN_REQUEST_HEADER *) &t.item.radioPacket.mhdr;
+        if (NTOH4(calculateMICJoinRequest(h, joinRootKey(t.identity))) != h->mic) {
+            t.rejected = true;
+            dispatcher->metrics.micFailures.inc();
+        }
+    }
+    recordStage(JOIN_STAGE_LOOKUP, started);
+}
+
+void JoinPipeline::checkReplay()
+{
+    auto started = std::chrono::steady_clock::now();
+    for (auto &t : batch) {
+        if (t.rejected)
+            continue;
+        uint64_t eui = t.frame.devEUI.u;
+        auto f = devNonces.find(eui);
+        if (f == devNonces.end()) {
+            f = devNonces.insert(std::pair<uint64_t, JoinDevNonceHistory>(eui, JoinDevNonceHistory())).first;
+            // device has joined before restart, remember last stored DevNonce
+            const DEVICE_ID &id = t.identity.value.devid.id;
+            if (id.joinNonce.get())
+                f->second.add(id.devNonce.u);
+        }
+        if (!f->second.add(t.frame.devNonce.u)) {
+            t.rejected = true;
+            dispatcher->metrics.joinReplays.inc();
+        }
+    }
+    recordStage(JOIN_STAGE_REPLAY, started);
+}
+
+bool JoinPipeline::takeGatewayToken(
+    uint64_t gatewayId,
+    TASK_TIME now
+)
+{
+    if (ratePerGateway <= 0)
+        return true;
+    auto f = gatewayRate.find(gatewayId);
+    if (f == gatewayRate.end()) {
+        f = gatewayRate.insert(std::pair<uint64_t, JoinRateBucket>(gatewayId, { burstPerGateway, now })).first;
+    } else {
+        double seconds = std::chrono::duration_cast<std::chrono::microseconds>(now - f->second.last).count() / 1000000.;
+        if (seconds > 0) {
+            f->second.tokens = std::min(burstPerGateway, f->second.tokens + seconds * ratePerGateway);
+            f->second.last = now;
+        }
+    }
+    if (f->second.tokens < 1.)
+        return false;
+    f->second.tokens -= 1.;
+    return true;
+}
+
+void JoinPipeline::selectGateway(
+    TASK_TIME now
+)
+{
+    auto started = std::chrono::steady_clock::now();
+    std::vector<const std::pair<const uint64_t, GatewayMetadata> *> candidates;
+    for (auto &t : batch) {
+        if (t.rejected)
+            continue;
+        // best SNR first
+        candidates.clear();
+        for (auto &m : t.item.metadata) {
+            candidates.push_back(&m);
+        }
+        std::sort(candidates.begin(), candidates.end(), [] (
+            const std::pair<const uint64_t, GatewayMetadata> *a,
+            const std::pair<const uint64_t, GatewayMetadata> *b
+        ) {
+            return a->second.rx.lsnr > b->second.rx.lsnr;
+        });
+        for (auto c : candidates) {
+            if (takeGatewayToken(c->first, now)) {
+                t.gatewayId = c->first;
+                t.gatewayMetadata = c->second;
+                break;
+            }
+        }
+        if (!t.gatewayId) {
+            t.rejected = true;
+            dispatcher->metrics.joinRateLimited.inc();
+        }
+    }
+    recordStage(JOIN_STAGE_GATEWAY, started);
+}
+
+void JoinPipeline::accept()
+{
+    auto started = std::chrono::steady_clock::now();
+    const RegionalParameterChannelPlan *plan = dispatcher->regionalPlan;
+    for (auto &t : batch) {
+        if (t.rejected)
+            continue;
+        DEVICE_ID &id = t.identity.value.devid.id;
+        id.joinNonce = JOINNONCE(id.joinNonce.get() + 1);
+        if (dispatcher->identityClient->svcIdentity->joinAccept(t.acceptHeader, t.identity) != CODE_OK) {
+            t.rejected = true;
+            dispatcher->metrics.joinErrors.inc();
+            continue;
+        }
+        t.acceptHeader.dlSettings.RX1DROffset = 0;
+        t.acceptHeader.dlSettings.RX2DataRate = plan ? (uint8_t) plan->get()->bandDefaults.value.RX2DataRate : 0;
+        t.acceptHeader.dlSettings.optNeg = 0;
+        t.acceptHeader.rxDelay = 1;
+    }
+    recordStage(JOIN_STAGE_ACCEPT, started);
+}
+
+void JoinPipeline::derive()
+{
+    auto started = std::chrono::steady_clock::now();
+    for (auto &t : batch) {
+        if (t.rejected)
+            continue;
+        DEVICE_ID &id = t.identity.value.devid.id;
+        const KEY128 &key = joinRootKey(t.identity);
+        // OptNeg is unset: FNwkSIntKey = SNwkSIntKey = NwkSEncKey = NwkSKey
+        deriveFNwkSIntKey(id.nwkSKey, key, t.acceptHeader.netId, t.acceptHeader.joinNonce, t.frame.devNonce);
+        deriveAppSKey(id.appSKey, key, t.acceptHeader.netId, t.acceptHeader.joinNonce, t.frame.devNonce);
+        id.devNonce = t.frame.devNonce;
+        id.joinNonce = t.acceptHeader.joinNonce;
+        if (dispatcher->identityClient->svcIdentity->put(t.identity.value.devaddr, t.identity.value.devid) != CODE_OK) {
+            t.rejected = true;
+            dispatcher->metrics.joinErrors.inc();
+            continue;
+        }
+        t.item.task.deviceId.set(t.identity.value.devaddr, t.identity.value.devid);
+    }
+    recordStage(JOIN_STAGE_DERIVE, started);
+}
+
+void JoinPipeline::build(
+    TASK_TIME now
+)
+{
+    auto started = std::chrono::steady_clock::now();
+    const RegionalParameterChannelPlan *plan = dispatcher->regionalPlan;
+    int delay1 = plan ? plan->joinAcceptDelay1() : 5;
+    int delay2 = plan ? plan->joinAcceptDelay2() : 6;
+    auto margin = std::chrono::milliseconds(txMarginMilliseconds);
+    for (auto &t : batch) {
+        if (t.rejected)
+            continue;
+        const SEMTECH_PROTOCOL_METADATA_RX &rx = t.gatewayMetadata.rx;
+        SEMTECH_PROTOCOL_METADATA_TX tx {};
+        uint32_t tmst;
+        if (now + margin < t.item.tim + std::chrono::seconds(delay1)) {
+            // RX1: uplink channel and data rate
+            t.window = 1;
+            tmst = rx.tmst + (uint32_t) delay1 * 1000000;
+            tx.freq_hz = rx.freq;
+            tx.bandwidth = rx.bandwidth;
+            tx.datarate = rx.spreadingFactor;
+            tx.coderate = rx.codingRate;
+        } else if (plan && now + margin < t.item.tim + std::chrono::seconds(delay2)) {
+            // RX2: fixed frequency and data rate
+            const BAND_DEFAULTS &bd = plan->get()->bandDefaults.value;
+            t.window = 2;
+            tmst = rx.tmst + (uint32_t) delay2 * 1000000;
+            tx.freq_hz = (uint32_t) bd.RX2Frequency;
+            if (bd.RX2DataRate >= 0 && (size_t) bd.RX2DataRate < plan->get()->dataRates.size()) {
+                const DATA_RATE &dr = plan->get()->dataRates[bd.RX2DataRate].value;
+                tx.bandwidth = dr.bandwidth;
+                tx.datarate = dr.spreadingFactor;
+            } else {
+                tx.bandwidth = rx.bandwidth;
+                tx.datarate = rx.spreadingFactor;
+            }
+            tx.coderate = CRLORA_4_5;
+        } else {
+            t.rejected = true;
+            dispatcher->metrics.joinLate.inc();
+            continue;
+        }
+        // makePull() adds 1s to the count_us
+        tx.count_us = tmst - 1000000;
+        tx.tx_mode = 1;     // TIMESTAMPED
+        tx.rf_power = (int8_t) (plan ? plan->get()->defaultDownlinkTXPower : 14);
+        tx.modulation = rx.modu;
+        tx.invert_pol = true;
+        tx.preamble = JOIN_PREAMBLE_SIZE;
+        tx.no_crc = true;
+
+        // MIC calculated over MHDR | JoinNonce | NetID | DevAddr | DLSettings | RxDelay
+        LORAWAN_MESSAGE_STORAGE m;
+        m.mhdr.i = 0;
+        m.mhdr.f.mtype = MTYPE_JOIN_ACCEPT;
+        m.data.joinResponse.hdr = t.acceptHeader;
+        const KEY128 &key = joinRootKey(t.identity);
+        m.data.joinResponse.mic = NTOH4(calculateMICJoinResponse(*(const JOIN_ACCEPT_FRAME *) &m.mhdr, key));
+        encryptJoinAcceptResponse(m.data.joinResponse, key);
+
+        JoinAcceptMessage msg(t.item.task, m.data.joinResponse);
+        tx.size = (uint16_t) msg.size();
+        ProtoGwParser *parser = t.gatewayMetadata.parser;
+        if (!parser && !dispatcher->parsers.empty())
+            parser = dispatcher->parsers[0];
+        t.buffer = buffers.acquire();
+        t.size = parser ? parser->makePull(t.buffer, JOIN_BUFFER_SIZE, DEVEUI(t.gatewayId), msg, ++token, &tx, plan, &t.item) : 0;
+        if (t.size <= 0 || t.size > JOIN_BUFFER_SIZE) {
+            t.rejected = true;
+            dispatcher->metrics.joinErrors.inc();
+        }
+    }
+    recordStage(JOIN_STAGE_BUILD, started);
+}
+
+void JoinPipeline::send()
+{
+    auto started = std::chrono::steady_clock::now();
+    for (auto &t : batch) {
+        if (!t.rejected) {
+            int r;
+            if (dispatcher->gatewaySocket.find(t.gatewayId) != dispatcher->gatewaySocket.end())
+                r = dispatcher->sendDownlink(t.gatewayId, &t.item.task.deviceId, t.buffer, (size_t) t.size, t.gatewayMetadata.parser);
+            else {
+                // gateway has not been pinged, reply to the address Join-request has been received from
+                r = ERR_CODE_GATEWAY_NOT_FOUND;
+                const TaskSocket *s = t.gatewayMetadata.taskSocket;
+                if (s && !s->customWrite) {
+                    if (s->sendMessage(t.buffer, (size_t) t.size, &t.gatewayMetadata.addr,
+                        addressLength(&t.gatewayMetadata.addr)) > 0) {
+                        dispatcher->metrics.downlinks.inc();
+                        r = CODE_OK;
+                    } else
+                        dispatcher->metrics.downlinkErrors.inc();
+                }
+            }
+            if (r == CODE_OK) {
+                dispatcher->metrics.joinAccepts.inc();
+                dispatcher->metrics.joinLatency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                    TASK_CLOCK::now() - t.item.tim).count());
+            } else
+                dispatcher->metrics.joinErrors.inc();
+        }
+        buffers.release(t.buffer);
+        t.buffer = nullptr;
+    }
+    recordStage(JOIN_STAGE_SEND, started);
+}
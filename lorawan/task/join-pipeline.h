@@ -0,0 +1,180 @@
+#ifndef JOIN_PIPELINE_H
+#define JOIN_PIPELINE_H
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "lorawan/lorawan-types.h"
+#include "lorawan/task/task-platform.h"
+#include "lorawan/task/message-queue-item.h"
+
+/**
+ * Join-request pipeline.
+ * Dispatcher passes each new Join-request (duplicates are merged in the MessageQueue::joins) to the pipeline.
+ * When duplicates from other gateways are collected, pending requests are processed in batches,
+ * stage by stage over the whole batch:
+ *  1. look up device by DevEUI and check Join-request MIC
+ *  2. reject replayed DevNonce
+ *  3. select the best gateway which has not exceeded join rate
+ *  4. assign address and JoinNonce by IdentityService::joinAccept()
+ *  5. derive NwkSKey, AppSKey (OptNeg unset) and store session keys
+ *  6. build encrypted Join-accept for RX1 or RX2 window to the pooled buffer
+ *  7. send to the gateway
+ * Runs in the dispatcher uplink thread, push() can be called from any thread.
+ */
+
+class MessageTaskDispatcher;
+
+#define DEF_JOIN_COLLECT_MS             100     ///< wait for duplicates from other gateways
+#define DEF_JOIN_BATCH_SIZE             256
+#define DEF_JOIN_RATE_PER_GATEWAY       10      ///< Join-accepts per second per gateway
+#define DEF_JOIN_BURST_PER_GATEWAY      20
+#define DEF_JOIN_TX_MARGIN_MS           300     ///< gateway must receive PULL_RESP before the window opens
+#define DEF_JOIN_EXPIRATION_SECONDS     6       ///< keep Join-request in the queue until RX2 window is closed
+#define JOIN_DEVNONCE_HISTORY           8       ///< remembered DevNonces per device
+#define JOIN_BUFFER_SIZE                512
+
+typedef enum {
+    JOIN_STAGE_LOOKUP = 0,
+    JOIN_STAGE_REPLAY,
+    JOIN_STAGE_GATEWAY,
+    JOIN_STAGE_ACCEPT,
+    JOIN_STAGE_DERIVE,
+    JOIN_STAGE_BUILD,
+    JOIN_STAGE_SEND,
+    JOIN_STAGE_COUNT
+} JOIN_STAGE;
+
+/**
+ * Join-request state passed through the stages
+ */
+class JoinTask {
+public:
+    JOIN_REQUEST_FRAME frame;
+    MessageQueueItem item;              ///< copy of the MessageQueue::joins item
+    NETWORKIDENTITY identity;
+    JOIN_ACCEPT_FRAME_HEADER acceptHeader;
+    uint64_t gatewayId;                 ///< selected gateway
+    GatewayMetadata gatewayMetadata;
+    char *buffer;                       ///< serialized PULL_RESP from the pool
+    ssize_t size;
+    int window;                         ///< 1- RX1, 2- RX2
+    bool rejected;
+    JoinTask();
+};
+
+/**
+ * Reuse fixed size buffers for serialized Join-accepts
+ */
+class JoinBufferPool {
+private:
+    std::vector<char *> buffers;
+public:
+    JoinBufferPool();
+    virtual ~JoinBufferPool();
+    char *acquire();
+    void release(
+        char *buffer
+    );
+};
+
+class JoinDevNonceHistory {
+public:
+    uint16_t nonces[JOIN_DEVNONCE_HISTORY];
+    uint8_t count;
+    uint8_t next;
+    JoinDevNonceHistory();
+    /**
+     * @return false if DevNonce has been used already
+     */
+    bool add(
+        uint16_t devNonce
+    );
+};
+
+class JoinRateBucket {
+public:
+    double tokens;
+    TASK_TIME last;
+};
+
+class JoinPipeline {
+private:
+    MessageTaskDispatcher *dispatcher;
+    std::mutex pendingMutex;
+    std::deque<std::pair<TASK_TIME, JOIN_REQUEST_FRAME>> pending;
+    std::vector<JoinTask> batch;
+    JoinBufferPool buffers;
+    std::unordered_map<uint64_t, JoinDevNonceHistory> devNonces;
+    std::map<uint64_t, JoinRateBucket> gatewayRate;
+    uint16_t token;
+
+    void lookup();
+    void checkReplay();
+    void selectGateway(
+        TASK_TIME now
+    );
+    void accept();
+    void derive();
+    void build(
+        TASK_TIME now
+    );
+    void send();
+    bool takeGatewayToken(
+        uint64_t gatewayId,
+        TASK_TIME now
+    );
+    void recordStage(
+        JOIN_STAGE stage,
+        std::chrono::steady_clock::time_point &started
+    );
+public:
+    size_t collectMilliseconds;
+    size_t batchSize;
+    double ratePerGateway;              ///< Join-accepts per second, 0- no rate limit
+    double burstPerGateway;
+    int txMarginMilliseconds;
+
+    explicit JoinPipeline(
+        MessageTaskDispatcher *dispatcher
+    );
+    JoinPipeline(
+        MessageTaskDispatcher *dispatcher,
+        const JoinPipeline &value
+    );
+    virtual ~JoinPipeline();
+    /**
+     * Add new Join-request, it must be in the MessageQueue::joins
+     * @param receivedTime time when first packet has been received
+     * @param frame Join-request
+     * @return true if pipeline was empty
+     */
+    bool push(
+        const TASK_TIME &receivedTime,
+        const JOIN_REQUEST_FRAME &frame
+    );
+    /**
+     * Process Join-requests collected duplicates
+     * @param now current time
+     * @return count of processed requests
+     */
+    size_t process(
+        TASK_TIME now
+    );
+    /**
+     * @return microseconds until first pending request is due, -1 if there are no pending requests
+     */
+    int64_t waitMicroseconds(
+        TASK_TIME now
+    );
+    size_t size();
+    static const char *stageName(
+        JOIN_STAGE stage
+    );
+};
+
+#endif
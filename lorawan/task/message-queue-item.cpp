@@ -4,6 +4,7 @@
 #include "lorawan/lorawan-date.h"
 #include "lorawan/lorawan-string.h"
 #include "lorawan/helper/ip-address.h"
+#include "lorawan/helper/codec-helper.h"
 #include "lorawan/proto/gw/proto-gw-parser.h"
 
 #define DEF_MESSAGE_EXPIRATION_SEC  60
@@ -57,7 +58,7 @@ std::string GatewayMetadata::toJsonString() const
 }
 
 MessageQueueItem::MessageQueueItem()
-    : queue(nullptr), tim(std::chrono::system_clock::now())
+    : queue(nullptr), tim(TASK_CLOCK::now())
 {
 
 }
@@ -108,7 +109,7 @@ bool MessageQueueItem::expired(
 std::string MessageQueueItem::toString() const
 {
     std::stringstream ss;
-    std::time_t t = std::chrono::system_clock::to_time_t(tim);
+    std::time_t t = std::chrono::system_clock::to_time_t(taskTime2systemTime(tim));
     ss << R"({"received": ")" << time2string(t) << R"(", "radio": )" << radioPacket.toString();
     ss << ", \"gateways\": [";
     for (auto it : metadata) {
@@ -122,11 +123,15 @@ std::string MessageQueueItem::toString() const
 
 std::string MessageQueueItem::toJsonString() const
 {
-    std::time_t t = std::chrono::system_clock::to_time_t(tim);
+    std::time_t t = std::chrono::system_clock::to_time_t(taskTime2systemTime(tim));
     std::stringstream ss;
     ss << R"({"received": ")" << time2string(t) << "\", \"radio\": " << radioPacket.toString();
-    if (radioPacket.payloadSize)
-        ss << R"(, "payload": ")" << hexString((const char *) radioPacket.data.downlink.payload(), radioPacket.payloadSize) << "\"";
+    if (radioPacket.payloadSize) {
+        char hex[2 * sizeof(LORAWAN_MESSAGE_STORAGE)];
+        ss << R"(, "payload": ")";
+        ss.write(hex, (std::streamsize) hexEncode(hex, radioPacket.data.downlink.payload(), radioPacket.payloadSize));
+        ss << "\"";
+    }
     if (!metadata.empty()) {
         ss << ", \"gateways\": [";
         bool isFirst = true;
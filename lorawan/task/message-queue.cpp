@@ -91,6 +91,7 @@ void MessageQueue::putUplink(
 /**
  * Return true if first packet added, false if it is from another gateway (duplicate)
  * @param pushData
+ * @param trace stage timestamps of the first received packet, can be NULL
  * @return
  */
 bool MessageQueue::putUplink(
@@ -98,26 +99,51 @@ bool MessageQueue::putUplink(
     const TaskSocket *taskSocket,
     const struct sockaddr &srcAddr,
     GwPushData &pushData,
-    ProtoGwParser *parser
+    ProtoGwParser *parser,
+    const PacketTrace *trace
 )
 {
     MessageQueueItem qi(this, time, pushData.rxMetadata.gatewayId, parser);
     qi.task.stage = TASK_STAGE_GATEWAY_REQUEST;
     const DEVADDR *addr = pushData.rxData.getAddr();
-    if (!addr)
-        return false;
+    if (!addr) {
+        // Join-request, merge duplicates received by other gateways
+        const JOIN_REQUEST_FRAME *jr = pushData.rxData.getJoinRequest();
+        if (!jr)
+            return false;
+        auto j = joins.find(*jr);
+        if (j != joins.end()) {
+            j->second.metadata[pushData.rxMetadata.gatewayId] = { taskSocket, srcAddr, METADATA_TYPE_RX, pushData.rxMetadata, parser };
+            return false;
+        }
+        if (trace) {
+            qi.task.trace = *trace;
+            qi.task.trace.mark(TRACE_STAGE_QUEUED);
+        }
+        qi.metadata[pushData.rxMetadata.gatewayId] = { taskSocket, srcAddr, METADATA_TYPE_RX, pushData.rxMetadata, parser };
+        qi.task.gatewayId = pushData.rxMetadata.gatewayId;
+        qi.radioPacket = pushData.rxData;
+        joins.insert(std::pair<JOIN_REQUEST_FRAME, MessageQueueItem>(*jr, qi));
+        return true;
+    }
     auto f = uplinkMessages.find(*addr);
     bool isSame = (f != uplinkMessages.end()) && (f->second.radioPacket == pushData.rxData);
     if (isSame) {
         // update metadata
         f->second.metadata[pushData.rxMetadata.gatewayId] = { taskSocket,srcAddr, METADATA_TYPE_RX, pushData.rxMetadata, parser };
     } else {
+        if (trace) {
+            qi.task.trace = *trace;
+            qi.task.trace.mark(TRACE_STAGE_QUEUED);
+        }
         if (dispatcher && dispatcher->identityClient) {
             // getUplink device identity
             DEVICEID did;
             dispatcher->identityClient->svcIdentity->get(did, *addr);
             qi.task.deviceId.set(*addr, did);
         }
+        if (trace)
+            qi.task.trace.mark(TRACE_STAGE_IDENTIFIED);
 
         qi.metadata[pushData.rxMetadata.gatewayId] = { taskSocket, srcAddr, METADATA_TYPE_RX, pushData.rxMetadata, parser };
         qi.task.gatewayId = pushData.rxMetadata.gatewayId;
@@ -273,3 +299,54 @@ size_t MessageQueue::clearOldDownlinkMessages(
     }
     return r;
 }
+
+/**
+ * Clear old Join-requests
+ * @param since time to delete from
+ * @return count of removed items
+ */
+size_t MessageQueue::clearOldJoinRequests(
+    TASK_TIME since
+)
+{
+    size_t r = 0;
+    for (auto m(joins.begin()); m != joins.end();) {
+        if (m->second.tim < since) {
+            m = joins.erase(m);
+            r++;
+        } else
+            m++;
+    }
+    return r;
+}
+
+static bool itemHasSocket(
+    const MessageQueueItem &item,
+    const TaskSocket *taskSocket
+)
+{
+    for (auto &m : item.metadata) {
+        if (m.second.taskSocket == taskSocket)
+            return true;
+    }
+    return false;
+}
+
+bool MessageQueue::hasSocket(
+    const TaskSocket *taskSocket
+) const
+{
+    for (auto &m : uplinkMessages) {
+        if (itemHasSocket(m.second, taskSocket))
+            return true;
+    }
+    for (auto &m : joins) {
+        if (itemHasSocket(m.second, taskSocket))
+            return true;
+    }
+    for (auto &m : downlinkMessages) {
+        if (itemHasSocket(m.second, taskSocket))
+            return true;
+    }
+    return false;
+}
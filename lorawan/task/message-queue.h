@@ -13,6 +13,7 @@ class TaskSocket;
 class MessageTaskDispatcher;
 class MessageQueueItem;
 class ProtoGwParser;
+class PacketTrace;
 
 class MessageQueue {
 protected:
@@ -52,7 +53,8 @@ public:
         const TaskSocket *taskSocket,
         const struct sockaddr &srcAddr,
         GwPushData &pushData,
-        ProtoGwParser *parser
+        ProtoGwParser *parser,
+        const PacketTrace *trace = nullptr
     );
     void putDownlink(
         const TASK_TIME& time,
@@ -94,6 +96,15 @@ public:
      */
     size_t clearOldUplinkMessages(TASK_TIME since);
     size_t clearOldDownlinkMessages(TASK_TIME since);
+    size_t clearOldJoinRequests(TASK_TIME since);
+    /**
+     * Check is any queued message received from or sent over the socket
+     * @param taskSocket socket
+     * @return true if socket is referenced by the message metadata
+     */
+    bool hasSocket(
+        const TaskSocket *taskSocket
+    ) const;
 };
 
 #endif
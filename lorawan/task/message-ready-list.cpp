@@ -0,0 +1,63 @@
+#include <algorithm>
+
+#include "lorawan/task/message-ready-list.h"
+
+MessageReadyList::MessageReadyList()
+    : head(nullptr)
+{
+}
+
+MessageReadyList::~MessageReadyList()
+{
+    Node *n = head.exchange(nullptr);
+    while (n) {
+        Node *next = n->next;
+        delete n;
+        n = next;
+    }
+}
+
+void MessageReadyList::pushLocal(
+    const DEVADDR &addr
+)
+{
+    local.push_back(addr);
+}
+
+bool MessageReadyList::push(
+    const DEVADDR &addr
+)
+{
+    Node *n = new Node { addr, head.load(std::memory_order_relaxed) };
+    while (!head.compare_exchange_weak(n->next, n, std::memory_order_release, std::memory_order_relaxed))
+        ;
+    return n->next == nullptr;
+}
+
+size_t MessageReadyList::pop(
+    std::vector<DEVADDR> &retVal
+)
+{
+    size_t r = local.size();
+    retVal.insert(retVal.end(), local.begin(), local.end());
+    local.clear();
+    Node *n = head.exchange(nullptr, std::memory_order_acquire);
+    if (!n)
+        return r;
+    // list is newest first, append oldest first
+    size_t start = retVal.size();
+    while (n) {
+        retVal.push_back(n->addr);
+        Node *next = n->next;
+        delete n;
+        n = next;
+        r++;
+    }
+    std::reverse(retVal.begin() + (std::ptrdiff_t) start, retVal.end());
+    return r;
+}
+
+bool MessageReadyList::empty() const
+{
+    return local.empty() && head.load(std::memory_order_acquire) == nullptr;
+}
@@ -0,0 +1,62 @@
+#ifndef MESSAGE_READY_LIST_H
+#define MESSAGE_READY_LIST_H
+
+#include <atomic>
+#include <vector>
+#include "lorawan/lorawan-types.h"
+
+/**
+ * Addresses of the devices which uplink messages are ready to deliver to the application bridges.
+ *
+ * Uplink loop pushes addresses to the plain vector. Other threads (e.g. USB gateway listener)
+ * push to the lock-free multiple producer single consumer list. Uplink loop takes both lists
+ * at the end of each iteration, so control socket is used only to wake up the loop when
+ * the lock-free list becomes non-empty.
+ */
+class MessageReadyList {
+private:
+    class Node {
+    public:
+        DEVADDR addr;
+        Node *next;
+    };
+    std::atomic<Node *> head;           ///< pushed by other threads, newest first
+    std::vector<DEVADDR> local;         ///< pushed by the consumer thread
+public:
+    MessageReadyList();
+    virtual ~MessageReadyList();
+
+    /**
+     * Push address from the consumer (uplink loop) thread
+     * @param addr device address
+     */
+    void pushLocal(
+        const DEVADDR &addr
+    );
+
+    /**
+     * Push address from any thread
+     * @param addr device address
+     * @return true if list was empty and consumer must be woken up
+     */
+    bool push(
+        const DEVADDR &addr
+    );
+
+    /**
+     * Take all pushed addresses in the order they were pushed. Call from the consumer thread only.
+     * @param retVal addresses appended to
+     * @return count of taken addresses
+     */
+    size_t pop(
+        std::vector<DEVADDR> &retVal
+    );
+
+    /**
+     * Consumer thread only
+     * @return true if there is nothing to take
+     */
+    bool empty() const;
+};
+
+#endif
@@ -15,7 +15,12 @@
 #include "lorawan/proto/gw/basic-udp.h"
 #include "lorawan/lorawan-string.h"
 #include "lorawan/lorawan-msg.h"
+#include "lorawan/lorawan-mac.h"
 #include "lorawan/task/task-accepted-socket.h"
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+#include "lorawan/task/task-replay-socket.h"
+#endif
 #include "lorawan/lorawan-date.h"
 
 #if defined(_MSC_VER) || defined(__MINGW32__)
@@ -36,12 +41,75 @@ typedef in_addr in_addr_t;
 #define DEF_WAIT_QUIT_SECONDS 1
 #define MAX_ACK_SIZE    8
 #define MIN_TIMER_IN_MICROSECONDS   9000
+// wake up uplink loop, ready list is not empty
+#define CMD_WAKEUP 'w'
+// control commands: reply with metrics in JSON or Prometheus text format
+#define CMD_METRICS_JSON 'm'
+#define CMD_METRICS_PROMETHEUS 'p'
+// control command: reply with sampled packet traces
+#define CMD_TRACES 't'
+
+/**
+ * Control socket is a stream, wake up bytes can be read at once
+ * @return true if buffer contains wake up commands only
+ */
+static bool isWakeUp(
+    const char *buffer,
+    ssize_t size
+)
+{
+    for (ssize_t i = 0; i < size; i++) {
+        if (buffer[i] != CMD_WAKEUP)
+            return false;
+    }
+    return size > 0;
+}
+
+#ifdef SO_TIMESTAMPNS
+/**
+ * recvfrom() returning kernel receive time
+ */
+static ssize_t recvWithKernelTime(
+    SOCKET sock,
+    char *buffer,
+    size_t size,
+    struct sockaddr &srcAddr,
+    socklen_t &srcAddrLen,
+    PacketTrace &trace
+)
+{
+    struct iovec iov {};
+    iov.iov_base = buffer;
+    iov.iov_len = size;
+    char control[CMSG_SPACE(sizeof(struct timespec))];
+    struct msghdr msg {};
+    msg.msg_name = &srcAddr;
+    msg.msg_namelen = srcAddrLen;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t r = recvmsg(sock, &msg, 0);
+    if (r < 0)
+        return r;
+    srcAddrLen = msg.msg_namelen;
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_TIMESTAMPNS) {
+            struct timespec ts {};
+            memmove(&ts, CMSG_DATA(c), sizeof(ts));
+            trace.setKernelTime((int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec);
+        }
+    }
+    return r;
+}
+#endif
 
 MessageTaskDispatcher::MessageTaskDispatcher()
-    : controlSocket(nullptr), timerSocket(new TaskTimerSocket), taskResponse(nullptr), threadUplink(nullptr),
+    : controlSocket(nullptr), timerSocket(new TaskTimerSocket), tracing(false), taskResponse(nullptr), threadUplink(nullptr),
+    bridgeQueueSize(0), bridgeOverflowPolicy(BRIDGE_OVERFLOW_DROP_NEWEST), bridgeMaxBatch(DEF_BRIDGE_MAX_BATCH),
     deviceBestGatewayClient(nullptr), regionalPlan(nullptr), identityClient(nullptr), state(TASK_STOPPED),
     onReceiveRawData(nullptr), onPushData(nullptr), onPullResp(nullptr), onTxPkAck(nullptr), onDestroy(nullptr),
-    onError(nullptr), onStart(nullptr), onStop(nullptr), onGatewayPing(nullptr)
+    onError(nullptr), onStart(nullptr), onStop(nullptr), onGatewayPing(nullptr), joinPipeline(this), capture(nullptr)
 {
     queue.setDispatcher(this);
     sockets.push_back(timerSocket);
@@ -50,13 +118,14 @@ MessageTaskDispatcher::MessageTaskDispatcher()
 MessageTaskDispatcher::MessageTaskDispatcher(
     const MessageTaskDispatcher &value
 )
-    : controlSocket(value.controlSocket), timerSocket(value.timerSocket), taskResponse(value.taskResponse),
-    deviceBestGatewayClient(value.deviceBestGatewayClient), threadUplink(value.threadUplink), parsers(value.parsers),
+    : controlSocket(value.controlSocket), timerSocket(value.timerSocket), tracing(value.tracing), taskResponse(value.taskResponse),
+    bridgeQueueSize(value.bridgeQueueSize), bridgeOverflowPolicy(value.bridgeOverflowPolicy),
+    bridgeMaxBatch(value.bridgeMaxBatch), bridgeOptions(value.bridgeOptions), deviceBestGatewayClient(value.deviceBestGatewayClient), threadUplink(value.threadUplink), parsers(value.parsers),
     regionalPlan(value.regionalPlan), identityClient(value.identityClient), queue(value.queue),
     state(value.state), onReceiveRawData(value.onReceiveRawData),
     onPushData(value.onPushData), onPullResp(value.onPullResp), onTxPkAck(value.onTxPkAck),
     onDestroy(value.onDestroy), onError(value.onError), onStart(value.onStart), onStop(value.onStop),
-    onGatewayPing(value.onGatewayPing)
+    onGatewayPing(value.onGatewayPing), joinPipeline(this, value.joinPipeline), adr(value.adr), capture(value.capture)
 {
 }
 
@@ -93,7 +162,7 @@ void MessageTaskDispatcher::send2uplink(
 )
 {
     if (controlSocket)
-        write(controlSocket->sock, (const char *) cmd, (int) size);
+        controlSocket->sendMessage(cmd, size, nullptr, 0);
 }
 
 /**
@@ -175,6 +244,12 @@ bool MessageTaskDispatcher::openSockets()
             r = false;
             break;
         }
+#ifdef SO_TIMESTAMPNS
+        if (tracing && s->socketAccept == SA_NONE) {
+            int on = 1;
+            setsockopt(s->sock, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+        }
+#endif
     }
     if (timerSocket)
         timerSocket->openSocket();
@@ -199,6 +274,21 @@ void MessageTaskDispatcher::clearSockets()
         delete s;
     // clear container
     sockets.clear();
+    for (auto s : closedSockets)
+        delete s;
+    closedSockets.clear();
+}
+
+void MessageTaskDispatcher::deleteClosedSockets()
+{
+    for (auto s = closedSockets.begin(); s != closedSockets.end();) {
+        if (queue.hasSocket(*s))
+            ++s;
+        else {
+            delete *s;
+            s = closedSockets.erase(s);
+        }
+    }
 }
 
 
@@ -238,6 +328,7 @@ int MessageTaskDispatcher::runUplink()
     }
 
     state = TASK_RUN;
+    uplinkThreadId = std::this_thread::get_id();
 
     initBridges();
 
@@ -252,8 +343,12 @@ int MessageTaskDispatcher::runUplink()
         onStart(this);
     }
     ParseResult pr;
+    PacketTrace trace;
+    PacketCaptureRecord replayed;
     struct sockaddr srcAddr {};
     socklen_t srcAddrLen = sizeof(srcAddr);
+    // monotonic time cached once after select() and once after processing, see TASK_CLOCK
+    TASK_TIME now = TASK_CLOCK::now();
     while (state == TASK_RUN) {
         fd_set workingSocketSet;
         // Copy the master fd_set over to the working fd_set
@@ -261,14 +356,23 @@ int MessageTaskDispatcher::runUplink()
         // Initialize the timeval struct
         timeout.tv_sec = DEF_TIMEOUT_SECONDS;
         timeout.tv_usec = 0;
+        // wake up when collected Join-requests are due
+        int64_t joinWait = joinPipeline.waitMicroseconds(now);
+        if (joinWait >= 0 && joinWait < DEF_TIMEOUT_SECONDS * 1000000) {
+            timeout.tv_sec = (long) (joinWait / 1000000);
+            timeout.tv_usec = (long) (joinWait % 1000000);
+        }
         int rc = select((int) maxFD1, &workingSocketSet, nullptr, nullptr, &timeout);
         if (rc < 0)     // select error
             break;
 
         // getUplink timestamp
-        TASK_TIME receivedTime = std::chrono::system_clock::now();
+        now = TASK_CLOCK::now();
+        const TASK_TIME receivedTime = now;
 
         if (rc == 0) {   // select() timed out.
+            processReadyList();
+            joinPipeline.process(receivedTime);
             if (!parsers.empty())
                 sendQueuedDownlinkMessages(parsers[0]);
             cleanupOldMessages(receivedTime);
@@ -304,88 +408,90 @@ int MessageTaskDispatcher::runUplink()
                     }
                     cleanupOldMessages(receivedTime);
                     continue;
+                case SA_ACCEPTED: {
+                    // stream socket: read available bytes, process all complete messages
+                    auto a = (TaskAcceptedSocket *) s;
+                    sz = a->receive();
+                    if (sz <= 0) {
+                        if (sz < 0)
+                            std::cerr << ERR_MESSAGE  << errno << ": " << strerror(errno)
+                                << " socket " << s->sock << std::endl;
+                        // close client connection
+                        removedSockets.push_back(s); // do not modify vector using iterator, do it after
+                        continue;
+                    }
+                    if (tracing) {
+                        trace.clear();
+                        trace.mark(TRACE_STAGE_RECEIVED);
+                    }
+                    // replies to all messages are written at once
+                    a->beginBatch();
+                    const char *frame;
+                    size_t frameSize;
+                    int r;
+                    while ((r = a->frames.next(frame, frameSize)) > 0) {
+                        processMessage(s, srcAddr, 0, frame, (ssize_t) frameSize, pr, receivedTime,
+                            tracing ? &trace : nullptr);
+                    }
+                    a->flush();
+                    if (r < 0) {
+                        std::cerr << ERR_MESSAGE << r << ": " << strerror_lorawan_ns(r)
+                            << " socket " << s->sock << std::endl;
+                        removedSockets.push_back(s);
+                    }
+                    continue;
+                }
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#else
+                case SA_REPLAY: {
+                    // captured packet, source address and received time are taken from the capture
+                    sz = ((TaskReplaySocket *) s)->receive(replayed);
+                    if (sz < 0)
+                        continue;
+                    if (tracing) {
+                        trace.clear();
+                        trace.mark(TRACE_STAGE_RECEIVED);
+                    }
+                    processMessage(s, replayed.sockAddr(), replayed.addrLen, replayed.data.c_str(), sz, pr,
+                        replayed.receivedTime, tracing ? &trace : nullptr);
+                    continue;
+                }
+#endif
+                case SA_CUSTOM_READ:
+                    // socket passes messages to pushData() itself e.g. records from the USB gateway worker process
+                    if (s->customReadSocket(this, receivedTime) < 0)
+                        std::cerr << ERR_MESSAGE << errno << ": " << strerror(errno)
+                            << " socket " << s->sock << std::endl;
+                    continue;
                 case SA_EVENTFD:
                     // not used
                     sz = read(s->sock, buffer, sizeof(buffer));
                     break;
                 default:
+                    if (tracing)
+                        trace.clear();
+#ifdef SO_TIMESTAMPNS
+                    if (tracing)
+                        sz = recvWithKernelTime(s->sock, buffer, sizeof(buffer), srcAddr, srcAddrLen, trace);
+                    else
+#endif
                     sz = recvfrom(s->sock, buffer, sizeof(buffer), 0, &srcAddr, &srcAddrLen);
+                    if (tracing)
+                        trace.mark(TRACE_STAGE_RECEIVED);
             }
             if (sz < 0) {
                 std::cerr << ERR_MESSAGE  << errno << ": " << strerror(errno)
                       << " socket " << s->sock
                       << std::endl;
-                if (s->socketAccept == SA_ACCEPTED) {
-                    // close client connection
-                    removedSockets.push_back(s); // do not modify vector using iterator, do it after
-                }
                 continue;
             }
-            if (sz > 0) {
-                switch (sz) {
-                case 1: case 2: case 3:
-                        // reserved
-                        break;
-                    case SIZE_DEVADDR:      // something happens on device (by address)
-                    {
-                        auto *a = (DEVADDR *) buffer;
-                        // process message queue
-                        MessageQueueItem *item = queue.findUplink(a);
-                        if (item) {
-                            sendPayloadOverBridge(item);
-                            if (onPushData)
-                                onPushData(this, item);
-                        }
-                        break;
-                    }
-                    default: {
-                        if (onReceiveRawData)
-                            if (!onReceiveRawData(this, buffer, sz, receivedTime))  // filter raw messages
-                                continue;
-                        for (auto parser: parsers) {
-                            if (parser->parse(pr, buffer, sz, receivedTime) != CODE_OK)
-                                continue;
-                            // check this gateway is out of service
-                            if (validateGatewayAddress(pr, s, srcAddr) != CODE_OK)
-                                continue;
-                            switch (pr.tag) {
-                                case SEMTECH_GW_PUSH_DATA:
-                                    // send to app service
-                                    pushData(s, srcAddr, pr.gwPushData, receivedTime, parser);
-                                    break;
-                                case SEMTECH_GW_PULL_DATA:
-                                    // re-translate a message to the end device via the specified gateway as is
-                                    std::cout << "Re-translate message to the end device via gateway "
-                                        << gatewayId2str(pr.gwId.u)
-                                        << " socket " << s->sock << " (" << s->toString() << ")"
-                                        << std::endl;
-                                    if (sz > 0) {
-                                        int r = sendDownlink(pr.gwId.u, nullptr, buffer, sz, parser);
-                                        if (r)
-                                            std::cerr << "Error send a message to the end device " << r
-                                                << " via gateway " << gatewayId2str(pr.gwId.u) << std::endl;
-                                    }
-                                    break;
-                                case SEMTECH_GW_PULL_RESP:
-                                    if (onPullResp)
-                                        onPullResp(this, pr.gwPullResp);
-                                    break;
-                                case SEMTECH_GW_TX_ACK:
-                                    onTxPkAck(this, pr.code);
-                                    break;
-                                default:
-                                    break;
-                            }
-                            // send ACK ASAP
-                            if (sz > 0 && sendACK(s, srcAddr, srcAddrLen, buffer, sz, parser) > 0) {
-                                // inform
-                            }
-                        }
-                    }
-                }
-            }
+            processMessage(s, srcAddr, srcAddrLen, buffer, sz, pr, receivedTime, tracing ? &trace : nullptr);
         }
 
+        processReadyList();
+        now = TASK_CLOCK::now();
+        joinPipeline.process(now);
+
         // if (isTimeProcessQueueOrSetTimer(receivedTime))
         //      sendQueue(receivedTime, pr.token);
 
@@ -406,10 +512,24 @@ int MessageTaskDispatcher::runUplink()
                 });
                 if (f != sockets.end())
                     sockets.erase(f);
+                for (auto g = gatewaySocket.begin(); g != gatewaySocket.end();) {
+                    if (g->second.taskSocket == removedSocket)
+                        g = gatewaySocket.erase(g);
+                    else
+                        ++g;
+                }
+                // queued messages may refer to the socket, close connection and delete it later
+                removedSocket->closeSocket();
+                closedSockets.push_back(removedSocket);
             }
             removedSockets.clear();
             maxFD1 = getMaxDescriptor1(masterReadSocketSet);
         }
+        metrics.uplinkQueueSize.set((int64_t) queue.uplinkMessages.size());
+        metrics.downlinkQueueSize.set((int64_t) queue.downlinkMessages.size());
+        metrics.gateways.set((int64_t) gatewaySocket.size());
+        metrics.sockets.set((int64_t) sockets.size());
+        metrics.joinQueueSize.set((int64_t) joinPipeline.size());
     }
     closeSockets();
     doneBridges();
@@ -439,7 +559,7 @@ ssize_t MessageTaskDispatcher::sendACK(
     ssize_t sz = parser->ack(ack, MAX_ACK_SIZE, packet, packetSize);
     if (sz <= 0)
         return sz;
-    return sendto(taskSocket->sock, (const char *)  &ack, (int) sz, 0, &destAddr, (int) destAddrLen);
+    return taskSocket->sendMessage(ack, (size_t) sz, &destAddr, destAddrLen);
 }
 
 ssize_t MessageTaskDispatcher::sendConfirm(
@@ -448,7 +568,7 @@ ssize_t MessageTaskDispatcher::sendConfirm(
     socklen_t destAddrLen
 ) {
     SEMTECH_ACK ack;
-    return sendto(taskSocket->sock, (const char *)  &ack, SIZE_SEMTECH_ACK, 0, &destAddr, destAddrLen);
+    return taskSocket->sendMessage(&ack, SIZE_SEMTECH_ACK, &destAddr, destAddrLen);
 }
 
 void MessageTaskDispatcher::setControlSocket(
@@ -468,22 +588,190 @@ void MessageTaskDispatcher::pushData(
     const sockaddr &addr,
     GwPushData &pushData,
     const TASK_TIME &receivedTime,
-    ProtoGwParser *parser
+    ProtoGwParser *parser,
+    const PacketTrace *trace
 ) {
     queueMutex.lock();
-    bool isNew = queue.putUplink(receivedTime, taskSocket, addr, pushData, parser);
+    bool isNew = queue.putUplink(receivedTime, taskSocket, addr, pushData, parser, trace);
     queueMutex.unlock();
 
-    if (isNew) {
-    }
+    metrics.uplinks.inc();
+    if (!isNew)
+        metrics.duplicates.inc();
 
     auto a = pushData.rxData.getAddr();
-    if (a)
-        send2uplink(a, SIZE_DEVADDR);  // pass address of just added item
+    if (a) {
+        // pass address of just added item to the uplink loop. Duplicates received by other gateways
+        // (concentrators) only add metadata to the queued item, item is processed once
+        if (isNew) {
+            if (std::this_thread::get_id() == uplinkThreadId)
+                readyList.pushLocal(*a);
+            else if (readyList.push(*a))
+                send2uplink(CMD_WAKEUP);   // list was empty, loop may sleep in select()
+        }
+    } else if (isNew) {
+        // Join-request waits for duplicates from other gateways in the join pipeline
+        auto jr = pushData.rxData.getJoinRequest();
+        if (jr && joinPipeline.push(receivedTime, *jr) && std::this_thread::get_id() != uplinkThreadId)
+            send2uplink(CMD_WAKEUP);   // pipeline was empty, loop may sleep in select()
+    }
     if (pushData.needConfirmation())
         prepareSendConfirmation(a, addr, receivedTime);
 }
 
+void MessageTaskDispatcher::processReadyList()
+{
+    if (readyList.empty())
+        return;
+    readyAddrs.clear();
+    readyList.pop(readyAddrs);
+    for (auto &a : readyAddrs) {
+        queueMutex.lock();
+        MessageQueueItem *item = queue.findUplink(&a);
+        queueMutex.unlock();
+        if (item) {
+            adr.add(*item, regionalPlan);
+            sendPayloadOverBridge(item);
+            if (onPushData)
+                onPushData(this, item);
+        }
+    }
+}
+
+bool MessageTaskDispatcher::isControlPeer(
+    const TaskSocket *taskSocket
+) const
+{
+    if (taskSocket == controlSocket)
+        return true;
+    if (!dynamic_cast<const TaskAcceptedSocket *>(taskSocket))
+        return false;
+    // accepted from the Unix domain socket
+    struct sockaddr_storage a {};
+    socklen_t sz = sizeof(a);
+    if (getsockname(taskSocket->sock, (struct sockaddr *) &a, &sz))
+        return false;
+    return a.ss_family == AF_UNIX;
+}
+
+bool MessageTaskDispatcher::replyControlCommand(
+    const TaskSocket *taskSocket,
+    const sockaddr &srcAddr,
+    socklen_t srcAddrLen,
+    const char *buffer,
+    ssize_t size
+)
+{
+    std::string reply;
+    switch (buffer[0]) {
+        case CMD_METRICS_JSON:
+            reply = metrics.toJsonString();
+            break;
+        case CMD_METRICS_PROMETHEUS:
+            reply = metrics.toPrometheus();
+            break;
+        case CMD_TRACES:
+            reply = traces.toJsonString();
+            break;
+        default:
+            return false;
+    }
+    taskSocket->sendMessage(reply.c_str(), reply.size(), &srcAddr, srcAddrLen);
+    return true;
+}
+
+void MessageTaskDispatcher::processMessage(
+    TaskSocket *taskSocket,
+    const sockaddr &srcAddr,
+    socklen_t srcAddrLen,
+    const char *buffer,
+    ssize_t size,
+    ParseResult &pr,
+    const TASK_TIME &receivedTime,
+    PacketTrace *trace
+)
+{
+    if (size <= 0 || isWakeUp(buffer, size))
+        return;   // ready list is processed by the uplink loop
+    switch (size) {
+        case 1: case 2: case 3:
+            // reserved. Do not reply to the (possibly spoofed) gateway datagrams
+            if (isControlPeer(taskSocket))
+                replyControlCommand(taskSocket, srcAddr, srcAddrLen, buffer, size);
+            return;
+        case SIZE_DEVADDR:      // something happens on device (by address)
+        {
+            auto *a = (const DEVADDR *) buffer;
+            // process message queue
+            MessageQueueItem *item = queue.findUplink(a);
+            if (item) {
+                sendPayloadOverBridge(item);
+                if (onPushData)
+                    onPushData(this, item);
+            }
+            return;
+        }
+        default:
+            break;
+    }
+    metrics.packets.inc();
+    if (capture)
+        capture->append(receivedTime, (uint32_t) taskSocket->sock, &srcAddr, srcAddrLen, buffer, size);
+    if (onReceiveRawData)
+        if (!onReceiveRawData(this, buffer, size, receivedTime))  // filter raw messages
+            return;
+    bool parsed = false;
+    for (auto parser: parsers) {
+        if (parser->parse(pr, buffer, size, receivedTime) != CODE_OK)
+            continue;
+        parsed = true;
+        if (trace)
+            trace->mark(TRACE_STAGE_PARSED);
+        // check this gateway is out of service
+        if (validateGatewayAddress(pr, taskSocket, srcAddr) != CODE_OK)
+            continue;
+        switch (pr.tag) {
+            case SEMTECH_GW_PUSH_DATA:
+                metrics.pushData.inc();
+                // send to app service
+                pushData(taskSocket, srcAddr, pr.gwPushData, receivedTime, parser, trace);
+                break;
+            case SEMTECH_GW_PULL_DATA:
+                metrics.pullData.inc();
+                // re-translate a message to the end device via the specified gateway as is
+                std::cout << "Re-translate message to the end device via gateway "
+                    << gatewayId2str(pr.gwId.u)
+                    << " socket " << taskSocket->sock << " (" << taskSocket->toString() << ")"
+                    << std::endl;
+                {
+                    int r = sendDownlink(pr.gwId.u, nullptr, buffer, size, parser);
+                    if (r)
+                        std::cerr << "Error send a message to the end device " << r
+                            << " via gateway " << gatewayId2str(pr.gwId.u) << std::endl;
+                }
+                break;
+            case SEMTECH_GW_PULL_RESP:
+                if (onPullResp)
+                    onPullResp(this, pr.gwPullResp);
+                break;
+            case SEMTECH_GW_TX_ACK:
+                metrics.txAck.inc();
+                onTxPkAck(this, pr.code);
+                break;
+            default:
+                break;
+        }
+        // send ACK ASAP
+        if (sendACK(taskSocket, srcAddr, srcAddrLen, buffer, size, parser) > 0) {
+            metrics.acks.inc();
+            metrics.ackLatency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                TASK_CLOCK::now() - receivedTime).count());
+        }
+    }
+    if (!parsed)
+        metrics.parseErrors.inc();
+}
+
 void MessageTaskDispatcher::addParser(
     ProtoGwParser *aParser)
 {
@@ -514,7 +802,11 @@ void MessageTaskDispatcher::sendQueue(
             continue;   // no uplink message in the uplink queue from the end-device found
         if (m->second.needConfirmation()) {
             // send uplink message confirmation to the end-device
-            ConfirmationMessage confirmationMessage(m->second.radioPacket, m->second.task);
+            uint8_t fOpts[MAC_LINK_ADR_REQ_SIZE];
+            auto fOptsSize = (uint8_t) adr.linkADRReq(fOpts, sizeof(fOpts), ta.addr, regionalPlan);
+            if (fOptsSize)
+                metrics.adrRequests.inc();
+            ConfirmationMessage confirmationMessage(m->second.radioPacket, m->second.task, fOpts, fOptsSize);
             GatewayMetadata gwMetadata;
             // determine best gateway
             m->second.task.gatewayId = m->second.getBestGatewayAddress(gwMetadata);
@@ -557,7 +849,7 @@ bool MessageTaskDispatcher::isTimeProcessQueueOrSetTimer(
     // enough time to wait one more
     now += std::chrono::microseconds(d);
 
-    if (!timerSocket->setStartupTime(now)) {
+    if (timerSocket->setStartupTime(now)) {
         if (onError)
             onError(this, LOG_CRIT, "Set timer", errno, strerror(errno));
         return true;
@@ -637,6 +929,11 @@ void MessageTaskDispatcher::cleanupOldMessages(
 )
 {
     queue.clearOldUplinkMessages(now - std::chrono::seconds(1));
+    queueMutex.lock();
+    queue.clearOldJoinRequests(now - std::chrono::seconds(DEF_JOIN_EXPIRATION_SECONDS));
+    if (!closedSockets.empty())
+        deleteClosedSockets();
+    queueMutex.unlock();
 }
 
 int MessageTaskDispatcher::validateGatewayAddress(
@@ -668,9 +965,32 @@ void MessageTaskDispatcher::sendPayloadOverBridge(
 {
     bool micMatched = item->radioPacket.matchMic(item->task.deviceId.nwkSKey);
     bool decoded = item->radioPacket.decode(&item->task.deviceId);
-    for (auto b: appBridges) {
-        std::cout << "Send payload, bridge " << b->name() << std::endl;
-        b->onPayload(this, item, decoded, micMatched);
+    PacketTrace &trace = item->task.trace;
+    if (trace.active())
+        trace.mark(TRACE_STAGE_DECODED);
+    if (!micMatched)
+        metrics.micFailures.inc();
+    metrics.bridgePayloads.inc();
+    auto started = std::chrono::steady_clock::now();
+    if (!bridgeWorkers.empty()) {
+        // bridge worker threads deliver payload
+        for (auto w: bridgeWorkers) {
+            w->push(item, decoded, micMatched);
+        }
+    } else {
+        for (auto b: appBridges) {
+            std::cout << "Send payload, bridge " << b->name() << std::endl;
+            b->onPayload(this, item, decoded, micMatched);
+        }
+    }
+    metrics.bridgeDelivery.record(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started).count());
+    if (trace.active()) {
+        trace.mark(TRACE_STAGE_DELIVERED);
+        metrics.recordTrace(trace);
+        traces.add(trace);
+        // item can be delivered again by device event, count trace once
+        trace.clear();
     }
 }
 
@@ -746,16 +1066,38 @@ int MessageTaskDispatcher::enqueueDownlink(
         } else
             td.gatewayId = gwId;
     }
+    // piggy-back LinkADRReq if there is room in FOpts
+    uint8_t opts[15];
+    if (fOpts && fOptsSize)
+        memmove(opts, fOpts, fOptsSize);
+    auto adrSize = adr.linkADRReq(opts + fOptsSize, sizeof(opts) - fOptsSize, addr, regionalPlan);
+    if (adrSize)
+        metrics.adrRequests.inc();
+    fOptsSize += (uint8_t) adrSize;
     // build downlink message
-    DownlinkMessageBuilder m(td, fPort, payload, payloadSize, fOpts, fOptsSize);
+    DownlinkMessageBuilder m(td, fPort, payload, payloadSize, opts, fOptsSize);
     queue.putDownlink(tim, m, td.deviceId, td.gatewayId.gatewayId, proto);
     return CODE_OK;
 }
 
+void MessageTaskDispatcher::setTracing(
+    size_t sampleRate
+)
+{
+    tracing = sampleRate > 0;
+    traces.sampleRate = sampleRate;
+}
+
+bool MessageTaskDispatcher::isTracing() const
+{
+    return tracing;
+}
+
 void MessageTaskDispatcher::initBridges()
 {
     for (auto b(appBridges.begin()); b != appBridges.end();) {
-        int r = (*b)->init("", "", nullptr);
+        auto o = bridgeOptions.find((*b)->name());
+        int r = o == bridgeOptions.end() ? (*b)->init("", "", nullptr) : (*b)->init(o->second.first, o->second.second, nullptr);
         if (r) {
             std::stringstream ss;
             ss << "Bridge " << (*b)->name() << " initialization error";
@@ -764,15 +1106,59 @@ void MessageTaskDispatcher::initBridges()
         } else
             b++;
     }
+    if (bridgeQueueSize) {
+        for (auto b: appBridges) {
+            auto w = new AppBridgeWorker(b, this, bridgeQueueSize, bridgeOverflowPolicy, bridgeMaxBatch);
+            w->start();
+            bridgeWorkers.push_back(w);
+        }
+    }
 }
 
 void MessageTaskDispatcher::doneBridges()
 {
+    // deliver queued payloads first
+    for (auto w: bridgeWorkers) {
+        w->stop();
+        delete w;
+    }
+    bridgeWorkers.clear();
     for (auto b: appBridges) {
         b->done();
     }
 }
 
+void MessageTaskDispatcher::setBridgeDelivery(
+    size_t queueSize,
+    BRIDGE_OVERFLOW_POLICY policy,
+    size_t maxBatch
+)
+{
+    bridgeQueueSize = queueSize;
+    bridgeOverflowPolicy = policy;
+    bridgeMaxBatch = maxBatch;
+}
+
+void MessageTaskDispatcher::setBridgeOptions(
+    const std::string &bridgeName,
+    const std::string &option,
+    const std::string &option2
+)
+{
+    bridgeOptions[bridgeName] = std::make_pair(option, option2);
+}
+
+void MessageTaskDispatcher::getBridgeStat(
+    std::vector<std::pair<std::string, AppBridgeWorkerStat>> &retVal
+) const
+{
+    for (auto w: bridgeWorkers) {
+        AppBridgeWorkerStat stat;
+        w->getStat(stat);
+        retVal.emplace_back(w->getBridge()->name(), stat);
+    }
+}
+
 int MessageTaskDispatcher::sendDownlink(
     uint64_t gwId,
     const NetworkIdentity *networkIdentity,
@@ -801,13 +1187,15 @@ int MessageTaskDispatcher::sendDownlink(
         socketGw->customWriteSocket(networkIdentity, buffer, bufferSize, proto);
         std::cout << "Send downlink to gateway direct " << sockaddr2string(&gw.sockaddr) << std::endl;
     } else {
-        r = sendto(socketGw->sock, buffer, (int) bufferSize, 0,
-                   &gw.sockaddr, (int) addressLength(&gw.sockaddr));
+        r = (int) socketGw->sendMessage(buffer, bufferSize, &gw.sockaddr, addressLength(&gw.sockaddr));
         std::cout << "Send downlink to gateway address " << sockaddr2string(&gw.sockaddr) << std::endl;
     }
 
-    if (r > 0)
+    if (r > 0 || socketGw->customWrite) {
+        metrics.downlinks.inc();
         return 0;   // 0- success, <0- error code
+    }
+    metrics.downlinkErrors.inc();
     return r;
 }
 
@@ -1,11 +1,13 @@
 #ifndef MESSAGE_TASK_DISPATCHER_H
 #define MESSAGE_TASK_DISPATCHER_H
 
+#include <map>
 #include <thread>
 #include <condition_variable>
 
 #include "lorawan/task/task-platform.h"
 #include "lorawan/task/message-queue.h"
+#include "lorawan/task/message-ready-list.h"
 #include "lorawan/task/task-response.h"
 #include "lorawan/helper/ip-address.h"
 #include "lorawan/proto/gw/gw.h"
@@ -16,7 +18,12 @@
 #include "lorawan/regional-parameters/regional-parameter-channel-plan.h"
 #include "lorawan/storage/client/direct-client.h"
 #include "lorawan/bridge/app-bridge.h"
+#include "lorawan/bridge/app-bridge-worker.h"
 #include "lorawan/storage/client/device-best-gateway-direct-client.h"
+#include "lorawan/task/dispatcher-metrics.h"
+#include "lorawan/task/join-pipeline.h"
+#include "lorawan/task/adr-engine.h"
+#include "lorawan/task/packet-capture.h"
 
 typedef void(*OnPushDataProc)(
     MessageTaskDispatcher* dispatcher,
@@ -91,6 +98,7 @@ typedef int(*TaskProc)(
  * MessageTaskDispatcher receive messages from the one or more TaskSocket
  */
 class MessageTaskDispatcher {
+    friend class JoinPipeline;
 private:
     std::mutex queueMutex;
     // running state
@@ -99,6 +107,13 @@ private:
     // reserved socket to send packet to maim select() loop
     TaskSocket *controlSocket;
     TaskTimerSocket *timerSocket;
+    // uplinks ready to deliver to the bridges
+    MessageReadyList readyList;
+    std::vector<DEVADDR> readyAddrs;
+    // closed stream connections, deleted by cleanupOldMessages() when queued messages do not refer to them
+    std::vector<TaskSocket*> closedSockets;
+    std::thread::id uplinkThreadId;
+    bool tracing;                       ///< stamp packet stages, see setTracing()
     /**
      * Set descriptor set
      * @param retValReadSet
@@ -107,10 +122,52 @@ private:
     SOCKET getMaxDescriptor1(
         fd_set &retValReadSet
     );
+    /**
+     * Deliver ready uplinks to the bridges. Called by uplink loop at the end of each iteration
+     */
+    void processReadyList();
+    /**
+     * Control commands are accepted from the control socket and local (Unix domain) stream sockets only
+     * @return true if socket can send control commands
+     */
+    bool isControlPeer(
+        const TaskSocket *taskSocket
+    ) const;
+    /**
+     * Reply to the control command received from the control socket
+     * @return true if buffer is a control command
+     */
+    bool replyControlCommand(
+        const TaskSocket *taskSocket,
+        const sockaddr &srcAddr,
+        socklen_t srcAddrLen,
+        const char *buffer,
+        ssize_t size
+    );
+    /**
+     * Process one message: control command, wake up, device address or gateway protocol message
+     * @param taskSocket socket message received from
+     * @param trace nullptr if packet is not traced
+     */
+    void processMessage(
+        TaskSocket *taskSocket,
+        const sockaddr &srcAddr,
+        socklen_t srcAddrLen,
+        const char *buffer,
+        ssize_t size,
+        ParseResult &pr,
+        const TASK_TIME &receivedTime,
+        PacketTrace *trace
+    );
 protected:
     TaskResponse *taskResponse;
     std::thread *threadUplink;    ///< main uplink loop thread
     std::vector<AppBridge *> appBridges;
+    std::vector<AppBridgeWorker *> bridgeWorkers;   ///< empty if payloads are delivered synchronously
+    size_t bridgeQueueSize;                         ///< 0- call onPayload() in the uplink thread
+    BRIDGE_OVERFLOW_POLICY bridgeOverflowPolicy;
+    size_t bridgeMaxBatch;
+    std::map<std::string, std::pair<std::string, std::string>> bridgeOptions;  ///< bridge name: init() options
 
     bool openSockets();
     /**
@@ -121,6 +178,10 @@ protected:
      * erase all sockets
      */
     void clearSockets();
+    /**
+     * Delete closed connections which are not referenced by the queued messages
+     */
+    void deleteClosedSockets();
 public:
     DeviceBestGatewayDirectClient *deviceBestGatewayClient;
     MessageQueue queue;                 ///< message queue
@@ -141,6 +202,11 @@ public:
     const RegionalParameterChannelPlan *regionalPlan;
     DirectClient *identityClient;
     std::map<uint64_t, GatewayPingTimeNSocket> gatewaySocket;
+    DispatcherMetrics metrics;          ///< counters, gauges and latency histograms
+    PacketTraceSampler traces;          ///< last sampled packet traces
+    JoinPipeline joinPipeline;          ///< Join-request processing
+    AdrEngine adr;                      ///< LinkADRReq piggy-backed to the downlinks, requires regional plan
+    PacketCaptureWriter *capture;       ///< record received packets, nullptr- do not capture
 
     int runUplink();
 
@@ -191,7 +257,8 @@ public:
         const sockaddr &addr,
         GwPushData &pushData,
         const TASK_TIME &receivedTime,
-        ProtoGwParser *aParser
+        ProtoGwParser *aParser,
+        const PacketTrace *trace = nullptr
     );
 
     void addParser(
@@ -298,6 +365,49 @@ public:
         ProtoGwParser *proto
     );
 
+    /**
+     * Deliver payloads to each bridge in its own thread through the bounded queue.
+     * Call before start.
+     * @param queueSize queue size, 0- call AppBridge::onPayload() synchronously in the uplink thread (default)
+     * @param policy what to do if bridge queue is full
+     * @param maxBatch max count of payloads passed to the AppBridge::onPayloadBatch() at once
+     */
+    void setBridgeDelivery(
+        size_t queueSize,
+        BRIDGE_OVERFLOW_POLICY policy = BRIDGE_OVERFLOW_DROP_NEWEST,
+        size_t maxBatch = DEF_BRIDGE_MAX_BATCH
+    );
+
+    /**
+     * Set options passed to AppBridge::init() of the bridge with given name(). Call before start.
+     * @param bridgeName bridge name, see AppBridge::name()
+     * @param option first init() option e.g. file name
+     * @param option2 second init() option
+     */
+    void setBridgeOptions(
+        const std::string &bridgeName,
+        const std::string &option,
+        const std::string &option2
+    );
+
+    /**
+     * Return per-bridge delivery counters. Empty if delivery is synchronous
+     * @param retVal bridge name and counters
+     */
+    void getBridgeStat(
+        std::vector<std::pair<std::string, AppBridgeWorkerStat>> &retVal
+    ) const;
+
+    /**
+     * Stamp each packet stage from socket receive to bridge delivery, aggregate stage latencies
+     * in the metrics and keep sampled traces. Call before start.
+     * @param sampleRate 0- disable tracing, N- keep every N-th trace in traces
+     */
+    void setTracing(
+        size_t sampleRate
+    );
+    bool isTracing() const;
+
     void initBridges();
     void doneBridges();
 
@@ -0,0 +1,147 @@
+#include <cstring>
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#define close(s) closesocket(s)
+#define read(sock, b, sz) ::recv(sock, b, (int) sz, 0)
+#define SHUT_RDWR SD_BOTH
+#define MSG_NOSIGNAL    0
+#else
+#include <sys/select.h>
+#include <unistd.h>
+#define INVALID_SOCKET  (-1)
+#endif
+
+#include "lorawan/lorawan-error.h"
+#include "lorawan/task/metrics-http-listener.h"
+
+// wake up accept loop to check is listener stopped
+#define METRICS_SELECT_TIMEOUT_MS   500
+#define METRICS_REQUEST_SIZE        1024
+// client that connects and does not send request must not block other scrapes
+#define METRICS_CLIENT_TIMEOUT_MS   2000
+
+MetricsHttpListener::MetricsHttpListener(
+    const DispatcherMetrics *aMetrics
+)
+    : metrics(aMetrics), sock(INVALID_SOCKET), thread(nullptr), running(false)
+{
+}
+
+MetricsHttpListener::~MetricsHttpListener()
+{
+    stop();
+}
+
+int MetricsHttpListener::start(
+    const std::string &address
+)
+{
+    std::string host;
+    uint16_t port;
+    if (!splitAddress(host, port, address))
+        return ERR_CODE_ADDR_OUT_OF_RANGE;
+    struct sockaddr_in6 addr {};
+    if (!string2sockaddr((struct sockaddr *) &addr, host, port))
+        return ERR_CODE_ADDR_OUT_OF_RANGE;
+    sock = socket(addr.sin6_family, SOCK_STREAM, 0);
+    if (sock == INVALID_SOCKET)
+        return ERR_CODE_SOCKET_CREATE;
+    int on = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char *) &on, sizeof(on));
+    if (bind(sock, (struct sockaddr *) &addr, addressLength((struct sockaddr *) &addr)) < 0) {
+        close(sock);
+        sock = INVALID_SOCKET;
+        return ERR_CODE_SOCKET_BIND;
+    }
+    if (listen(sock, 8) < 0) {
+        close(sock);
+        sock = INVALID_SOCKET;
+        return ERR_CODE_SOCKET_LISTEN;
+    }
+    running = true;
+    thread = new std::thread(&MetricsHttpListener::run, this);
+    return CODE_OK;
+}
+
+void MetricsHttpListener::stop()
+{
+    running = false;
+    // wake up select()
+    if (sock != INVALID_SOCKET)
+        shutdown(sock, SHUT_RDWR);
+    if (thread) {
+        thread->join();
+        delete thread;
+        thread = nullptr;
+    }
+    if (sock != INVALID_SOCKET) {
+        close(sock);
+        sock = INVALID_SOCKET;
+    }
+}
+
+void MetricsHttpListener::run()
+{
+    while (running) {
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(sock, &readSet);
+        struct timeval timeout {};
+        timeout.tv_sec = 0;
+        timeout.tv_usec = METRICS_SELECT_TIMEOUT_MS * 1000;
+        int rc = select((int) sock + 1, &readSet, nullptr, nullptr, &timeout);
+        if (rc < 0)
+            break;
+        if (rc == 0)
+            continue;
+        SOCKET client = accept(sock, nullptr, nullptr);
+        if (client == INVALID_SOCKET)
+            continue;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+        DWORD clientTimeout = METRICS_CLIENT_TIMEOUT_MS;
+#else
+        struct timeval clientTimeout {};
+        clientTimeout.tv_sec = METRICS_CLIENT_TIMEOUT_MS / 1000;
+        clientTimeout.tv_usec = (METRICS_CLIENT_TIMEOUT_MS % 1000) * 1000;
+#endif
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (char *) &clientTimeout, sizeof(clientTimeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, (char *) &clientTimeout, sizeof(clientTimeout));
+        serve(client);
+        close(client);
+    }
+}
+
+void MetricsHttpListener::serve(
+    SOCKET client
+)
+{
+    char request[METRICS_REQUEST_SIZE];
+    // request line is enough, scraper sends whole request at once
+    ssize_t sz = read(client, request, sizeof(request) - 1);
+    if (sz <= 0)
+        return;
+    request[sz] = '\0';
+    std::string body;
+    std::string status;
+    if (strncmp(request, "GET ", 4) == 0) {
+        status = "200 OK";
+        body = metrics->toPrometheus();
+    } else {
+        status = "405 Method Not Allowed";
+    }
+    std::string response = "HTTP/1.1 " + status + "\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+    const char *p = response.c_str();
+    size_t left = response.size();
+    while (left > 0) {
+        // scraper may close the connection early, do not raise SIGPIPE
+        ssize_t w = send(client, p, left, MSG_NOSIGNAL);
+        if (w <= 0)
+            break;
+        p += w;
+        left -= (size_t) w;
+    }
+    shutdown(client, SHUT_RDWR);
+}
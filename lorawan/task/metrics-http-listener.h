@@ -0,0 +1,43 @@
+#ifndef METRICS_HTTP_LISTENER_H
+#define METRICS_HTTP_LISTENER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "lorawan/helper/ip-address.h"
+#include "lorawan/task/dispatcher-metrics.h"
+
+/**
+ * Minimal HTTP endpoint for Prometheus scraper. Any GET request is answered by the
+ * dispatcher metrics in the text exposition format, connection is closed after each response.
+ * Client socket has receive and send timeout, so idle client can not stall the serving thread.
+ * Does not require libmicrohttpd.
+ */
+class MetricsHttpListener {
+private:
+    const DispatcherMetrics *metrics;
+    SOCKET sock;
+    std::thread *thread;
+    std::atomic<bool> running;
+    void run();
+    void serve(
+        SOCKET client
+    );
+public:
+    explicit MetricsHttpListener(
+        const DispatcherMetrics *metrics
+    );
+    virtual ~MetricsHttpListener();
+    /**
+     * Listen and start serving thread
+     * @param address IPv4 or IPv6 address and port e.g. "0.0.0.0:9100"
+     * @return CODE_OK or ERR_CODE_ADDR_OUT_OF_RANGE, ERR_CODE_SOCKET_CREATE, ERR_CODE_SOCKET_BIND, ERR_CODE_SOCKET_LISTEN
+     */
+    int start(
+        const std::string &address
+    );
+    void stop();
+};
+
+#endif
@@ -0,0 +1,225 @@
+#include <cstring>
+
+#include "lorawan/task/packet-capture.h"
+#include "lorawan/lorawan-error.h"
+
+static void putLE(
+    char *retVal,
+    uint64_t value,
+    size_t size
+)
+{
+    for (size_t i = 0; i < size; i++) {
+        retVal[i] = (char) ((value >> (i * 8)) & 0xff);
+    }
+}
+
+static uint64_t getLE(
+    const char *buffer,
+    size_t size
+)
+{
+    uint64_t r = 0;
+    for (size_t i = 0; i < size; i++) {
+        r |= (uint64_t) (uint8_t) buffer[i] << (i * 8);
+    }
+    return r;
+}
+
+PacketCaptureRecord::PacketCaptureRecord()
+    : socketId(0), addr {}, addrLen(0)
+{
+}
+
+const sockaddr &PacketCaptureRecord::sockAddr() const
+{
+    return *(const sockaddr *) &addr;
+}
+
+size_t PacketCaptureRecord::serialize(
+    std::string &retVal,
+    const TASK_TIME &receivedTime,
+    uint32_t socketId,
+    const sockaddr *addr,
+    socklen_t addrLen,
+    const char *data,
+    size_t size
+)
+{
+    if (!addr || addrLen > sizeof(struct sockaddr_storage))
+        addrLen = 0;
+    char h[PACKET_CAPTURE_RECORD_HEADER_SIZE];
+    putLE(h, (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+        receivedTime.time_since_epoch()).count(), 8);
+    putLE(h + 8, socketId, 4);
+    putLE(h + 12, addrLen, 2);
+    putLE(h + 14, size, 4);
+    retVal.append(h, PACKET_CAPTURE_RECORD_HEADER_SIZE);
+    if (addrLen)
+        retVal.append((const char *) addr, addrLen);
+    retVal.append(data, size);
+    return PACKET_CAPTURE_RECORD_HEADER_SIZE + addrLen + size;
+}
+
+ssize_t PacketCaptureRecord::parse(
+    const char *buffer,
+    size_t size
+)
+{
+    if (size < PACKET_CAPTURE_RECORD_HEADER_SIZE)
+        return 0;
+    auto addrSize = (size_t) getLE(buffer + 12, 2);
+    auto dataSize = (size_t) getLE(buffer + 14, 4);
+    if (addrSize > sizeof(addr))
+        return ERR_CODE_INVALID_PACKET;
+    size_t sz = PACKET_CAPTURE_RECORD_HEADER_SIZE + addrSize + dataSize;
+    if (size < sz)
+        return 0;
+    receivedTime = TASK_TIME(std::chrono::duration_cast<TASK_TIME::duration>(
+        std::chrono::microseconds((int64_t) getLE(buffer, 8))));
+    socketId = (uint32_t) getLE(buffer + 8, 4);
+    memset(&addr, 0, sizeof(addr));
+    addrLen = (socklen_t) addrSize;
+    memmove(&addr, buffer + PACKET_CAPTURE_RECORD_HEADER_SIZE, addrSize);
+    data.assign(buffer + PACKET_CAPTURE_RECORD_HEADER_SIZE + addrSize, dataSize);
+    return (ssize_t) sz;
+}
+
+PacketCaptureWriter::PacketCaptureWriter(
+    size_t aBufferSize
+)
+    : f(nullptr), bufferSize(aBufferSize), count(0)
+{
+    buffer.reserve(bufferSize);
+}
+
+PacketCaptureWriter::~PacketCaptureWriter()
+{
+    close();
+}
+
+int PacketCaptureWriter::open(
+    const std::string &fileName
+)
+{
+    close();
+    std::lock_guard<std::mutex> lock(mutexBuffer);
+    f = fopen(fileName.c_str(), "wb");
+    if (!f)
+        return ERR_CODE_CAPTURE_OPEN;
+    char h[PACKET_CAPTURE_FILE_HEADER_SIZE];
+    putLE(h, PACKET_CAPTURE_MAGIC, 4);
+    putLE(h + 4, PACKET_CAPTURE_VERSION, 4);
+    if (fwrite(h, sizeof(h), 1, f) != 1) {
+        fclose(f);
+        f = nullptr;
+        return ERR_CODE_CAPTURE_OPEN;
+    }
+    count = 0;
+    return CODE_OK;
+}
+
+void PacketCaptureWriter::close()
+{
+    std::lock_guard<std::mutex> lock(mutexBuffer);
+    if (!f)
+        return;
+    writeBuffer();
+    fclose(f);
+    f = nullptr;
+}
+
+int PacketCaptureWriter::writeBuffer()
+{
+    if (buffer.empty())
+        return CODE_OK;
+    bool written = fwrite(buffer.data(), buffer.size(), 1, f) == 1;
+    buffer.clear();
+    if (!written)
+        return ERR_CODE_CAPTURE_WRITE;
+    return fflush(f) == 0 ? CODE_OK : ERR_CODE_CAPTURE_WRITE;
+}
+
+int PacketCaptureWriter::append(
+    const TASK_TIME &receivedTime,
+    uint32_t socketId,
+    const sockaddr *addr,
+    socklen_t addrLen,
+    const char *data,
+    size_t size
+)
+{
+    std::lock_guard<std::mutex> lock(mutexBuffer);
+    if (!f)
+        return ERR_CODE_CAPTURE_WRITE;
+    PacketCaptureRecord::serialize(buffer, receivedTime, socketId, addr, addrLen, data, size);
+    count++;
+    if (buffer.size() < bufferSize)
+        return CODE_OK;
+    return writeBuffer();
+}
+
+int PacketCaptureWriter::flush()
+{
+    std::lock_guard<std::mutex> lock(mutexBuffer);
+    if (!f)
+        return ERR_CODE_CAPTURE_WRITE;
+    return writeBuffer();
+}
+
+size_t PacketCaptureWriter::size() const
+{
+    return count;
+}
+
+PacketCaptureReader::PacketCaptureReader()
+    : f(nullptr)
+{
+}
+
+PacketCaptureReader::~PacketCaptureReader()
+{
+    close();
+}
+
+int PacketCaptureReader::open(
+    const std::string &fileName
+)
+{
+    close();
+    f = fopen(fileName.c_str(), "rb");
+    if (!f)
+        return ERR_CODE_CAPTURE_OPEN;
+    char h[PACKET_CAPTURE_FILE_HEADER_SIZE];
+    if (fread(h, sizeof(h), 1, f) != 1 || getLE(h, 4) != PACKET_CAPTURE_MAGIC
+        || getLE(h + 4, 4) != PACKET_CAPTURE_VERSION) {
+        close();
+        return ERR_CODE_INVALID_PACKET;
+    }
+    return CODE_OK;
+}
+
+void PacketCaptureReader::close()
+{
+    if (!f)
+        return;
+    fclose(f);
+    f = nullptr;
+}
+
+int PacketCaptureReader::next(
+    PacketCaptureRecord &retVal
+)
+{
+    if (!f)
+        return 0;
+    char h[PACKET_CAPTURE_RECORD_HEADER_SIZE];
+    if (fread(h, sizeof(h), 1, f) != 1)
+        return 0;
+    size_t sz = (size_t) getLE(h + 12, 2) + (size_t) getLE(h + 14, 4);
+    buffer.assign(h, sizeof(h));
+    buffer.resize(sizeof(h) + sz);
+    if (sz && fread(&buffer[sizeof(h)], sz, 1, f) != 1)
+        return 0;
+    return retVal.parse(buffer.c_str(), buffer.size()) > 0 ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+#ifndef PACKET_CAPTURE_H_
+#define PACKET_CAPTURE_H_ 1
+
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+#include <mutex>
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#include <Winsock2.h>
+#else
+#include <sys/socket.h>
+#endif
+
+#include "lorawan/task/task-platform.h"
+
+/**
+ * Raw packet capture.
+ *
+ * File layout:
+ *  magic (4 bytes) "LTPC", version (4 bytes)
+ *  records:
+ *      received time, monotonic clock (TASK_CLOCK) microseconds (8 bytes), replay uses intervals only
+ *      socket identifier (4 bytes)
+ *      source address size (2 bytes)
+ *      data size (4 bytes)
+ *      source address (sockaddr)
+ *      raw datagram or stream message
+ * Numbers are little endian.
+ *
+ * PacketCaptureWriter appends records to the memory buffer and writes it to the file when
+ * buffer is full, so capture costs one memcpy per packet in the uplink loop.
+ * Torn record at the end of file (crash in the middle of write) is skipped by the reader.
+ */
+
+#define PACKET_CAPTURE_MAGIC                0x4350544c  ///< "LTPC" in little endian
+#define PACKET_CAPTURE_VERSION              1
+#define PACKET_CAPTURE_FILE_HEADER_SIZE     8
+#define PACKET_CAPTURE_RECORD_HEADER_SIZE   18
+#define DEF_PACKET_CAPTURE_BUFFER_SIZE      (256 * 1024)
+
+class PacketCaptureRecord {
+public:
+    TASK_TIME receivedTime;
+    uint32_t socketId;                  ///< socket descriptor packet received from
+    struct sockaddr_storage addr;       ///< source address
+    socklen_t addrLen;                  ///< 0- no address
+    std::string data;
+
+    PacketCaptureRecord();
+    const sockaddr &sockAddr() const;
+    /**
+     * Append serialized record to the string
+     * @param retVal string to append to
+     * @param addr source address, can be nullptr
+     * @param addrLen source address size
+     * @return appended size
+     */
+    static size_t serialize(
+        std::string &retVal,
+        const TASK_TIME &receivedTime,
+        uint32_t socketId,
+        const sockaddr *addr,
+        socklen_t addrLen,
+        const char *data,
+        size_t size
+    );
+    /**
+     * Parse serialized record
+     * @return parsed size, 0- incomplete record, ERR_CODE_INVALID_PACKET- invalid record
+     */
+    ssize_t parse(
+        const char *buffer,
+        size_t size
+    );
+};
+
+class PacketCaptureWriter {
+private:
+    std::mutex mutexBuffer;
+    FILE *f;
+    std::string buffer;
+    size_t bufferSize;
+    size_t count;
+    int writeBuffer();
+public:
+    explicit PacketCaptureWriter(
+        size_t bufferSize = DEF_PACKET_CAPTURE_BUFFER_SIZE
+    );
+    virtual ~PacketCaptureWriter();
+    /**
+     * Create or truncate capture file
+     * @return CODE_OK- success, ERR_CODE_CAPTURE_OPEN- can not create file
+     */
+    int open(
+        const std::string &fileName
+    );
+    /**
+     * Flush buffer and close file
+     */
+    void close();
+    /**
+     * Append packet. Can be called from MessageTaskDispatcher::onReceiveRawData hook without address
+     * @param receivedTime packet received time
+     * @param socketId socket descriptor
+     * @param addr source address, can be nullptr
+     * @param addrLen source address size
+     * @param data raw packet
+     * @param size raw packet size
+     * @return CODE_OK- success, ERR_CODE_CAPTURE_WRITE- file write error
+     */
+    int append(
+        const TASK_TIME &receivedTime,
+        uint32_t socketId,
+        const sockaddr *addr,
+        socklen_t addrLen,
+        const char *data,
+        size_t size
+    );
+    /**
+     * Write buffered records to the file
+     * @return CODE_OK- success, ERR_CODE_CAPTURE_WRITE- file write error
+     */
+    int flush();
+    /**
+     * @return records appended since open()
+     */
+    size_t size() const;
+};
+
+class PacketCaptureReader {
+private:
+    FILE *f;
+    std::string buffer;
+public:
+    PacketCaptureReader();
+    virtual ~PacketCaptureReader();
+    /**
+     * Open capture file and check header
+     * @return CODE_OK- success, ERR_CODE_CAPTURE_OPEN- can not open file, ERR_CODE_INVALID_PACKET- not a capture file
+     */
+    int open(
+        const std::string &fileName
+    );
+    void close();
+    /**
+     * Read next record
+     * @return 1- record read, 0- end of file (or torn record at the end)
+     */
+    int next(
+        PacketCaptureRecord &retVal
+    );
+};
+
+#endif
@@ -0,0 +1,47 @@
+#include <thread>
+
+#include "lorawan/task/packet-replay.h"
+#include "lorawan/lorawan-error.h"
+
+PacketReplay::PacketReplay(
+    TaskReplaySocket *aSocket,
+    bool aRealTime
+)
+    : socket(aSocket), realTime(aRealTime), count(0)
+{
+}
+
+int PacketReplay::run(
+    PacketCaptureReader &reader
+)
+{
+    PacketCaptureRecord record;
+    TASK_TIME start = TASK_CLOCK::now();
+    TASK_TIME first;
+    bool hasFirst = false;
+    while (reader.next(record) > 0) {
+        if (!hasFirst) {
+            first = record.receivedTime;
+            hasFirst = true;
+        }
+        TASK_TIME t = start + (record.receivedTime - first);
+        if (realTime)
+            std::this_thread::sleep_until(t);
+        int r = socket->push(record, t);
+        if (r)
+            return r;
+        count++;
+    }
+    return CODE_OK;
+}
+
+int PacketReplay::run(
+    const std::string &fileName
+)
+{
+    PacketCaptureReader reader;
+    int r = reader.open(fileName);
+    if (r)
+        return r;
+    return run(reader);
+}
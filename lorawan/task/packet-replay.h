@@ -0,0 +1,50 @@
+#ifndef PACKET_REPLAY_H_
+#define PACKET_REPLAY_H_ 1
+
+#include <string>
+
+#include "lorawan/task/task-replay-socket.h"
+
+/**
+ * Replay captured packets through the dispatcher uplink loop.
+ * Received time of the first record is mapped to the time replay started, intervals between
+ * records are kept, so dispatcher sees the same relative timing (deduplication windows, RX1 delays)
+ * in both modes:
+ *  realTime == true    wait between packets as in the capture, reproduce incident
+ *  realTime == false   as fast as dispatcher reads, benchmark
+ *
+ * Usage:
+ *  auto s = new TaskReplaySocket;
+ *  dispatcher.sockets.push_back(s);
+ *  dispatcher.start();
+ *  PacketReplay replay(s, false);
+ *  replay.run("incident.cap");
+ */
+class PacketReplay {
+private:
+    TaskReplaySocket *socket;
+public:
+    bool realTime;          ///< keep intervals between packets
+    size_t count;           ///< records replayed
+
+    PacketReplay(
+        TaskReplaySocket *socket,
+        bool realTime
+    );
+    /**
+     * Replay all records
+     * @return CODE_OK- success, ERR_CODE_SOCKET_WRITE- dispatcher socket is closed
+     */
+    int run(
+        PacketCaptureReader &reader
+    );
+    /**
+     * Replay capture file
+     * @return CODE_OK- success, ERR_CODE_CAPTURE_OPEN, ERR_CODE_INVALID_PACKET- invalid file
+     */
+    int run(
+        const std::string &fileName
+    );
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include <chrono>
+#include <sstream>
+
+#include "lorawan/task/packet-trace.h"
+
+static const char *STAGE_NAMES[TRACE_STAGE_COUNT] = {
+    "kernel", "received", "parsed", "queued", "identified", "decoded", "delivered"
+};
+
+PacketTrace::PacketTrace()
+{
+    clear();
+}
+
+void PacketTrace::clear()
+{
+    for (auto &s : stamps) {
+        s = 0;
+    }
+}
+
+int64_t PacketTrace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PacketTrace::mark(
+    TRACE_STAGE stage
+)
+{
+    stamps[stage] = now();
+}
+
+void PacketTrace::setKernelTime(
+    int64_t realtimeNs
+)
+{
+    int64_t mono = now();
+    int64_t real = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t d = real - realtimeNs;
+    // clock adjusted
+    if (d < 0)
+        d = 0;
+    stamps[TRACE_STAGE_KERNEL] = mono - d;
+}
+
+bool PacketTrace::active() const
+{
+    return stamps[TRACE_STAGE_RECEIVED] != 0;
+}
+
+int64_t PacketTrace::duration(
+    TRACE_STAGE stage
+) const
+{
+    if (!stamps[stage])
+        return -1;
+    for (int s = stage - 1; s >= 0; s--) {
+        if (stamps[s])
+            return (stamps[stage] - stamps[s]) / 1000;
+    }
+    return -1;
+}
+
+int64_t PacketTrace::total() const
+{
+    int64_t first = 0;
+    int64_t last = 0;
+    for (auto s : stamps) {
+        if (!s)
+            continue;
+        if (!first)
+            first = s;
+        last = s;
+    }
+    return (last - first) / 1000;
+}
+
+std::string PacketTrace::toJsonString() const
+{
+    std::stringstream ss;
+    ss << "{";
+    bool isFirst = true;
+    for (int s = TRACE_STAGE_RECEIVED; s < TRACE_STAGE_COUNT; s++) {
+        int64_t d = duration((TRACE_STAGE) s);
+        if (d < 0)
+            continue;
+        if (isFirst)
+            isFirst = false;
+        else
+            ss << ", ";
+        ss << "\"" << STAGE_NAMES[s] << "\": " << d;
+    }
+    if (!isFirst)
+        ss << ", ";
+    ss << "\"total\": " << total() << "}";
+    return ss.str();
+}
+
+const char *PacketTrace::stageName(
+    TRACE_STAGE stage
+)
+{
+    return STAGE_NAMES[stage];
+}
+
+PacketTraceSampler::PacketTraceSampler(
+    size_t aCapacity
+)
+    : capacity(aCapacity), next(0), counter(0), sampleRate(0)
+{
+}
+
+bool PacketTraceSampler::add(
+    const PacketTrace &trace
+)
+{
+    std::lock_guard<std::mutex> lock(mutexTraces);
+    if (!sampleRate || (counter++ % sampleRate))
+        return false;
+    if (traces.size() < capacity)
+        traces.push_back(trace);
+    else
+        traces[next] = trace;
+    next = (next + 1) % capacity;
+    return true;
+}
+
+std::string PacketTraceSampler::toJsonString() const
+{
+    std::lock_guard<std::mutex> lock(mutexTraces);
+    std::stringstream ss;
+    ss << "[";
+    size_t start = traces.size() < capacity ? 0 : next;
+    for (size_t i = 0; i < traces.size(); i++) {
+        if (i)
+            ss << ", ";
+        ss << traces[(start + i) % traces.size()].toJsonString();
+    }
+    ss << "]";
+    return ss.str();
+}
@@ -0,0 +1,97 @@
+#ifndef PACKET_TRACE_H
+#define PACKET_TRACE_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cinttypes>
+
+/**
+ * Optional per-packet stage timestamps from socket receive to bridge delivery.
+ * Timestamps are monotonic clock nanoseconds, kernel receive time (SO_TIMESTAMPNS) is
+ * converted to the monotonic clock when packet is read.
+ */
+
+typedef enum {
+    TRACE_STAGE_KERNEL = 0,     ///< kernel receive time, 0 if not available
+    TRACE_STAGE_RECEIVED,       ///< packet read by the uplink loop
+    TRACE_STAGE_PARSED,         ///< protocol parser returned
+    TRACE_STAGE_QUEUED,         ///< gateway validated, packet deduplicated in the queue
+    TRACE_STAGE_IDENTIFIED,     ///< device identity resolved
+    TRACE_STAGE_DECODED,        ///< MIC checked, payload decrypted
+    TRACE_STAGE_DELIVERED,      ///< AppBridge::onPayload() returned or payload pushed to the bridge workers
+    TRACE_STAGE_COUNT
+} TRACE_STAGE;
+
+#define DEF_TRACE_SAMPLES   16
+
+class PacketTrace {
+public:
+    int64_t stamps[TRACE_STAGE_COUNT];  ///< nanoseconds, 0- stage is not stamped
+
+    PacketTrace();
+    void clear();
+    /**
+     * Stamp stage with current monotonic time
+     */
+    void mark(
+        TRACE_STAGE stage
+    );
+    /**
+     * Set kernel receive time
+     * @param realtimeNs CLOCK_REALTIME nanoseconds returned by SO_TIMESTAMPNS
+     */
+    void setKernelTime(
+        int64_t realtimeNs
+    );
+    /**
+     * @return true if packet is traced
+     */
+    bool active() const;
+    /**
+     * Time spent in the stage since previous stamped stage
+     * @return microseconds, -1 if stage or previous stage are not stamped
+     */
+    int64_t duration(
+        TRACE_STAGE stage
+    ) const;
+    /**
+     * @return microseconds from first stamped stage to the last one
+     */
+    int64_t total() const;
+    std::string toJsonString() const;
+    static int64_t now();
+    static const char *stageName(
+        TRACE_STAGE stage
+    );
+};
+
+/**
+ * Keep each sampleRate'th trace in the ring of last traces
+ */
+class PacketTraceSampler {
+private:
+    mutable std::mutex mutexTraces;
+    std::vector<PacketTrace> traces;
+    size_t capacity;
+    size_t next;
+    uint64_t counter;
+public:
+    size_t sampleRate;  ///< 0- tracing disabled, 1- each packet, N- every N-th packet
+
+    explicit PacketTraceSampler(
+        size_t capacity = DEF_TRACE_SAMPLES
+    );
+    /**
+     * @return true if trace sampled
+     */
+    bool add(
+        const PacketTrace &trace
+    );
+    /**
+     * @return JSON array of sampled traces, oldest first
+     */
+    std::string toJsonString() const;
+};
+
+#endif
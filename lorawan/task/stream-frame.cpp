@@ -0,0 +1,77 @@
+#include <cstring>
+
+#include "lorawan/task/stream-frame.h"
+#include "lorawan/lorawan-error.h"
+
+StreamFrameBuffer::StreamFrameBuffer()
+    : start(0), finish(0)
+{
+}
+
+char *StreamFrameBuffer::space(
+    size_t &retSize
+)
+{
+    if (buffer.empty())
+        buffer.resize(STREAM_FRAME_HEADER_SIZE + STREAM_FRAME_MAX_SIZE);
+    if (start > 0) {
+        // move incomplete message to the beginning
+        if (finish > start)
+            memmove(buffer.data(), buffer.data() + start, finish - start);
+        finish -= start;
+        start = 0;
+    }
+    retSize = buffer.size() - finish;
+    return buffer.data() + finish;
+}
+
+void StreamFrameBuffer::received(
+    size_t size
+)
+{
+    finish += size;
+    if (finish > buffer.size())
+        finish = buffer.size();
+}
+
+int StreamFrameBuffer::next(
+    const char *&retFrame,
+    size_t &retSize
+)
+{
+    if (finish - start < STREAM_FRAME_HEADER_SIZE)
+        return 0;
+    auto *h = (const unsigned char *) buffer.data() + start;
+    size_t sz = ((size_t) h[0] << 24) | ((size_t) h[1] << 16) | ((size_t) h[2] << 8) | h[3];
+    if (sz > STREAM_FRAME_MAX_SIZE)
+        return ERR_CODE_INVALID_PACKET;
+    if (finish - start < STREAM_FRAME_HEADER_SIZE + sz)
+        return 0;
+    retFrame = buffer.data() + start + STREAM_FRAME_HEADER_SIZE;
+    retSize = sz;
+    start += STREAM_FRAME_HEADER_SIZE + sz;
+    return 1;
+}
+
+size_t StreamFrameBuffer::size() const
+{
+    return finish - start;
+}
+
+void StreamFrameBuffer::clear()
+{
+    std::vector<char>().swap(buffer);
+    start = 0;
+    finish = 0;
+}
+
+void StreamFrameBuffer::header(
+    char *retVal,
+    size_t size
+)
+{
+    retVal[0] = (char) ((size >> 24) & 0xff);
+    retVal[1] = (char) ((size >> 16) & 0xff);
+    retVal[2] = (char) ((size >> 8) & 0xff);
+    retVal[3] = (char) (size & 0xff);
+}
@@ -0,0 +1,68 @@
+#ifndef STREAM_FRAME_H_
+#define STREAM_FRAME_H_ 1
+
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Messages over stream (TCP, Unix domain) sockets are prefixed by 4 bytes length in network byte order.
+ * StreamFrameBuffer collects received bytes and extracts all complete messages, so a message split
+ * across reads and several messages coalesced in one read are parsed the same way as datagrams.
+ */
+
+#define STREAM_FRAME_HEADER_SIZE    4
+#define STREAM_FRAME_MAX_SIZE       65536   ///< incoming message larger than this is a protocol error
+
+class StreamFrameBuffer {
+private:
+    std::vector<char> buffer;
+    size_t start;           ///< first byte of the incomplete message
+    size_t finish;          ///< end of the received bytes
+public:
+    StreamFrameBuffer();
+    /**
+     * Return free space to receive bytes into. Incomplete message is moved to the beginning of the buffer
+     * @param retSize free space size
+     * @return pointer to the free space
+     */
+    char *space(
+        size_t &retSize
+    );
+    /**
+     * Account bytes received into space()
+     * @param size received bytes
+     */
+    void received(
+        size_t size
+    );
+    /**
+     * Extract next complete message. Message is valid until next space() call
+     * @param retFrame message
+     * @param retSize message size
+     * @return 1- message extracted, 0- no complete message, ERR_CODE_INVALID_PACKET- message is too large
+     */
+    int next(
+        const char *&retFrame,
+        size_t &retSize
+    );
+    /**
+     * @return bytes received but not extracted yet
+     */
+    size_t size() const;
+    /**
+     * Drop received bytes and release memory
+     */
+    void clear();
+    /**
+     * Write message header
+     * @param retVal buffer at least STREAM_FRAME_HEADER_SIZE bytes
+     * @param size message size
+     */
+    static void header(
+        char *retVal,
+        size_t size
+    );
+};
+
+#endif
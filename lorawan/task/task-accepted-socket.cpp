@@ -1,4 +1,5 @@
 #include <csignal>
+#include <cstring>
 
 #include "lorawan/task/task-accepted-socket.h"
 
@@ -6,12 +7,15 @@
 #define close(x) closesocket(x)
 #else
 #include <unistd.h>
+#include <sys/uio.h>
 #endif
 
+#include "lorawan/lorawan-error.h"
+
 TaskAcceptedSocket::TaskAcceptedSocket(
     TaskSocketPreNAcceptedSocket &taskSocketPreNAcceptedSocket
 )
-    : TaskSocket(taskSocketPreNAcceptedSocket.acceptedSocket, SA_ACCEPTED)
+    : TaskSocket(taskSocketPreNAcceptedSocket.acceptedSocket, SA_ACCEPTED), batch(false)
 {
     if (taskSocketPreNAcceptedSocket.taskSocket) {
         // copy custom write from the originator
@@ -37,6 +41,8 @@ void TaskAcceptedSocket::closeSocket()
     if (sock >= 0)
         close(sock);
     sock = -1;
+    frames.clear();
+    pending.clear();
 }
 
 void TaskAcceptedSocket::customWriteSocket(
@@ -48,3 +54,111 @@ void TaskAcceptedSocket::customWriteSocket(
     if (originator)
         originator->customWriteSocket(networkIdentity, data, size, proto);
 }
+
+ssize_t TaskAcceptedSocket::receive()
+{
+    size_t available;
+    char *p = frames.space(available);
+    if (available == 0)
+        return ERR_CODE_INVALID_PACKET;     // never happens, StreamFrameBuffer keeps room for the largest message
+    ssize_t r = recv(sock, p, (int) available, 0);
+    if (r > 0)
+        frames.received((size_t) r);
+    return r;
+}
+
+void TaskAcceptedSocket::beginBatch()
+{
+    batch = true;
+}
+
+ssize_t TaskAcceptedSocket::flush()
+{
+    batch = false;
+    if (pending.empty())
+        return 0;
+    auto sz = (ssize_t) pending.size();
+    ssize_t r = writeMessages(nullptr, 0);
+    return r < 0 ? r : sz;
+}
+
+ssize_t TaskAcceptedSocket::sendMessage(
+    const void *data,
+    size_t size,
+    const sockaddr *destAddr,
+    socklen_t destAddrLen
+) const
+{
+    if (batch) {
+        size_t o = pending.size();
+        pending.resize(o + STREAM_FRAME_HEADER_SIZE + size);
+        StreamFrameBuffer::header(pending.data() + o, size);
+        memmove(pending.data() + o + STREAM_FRAME_HEADER_SIZE, data, size);
+        return (ssize_t) size;
+    }
+    return writeMessages(data, size);
+}
+
+ssize_t TaskAcceptedSocket::writeMessages(
+    const void *data,
+    size_t size
+) const
+{
+    ssize_t r = writeFramed(sock, pending.data(), pending.size(), data, size);
+    pending.clear();
+    return r;
+}
+
+ssize_t TaskAcceptedSocket::writeFramed(
+    SOCKET sock,
+    const char *framed,
+    size_t framedSize,
+    const void *data,
+    size_t size
+)
+{
+    char h[STREAM_FRAME_HEADER_SIZE];
+    StreamFrameBuffer::header(h, size);
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    std::vector<char> b(framed, framed + framedSize);
+    if (data) {
+        b.insert(b.end(), h, h + STREAM_FRAME_HEADER_SIZE);
+        b.insert(b.end(), (const char *) data, (const char *) data + size);
+    }
+    ssize_t r = send(sock, b.data(), (int) b.size(), 0);
+    if (r >= 0)
+        r = (size_t) r < b.size() ? ERR_CODE_SOCKET_WRITE : (ssize_t) size;
+#else
+    // already framed messages, header and message in one system call
+    struct iovec v[3];
+    int c = 0;
+    if (framedSize)
+        v[c++] = { (void *) framed, framedSize };
+    if (data) {
+        v[c++] = { h, STREAM_FRAME_HEADER_SIZE };
+        v[c++] = { (void *) data, size };
+    }
+    size_t left = framedSize + (data ? STREAM_FRAME_HEADER_SIZE + size : 0);
+    ssize_t r = (ssize_t) size;
+    struct iovec *iv = v;
+    while (left > 0) {
+        ssize_t w = writev(sock, iv, c);
+        if (w <= 0) {
+            r = w < 0 ? w : ERR_CODE_SOCKET_WRITE;
+            break;
+        }
+        left -= (size_t) w;
+        // skip written buffers, stream socket may write partially
+        while (c > 0 && (size_t) w >= iv->iov_len) {
+            w -= (ssize_t) iv->iov_len;
+            iv++;
+            c--;
+        }
+        if (c > 0) {
+            iv->iov_base = (char *) iv->iov_base + w;
+            iv->iov_len -= (size_t) w;
+        }
+    }
+#endif
+    return r;
+}
@@ -8,15 +8,32 @@
 #include <netinet/in.h>
 #endif
 
+#include <vector>
+
 #include "lorawan/storage/gateway-identity.h"
 #include "lorawan/task/task-socket.h"
+#include "lorawan/task/stream-frame.h"
 
 /**
- * After TCP socket is accepted, create TaskAcceptedSocket
+ * After TCP socket is accepted, create TaskAcceptedSocket.
+ * Messages in both directions are prefixed by the length, see StreamFrameBuffer.
+ * Replies sent between beginBatch() and flush() are written to the socket at once.
  */
 class TaskAcceptedSocket : public TaskSocket {
+private:
+    mutable std::vector<char> pending;  ///< batched replies with headers
+    mutable bool batch;
+    /**
+     * Write pending replies followed by the message
+     * @return bytes written, <0- error
+     */
+    ssize_t writeMessages(
+        const void *data,
+        size_t size
+    ) const;
 public:
     TaskSocket *originator;
+    StreamFrameBuffer frames;           ///< received bytes
     /**
      * @param socket accepted socket
      */
@@ -28,6 +45,42 @@ public:
     SOCKET openSocket() override;
     void closeSocket() override;
     virtual ~TaskAcceptedSocket();
+    /**
+     * Read available bytes into the frames buffer, then call frames.next() to extract messages
+     * @return bytes received, 0- connection closed, <0- error
+     */
+    ssize_t receive();
+    /**
+     * Collect replies until flush()
+     */
+    void beginBatch();
+    /**
+     * Write collected replies
+     * @return bytes written, <0- error
+     */
+    ssize_t flush();
+    ssize_t sendMessage(
+        const void *data,
+        size_t size,
+        const sockaddr *destAddr,
+        socklen_t destAddrLen
+    ) const override;
+    /**
+     * Write already framed messages followed by the message with header
+     * @param sock stream socket
+     * @param framed messages with headers, can be nullptr
+     * @param framedSize framed size
+     * @param data message to prefix with header, nullptr if none
+     * @param size message size
+     * @return message size, <0- error
+     */
+    static ssize_t writeFramed(
+        SOCKET sock,
+        const char *framed,
+        size_t framedSize,
+        const void *data,
+        size_t size
+    );
     void customWriteSocket(
         const NetworkIdentity *networkIdentity,
         const void* data,
@@ -10,7 +10,7 @@ TaskDescriptor::TaskDescriptor(
     const TaskDescriptor &value
 )
     : stage(value.stage), state(value.state), errorCode(value.errorCode),
-        repeats(value.repeats), deviceId(value.deviceId), gatewayId(value.gatewayId)
+        repeats(value.repeats), deviceId(value.deviceId), gatewayId(value.gatewayId), trace(value.trace)
 {
 
 }
@@ -25,6 +25,7 @@ TaskDescriptor& TaskDescriptor::operator=(
     repeats = value.repeats;
     deviceId = value.deviceId;
     gatewayId = value.gatewayId;
+    trace = value.trace;
     return *this;
 }
 
@@ -6,6 +6,7 @@
 
 #include "lorawan/storage/network-identity.h"
 #include "lorawan/storage/gateway-identity.h"
+#include "lorawan/task/packet-trace.h"
 
 typedef enum {
     TASK_STAGE_RECEIVED = 0,                // just received
@@ -41,6 +42,7 @@ public:
 
     NetworkIdentity deviceId;               // device keys
     GatewayIdentity gatewayId;              // best gateway address
+    PacketTrace trace;                      // stage timestamps if dispatcher tracing is enabled
 
     TaskDescriptor();
     TaskDescriptor(const TaskDescriptor &value);
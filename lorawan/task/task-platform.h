@@ -6,7 +6,26 @@
 
 #include <chrono>
 
-typedef std::chrono::time_point<std::chrono::system_clock> TASK_TIME;
+/**
+ * Queue expiry, duplicate collection window and RX window timers use monotonic clock,
+ * so NTP steps do not expire or delay queued messages. Wall clock is used for reporting only,
+ * see taskTime2systemTime()
+ */
+typedef std::chrono::steady_clock TASK_CLOCK;
+typedef std::chrono::time_point<TASK_CLOCK> TASK_TIME;
+
+/**
+ * Convert monotonic task time to the wall clock time for reporting
+ * @param time task time
+ * @return wall clock time
+ */
+inline std::chrono::system_clock::time_point taskTime2systemTime(
+    const TASK_TIME &time
+)
+{
+    return std::chrono::system_clock::now()
+        + std::chrono::duration_cast<std::chrono::system_clock::duration>(time - TASK_CLOCK::now());
+}
 
 #if defined(_MSC_VER)
 #include <BaseTsd.h>
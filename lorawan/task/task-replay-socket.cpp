@@ -0,0 +1,81 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "lorawan/task/task-replay-socket.h"
+#include "lorawan/task/stream-frame.h"
+#include "lorawan/lorawan-error.h"
+
+#define INVALID_SOCKET  (-1)
+
+TaskReplaySocket::TaskReplaySocket()
+    : TaskSocket(SA_REPLAY), peer(INVALID_SOCKET), received(0), replies(0)
+{
+}
+
+SOCKET TaskReplaySocket::openSocket()
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fds)) {
+        lastError = ERR_CODE_SOCKET_CREATE;
+        return INVALID_SOCKET;
+    }
+    sock = fds[0];
+    peer = fds[1];
+    return sock;
+}
+
+void TaskReplaySocket::closeSocket()
+{
+    if (peer != INVALID_SOCKET) {
+        close(peer);
+        peer = INVALID_SOCKET;
+    }
+    if (sock != INVALID_SOCKET) {
+        close(sock);
+        sock = INVALID_SOCKET;
+    }
+}
+
+TaskReplaySocket::~TaskReplaySocket()
+{
+    closeSocket();
+}
+
+ssize_t TaskReplaySocket::sendMessage(
+    const void *data,
+    size_t size,
+    const sockaddr *destAddr,
+    socklen_t destAddrLen
+) const
+{
+    replies++;
+    return (ssize_t) size;
+}
+
+int TaskReplaySocket::push(
+    const PacketCaptureRecord &record,
+    const TASK_TIME &receivedTime
+)
+{
+    std::string s;
+    PacketCaptureRecord::serialize(s, receivedTime, record.socketId, record.addrLen ? &record.sockAddr() : nullptr,
+        record.addrLen, record.data.c_str(), record.data.size());
+    if (send(peer, s.c_str(), s.size(), 0) != (ssize_t) s.size())
+        return ERR_CODE_SOCKET_WRITE;
+    return CODE_OK;
+}
+
+ssize_t TaskReplaySocket::receive(
+    PacketCaptureRecord &retVal
+)
+{
+    if (buffer.empty())
+        buffer.resize(PACKET_CAPTURE_RECORD_HEADER_SIZE + sizeof(struct sockaddr_storage) + STREAM_FRAME_MAX_SIZE);
+    ssize_t sz = recv(sock, buffer.data(), buffer.size(), 0);
+    if (sz <= 0)
+        return ERR_CODE_SOCKET_READ;
+    if (retVal.parse(buffer.data(), (size_t) sz) <= 0)
+        return ERR_CODE_INVALID_PACKET;
+    received++;
+    return (ssize_t) retVal.data.size();
+}
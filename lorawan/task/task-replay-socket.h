@@ -0,0 +1,60 @@
+#ifndef TASK_REPLAY_SOCKET_H_
+#define TASK_REPLAY_SOCKET_H_ 1
+
+#include <atomic>
+#include <vector>
+
+#include "lorawan/task/task-socket.h"
+#include "lorawan/task/packet-capture.h"
+
+/**
+ * Feed captured packets into the MessageTaskDispatcher uplink loop.
+ * PacketReplay writes records to the one end of the datagram socket pair, dispatcher reads them from
+ * the other end and process packet with source address and received time taken from the capture.
+ * Replies (ACK, downlinks) are counted and discarded, replay never sends to the real gateways.
+ */
+class TaskReplaySocket : public TaskSocket {
+private:
+    SOCKET peer;                    ///< write end of the socket pair
+    std::vector<char> buffer;
+public:
+    std::atomic<size_t> received;   ///< records read by the dispatcher
+    mutable std::atomic<size_t> replies;    ///< messages sent by the dispatcher
+    TaskReplaySocket();
+    /**
+     * Create socket pair
+     * @return read end, -1 if fails
+     */
+    SOCKET openSocket() override;
+    void closeSocket() override;
+    virtual ~TaskReplaySocket();
+    /**
+     * Count and discard reply
+     * @return size
+     */
+    ssize_t sendMessage(
+        const void *data,
+        size_t size,
+        const sockaddr *destAddr,
+        socklen_t destAddrLen
+    ) const override;
+    /**
+     * Write record to the dispatcher. Blocks while dispatcher is busy
+     * @param record captured packet
+     * @param receivedTime time passed to the dispatcher instead of the captured one
+     * @return CODE_OK- success, ERR_CODE_SOCKET_WRITE- socket is closed
+     */
+    int push(
+        const PacketCaptureRecord &record,
+        const TASK_TIME &receivedTime
+    );
+    /**
+     * Read record, called by the dispatcher
+     * @return data size, <0- error
+     */
+    ssize_t receive(
+        PacketCaptureRecord &retVal
+    );
+};
+
+#endif
@@ -4,6 +4,7 @@
 #if defined(_MSC_VER) || defined(__MINGW32__)
 #else
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 #define INVALID_SOCKET  (-1)
 #endif
 
@@ -46,6 +47,24 @@ void TaskSocket::customWriteSocket(
 
 }
 
+ssize_t TaskSocket::customReadSocket(
+    MessageTaskDispatcher *dispatcher,
+    const TASK_TIME &receivedTime
+)
+{
+    return -1;
+}
+
+ssize_t TaskSocket::sendMessage(
+    const void *data,
+    size_t size,
+    const sockaddr *destAddr,
+    socklen_t destAddrLen
+) const
+{
+    return sendto(sock, (const char *) data, (int) size, 0, destAddr, (int) destAddrLen);
+}
+
 TaskSocket::~TaskSocket()
 {
 }
@@ -69,6 +88,9 @@ std::string TaskSocket::toString() const
         case SA_EVENTFD:
             ss << "event reserved socket ";
             break;
+        case SA_CUSTOM_READ:
+            ss << "custom read socket ";
+            break;
         default:
             ss << "invalid socket ";
             break;
@@ -97,6 +119,9 @@ std::string TaskSocket::toJsonString() const
         case SA_EVENTFD:
             ss << "event";
             break;
+        case SA_CUSTOM_READ:
+            ss << "custom";
+            break;
         default:
             ss << "invalid";
             break;
@@ -121,7 +146,7 @@ TaskSocketPreNAcceptedSocket::TaskSocketPreNAcceptedSocket(
 }
 
 GatewayPingTimeNSocket::GatewayPingTimeNSocket()
-    : taskSocket(nullptr), tim(std::chrono::system_clock::now())
+    : taskSocket(nullptr), tim(TASK_CLOCK::now())
 {
 
 }
@@ -129,7 +154,7 @@ GatewayPingTimeNSocket::GatewayPingTimeNSocket()
 GatewayPingTimeNSocket::GatewayPingTimeNSocket(
     TaskSocket *aTaskSocket
 )
-    : taskSocket(aTaskSocket), tim(std::chrono::system_clock::now())
+    : taskSocket(aTaskSocket), tim(TASK_CLOCK::now())
 {
 
 }
@@ -13,13 +13,16 @@
 #include "lorawan/storage/gateway-identity.h"
 
 class ProtoGwParser;
+class MessageTaskDispatcher;
 
 enum ENUM_SOCKET_ACCEPT {
     SA_NONE,        ///< socket do not require accept()
     SA_ACCEPT_REQUIRE,     ///< socket require accept()
     SA_ACCEPTED,    ///< socket require accept() and already accepted
     SA_TIMER,       ///< timer
-    SA_EVENTFD      ///< reserved
+    SA_EVENTFD,     ///< reserved
+    SA_REPLAY,      ///< captured packets, see TaskReplaySocket
+    SA_CUSTOM_READ  ///< socket reads messages and pass them to the dispatcher itself, see customReadSocket()
 };
 
 /**
@@ -33,6 +36,7 @@ enum ENUM_SOCKET_ACCEPT {
  *  TaskUDPSocket       Task UDP socket
  *  TaskUnixSocket      Task Unix domain socket
  *  TaskAcceptedSocket  Task TCP socket after accept()
+ *  TaskReplaySocket    Captured packets replayed by PacketReplay
  * Task*ControlSocket classes intend for receive messages from the Network server
  * with request to stop the server
  *  TaskUDPControlSocket
@@ -79,6 +83,32 @@ public:
         size_t size,
         ProtoGwParser *proto
     );
+    /**
+     * Read messages and pass them to the dispatcher if socketAccept == SA_CUSTOM_READ.
+     * Called by the dispatcher uplink loop when socket is readable.
+     * @param dispatcher dispatcher
+     * @param receivedTime time when socket has been selected
+     * @return count of messages read, <0- error
+     */
+    virtual ssize_t customReadSocket(
+        MessageTaskDispatcher *dispatcher,
+        const TASK_TIME &receivedTime
+    );
+    /**
+     * Send message to the peer. Datagram socket sends message to the destination address,
+     * TaskAcceptedSocket prefixes message with the length, see StreamFrameBuffer
+     * @param data message
+     * @param size message size
+     * @param destAddr destination address, ignored by stream socket
+     * @param destAddrLen destination address size
+     * @return bytes sent, <0- error
+     */
+    virtual ssize_t sendMessage(
+        const void *data,
+        size_t size,
+        const sockaddr *destAddr,
+        socklen_t destAddrLen
+    ) const;
     virtual ~TaskSocket();
     std::string toString() const;
     std::string toJsonString() const;
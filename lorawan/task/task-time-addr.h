@@ -1,5 +1,5 @@
-#ifndef TASK_UDP_SOCKET_H_
-#define TASK_UDP_SOCKET_H_ 1
+#ifndef TASK_TIME_ADDR_H_
+#define TASK_TIME_ADDR_H_ 1
 
 #include <map>
 #include "lorawan/lorawan-types.h"
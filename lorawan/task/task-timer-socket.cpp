@@ -59,7 +59,7 @@ SOCKET TaskTimerSocket::openSocket()
     lastError = CODE_OK;
     return sock;
 #else
-    sock = timerfd_create(CLOCK_REALTIME, 0);
+    sock = timerfd_create(CLOCK_MONOTONIC, 0);
 #endif
     if (sock <= 0)
         lastError = ERR_CODE_SOCKET_CREATE;
@@ -112,7 +112,7 @@ VOID CALLBACK onTimerCb(
 /**
  * Set expiration time for timer
  * @param tim time to set
- * @return true if success
+ * @return 0- success
  */
 int TaskTimerSocket::setStartupTime(
     TASK_TIME tim
@@ -120,12 +120,13 @@ int TaskTimerSocket::setStartupTime(
 {
 #if defined(_MSC_VER) || defined(__MINGW32__)
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            (tim - std::chrono::system_clock::now())
+            (tim - TASK_CLOCK::now())
     );
     BOOL r = CreateTimerQueueTimer(&hTimer, hTimerQueue, (WAITORTIMERCALLBACK) onTimerCb,
         this, (DWORD) ms.count(), 0, WT_EXECUTEINTIMERTHREAD | WT_EXECUTEONLYONCE);
     return r ? CODE_OK : ERR_CODE_PARAM_INVALID;
 #else
+    // steady_clock counts CLOCK_MONOTONIC time, absolute time is the same for the timer
     // getUplink seconds
     auto s = std::chrono::duration_cast<std::chrono::seconds>(tim.time_since_epoch());
     // getUplink nanoseconds: extract seconds from the time
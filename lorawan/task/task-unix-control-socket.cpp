@@ -1,4 +1,5 @@
 #include "lorawan/task/task-unix-control-socket.h"
+#include "lorawan/task/task-accepted-socket.h"
 
 #if defined(_MSC_VER) || defined(__MINGW32__)
 #else
@@ -94,6 +95,16 @@ void TaskUnixControlSocket::closeSocket()
     unlink(socketPath.c_str());
 }
 
+ssize_t TaskUnixControlSocket::sendMessage(
+    const void *data,
+    size_t size,
+    const sockaddr *destAddr,
+    socklen_t destAddrLen
+) const
+{
+    return TaskAcceptedSocket::writeFramed(sock, nullptr, 0, data, size);
+}
+
 // virtual int onData(const char *buffer, size_t size) = 0;
 TaskUnixControlSocket::~TaskUnixControlSocket()
 {
@@ -25,6 +25,15 @@ public:
      */
     SOCKET openSocket() override;
     void closeSocket() override;
+    /**
+     * Stream socket: prefix message with the length, see StreamFrameBuffer
+     */
+    ssize_t sendMessage(
+        const void *data,
+        size_t size,
+        const sockaddr *destAddr,
+        socklen_t destAddrLen
+    ) const override;
     virtual ~TaskUnixControlSocket();
 };
 
@@ -0,0 +1,219 @@
+/**
+ * Identity service load generator.
+ * Each client thread has its own UDP socket and keeps up to window requests in flight.
+ * Print requests per second and round trip latency percentiles.
+ */
+#include <string>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include "argtable3/argtable3.h"
+
+#include "lorawan/lorawan-error.h"
+#include "lorawan/lorawan-msg.h"
+#include "lorawan/helper/ip-address.h"
+#include "lorawan/storage/serialization/identity-binary-serialization.h"
+
+// i18n
+// #include <libintl.h>
+// #define _(String) gettext (String)
+#define _(String) (String)
+
+const char *programName = "lorawan-identity-bench";
+
+#define DEF_PORT        4244
+#define DEF_CLIENTS     8
+#define DEF_REQUESTS    10000
+#define DEF_WINDOW      16
+#define RECEIVE_TIMEOUT_MS  500
+
+class BenchParams {
+public:
+    std::string intf;
+    uint16_t port;
+    int clients;
+    int requests;
+    int window;
+    uint32_t addrCount;     ///< query addresses 1..addrCount
+    int32_t code;
+    uint64_t accessCode;
+    BenchParams()
+        : port(DEF_PORT), clients(DEF_CLIENTS), requests(DEF_REQUESTS), window(DEF_WINDOW),
+        addrCount(1000), code(42), accessCode(42)
+    {
+    }
+};
+
+class ClientResult {
+public:
+    size_t sent;
+    size_t received;
+    size_t lost;
+    std::vector<uint32_t> latencyMicroseconds;
+    ClientResult()
+        : sent(0), received(0), lost(0)
+    {
+    }
+};
+
+static BenchParams params;
+
+static void runClient(
+    int clientNo,
+    const struct sockaddr &destAddr,
+    ClientResult &result
+)
+{
+    int sock = socket(destAddr.sa_family, SOCK_DGRAM, 0);
+    if (sock < 0)
+        return;
+    struct timeval timeout { 0, RECEIVE_TIMEOUT_MS * 1000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char *) &timeout, sizeof(timeout));
+    socklen_t addrLen = destAddr.sa_family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+    if (connect(sock, &destAddr, addrLen)) {
+        close(sock);
+        return;
+    }
+    result.latencyMicroseconds.reserve(params.requests);
+    unsigned char req[SIZE_DEVICE_ADDR_REQUEST];
+    unsigned char resp[1024];
+    uint32_t a = (uint32_t) clientNo;
+    int left = params.requests;
+    while (left > 0) {
+        int w = std::min(left, params.window);
+        auto started = std::chrono::steady_clock::now();
+        for (int i = 0; i < w; i++) {
+            DEVADDR addr(1 + (a++ % params.addrCount));
+            IdentityAddrRequest r(QUERY_IDENTITY_EUI, addr, params.code, params.accessCode);
+            r.serialize(req);
+            if (send(sock, (const char *) req, SIZE_DEVICE_ADDR_REQUEST, 0) == SIZE_DEVICE_ADDR_REQUEST)
+                result.sent++;
+        }
+        for (int i = 0; i < w; i++) {
+            ssize_t sz = recv(sock, (char *) resp, sizeof(resp), 0);
+            if (sz <= 0) {
+                // timed out, rest of window is lost
+                result.lost += w - i;
+                break;
+            }
+            result.received++;
+            result.latencyMicroseconds.push_back((uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started).count());
+        }
+        left -= w;
+    }
+    close(sock);
+}
+
+static uint32_t percentile(
+    const std::vector<uint32_t> &sorted,
+    double p
+)
+{
+    if (sorted.empty())
+        return 0;
+    size_t i = (size_t) (p * (double) (sorted.size() - 1));
+    return sorted[i];
+}
+
+int main(int argc, char **argv) {
+    struct arg_str *a_interface_n_port = arg_str0(nullptr, nullptr, _("<ipaddr:port>"), _("Default 127.0.0.1:4244"));
+    struct arg_int *a_clients = arg_int0("t", "threads", _("<number>"), _("concurrent clients. Default 8"));
+    struct arg_int *a_requests = arg_int0("n", "requests", _("<number>"), _("requests per client. Default 10000"));
+    struct arg_int *a_window = arg_int0("w", "window", _("<number>"), _("requests in flight per client. Default 16"));
+    struct arg_int *a_addr_count = arg_int0("r", "range", _("<number>"), _("query addresses 1..range. Default 1000"));
+    struct arg_int *a_code = arg_int0("c", "code", _("<number>"), _("Default 42. 0x - hex number prefix"));
+    struct arg_str *a_access_code = arg_str0("a", "access", _("<hex>"), _("Default 2a (42 decimal)"));
+    struct arg_lit *a_help = arg_lit0("h", "help", _("Show this help"));
+    struct arg_end *a_end = arg_end(20);
+
+    void* argtable[] = {
+        a_interface_n_port, a_clients, a_requests, a_window, a_addr_count,
+        a_code, a_access_code,
+        a_help, a_end
+    };
+
+    if (arg_nullcheck(argtable) != 0) {
+        arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+        return ERR_CODE_COMMAND_LINE;
+    }
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    if (a_interface_n_port->count) {
+        if (!splitAddress(params.intf, params.port, std::string(*a_interface_n_port->sval)))
+            nerrors++;
+    } else
+        params.intf = "127.0.0.1";
+    if (a_clients->count)
+        params.clients = std::max(1, *a_clients->ival);
+    if (a_requests->count)
+        params.requests = std::max(1, *a_requests->ival);
+    if (a_window->count)
+        params.window = std::max(1, *a_window->ival);
+    if (a_addr_count->count)
+        params.addrCount = (uint32_t) std::max(1, *a_addr_count->ival);
+    if (a_code->count)
+        params.code = *a_code->ival;
+    if (a_access_code->count)
+        params.accessCode = strtoull(*a_access_code->sval, nullptr, 16);
+
+    if ((a_help->count) || nerrors) {
+        if (nerrors)
+            arg_print_errors(stderr, a_end, programName);
+        std::cerr << _("Usage: ") << programName << std::endl;
+        arg_print_syntax(stderr, argtable, "\n");
+        std::cerr << _("LoRaWAN identity service load generator") << std::endl;
+        arg_print_glossary(stderr, argtable, "  %-27s %s\n");
+        arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+        return ERR_CODE_COMMAND_LINE;
+    }
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+
+    struct sockaddr_storage destAddr {};
+    if (!string2sockaddr((struct sockaddr *) &destAddr, params.intf, params.port)) {
+        std::cerr << ERR_MESSAGE << ERR_CODE_ADDR_OUT_OF_RANGE << ": " << params.intf << std::endl;
+        return ERR_CODE_ADDR_OUT_OF_RANGE;
+    }
+
+    std::vector<ClientResult> results(params.clients);
+    std::vector<std::thread> threads;
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < params.clients; i++) {
+        threads.emplace_back(runClient, i, std::cref(*(const struct sockaddr *) &destAddr), std::ref(results[i]));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    size_t sent = 0, received = 0, lost = 0;
+    std::vector<uint32_t> latency;
+    for (auto &r : results) {
+        sent += r.sent;
+        received += r.received;
+        lost += r.lost;
+        latency.insert(latency.end(), r.latencyMicroseconds.begin(), r.latencyMicroseconds.end());
+    }
+    std::sort(latency.begin(), latency.end());
+    std::cout << "{\"clients\": " << params.clients
+        << ", \"window\": " << params.window
+        << ", \"sent\": " << sent
+        << ", \"received\": " << received
+        << ", \"lost\": " << lost
+        << ", \"seconds\": " << seconds
+        << ", \"requestsPerSecond\": " << (seconds > 0 ? (double) received / seconds : 0.0)
+        << ", \"p50\": " << percentile(latency, 0.5)
+        << ", \"p99\": " << percentile(latency, 0.99)
+        << ", \"max\": " << (latency.empty() ? 0 : latency.back())
+        << "}" << std::endl;
+    return lost ? ERR_CODE_SOCKET_READ : CODE_OK;
+}
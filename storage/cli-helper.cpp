@@ -3,6 +3,11 @@
 #include "cli-helper.h"
 #include "lorawan/storage/serialization/identity-binary-serialization.h"
 #include "lorawan/storage/serialization/gateway-binary-serialization.h"
+#include "lorawan/lorawan-string.h"
+#include "lorawan/lorawan-error.h"
+#ifdef ENABLE_JSON
+#include "lorawan/storage/serialization/json-helper.h"
+#endif
 
 std::string listCommands() {
     std::stringstream ss;
@@ -119,3 +124,37 @@ bool readNetId(
         retVal.set(strtoul(value.c_str(), nullptr, 16));
     return true;
 }
+
+int readIdentities(
+    std::vector<NETWORKIDENTITY> &retVal,
+    std::istream &strm,
+    size_t maxCount,
+    size_t &retLineNo
+)
+{
+    std::string line;
+    for (size_t count = 0; count < maxCount && std::getline(strm, line); ) {
+        retLineNo++;
+        auto start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+        auto finish = line.find_last_not_of(" \t\r");
+        line = line.substr(start, finish - start + 1);
+        NETWORKIDENTITY ni;
+        if (line[0] == '{') {
+#ifdef ENABLE_JSON
+            nlohmann::json js = nlohmann::json::parse(line, nullptr, false);
+            if (js.is_discarded() || !json2NETWORKIDENTITY(ni, js))
+                return ERR_CODE_PARAM_INVALID;
+#else
+            return ERR_CODE_PARAM_INVALID;
+#endif
+        } else {
+            if (!string2NETWORKIDENTITY(ni, line.c_str()))
+                return ERR_CODE_PARAM_INVALID;
+        }
+        retVal.push_back(ni);
+        count++;
+    }
+    return CODE_OK;
+}
@@ -7,6 +7,7 @@
 
 #include <string>
 #include <vector>
+#include <istream>
 
 #include "lorawan/lorawan-types.h"
 #include "lorawan/storage/serialization/identity-serialization.h"
@@ -62,4 +63,20 @@ bool readNetId(
     const std::string &value
 );
 
+/**
+ * Read identities from stream, one identity per line: CSV "addr,activation,class,..." as in command line
+ * or JSON object (NDJSON). Empty lines and lines started with '#' are skipped.
+ * @param retVal identities appended
+ * @param strm stream to read
+ * @param maxCount read no more than maxCount identities
+ * @param retLineNo current line number, incremented
+ * @return CODE_OK, ERR_CODE_PARAM_INVALID if line is invalid. Nothing appended at the end of stream
+ */
+int readIdentities(
+    std::vector<NETWORKIDENTITY> &retVal,
+    std::istream &strm,
+    size_t maxCount,
+    size_t &retLineNo
+);
+
 #endif
@@ -26,6 +26,7 @@
 #define DAEMONIZE_CLOSE_FILE_DESCRIPTORS_AFTER_FORK true
 #endif
 
+#include "lorawan/storage/listener/reuse-port-listener.h"
 #include "cli-helper.h"
 
 #ifdef ENABLE_HTTP
@@ -115,11 +116,13 @@ public:
     enum IP_PROTO proto;
     std::string intf;
     uint16_t port;
+    int threads;    ///< UDP loops bound with SO_REUSEPORT
 #ifdef ENABLE_HTTP
     StorageListener *httpServer;
     std::string httpIntf;
     uint16_t httpPort;
     std::string httpHtmlRootDir;
+    int httpThreads;
 #endif
 #ifdef ENABLE_QRCODE
     StorageListener *httpQRCodeURNServer;
@@ -140,9 +143,9 @@ public:
     NETID netid;
 #endif
     CliServiceDescriptorNParams()
-        : storageType(ST_MEM), server(nullptr), proto(PROTO_UDP), port(4244),
+        : storageType(ST_MEM), server(nullptr), proto(PROTO_UDP), port(4244), threads(1),
 #ifdef ENABLE_HTTP
-        httpServer(nullptr), httpPort(4246),
+        httpServer(nullptr), httpPort(4246), httpThreads(1),
 #endif
 #ifdef ENABLE_QRCODE
           httpQRCodeURNServer(nullptr), httpQRCodeURNPort(4248),
@@ -159,6 +162,8 @@ public:
     std::string toString() const {
         std::stringstream ss;
         ss << _("Service: ") << intf << ":" << port << " " << IP_PROTO2string(proto) << "\n";
+        if (threads > 1)
+            ss << _("Threads: ") << threads << "\n";
 #ifdef ENABLE_HTTP
         ss << _("HTTP: ") << httpIntf << ":" << httpPort << "\n"
             << _("HTML page root directory: ") << (httpHtmlRootDir.empty() ? _("none") : httpHtmlRootDir) << "\n";
@@ -192,7 +197,13 @@ CliServiceDescriptorNParams svc;
 static void done() {
     if (svc.server) {
         svc.server->stop();
+        // JSON services rewrite own files on done()
         svc.server->identitySerialization->svc->flush();
+        svc.server->identitySerialization->svc->done();
+        if (svc.server->gatewaySerialization) {
+            svc.server->gatewaySerialization->svc->flush();
+            svc.server->gatewaySerialization->svc->done();
+        }
         delete svc.server;
         svc.server = nullptr;
         std::cerr << MSG_GRACEFULLY_STOPPED << std::endl;
@@ -276,18 +287,30 @@ void run() {
 
     auto identitySerialization = new IdentityBinarySerialization(identityService, svc.code, svc.accessCode);
     auto gatewaySerialization = new GatewayBinarySerialization(gatewayService, svc.code, svc.accessCode);
+    if (svc.threads > 1 && ReusePortListener::supported()) {
+        // UDP only, each loop has own serialization objects over the shared services, listener deletes them
+        auto l = new ReusePortListener(identitySerialization, gatewaySerialization);
+        for (int i = 1; i < svc.threads; i++) {
+            l->addLoop(new IdentityBinarySerialization(identityService, svc.code, svc.accessCode),
+                new GatewayBinarySerialization(gatewayService, svc.code, svc.accessCode));
+        }
+        svc.server = l;
+    } else {
 #ifdef ENABLE_LIBUV
-    svc.server = new UVListener(identitySerialization, gatewaySerialization);
+        svc.server = new UVListener(identitySerialization, gatewaySerialization);
 #else
-    svc.server = new UDPListener(identitySerialization, gatewaySerialization);
+        svc.server = new UDPListener(identitySerialization, gatewaySerialization);
 #endif
+    }
     svc.server->setAddress(svc.intf, svc.port);
     svc.server->setLog(svc.verbose, &svc);
 
 #ifdef ENABLE_HTTP
     auto identitySerializationJSON = new IdentityTextJSONSerialization(identityService, svc.code, svc.accessCode);
     auto gatewaySerializationJSON = new GatewayTextJSONSerialization(gatewayService, svc.code, svc.accessCode);
-    svc.httpServer = new HTTPListener(identitySerializationJSON, gatewaySerializationJSON, svc.httpHtmlRootDir);
+    auto httpListener = new HTTPListener(identitySerializationJSON, gatewaySerializationJSON, svc.httpHtmlRootDir);
+    httpListener->setThreadPool(svc.httpThreads);
+    svc.httpServer = httpListener;
     svc.httpServer->setAddress(svc.httpIntf, svc.httpPort);
     svc.httpServer->setLog(svc.verbose, &svc);
     svc.httpServer->run();
@@ -311,10 +334,12 @@ void run() {
 
 int main(int argc, char **argv) {
 	struct arg_str *a_interface_n_port = arg_str0(nullptr, nullptr, _("IP addr:port"), _("Default *:4244"));
+    struct arg_int *a_threads = arg_int0("t", "threads", _("<number>"), _("UDP loops bound to the same port. Default 1"));
 
 #ifdef ENABLE_HTTP
     struct arg_str *a_http_interface_n_port = arg_str0("h", "http", _("IP addr:port"), _("Default *:4246"));
     struct arg_str *a_http_html_root_dir = arg_str0("r", "root", _("<path>"), _("web root path. Default none"));
+    struct arg_int *a_http_threads = arg_int0(nullptr, "http-threads", _("<number>"), _("HTTP thread pool size. Default 1"));
 #endif
 #ifdef ENABLE_QRCODE
     struct arg_str *a_http_qrcode_urn_interface_n_port = arg_str0("q", "qr", _("IP addr:port"), _("Default *:4248"));
@@ -343,10 +368,10 @@ int main(int argc, char **argv) {
 
 
     void* argtable[] = {
-            a_interface_n_port,
+            a_interface_n_port, a_threads,
 #ifdef ENABLE_HTTP
             a_http_interface_n_port,
-            a_http_html_root_dir,
+            a_http_html_root_dir, a_http_threads,
 #endif
 #ifdef ENABLE_QRCODE
             a_http_qrcode_urn_interface_n_port,
@@ -388,6 +413,12 @@ int main(int argc, char **argv) {
         svc.intf = "*";
         svc.port = 4244;
     }
+    if (a_threads->count) {
+        svc.threads = *a_threads->ival;
+        if (svc.threads < 1)
+            svc.threads = 1;
+    } else
+        svc.threads = 1;
 
 #ifdef ENABLE_HTTP
     if (a_http_interface_n_port->count) {
@@ -400,6 +431,10 @@ int main(int argc, char **argv) {
         svc.httpHtmlRootDir = file::expandFileName(*a_http_html_root_dir->sval);
     else
         svc.httpHtmlRootDir = "";
+    if (a_http_threads->count && *a_http_threads->ival > 1)
+        svc.httpThreads = *a_http_threads->ival;
+    else
+        svc.httpThreads = 1;
 #endif
 
 #ifdef ENABLE_QRCODE
@@ -466,6 +501,15 @@ int main(int argc, char **argv) {
 	}
 	arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
 
+#ifdef ENABLE_LIBUV
+    // UDP loops can not replace libuv TCP endpoint
+    if (svc.threads > 1) {
+        std::cerr << ERR_MESSAGE << ERR_CODE_COMMAND_LINE << ": " << ERR_COMMAND_LINE
+            << _(". -t is not supported with TCP (libuv) listener") << std::endl;
+        return ERR_CODE_COMMAND_LINE;
+    }
+#endif
+
 #if defined(_MSC_VER) || defined(__MINGW32__)
     WSADATA wsaData;
     int r = WSAStartup(MAKEWORD(2, 2), &wsaData);
@@ -1,5 +1,6 @@
 #include <string>
 #include <iostream>
+#include <fstream>
 
 #include <sstream>
 #include <cstring>
@@ -44,12 +45,17 @@ public:
     uint64_t accessCode;
     uint32_t offset;
     uint8_t size;
+    std::string importFileName;
+    std::ifstream importFile;
+    std::istream *importStream;     ///< nullptr if no import
+    size_t importLineNo;
+    size_t importCount;
 
     int32_t retCode;
 
     CliQueryParams()
         : tag(QUERY_GATEWAY_NONE), queryPos(0), useTcp(false), verbose(0), port(DEF_PORT), code(42), accessCode(42), offset(0), size(0),
-          retCode(0)
+          importStream(nullptr), importLineNo(0), importCount(0), retCode(0)
     {
 
     }
@@ -60,6 +66,8 @@ public:
             << _("Service: ") << intf << ":" << port << " " << (useTcp ? "TCP" : "UDP") << " "
             << _("command: ") << commandLongName(tag) << _(", code: ") << std::hex << code << _(", access code: ")  << accessCode << " "
             << _("offset: ") << std::dec << offset << _(", size: ")  << (int) size << "\n";
+        if (!importFileName.empty())
+            ss << _("Import from: ") << importFileName << "\n";
         for (auto & it : query) {
             if (it.hasDevice) {
                 if (!it.nid.value.devaddr.empty())
@@ -123,6 +131,21 @@ public:
         QueryClient* client,
         const IdentityOperationResponse *response
     ) override {
+        if (response && (response->tag == QUERY_IDENTITY_ASSIGN_BATCH || response->tag == QUERY_IDENTITY_RM_BATCH)) {
+            // batch response is count of processed identities or error code
+            if (response->response < 0) {
+                std::cerr << ERR_MESSAGE << response->response << _(", line ") << params.importLineNo << std::endl;
+                params.retCode = response->response;
+                client->stop();
+                return;
+            }
+            params.importCount += response->response;
+            if (params.verbose > 1)
+                std::cerr << params.importCount << _(" identities processed") << std::endl;
+            if (!next(client))
+                client->stop();
+            return;
+        }
         if (response) {
             if (params.verbose) {
                 if (response->response != 0)
@@ -242,9 +265,48 @@ public:
         }
     }
 
+    /**
+     * Read next batch of the imported identities
+     * @return nullptr if there are no more identities or an error occurred
+     */
+    static ServiceMessage *nextImportBatch() {
+        std::vector<NETWORKIDENTITY> batch;
+        int r = readIdentities(batch, *params.importStream, MAX_IDENTITY_BATCH_SIZE, params.importLineNo);
+        if (r) {
+            std::cerr << ERR_MESSAGE << r << ": " << strerror_lorawan_ns(r) << _(", line ") << params.importLineNo << std::endl;
+            params.retCode = r;
+            return nullptr;
+        }
+        if (batch.empty())
+            return nullptr;
+        if (params.tag == QUERY_IDENTITY_RM) {
+            auto req = new IdentityRmBatchRequest(params.code, params.accessCode);
+            req->addrs.reserve(batch.size());
+            for (auto &it : batch) {
+                req->addrs.push_back(it.value.devaddr);
+            }
+            return req;
+        }
+        auto req = new IdentityAssignBatchRequest(params.code, params.accessCode);
+        req->identities = batch;
+        return req;
+    }
+
     bool next(
         QueryClient *client
     ) {
+        if (params.importStream) {
+            ServiceMessage *req = nextImportBatch();
+            if (!req) {
+                if (params.verbose && params.retCode == CODE_OK)
+                    std::cerr << params.importCount << _(" identities processed") << std::endl;
+                return false;
+            }
+            ServiceMessage *previousMessage = client->request(req);
+            if (previousMessage)
+                delete previousMessage;
+            return true;
+        }
         bool hasNext = params.queryPos < query.size();
         ServiceMessage *req = nullptr;
         if (hasNext) {
@@ -341,6 +403,7 @@ int main(int argc, char **argv) {
 	struct arg_lit *a_tcp = arg_lit0("t", "tcp", _("use TCP protocol. Default UDP"));
     struct arg_int *a_offset = arg_int0("o", "offset", _("<0..>"), _("list offset. Default 0. Max 4294967295"));
     struct arg_int *a_size = arg_int0("z", "size", _("<number>"), _("list size limit. Default 10. Max 255"));
+    struct arg_str *a_import = arg_str0("i", "import", _("<file | ->"), _("assign or remove identities listed in the CSV or NDJSON file, - stdin"));
     struct arg_lit *a_verbose = arg_litn("v", "verbose", 0, 2, _("-v verbose -vv debug"));
     struct arg_lit *a_help = arg_lit0("h", "help", _("Show this help"));
 	struct arg_end *a_end = arg_end(20);
@@ -348,7 +411,7 @@ int main(int argc, char **argv) {
 	void* argtable[] = { 
 		a_query, a_interface_n_port,
         a_code, a_access_code, a_tcp,
-        a_offset, a_size, a_verbose,
+        a_offset, a_size, a_import, a_verbose,
 		a_help, a_end 
 	};
 
@@ -445,6 +508,23 @@ int main(int argc, char **argv) {
             params.size = 10;
     }
 
+    if (a_import->count) {
+        params.importFileName = *a_import->sval;
+        if (params.tag != QUERY_IDENTITY_ASSIGN && params.tag != QUERY_IDENTITY_RM) {
+            std::cerr << _("Import requires p or r command") << std::endl;
+            errorCount++;
+        } else {
+            if (params.importFileName == "-")
+                params.importStream = &std::cin;
+            else {
+                params.importFile.open(params.importFileName);
+                if (!params.importFile.is_open())
+                    return ERR_CODE_OPEN_DEVICE;
+                params.importStream = &params.importFile;
+            }
+        }
+    }
+
     if (params.tag == QUERY_GATEWAY_ASSIGN) {
         // reorder query
         mergeIdAddress(params.query);
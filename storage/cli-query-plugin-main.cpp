@@ -1,5 +1,6 @@
 #include <string>
 #include <iostream>
+#include <fstream>
 
 #include <sstream>
 
@@ -42,10 +43,13 @@ public:
     NETID netid;
     std::string db;
     std::string dbGatewayJson;
+    std::string importFileName;
+    size_t batchSize;
+    bool journal;
 
     CliQueryParams()
         : tag(QUERY_GATEWAY_NONE), queryPos(0), verbose(0), offset(0), size(0),
-          retCode(0), netid(0, 0)
+          retCode(0), netid(0, 0), batchSize(0), journal(false)
     {
 
     }
@@ -62,6 +66,8 @@ public:
         if (!dbGatewayJson.empty())
             ss << _(". gateway database file name: ") << dbGatewayJson;
 #endif
+        if (!importFileName.empty())
+            ss << _(". Import from: ") << importFileName << _(", batch size: ") << batchSize;
         ss << " "
             << _("command: ") << commandLongName(tag)
             << _(", offset: ") << std::dec << offset << _(", size: ")  << (int) size << "\n";
@@ -86,6 +92,54 @@ static CliQueryParams params;
 
 #define DEF_PLUGIN  "json"
 #define DEF_MASTERKEY   "masterkey"
+#define DEF_BATCH_SIZE  10000
+
+/**
+ * Assign or remove identities read from the file (or stdin if file name is "-") by batches
+ * @return CODE_OK or error code
+ */
+static int importIdentities(
+    IdentityService *svc
+)
+{
+    std::ifstream f;
+    std::istream *strm = &std::cin;
+    if (params.importFileName != "-") {
+        f.open(params.importFileName);
+        if (!f.is_open())
+            return ERR_CODE_OPEN_DEVICE;
+        strm = &f;
+    }
+    size_t count = 0;
+    size_t lineNo = 0;
+    std::vector<NETWORKIDENTITY> batch;
+    batch.reserve(params.batchSize);
+    std::vector<DEVADDR> addrs;
+    int r;
+    while (true) {
+        batch.clear();
+        r = readIdentities(batch, *strm, params.batchSize, lineNo);
+        if (r || batch.empty())
+            break;
+        if (params.tag == QUERY_IDENTITY_RM) {
+            addrs.clear();
+            for (auto &it : batch) {
+                addrs.push_back(it.value.devaddr);
+            }
+            r = svc->rmBatch(addrs);
+        } else
+            r = svc->putBatch(batch);
+        if (r)
+            break;
+        count += batch.size();
+    }
+    if (r)
+        std::cerr << ERR_MESSAGE << r << ": " << strerror_lorawan_ns(r) << _(", line ") << lineNo << std::endl;
+    else
+        if (params.verbose)
+            std::cerr << count << _(" identities processed") << std::endl;
+    return r;
+}
 
 static void run()
 {
@@ -98,6 +152,12 @@ static void run()
         params.retCode = ERR_CODE_LOAD_PLUGINS_FAILED;
         return;
     }
+    if (params.journal) {
+        // 3- keep changes of the memory storage in the journal and snapshot
+        c->svcIdentity->setOption(3, &params.journal);
+        if (c->svcGateway)
+            c->svcGateway->setOption(3, &params.journal);
+    }
     if (!params.db.empty())
         c->svcIdentity->init(params.db, nullptr);
     else
@@ -152,11 +212,19 @@ static void run()
         }
             break;
         case QUERY_IDENTITY_ASSIGN:
+            if (!params.importFileName.empty()) {
+                params.retCode = importIdentities(c->svcIdentity);
+                break;
+            }
             for (auto &it: params.query) {
                 c->svcIdentity->put(it.nid.value.devaddr, it.nid.value.devid);
             }
             break;
         case QUERY_IDENTITY_RM:
+            if (!params.importFileName.empty()) {
+                params.retCode = importIdentities(c->svcIdentity);
+                break;
+            }
             for (auto &it: params.query) {
                 c->svcIdentity->rm(it.nid.value.devaddr);
             }
@@ -235,6 +303,9 @@ int main(int argc, char **argv) {
     struct arg_int *a_size = arg_int0("z", "size", "<number>", _("list size limit. Default 10. Max 255"));
     struct arg_str* a_pass_phrase = arg_str0("m", "masterkey", _("<pass-phrase>"), _("Default " DEF_MASTERKEY));
     struct arg_str *a_net_id = arg_str0("n", "network-id", _("<hex|hex:hex>"), _("Hexadecimal <network-id> or <net-type>:<net-id>. Default 0"));
+    struct arg_str *a_import = arg_str0("i", "import", _("<file | ->"), _("assign or remove identities listed in the CSV or NDJSON file, - stdin"));
+    struct arg_int *a_batch_size = arg_int0("b", "batch", "<number>", _("import batch size. Default 10000"));
+    struct arg_lit *a_journal = arg_lit0("j", "journal", _("memory storage keeps changes in <database file>.journal"));
     struct arg_lit *a_verbose = arg_litn("v", "verbose", 0, 2, _("-v verbose -vv debug"));
     struct arg_lit *a_help = arg_lit0("h", "help", _("Show this help"));
 	struct arg_end *a_end = arg_end(20);
@@ -245,6 +316,7 @@ int main(int argc, char **argv) {
         a_gateway_json_db,
 #endif
         a_offset, a_size, a_pass_phrase, a_net_id,
+        a_import, a_batch_size, a_journal,
         a_verbose,
         a_help, a_end
 	};
@@ -258,6 +330,7 @@ int main(int argc, char **argv) {
 	int errorCount = arg_parse(argc, argv, argtable);
 
     params.verbose = a_verbose->count;
+    params.journal = a_journal->count > 0;
 
     if (a_db->count)
         params.db = *a_db->sval;
@@ -352,6 +425,17 @@ int main(int argc, char **argv) {
             params.size = 10;
     }
 
+    if (a_import->count) {
+        params.importFileName = *a_import->sval;
+        params.batchSize = DEF_BATCH_SIZE;
+        if (a_batch_size->count && *a_batch_size->ival > 0)
+            params.batchSize = (size_t) *a_batch_size->ival;
+        if (params.tag != QUERY_IDENTITY_ASSIGN && params.tag != QUERY_IDENTITY_RM) {
+            std::cerr << _("Import requires p or r command") << std::endl;
+            errorCount++;
+        }
+    }
+
     if (params.tag == QUERY_GATEWAY_ASSIGN) {
         // reorder query
         mergeIdAddress(params.query);
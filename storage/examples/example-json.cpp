@@ -18,7 +18,7 @@ static void printIdentity(
         std::cout << it.toString() << std::endl;
     }
     // rewrite file
-    c.flush();
+    c.done();
 }
 
 static void printGateway(
@@ -33,7 +33,7 @@ static void printGateway(
         std::cout << it.toString() << std::endl;
     }
     // rewrite file
-    c.flush();
+    c.done();
 }
 
 int main(int argc, char *argv[])
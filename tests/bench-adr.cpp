@@ -0,0 +1,127 @@
+/**
+ * ADR simulation benchmark.
+ * Devices are placed at random link budget and start at DR0 with max TX power. Each device sends uplinks
+ * heard by one to three gateways with random fading, network server answers each uplink with a downlink
+ * carrying LinkADRReq if AdrEngine decides so, and device applies it.
+ * Prints JSON: aggregate airtime and lost uplinks (SNR below demodulation floor) without and with ADR,
+ * and nanoseconds AdrEngine spends per uplink.
+ * Usage: bench-adr [devices]
+ */
+#include <iostream>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#include "lorawan/task/adr-engine.h"
+#include "gen/regional-parameters-3.h"
+
+#define DEF_DEVICES         1000
+#define UPLINKS_PER_DEVICE  200
+#define PHY_PAYLOAD_SIZE    24      ///< 13 bytes header and MIC, 11 bytes payload
+#define FADING_DB           2.0
+
+class SimDevice {
+public:
+    DEVADDR addr;
+    float snr;          ///< SNR at max TX power
+    uint8_t dataRate;
+    uint8_t txPower;
+};
+
+class SimResult {
+public:
+    double airtimeMs;
+    size_t uplinks;
+    size_t lost;
+    size_t commands;
+    double nsPerUplink;
+
+    std::string toJsonString() const
+    {
+        std::stringstream ss;
+        ss << R"({"airtimeMs": )" << airtimeMs << R"(, "uplinks": )" << uplinks
+            << R"(, "lost": )" << lost << R"(, "commands": )" << commands
+            << R"(, "nsPerUplink": )" << nsPerUplink << "}";
+        return ss.str();
+    }
+};
+
+static SimResult simulate(
+    std::vector<SimDevice> devices,
+    const RegionalParameterChannelPlan *plan,
+    bool adrOn
+)
+{
+    const REGIONAL_PARAMETER_CHANNEL_PLAN *p = plan->get();
+    std::mt19937 rnd(42);
+    std::normal_distribution<float> fading(0, FADING_DB);
+    std::uniform_int_distribution<int> gateways(1, 3);
+    AdrEngine adr;
+    SimResult r {};
+    std::chrono::steady_clock::duration spent(0);
+    uint8_t fOpts[15];
+    for (uint16_t f = 0; f < UPLINKS_PER_DEVICE; f++) {
+        for (auto &d : devices) {
+            const DATA_RATE &rate = p->dataRates[d.dataRate].value;
+            r.airtimeMs += AdrEngine::airtimeMilliseconds(rate.spreadingFactor, rate.bandwidth, PHY_PAYLOAD_SIZE);
+            r.uplinks++;
+            float snr = d.snr + (float) p->txPowerOffsets[d.txPower];
+            bool received = false;
+            int gw = gateways(rnd);
+            auto started = std::chrono::steady_clock::now();
+            for (int g = 0; g < gw; g++) {
+                float s = snr + fading(rnd) - (float) g * 3;
+                if (s < AdrEngine::requiredSnr(rate.spreadingFactor))
+                    continue;
+                received = true;
+                if (!adrOn)
+                    continue;
+                SEMTECH_PROTOCOL_METADATA_RX rx {};
+                rx.modu = MODULATION_LORA;
+                rx.bandwidth = rate.bandwidth;
+                rx.spreadingFactor = rate.spreadingFactor;
+                rx.lsnr = s;
+                adr.add(d.addr, f, rx, plan);
+            }
+            if (!received) {
+                r.lost++;
+                continue;
+            }
+            if (adrOn && adr.linkADRReq(fOpts, sizeof(fOpts), d.addr, plan)) {
+                r.commands++;
+                d.dataRate = (uint8_t) (fOpts[1] >> 4);
+                d.txPower = (uint8_t) (fOpts[1] & 0xf);
+            }
+            spent += std::chrono::steady_clock::now() - started;
+        }
+    }
+    r.nsPerUplink = std::chrono::duration<double, std::nano>(spent).count() / (double) r.uplinks;
+    return r;
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : DEF_DEVICES;
+    if (!count)
+        count = DEF_DEVICES;
+    const RegionalParameterChannelPlan *eu = regionalParameterChannelPlanMem.get("EU868");
+    // SNR at max TX power: from the cell edge (SF12 barely works) to close devices
+    std::mt19937 rnd(1);
+    std::uniform_real_distribution<float> snr(-16.0f, 10.0f);
+    std::vector<SimDevice> devices(count);
+    for (size_t i = 0; i < count; i++) {
+        devices[i].addr = DEVADDR((uint32_t) (0x26000000 + i));
+        devices[i].snr = snr(rnd);
+        devices[i].dataRate = 0;
+        devices[i].txPower = 0;
+    }
+    SimResult off = simulate(devices, eu, false);
+    SimResult on = simulate(devices, eu, true);
+    std::cout << R"({"devices": )" << count
+        << R"(, "adrOff": )" << off.toJsonString()
+        << R"(, "adrOn": )" << on.toJsonString()
+        << R"(, "airtimeRatio": )" << on.airtimeMs / off.airtimeMs
+        << "}" << std::endl;
+    return 0;
+}
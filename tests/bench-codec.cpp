@@ -0,0 +1,62 @@
+/**
+ * base64 and hex codec microbenchmark.
+ * Encode and decode random payloads of 10..255 bytes by each supported code level and
+ * by third-party base64 as the baseline, print nanoseconds per payload as JSON (see bench-helper.h).
+ * Usage: bench-codec [iterations]
+ */
+#include <string>
+#include <vector>
+#include <random>
+
+#include "lorawan/helper/codec-helper.h"
+#include "base64/base64.h"
+#include "bench-helper.h"
+
+#define MIN_PAYLOAD_SIZE    10
+#define MAX_PAYLOAD_SIZE    255
+#define PAYLOAD_COUNT       1024
+#define DEF_ITERATIONS      40
+
+int main(int argc, char **argv) {
+    std::mt19937 rnd(42);
+    std::uniform_int_distribution<size_t> sizeDist(MIN_PAYLOAD_SIZE, MAX_PAYLOAD_SIZE);
+    std::vector<std::string> payloads(PAYLOAD_COUNT), base64s(PAYLOAD_COUNT), hexes(PAYLOAD_COUNT);
+    for (size_t i = 0; i < PAYLOAD_COUNT; i++) {
+        payloads[i].resize(sizeDist(rnd));
+        for (auto &c : payloads[i]) {
+            c = (char) (rnd() & 0xff);
+        }
+        base64s[i] = base64_encode(payloads[i]);
+        hexes[i].resize(payloads[i].size() * 2);
+        hexEncode(&hexes[i][0], payloads[i].c_str(), payloads[i].size());
+    }
+    char enc[BASE64_ENCODED_SIZE(MAX_PAYLOAD_SIZE) + MAX_PAYLOAD_SIZE * 2];
+    char dec[MAX_PAYLOAD_SIZE + 3];
+
+    BenchPrinter bench(argc, argv, DEF_ITERATIONS);
+    bench.run("base64Encode", "third-party", PAYLOAD_COUNT, [&](size_t i) {
+        return base64_encode(payloads[i]).size();
+    });
+    bench.run("base64Decode", "third-party", PAYLOAD_COUNT, [&](size_t i) {
+        return base64_decode(base64s[i]).size();
+    });
+
+    int maxLevel = setCodecLevel(CODEC_LEVEL_AVX2);
+    for (int level = CODEC_LEVEL_SCALAR; level <= maxLevel; level++) {
+        const char *levelName = codecLevelName(setCodecLevel(level));
+        bench.run("base64Encode", levelName, PAYLOAD_COUNT, [&](size_t i) {
+            return base64Encode(enc, payloads[i].c_str(), payloads[i].size());
+        });
+        bench.run("base64Decode", levelName, PAYLOAD_COUNT, [&](size_t i) {
+            return base64Decode(dec, sizeof(dec), base64s[i].c_str(), base64s[i].size());
+        });
+        bench.run("hexEncode", levelName, PAYLOAD_COUNT, [&](size_t i) {
+            return hexEncode(enc, payloads[i].c_str(), payloads[i].size());
+        });
+        bench.run("hexDecode", levelName, PAYLOAD_COUNT, [&](size_t i) {
+            return hexDecode(dec, sizeof(dec), hexes[i].c_str(), hexes[i].size());
+        });
+    }
+    setCodecLevel(maxLevel);
+    return 0;
+}
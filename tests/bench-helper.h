@@ -0,0 +1,142 @@
+#ifndef BENCH_HELPER_H
+#define BENCH_HELPER_H
+
+/**
+ * Microbenchmark helpers used by bench-* programs.
+ * Each program prints JSON array of results to stdout:
+ * [{"name": "parse", "variant": "push-data", "ops": 100000, "nsPerOp": 812.4, "minNsPerOp": 801.2}, ...]
+ * nsPerOp is median of BENCH_REPEATS runs, inputs are generated with fixed seeds so results are comparable
+ * between releases built with the same compiler and options.
+ */
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+#define BENCH_REPEATS   5
+
+/**
+ * Prevent optimizer removing benchmarked calls
+ */
+static volatile size_t benchSink = 0;
+
+/**
+ * Measure f(i), i = 0..count-1 in each of iterations runs. reset() is called before each run and is not measured.
+ * @return nanoseconds per f() call: median and minimum of BENCH_REPEATS measurements
+ */
+template <class F, class R>
+static void benchMeasure(
+    double &retMedian,
+    double &retMin,
+    size_t iterations,
+    size_t count,
+    F f,
+    R reset
+)
+{
+    std::vector<double> ns;
+    // warm up caches and lazy initialized data
+    reset();
+    for (size_t i = 0; i < count; i++) {
+        benchSink += (size_t) f(i);
+    }
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        std::chrono::steady_clock::duration d(0);
+        size_t s = 0;
+        for (size_t it = 0; it < iterations; it++) {
+            reset();
+            auto started = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < count; i++) {
+                s += (size_t) f(i);
+            }
+            d += std::chrono::steady_clock::now() - started;
+        }
+        benchSink += s;
+        ns.push_back(std::chrono::duration<double, std::nano>(d).count() / (double) (iterations * count));
+    }
+    std::sort(ns.begin(), ns.end());
+    retMedian = ns[ns.size() / 2];
+    retMin = ns[0];
+}
+
+class BenchPrinter {
+private:
+    bool isFirst;
+    size_t iterations;
+public:
+    /**
+     * @param argc command line argument count
+     * @param argv optional first argument is iterations count
+     * @param defIterations default iterations count
+     */
+    BenchPrinter(
+        int argc,
+        char **argv,
+        size_t defIterations
+    )
+        : isFirst(true), iterations(argc > 1 ? strtoul(argv[1], nullptr, 10) : defIterations)
+    {
+        if (!iterations)
+            iterations = defIterations;
+        std::cout << "[\n";
+    }
+
+    ~BenchPrinter()
+    {
+        std::cout << "\n]" << std::endl;
+    }
+
+    template <class F, class R>
+    void run(
+        const char *name,
+        const char *variant,
+        size_t count,
+        F f,
+        R reset
+    )
+    {
+        double median, minimum;
+        benchMeasure(median, minimum, iterations, count, f, reset);
+        print(name, variant, iterations * count, median, minimum);
+    }
+
+    /**
+     * Print result measured by the caller, e.g. throughput of many threads
+     */
+    void print(
+        const char *name,
+        const char *variant,
+        size_t ops,
+        double nsPerOp,
+        double minNsPerOp
+    )
+    {
+        if (isFirst)
+            isFirst = false;
+        else
+            std::cout << ",\n";
+        std::cout << R"({"name": ")" << name << R"(", "variant": ")" << variant
+            << R"(", "ops": )" << ops
+            << ", \"nsPerOp\": " << nsPerOp << ", \"minNsPerOp\": " << minNsPerOp << "}";
+    }
+
+    size_t getIterations() const
+    {
+        return iterations;
+    }
+
+    template <class F>
+    void run(
+        const char *name,
+        const char *variant,
+        size_t count,
+        F f
+    )
+    {
+        run(name, variant, count, f, [] {});
+    }
+};
+
+#endif
@@ -0,0 +1,290 @@
+/**
+ * Network server hot path microbenchmark.
+ * Parse PUSH_DATA, make PULL_RESP, calculate MIC, encrypt payload, put uplinks from several gateways to the
+ * message queue, look up identities in each built identity service backend and serialize queue item to JSON.
+ * Print nanoseconds per operation as JSON (see bench-helper.h).
+ * Usage: bench-hot-path [iterations]
+ */
+#include <string>
+#include <vector>
+#include <random>
+#include <cstring>
+#include <fstream>
+
+#include "lorawan/lorawan-error.h"
+#include "lorawan/lorawan-const.h"
+#include "lorawan/lorawan-string.h"
+#include "lorawan/lorawan-mic.h"
+#include "lorawan/helper/aes-helper.h"
+#include "lorawan/helper/file-helper.h"
+#include "lorawan/proto/gw/basic-udp.h"
+#include "lorawan/proto/gw/parse-result.h"
+#include "lorawan/task/message-queue.h"
+#include "lorawan/task/message-queue-item.h"
+#include "lorawan/task/task-udp-socket.h"
+#include "lorawan/storage/service/identity-service-gen.h"
+#include "lorawan/storage/service/identity-service-mem.h"
+#include "lorawan/storage/service/identity-service-json.h"
+#include "lorawan/storage/service/storage-snapshot.h"
+#include "lorawan/storage/service/storage-journal.h"
+#ifdef ENABLE_SQLITE
+#include "lorawan/storage/service/identity-service-sqlite.h"
+#endif
+#ifdef ENABLE_LMDB
+#include "lorawan/storage/service/identity-service-lmdb.h"
+#endif
+
+#include "bench-helper.h"
+
+#define DEF_ITERATIONS      10
+#define PACKET_COUNT        1000
+#define DEVICE_COUNT        10000
+#define GATEWAY_COUNT       3
+#define LOOKUP_COUNT        10000
+// getNetworkIdentity() scans all identities in memory backends
+#define EUI_LOOKUP_COUNT    1000
+#define FILTER_COUNT        100
+
+static const std::string IDENTITY_JSON_FILE_NAME("bench-identity.json");
+static const std::string IDENTITY_SQLITE_FILE_NAME("bench-identity.db");
+static const std::string IDENTITY_LMDB_DIR_NAME("bench-identity-lmdb");
+
+// PUSH_DATA with one rxpk, see test-decode-rxpk.cpp
+static const char *PUSH_DATA_HEX = "02bbe50000006cc3743eed467b227278706b223a5b7b22746d7374223a343032333131313534302c"
+    "226368616e223a332c2272666368223a302c2266726571223a3836342e3730303030302c2273746174223a312c226d6f6475223a22"
+    "4c4f5241222c2264617472223a22534631324257313235222c22636f6472223a22342f35222c226c736e72223a2d31382e352c2272"
+    "737369223a2d3132312c2273697a65223a33372c2264617461223a22514441445251474151774143334749312b374553394d697030"
+    "356a436c6f536f464e367a634b65437877394d7357457634513d3d227d5d7d";
+
+static void benchProtocol(
+    BenchPrinter &bench,
+    GatewayBasicUdpProtocol &proto,
+    const std::string &pushData
+)
+{
+    char buf[1024];
+    ParseResult pr;
+    TASK_TIME t = TASK_CLOCK::now();
+    bench.run("parse", "push-data", PACKET_COUNT, [&](size_t) {
+        // parse() converts prefix byte order in place
+        memmove(buf, pushData.c_str(), pushData.size());
+        return proto.parse(pr, buf, pushData.size(), t);
+    });
+
+    // confirmation downlink is the most frequent PULL_RESP
+    memmove(buf, pushData.c_str(), pushData.size());
+    proto.parse(pr, buf, pushData.size(), t);
+    TaskDescriptor td;
+    GenIdentityService gen("bench");
+    DEVICEID did;
+    gen.get(did, pr.gwPushData.rxData.data.uplink.devaddr);
+    td.deviceId = NetworkIdentity(pr.gwPushData.rxData.data.uplink.devaddr, did);
+    ConfirmationMessage msg(pr.gwPushData.rxData, td);
+    SEMTECH_PROTOCOL_METADATA_TX tx {};
+    tx.freq_hz = 869525000;
+    tx.tx_mode = 1;
+    tx.count_us = pr.gwPushData.rxMetadata.tmst;
+    tx.rf_power = 14;
+    tx.modulation = MODULATION_LORA;
+    tx.bandwidth = BANDWIDTH_INDEX_125KHZ;
+    tx.datarate = DRLORA_SF12;
+    tx.coderate = CRLORA_4_5;
+    tx.invert_pol = true;
+    tx.preamble = 8;
+    DEVEUI gwId(pr.gwId);
+    bench.run("makePull", "confirmation", PACKET_COUNT, [&](size_t i) {
+        return proto.makePull(buf, sizeof(buf), gwId, msg, (uint16_t) i, &tx, nullptr, nullptr);
+    });
+}
+
+static void benchCrypto(
+    BenchPrinter &bench
+)
+{
+    std::mt19937 rnd(42);
+    DEVADDR addr(0x01450330);
+    KEY128 key;
+    for (size_t i = 0; i < sizeof(key.c); i++) {
+        key.c[i] = (uint8_t) rnd();
+    }
+    uint8_t data[255];
+    for (auto &c : data) {
+        c = (uint8_t) rnd();
+    }
+    static const size_t SIZES[] = { 16, 51, 222 };
+    static const char *SIZE_NAMES[] = { "16", "51", "222" };
+    for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++) {
+        size_t sz = SIZES[s];
+        bench.run("calculateMICFrmPayload", SIZE_NAMES[s], PACKET_COUNT, [&](size_t i) {
+            return calculateMICFrmPayload(data, (unsigned char) sz, (unsigned) i, LORAWAN_UPLINK, addr, key);
+        });
+        bench.run("encryptPayload", SIZE_NAMES[s], PACKET_COUNT, [&](size_t i) {
+            encryptPayload(data, sz, (unsigned) i, LORAWAN_UPLINK, addr, key);
+            return data[0];
+        });
+    }
+}
+
+static void benchMessageQueue(
+    BenchPrinter &bench,
+    GatewayBasicUdpProtocol &proto,
+    const std::string &pushData
+)
+{
+    char buf[1024];
+    ParseResult pr;
+    TASK_TIME t = TASK_CLOCK::now();
+    memmove(buf, pushData.c_str(), pushData.size());
+    proto.parse(pr, buf, pushData.size(), t);
+
+    // each device uplink is received by GATEWAY_COUNT gateways
+    std::vector<GwPushData> uplinks;
+    for (uint32_t d = 0; d < DEVICE_COUNT; d++) {
+        for (uint64_t g = 0; g < GATEWAY_COUNT; g++) {
+            GwPushData u = pr.gwPushData;
+            u.rxData.data.uplink.devaddr = DEVADDR(d + 1);
+            u.rxMetadata.gatewayId = pr.gwId.u + g;
+            uplinks.push_back(u);
+        }
+    }
+    TaskUDPSocket socket(INADDR_LOOPBACK, 4242);
+    struct sockaddr srcAddr {};
+    MessageQueue queue;
+    bench.run("putUplink", "3 gateways", uplinks.size(), [&](size_t i) {
+        return queue.putUplink(t, &socket, srcAddr, uplinks[i], &proto);
+    }, [&] {
+        queue.uplinkMessages.clear();
+    });
+    // queue already has all uplinks, only metadata is updated
+    bench.run("putUplink", "duplicate", uplinks.size(), [&](size_t i) {
+        return queue.putUplink(t, &socket, srcAddr, uplinks[i], &proto);
+    });
+
+    auto item = queue.getUplink(DEVADDR(1));
+    bench.run("MessageQueueItem::toJsonString", "3 gateways", PACKET_COUNT / 10, [&](size_t) {
+        return item ? item->toJsonString().size() : 0;
+    });
+}
+
+static void benchIdentityService(
+    BenchPrinter &bench,
+    const char *variant,
+    IdentityService &svc,
+    const std::vector<DEVADDR> &addrs,
+    const std::vector<DEVEUI> &euis
+)
+{
+    DEVICEID did;
+    if (svc.get(did, addrs[0]) == CODE_OK) {
+        bench.run("IdentityService::get", variant, addrs.size(), [&](size_t i) {
+            return svc.get(did, addrs[i]);
+        });
+    }
+    NETWORKIDENTITY nid;
+    if (svc.getNetworkIdentity(nid, euis[0]) == CODE_OK) {
+        bench.run("IdentityService::getNetworkIdentity", variant, euis.size(), [&](size_t i) {
+            return svc.getNetworkIdentity(nid, euis[i]);
+        });
+    }
+    std::vector<NETWORK_IDENTITY_FILTER> addrRange;
+    std::string expression = "addr >= 00001000 and addr < 00001100";
+    string2NETWORK_IDENTITY_FILTERS(addrRange, expression.c_str(), expression.size());
+    std::vector<NETWORK_IDENTITY_FILTER> scan;
+    expression = "class = C and activation = ABP";
+    string2NETWORK_IDENTITY_FILTERS(scan, expression.c_str(), expression.size());
+    std::vector<NETWORKIDENTITY> found;
+    bench.run("IdentityService::filter address range", variant, FILTER_COUNT, [&](size_t i) {
+        found.clear();
+        return svc.filter(found, addrRange, 0, 100);
+    });
+    bench.run("IdentityService::filter scan", variant, FILTER_COUNT, [&](size_t i) {
+        found.clear();
+        return svc.filter(found, scan, 0, 100);
+    });
+}
+
+static void fillIdentityService(
+    IdentityService &svc,
+    GenIdentityService &gen
+)
+{
+    DEVICEID did;
+    for (uint32_t d = 1; d <= DEVICE_COUNT; d++) {
+        DEVADDR a(d);
+        gen.get(did, a);
+        svc.put(a, did);
+    }
+    svc.flush();
+}
+
+static void benchIdentityServices(
+    BenchPrinter &bench
+)
+{
+    GenIdentityService gen("bench");
+    std::mt19937 rnd(42);
+    std::vector<DEVADDR> addrs;
+    std::vector<DEVEUI> euis;
+    for (size_t i = 0; i < LOOKUP_COUNT; i++) {
+        DEVADDR a((uint32_t) (rnd() % DEVICE_COUNT + 1));
+        DEVICEID did;
+        gen.get(did, a);
+        addrs.push_back(a);
+        if (i < EUI_LOOKUP_COUNT)
+            euis.push_back(did.id.devEUI);
+    }
+    benchIdentityService(bench, "gen", gen, addrs, euis);
+
+    MemoryIdentityService mem;
+    mem.init("", nullptr);
+    fillIdentityService(mem, gen);
+    benchIdentityService(bench, "memory", mem, addrs, euis);
+    mem.done();
+
+    std::ofstream f(IDENTITY_JSON_FILE_NAME);
+    f << "[]";
+    f.close();
+    JsonIdentityService json;
+    if (json.init(IDENTITY_JSON_FILE_NAME, nullptr) == CODE_OK) {
+        fillIdentityService(json, gen);
+        benchIdentityService(bench, "json", json, addrs, euis);
+    }
+    json.done();
+    file::rmFile(IDENTITY_JSON_FILE_NAME);
+    file::rmFile(IDENTITY_JSON_FILE_NAME + SNAPSHOT_FILE_SUFFIX);
+    file::rmFile(IDENTITY_JSON_FILE_NAME + JOURNAL_FILE_SUFFIX);
+
+#ifdef ENABLE_SQLITE
+    file::rmFile(IDENTITY_SQLITE_FILE_NAME);
+    SqliteIdentityService sqlite;
+    if (sqlite.init(IDENTITY_SQLITE_FILE_NAME, nullptr) == CODE_OK) {
+        fillIdentityService(sqlite, gen);
+        benchIdentityService(bench, "sqlite", sqlite, addrs, euis);
+    }
+    sqlite.done();
+    file::rmFile(IDENTITY_SQLITE_FILE_NAME);
+#endif
+
+#ifdef ENABLE_LMDB
+    file::rmAllDir(IDENTITY_LMDB_DIR_NAME.c_str());
+    LMDBIdentityService lmdb;
+    if (lmdb.init(IDENTITY_LMDB_DIR_NAME, nullptr) == CODE_OK) {
+        fillIdentityService(lmdb, gen);
+        benchIdentityService(bench, "lmdb", lmdb, addrs, euis);
+    }
+    lmdb.done();
+    file::rmAllDir(IDENTITY_LMDB_DIR_NAME.c_str());
+#endif
+}
+
+int main(int argc, char **argv) {
+    GatewayBasicUdpProtocol proto(nullptr);
+    std::string pushData = hex2string(PUSH_DATA_HEX);
+
+    BenchPrinter bench(argc, argv, DEF_ITERATIONS);
+    benchProtocol(bench, proto, pushData);
+    benchCrypto(bench);
+    benchMessageQueue(bench, proto, pushData);
+    benchIdentityServices(bench);
+    return 0;
+}
@@ -0,0 +1,209 @@
+/**
+ * Memory identity service lookup microbenchmark.
+ * Measure get() of one thread and lookups of 1, 2, 4 and 8 reader threads while writer thread provisions,
+ * updates and removes devices. Reference variant is std::map locked by the mutex.
+ * Print nanoseconds per lookup as JSON (see bench-helper.h), multithreaded variants print wall time divided by
+ * lookups of all readers, lookups per second and writer updates are printed to stderr.
+ * Usage: bench-identity-table [iterations]
+ */
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "lorawan/storage/service/identity-service-mem.h"
+#include "lorawan/lorawan-error.h"
+#include "bench-helper.h"
+
+#define DEVICE_COUNT        100000
+#define LOOKUP_COUNT        100000
+#define DEF_ITERATIONS      2
+
+/**
+ * Lookup addresses of the present and absent devices
+ */
+static std::vector<DEVADDR> makeAddresses()
+{
+    std::vector<DEVADDR> r;
+    std::mt19937 rnd(42);
+    std::uniform_int_distribution<uint32_t> d(0, DEVICE_COUNT * 2 - 1);
+    for (size_t i = 0; i < LOOKUP_COUNT; i++) {
+        r.emplace_back(d(rnd));
+    }
+    return r;
+}
+
+static DEVICEID makeId(
+    uint32_t addr
+)
+{
+    DEVICEID r;
+    r.id.devEUI.u = addr;
+    r.id.appEUI.u = addr;
+    return r;
+}
+
+/**
+ * Writer adds and removes second half of the addresses in turn
+ */
+template <class P, class R>
+static void provision(
+    uint32_t i,
+    P put,
+    R rm
+)
+{
+    uint32_t a = DEVICE_COUNT + i % DEVICE_COUNT;
+    if ((i / DEVICE_COUNT) & 1)
+        rm(DEVADDR(a));
+    else
+        put(DEVADDR(a), makeId(a));
+}
+
+/**
+ * Run readers and writer, measure readers wall time
+ * @param retNsPerOp nanoseconds per lookup of each repeat
+ * @return writer updates
+ */
+template <class G, class W>
+static size_t measureThreads(
+    std::vector<double> &retNsPerOp,
+    size_t iterations,
+    int threads,
+    const std::vector<DEVADDR> &addresses,
+    G get,
+    W write
+)
+{
+    size_t updates = 0;
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        std::chrono::steady_clock::duration d(0);
+        for (size_t it = 0; it < iterations; it++) {
+            std::atomic<bool> stopped(false);
+            std::atomic<bool> go(false);
+            std::atomic<int> ready(0);
+            std::atomic<size_t> written(0);
+            std::thread writer([&] {
+                uint32_t i = 0;
+                while (!stopped) {
+                    write(i++);
+                }
+                written = i;
+            });
+            std::vector<std::thread> readers;
+            for (int t = 0; t < threads; t++) {
+                readers.emplace_back([&, t] {
+                    ready++;
+                    while (!go) {
+                        std::this_thread::yield();
+                    }
+                    size_t found = 0;
+                    for (size_t i = 0; i < LOOKUP_COUNT; i++) {
+                        found += get(addresses[(i + t * 7919) % LOOKUP_COUNT]);
+                    }
+                    benchSink += found;
+                });
+            }
+            while (ready < threads) {
+                std::this_thread::yield();
+            }
+            auto started = std::chrono::steady_clock::now();
+            go = true;
+            for (auto &r : readers) {
+                r.join();
+            }
+            d += std::chrono::steady_clock::now() - started;
+            stopped = true;
+            writer.join();
+            updates += written;
+        }
+        retNsPerOp.push_back(std::chrono::duration<double, std::nano>(d).count() / (double) (iterations * threads * LOOKUP_COUNT));
+    }
+    std::sort(retNsPerOp.begin(), retNsPerOp.end());
+    return updates;
+}
+
+template <class G, class W>
+static void runThreads(
+    BenchPrinter &bench,
+    const char *name,
+    const std::vector<DEVADDR> &addresses,
+    G get,
+    W write
+)
+{
+    static const int THREADS[] = { 1, 2, 4, 8 };
+    for (int threads : THREADS) {
+        std::vector<double> ns;
+        size_t updates = measureThreads(ns, bench.getIterations(), threads, addresses, get, write);
+        std::string variant = std::to_string(threads) + "-readers-writer";
+        double median = ns[ns.size() / 2];
+        bench.print(name, variant.c_str(), bench.getIterations() * threads * LOOKUP_COUNT, median, ns[0]);
+        std::cerr << name << " " << variant << ": " << (size_t) (1e9 / median) << " lookups/s, "
+            << updates << " updates" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<DEVADDR> addresses = makeAddresses();
+
+    MemoryIdentityService service;
+    service.init("", nullptr);
+    std::mutex mapMutex;
+    std::map<DEVADDR, DEVICEID> map;
+    for (uint32_t a = 0; a < DEVICE_COUNT; a++) {
+        service.put(DEVADDR(a), makeId(a));
+        map[DEVADDR(a)] = makeId(a);
+    }
+
+    BenchPrinter bench(argc, argv, DEF_ITERATIONS);
+    bench.run("identity-mem-get", "1-reader", LOOKUP_COUNT, [&](size_t i) {
+        DEVICEID id;
+        return service.get(id, addresses[i]) == CODE_OK;
+    });
+    runThreads(bench, "identity-mem-get", addresses,
+        [&](const DEVADDR &a) {
+            DEVICEID id;
+            return service.get(id, a) == CODE_OK;
+        },
+        [&](uint32_t i) {
+            provision(i,
+                [&](const DEVADDR &a, const DEVICEID &id) { service.put(a, id); },
+                [&](const DEVADDR &a) { service.rm(a); });
+        });
+
+    // reference: map locked by readers and writer
+    bench.run("mutex-map-get", "1-reader", LOOKUP_COUNT, [&](size_t i) {
+        DEVICEID id;
+        std::lock_guard<std::mutex> lock(mapMutex);
+        auto f = map.find(addresses[i]);
+        if (f == map.end())
+            return false;
+        id = f->second;
+        return true;
+    });
+    runThreads(bench, "mutex-map-get", addresses,
+        [&](const DEVADDR &a) {
+            DEVICEID id;
+            std::lock_guard<std::mutex> lock(mapMutex);
+            auto f = map.find(a);
+            if (f == map.end())
+                return false;
+            id = f->second;
+            return true;
+        },
+        [&](uint32_t i) {
+            provision(i,
+                [&](const DEVADDR &a, const DEVICEID &id) {
+                    std::lock_guard<std::mutex> lock(mapMutex);
+                    map[a] = id;
+                },
+                [&](const DEVADDR &a) {
+                    std::lock_guard<std::mutex> lock(mapMutex);
+                    map.erase(a);
+                });
+        });
+    service.done();
+    return 0;
+}
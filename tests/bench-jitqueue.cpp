@@ -0,0 +1,113 @@
+/**
+ * Just In Time downlink queue microbenchmark.
+ * Class A downlinks are placed in 100ms slots next to the concentrator counter roll-over. Measure enqueue
+ * into the last free slots, rejected enqueue colliding with a queued packet, peek with nothing due and
+ * peek + dequeue draining the queue, for the default and the former (32 packets) queue capacity.
+ * Print nanoseconds per call as JSON (see bench-helper.h).
+ * Usage: bench-jitqueue [iterations]
+ */
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cassert>
+
+#include "gateway-lora.h"
+#include "bench-helper.h"
+
+#define SLOT_US             100000
+#define FIRST_SLOT_US       1000000
+#define ENQUEUE_COUNT       16
+#define DEF_ITERATIONS      200
+
+static const uint32_t TIME_BASE = 0xffffffff - 10000000;    // counter wraps around in 10s
+
+static struct lgw_pkt_tx_s slotPacket(
+    uint32_t slot,
+    int32_t shiftUs
+)
+{
+    struct lgw_pkt_tx_s pkt {};
+    pkt.tx_mode = TIMESTAMPED;
+    pkt.count_us = TIME_BASE + FIRST_SLOT_US + slot * SLOT_US + shiftUs;
+    pkt.freq_hz = 869525000;
+    pkt.modulation = MOD_LORA;
+    pkt.bandwidth = BW_125KHZ;
+    pkt.datarate = DR_LORA_SF7;
+    pkt.coderate = CR_LORA_4_5;
+    pkt.preamble = 8;
+    pkt.size = 12;
+    return pkt;
+}
+
+static void fill(
+    struct jit_queue_s &queue,
+    uint32_t capacity,
+    const std::vector<uint32_t> &slots,
+    size_t count
+)
+{
+    jit_queue_free(&queue);
+    jit_queue_init_capacity(&queue, capacity);
+    for (size_t i = 0; i < count; i++) {
+        struct lgw_pkt_tx_s pkt = slotPacket(slots[i], 0);
+        jit_enqueue(&queue, TIME_BASE, &pkt, JIT_PKT_TYPE_DOWNLINK_CLASS_A);
+    }
+}
+
+static void benchCapacity(
+    BenchPrinter &bench,
+    uint32_t capacity,
+    const char *variant
+)
+{
+    std::vector<uint32_t> slots(capacity);
+    for (uint32_t i = 0; i < capacity; i++) {
+        slots[i] = i;
+    }
+    std::shuffle(slots.begin(), slots.end(), std::mt19937(42));
+
+    struct jit_queue_s queue {};
+    // last ENQUEUE_COUNT packets make queue full
+    bench.run("enqueue", variant, ENQUEUE_COUNT, [&](size_t i) {
+        struct lgw_pkt_tx_s pkt = slotPacket(slots[capacity - ENQUEUE_COUNT + i], 0);
+        return jit_enqueue(&queue, TIME_BASE, &pkt, JIT_PKT_TYPE_DOWNLINK_CLASS_A);
+    }, [&] {
+        fill(queue, capacity, slots, capacity - ENQUEUE_COUNT);
+    });
+    assert(queue.num_pkt == capacity);
+
+    // one free slot left, packets shifted by 10ms collide with queued ones
+    fill(queue, capacity, slots, capacity - 1);
+    bench.run("enqueueCollision", variant, capacity - 1, [&](size_t i) {
+        struct lgw_pkt_tx_s pkt = slotPacket(slots[i], 10000);
+        return jit_enqueue(&queue, TIME_BASE, &pkt, JIT_PKT_TYPE_DOWNLINK_CLASS_A);
+    });
+    assert(queue.num_pkt == capacity - 1);
+
+    fill(queue, capacity, slots, capacity);
+    bench.run("peek", variant, capacity, [&](size_t i) {
+        int idx;
+        jit_peek(&queue, TIME_BASE + (uint32_t) i, &idx);
+        return idx;
+    });
+
+    // peek each slot 10ms before it is due and dequeue it
+    bench.run("peekDequeue", variant, capacity, [&](size_t i) {
+        int idx;
+        jit_peek(&queue, TIME_BASE + FIRST_SLOT_US + (uint32_t) i * SLOT_US - 10000, &idx);
+        struct lgw_pkt_tx_s pkt;
+        enum jit_pkt_type_e pktType;
+        return jit_dequeue(&queue, idx, &pkt, &pktType);
+    }, [&] {
+        fill(queue, capacity, slots, capacity);
+    });
+    assert(jit_queue_is_empty(&queue));
+    jit_queue_free(&queue);
+}
+
+int main(int argc, char **argv) {
+    BenchPrinter bench(argc, argv, DEF_ITERATIONS);
+    benchCapacity(bench, JIT_QUEUE_MAX, "full-default");
+    benchCapacity(bench, 32, "full-32");
+    return 0;
+}
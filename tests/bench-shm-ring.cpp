@@ -0,0 +1,114 @@
+/**
+ * Shared memory ring bridge microbenchmark.
+ * Measure record write (single payload and batches of 64 payloads), C reader copy of the written record and
+ * record write while two reader threads follow the writer.
+ * Print nanoseconds per record as JSON (see bench-helper.h).
+ * Usage: bench-shm-ring [iterations]
+ */
+#include <atomic>
+#include <thread>
+#include <unistd.h>
+
+#include "lorawan/bridge/shm-ring-bridge.h"
+#include "bench-helper.h"
+
+#define RING_FILE_NAME      "bench-shm-ring.ring"
+#define RING_CAPACITY       65536
+#define RECORD_COUNT        32768
+#define BATCH_SIZE          64
+#define DEF_ITERATIONS      20
+
+static void makeItems(
+    std::vector<MessageQueueItem> &retVal
+)
+{
+    struct sockaddr addr {};
+    SEMTECH_PROTOCOL_METADATA_RX rx {};
+    rx.freq = 868100000;
+    rx.rssi = -100;
+    rx.lsnr = 5.5;
+    rx.spreadingFactor = DRLORA_SF7;
+    retVal.resize(RECORD_COUNT);
+    for (uint32_t i = 0; i < RECORD_COUNT; i++) {
+        MessageQueueItem &item = retVal[i];
+        item.radioPacket.mhdr.f.mtype = MTYPE_UNCONFIRMED_DATA_UP;
+        item.radioPacket.data.uplink.devaddr.u = i;
+        item.radioPacket.data.uplink.fcnt = (uint16_t) i;
+        item.radioPacket.data.uplink.setFport(2);
+        uint8_t payload[16] = { (uint8_t) i };
+        item.radioPacket.data.uplink.setPayload(payload, sizeof(payload));
+        item.radioPacket.payloadSize = sizeof(payload);
+        item.metadata[0x0102030405060708 + (i & 3)] = GatewayMetadata(nullptr, addr, METADATA_TYPE_RX, rx, nullptr);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<MessageQueueItem> items;
+    makeItems(items);
+    std::vector<AppBridgePayload> batches[RECORD_COUNT / BATCH_SIZE];
+    for (size_t i = 0; i < RECORD_COUNT; i++) {
+        batches[i / BATCH_SIZE].emplace_back(items[i], true, true);
+    }
+    unlink(RING_FILE_NAME);
+    ShmRingBridge bridge;
+    if (bridge.init(RING_FILE_NAME, std::to_string(RING_CAPACITY), nullptr))
+        return 1;
+    shm_ring_reader reader;
+    if (shm_ring_open(&reader, RING_FILE_NAME))
+        return 1;
+    shm_ring_record record;
+
+    BenchPrinter bench(argc, argv, DEF_ITERATIONS);
+    bench.run("shm-ring", "write", RECORD_COUNT, [&](size_t i) {
+        bridge.onPayload(nullptr, &items[i], true, true);
+        return 1;
+    });
+    bench.run("shm-ring", "write-batch-64", RECORD_COUNT / BATCH_SIZE, [&](size_t i) {
+        bridge.onPayloadBatch(nullptr, batches[i]);
+        return BATCH_SIZE;
+    });
+    bench.run("shm-ring", "read", RECORD_COUNT, [&](size_t i) {
+        return shm_ring_read(&reader, &record) + record.payload_size;
+    }, [&] {
+        // records are written outside of the measurement
+        reader.next = bridge.written();
+        for (size_t i = 0; i < RECORD_COUNT; i++) {
+            bridge.onPayload(nullptr, &items[i], true, true);
+        }
+    });
+
+    // writer shares record cache lines with readers
+    std::atomic<bool> stopped(false);
+    std::atomic<uint64_t> read(0), lost(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; t++) {
+        readers.emplace_back([&] {
+            shm_ring_reader r;
+            if (shm_ring_open(&r, RING_FILE_NAME))
+                return;
+            shm_ring_record rec;
+            uint64_t c = 0;
+            while (!stopped) {
+                c += (uint64_t) shm_ring_read(&r, &rec);
+            }
+            read += c;
+            lost += r.lost;
+            shm_ring_close(&r);
+        });
+    }
+    bench.run("shm-ring", "write-2-readers", RECORD_COUNT, [&](size_t i) {
+        bridge.onPayload(nullptr, &items[i], true, true);
+        return 1;
+    });
+    stopped = true;
+    for (auto &t : readers) {
+        t.join();
+    }
+    std::cerr << "readers read " << read << " lost " << lost << " records" << std::endl;
+
+    shm_ring_close(&reader);
+    bridge.done();
+    unlink(RING_FILE_NAME);
+    return 0;
+}
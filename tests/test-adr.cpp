@@ -0,0 +1,92 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "lorawan/task/adr-engine.h"
+#include "lorawan/lorawan-builder.h"
+#include "lorawan/lorawan-mac.h"
+#include "gen/regional-parameters-3.h"
+
+static SEMTECH_PROTOCOL_METADATA_RX rxMetadata(
+    SPREADING_FACTOR sf,
+    float lsnr
+)
+{
+    SEMTECH_PROTOCOL_METADATA_RX r {};
+    r.modu = MODULATION_LORA;
+    r.bandwidth = BANDWIDTH_INDEX_125KHZ;
+    r.spreadingFactor = sf;
+    r.rssi = -110;
+    r.lsnr = lsnr;
+    return r;
+}
+
+int main() {
+    const RegionalParameterChannelPlan *eu = regionalParameterChannelPlanMem.get("EU868");
+    assert(eu);
+
+    // time on air, 20 bytes
+    assert(std::fabs(AdrEngine::airtimeMilliseconds(DRLORA_SF7, BANDWIDTH_INDEX_125KHZ, 20) - 56.576) < 0.01);
+    assert(std::fabs(AdrEngine::airtimeMilliseconds(DRLORA_SF12, BANDWIDTH_INDEX_125KHZ, 20) - 1318.912) < 0.01);
+    assert(AdrEngine::dataRateIndex(eu, BANDWIDTH_INDEX_125KHZ, DRLORA_SF12) == 0);
+    assert(AdrEngine::dataRateIndex(eu, BANDWIDTH_INDEX_125KHZ, DRLORA_SF7) == 5);
+
+    AdrEngine adr;
+    DEVADDR addr(0x26011234);
+    uint8_t dr, pwr;
+    uint8_t fOpts[15];
+    // not enough uplinks
+    for (uint16_t f = 0; f < DEF_ADR_MIN_SAMPLES - 1; f++) {
+        assert(adr.add(addr, f, rxMetadata(DRLORA_SF12, 5.0), eu));
+        // duplicate received by other gateway with worse SNR
+        assert(adr.add(addr, f, rxMetadata(DRLORA_SF12, -3.0), eu));
+    }
+    assert(!adr.calculate(dr, pwr, addr, eu));
+    assert(adr.linkADRReq(fOpts, sizeof(fOpts), addr, eu) == 0);
+    assert(adr.add(addr, DEF_ADR_MIN_SAMPLES, rxMetadata(DRLORA_SF12, 5.0), eu));
+    // margin 5 - (-20) - 10 = 15 dB: 5 steps to DR5
+    assert(adr.calculate(dr, pwr, addr, eu));
+    assert(dr == 5 && pwr == 0);
+    assert(adr.linkADRReq(fOpts, 4, addr, eu) == 0);
+    assert(adr.linkADRReq(fOpts, sizeof(fOpts), addr, eu) == MAC_LINK_ADR_REQ_SIZE);
+    assert(fOpts[0] == LinkADR);
+    assert(fOpts[1] == 0x50);                       // DR5, TX power 0
+    assert(fOpts[2] == 0x07 && fOpts[3] == 0);      // 3 default EU868 channels
+    assert(fOpts[4] == 0x01);                       // NbTrans 1
+    // history is cleared after request
+    assert(!adr.calculate(dr, pwr, addr, eu));
+
+    // strong signal at SF7: lower TX power
+    for (uint16_t f = 100; f < 100 + DEF_ADR_MIN_SAMPLES; f++) {
+        adr.add(addr, f, rxMetadata(DRLORA_SF7, 9.0), eu);
+    }
+    // margin 9 - (-7.5) - 10 = 6.5 dB: 2 steps
+    assert(adr.calculate(dr, pwr, addr, eu));
+    assert(dr == 5 && pwr == 2);
+    assert(adr.linkADRReq(fOpts, sizeof(fOpts), addr, eu) == MAC_LINK_ADR_REQ_SIZE);
+    // weak signal: raise TX power back
+    for (uint16_t f = 200; f < 200 + DEF_ADR_MIN_SAMPLES; f++) {
+        adr.add(addr, f, rxMetadata(DRLORA_SF7, -6.0), eu);
+    }
+    assert(adr.calculate(dr, pwr, addr, eu));
+    assert(dr == 5 && pwr == 0);
+
+    // LinkADRReq piggy-backed in FOpts of the confirmation
+    LORAWAN_MESSAGE_STORAGE up {};
+    up.mhdr.f.mtype = MTYPE_CONFIRMED_DATA_UP;
+    up.data.uplink.devaddr = addr;
+    up.data.uplink.fcnt = 7;
+    TaskDescriptor td;
+    ConfirmationMessage c(up, td, fOpts, MAC_LINK_ADR_REQ_SIZE);
+    uint8_t buf[64];
+    size_t sz = c.get(buf, sizeof(buf));
+    assert(sz == 1 + SIZE_DOWNLINK_EMPTY_STORAGE + MAC_LINK_ADR_REQ_SIZE + SIZE_MIC);
+    assert((buf[5] & 0x0f) == MAC_LINK_ADR_REQ_SIZE);
+    assert(buf[5] & 0x20);                          // ACK
+    assert(memcmp(buf + 1 + SIZE_DOWNLINK_EMPTY_STORAGE, fOpts, MAC_LINK_ADR_REQ_SIZE) == 0);
+
+    adr.rm(addr);
+    assert(adr.size() == 0);
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include "lorawan/bridge/app-bridge-worker.h"
+
+class CountBridge : public AppBridge {
+public:
+    size_t payloads;
+    size_t batches;
+    int delayMs;
+    explicit CountBridge(int aDelayMs)
+        : payloads(0), batches(0), delayMs(aDelayMs)
+    {
+    }
+    void onPayload(const void *dispatcher, const MessageQueueItem *item, bool decoded, bool micMatched) override {
+        payloads++;
+    }
+    void onPayloadBatch(const void *dispatcher, const std::vector<AppBridgePayload> &items) override {
+        batches++;
+        if (delayMs)
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+        AppBridge::onPayloadBatch(dispatcher, items);
+    }
+    int init(const std::string& option, const std::string& option2, const void *option3) override { return 0; }
+    const char *name() override { return "count"; }
+    void done() override {}
+    void onSend(const void *dispatcher, const MessageQueueItem *item, int code) override {}
+};
+
+static void testDeliverAll()
+{
+    CountBridge b(0);
+    AppBridgeWorker w(&b, nullptr, 16, BRIDGE_OVERFLOW_BLOCK, 8);
+    w.start();
+    MessageQueueItem item;
+    for (int i = 0; i < 1000; i++) {
+        assert(w.push(&item, false, false));
+    }
+    w.stop();
+    AppBridgeWorkerStat stat;
+    w.getStat(stat);
+    std::cout << stat.toJsonString() << std::endl;
+    assert(b.payloads == 1000);
+    assert(stat.delivered == 1000);
+    assert(stat.dropped == 0);
+    assert(stat.maxQueued <= 16);
+}
+
+static void testDrop()
+{
+    CountBridge b(50);
+    AppBridgeWorker w(&b, nullptr, 4, BRIDGE_OVERFLOW_DROP_NEWEST, 2);
+    w.start();
+    MessageQueueItem item;
+    for (int i = 0; i < 100; i++) {
+        w.push(&item, false, false);
+    }
+    w.stop();
+    AppBridgeWorkerStat stat;
+    w.getStat(stat);
+    std::cout << stat.toJsonString() << std::endl;
+    assert(stat.dropped > 0);
+    assert(stat.delivered + stat.dropped == 100);
+    assert(b.payloads == stat.delivered);
+}
+
+int main(int argc, char **argv) {
+    testDeliverAll();
+    testDrop();
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <random>
+
+#include "lorawan/helper/codec-helper.h"
+#include "lorawan/lorawan-error.h"
+#include "lorawan/lorawan-string.h"
+#include "base64/base64.h"
+
+#define MAX_SIZE 300
+
+static std::string randomBytes(
+    std::mt19937 &rnd,
+    size_t size
+)
+{
+    std::string r(size, '\0');
+    for (auto &c : r) {
+        c = (char) (rnd() & 0xff);
+    }
+    return r;
+}
+
+static void testBase64()
+{
+    std::mt19937 rnd(42);
+    char enc[BASE64_ENCODED_SIZE(MAX_SIZE)];
+    char dec[BASE64_DECODED_SIZE(BASE64_ENCODED_SIZE(MAX_SIZE))];
+    for (size_t sz = 0; sz <= MAX_SIZE; sz++) {
+        std::string s = randomBytes(rnd, sz);
+        size_t esz = base64Encode(enc, s.c_str(), s.size());
+        assert(esz == BASE64_ENCODED_SIZE(sz));
+        assert(std::string(enc, esz) == base64_encode(s));
+        int dsz = base64Decode(dec, sizeof(dec), enc, esz);
+        assert(dsz == (int) sz);
+        assert(memcmp(dec, s.c_str(), sz) == 0);
+        // URL-safe alphabet
+        std::string url = base64_encode(s, true);
+        dsz = base64Decode(dec, sizeof(dec), url.c_str(), url.size());
+        assert(dsz == (int) sz);
+        assert(memcmp(dec, s.c_str(), sz) == 0);
+        // exact output buffer
+        if (sz) {
+            dsz = base64Decode(dec, sz, enc, esz);
+            assert(dsz == (int) sz);
+            assert(base64Decode(dec, sz - 1, enc, esz) == ERR_CODE_INVALID_BUFFER_SIZE);
+        }
+        // invalid character in the SIMD block and in the scalar tail
+        if (esz > 4) {
+            std::string bad(enc, esz);
+            bad[esz / 2] = '*';
+            assert(base64Decode(dec, sizeof(dec), bad.c_str(), bad.size()) == ERR_CODE_INVALID_BASE64);
+            bad = std::string(enc, esz);
+            bad[0] = '=';
+            assert(base64Decode(dec, sizeof(dec), bad.c_str(), bad.size()) == ERR_CODE_INVALID_BASE64);
+        }
+    }
+    // without padding
+    assert(base64Decode(dec, sizeof(dec), "QUI", 3) == 2);
+    assert(memcmp(dec, "AB", 2) == 0);
+    assert(base64Decode(dec, sizeof(dec), "Q", 1) == ERR_CODE_INVALID_BASE64);
+}
+
+static void testHex()
+{
+    std::mt19937 rnd(42);
+    char enc[MAX_SIZE * 2];
+    char dec[MAX_SIZE];
+    for (size_t sz = 0; sz <= MAX_SIZE; sz++) {
+        std::string s = randomBytes(rnd, sz);
+        size_t esz = hexEncode(enc, s.c_str(), s.size());
+        assert(esz == sz * 2);
+        for (size_t i = 0; i < sz; i++) {
+            char b[3];
+            snprintf(b, sizeof(b), "%02x", (unsigned char) s[i]);
+            assert(enc[i * 2] == b[0] && enc[i * 2 + 1] == b[1]);
+        }
+        assert(hexDecode(dec, sizeof(dec), enc, esz) == (int) sz);
+        assert(memcmp(dec, s.c_str(), sz) == 0);
+        std::string upper = toUpperCase(std::string(enc, esz));
+        assert(hexDecode(dec, sizeof(dec), upper.c_str(), upper.size()) == (int) sz);
+        assert(memcmp(dec, s.c_str(), sz) == 0);
+        if (sz) {
+            std::string bad(enc, esz);
+            bad[esz - 1] = 'g';
+            assert(hexDecode(dec, sizeof(dec), bad.c_str(), bad.size()) == ERR_CODE_PARAM_INVALID);
+            bad = std::string(enc, esz);
+            bad[0] = ':';
+            assert(hexDecode(dec, sizeof(dec), bad.c_str(), bad.size()) == ERR_CODE_PARAM_INVALID);
+            assert(hexDecode(dec, sz - 1, enc, esz) == ERR_CODE_INVALID_BUFFER_SIZE);
+        }
+    }
+    assert(hexDecode(dec, sizeof(dec), "abc", 3) == ERR_CODE_PARAM_INVALID);
+    // lorawan-string wrappers
+    assert(hexString("\x01\xab\xff", 3) == "01abff");
+    assert(hex2string("01ABff") == std::string("\x01\xab\xff", 3));
+}
+
+int main() {
+    int maxLevel = setCodecLevel(CODEC_LEVEL_AVX2);
+    for (int level = CODEC_LEVEL_SCALAR; level <= maxLevel; level++) {
+        setCodecLevel(level);
+        std::cout << codecLevelName(codecLevel()) << std::endl;
+        testBase64();
+        testHex();
+    }
+    return 0;
+}
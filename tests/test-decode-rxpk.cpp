@@ -1,4 +1,5 @@
 #include <string>
+#include <ctime>
 #include <iostream>
 #include "lorawan/lorawan-types.h"
 #include "lorawan/lorawan-string.h"
@@ -59,8 +60,12 @@ static std::string extractPayloadFromBasicUDP(
     MessageTaskDispatcher d;
     GatewayBasicUdpProtocol p(&d);
     ParseResult pr;
-    TASK_TIME receivedTime = std::chrono::system_clock::now();
+    TASK_TIME receivedTime = TASK_CLOCK::now();
     p.parse(pr, packetForwarderPacket.c_str(), packetForwarderPacket.size(), receivedTime);
+    // received time is monotonic, metadata reports wall clock time
+    long long dt = (long long) pr.gwPushData.rxMetadata.t - (long long) time(nullptr);
+    if (dt < -1 || dt > 1)
+        return "";
     pr.gwPushData.rxData.decode(*pr.gwPushData.rxData.getAddr(), appSKey);
     return pr.gwPushData.rxData.payloadString();
 }
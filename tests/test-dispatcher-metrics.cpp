@@ -0,0 +1,127 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include "lorawan/task/dispatcher-metrics.h"
+
+#define THREADS     4
+#define PER_THREAD  100000
+
+static void testBuckets()
+{
+    // each value is in the bucket, bucket bounds do not overlap
+    for (uint64_t v = 0; v < 100000; v++) {
+        size_t i = MetricsHistogram::bucketIndex(v);
+        assert(i < METRICS_HISTOGRAM_BUCKETS);
+        assert(v <= MetricsHistogram::bucketUpperBound(i));
+        if (i > 0)
+            assert(v > MetricsHistogram::bucketUpperBound(i - 1));
+    }
+    assert(MetricsHistogram::bucketIndex(UINT64_MAX) == METRICS_HISTOGRAM_BUCKETS - 1);
+    assert(MetricsHistogram::bucketUpperBound(METRICS_HISTOGRAM_BUCKETS - 1) == UINT64_MAX);
+}
+
+static void testQuantiles()
+{
+    MetricsHistogram h;
+    assert(h.quantile(0.5) == 0);
+    for (int64_t v = 1; v <= 1000; v++) {
+        h.record(v);
+    }
+    assert(h.getCount() == 1000);
+    assert(h.getSum() == 500500);
+    assert(h.getMax() == 1000);
+    // relative error is less than 1 / METRICS_HISTOGRAM_SUB_COUNT
+    uint64_t p50 = h.quantile(0.5);
+    assert(p50 >= 500 && p50 < 500 + 500 / METRICS_HISTOGRAM_SUB_COUNT);
+    uint64_t p99 = h.quantile(0.99);
+    assert(p99 >= 990 && p99 <= 1000);
+    assert(h.quantile(1.0) == 1000);
+    h.record(-1);
+    assert(h.getCount() == 1001);
+    h.reset();
+    assert(h.getCount() == 0 && h.getMax() == 0);
+}
+
+static void testCounters()
+{
+    DispatcherMetrics m;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&m] {
+            for (int i = 0; i < PER_THREAD; i++) {
+                m.packets.inc();
+                m.ackLatency.record(i % 100);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    assert(m.packets.get() == THREADS * PER_THREAD);
+    assert(m.ackLatency.getCount() == THREADS * PER_THREAD);
+    m.uplinkQueueSize.set(3);
+    std::string p = m.toPrometheus();
+    assert(p.find("# TYPE tlns_packets_total counter\ntlns_packets_total 400000\n") != std::string::npos);
+    assert(p.find("tlns_uplink_queue_size 3\n") != std::string::npos);
+    assert(p.find("tlns_ack_latency_microseconds{quantile=\"0.5\"}") != std::string::npos);
+    assert(p.find("tlns_ack_latency_microseconds_count 400000\n") != std::string::npos);
+    assert(m.toJsonString().find("\"packets\": 400000") != std::string::npos);
+    m.reset();
+    assert(m.packets.get() == 0);
+}
+
+static void testTrace()
+{
+    PacketTrace t;
+    assert(!t.active());
+    assert(t.duration(TRACE_STAGE_PARSED) == -1);
+    t.stamps[TRACE_STAGE_RECEIVED] = 1000000;
+    t.stamps[TRACE_STAGE_PARSED] = 3000000;
+    // queued, identified are not stamped
+    t.stamps[TRACE_STAGE_DECODED] = 8000000;
+    assert(t.active());
+    assert(t.duration(TRACE_STAGE_RECEIVED) == -1);
+    assert(t.duration(TRACE_STAGE_PARSED) == 2000);
+    assert(t.duration(TRACE_STAGE_QUEUED) == -1);
+    assert(t.duration(TRACE_STAGE_DECODED) == 5000);
+    assert(t.total() == 7000);
+    assert(t.toJsonString() == "{\"parsed\": 2000, \"decoded\": 5000, \"total\": 7000}");
+
+    // kernel time is converted to the monotonic clock
+    PacketTrace k;
+    int64_t real = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    k.setKernelTime(real - 1000000);
+    k.mark(TRACE_STAGE_RECEIVED);
+    assert(k.duration(TRACE_STAGE_RECEIVED) >= 1000);
+
+    DispatcherMetrics m;
+    m.recordTrace(t);
+    assert(m.stages[TRACE_STAGE_PARSED].getCount() == 1);
+    assert(m.stages[TRACE_STAGE_QUEUED].getCount() == 0);
+    assert(m.traceTotal.getMax() == 7000);
+    assert(m.toPrometheus().find("tlns_stage_latency_microseconds_count{stage=\"decoded\"} 1\n") != std::string::npos);
+
+    PacketTraceSampler sampler(2);
+    assert(!sampler.add(t));    // disabled
+    sampler.sampleRate = 2;
+    for (int i = 0; i < 6; i++) {
+        t.stamps[TRACE_STAGE_DECODED] = 8000000 + i * 1000000;
+        sampler.add(t);
+    }
+    // traces 0, 2, 4 sampled, last 2 kept
+    assert(sampler.toJsonString() == "[{\"parsed\": 2000, \"decoded\": 7000, \"total\": 9000}, "
+        "{\"parsed\": 2000, \"decoded\": 9000, \"total\": 11000}]");
+}
+
+int main(int argc, char **argv)
+{
+    testBuckets();
+    testQuantiles();
+    testCounters();
+    testTrace();
+    std::cout << "OK" << std::endl;
+    return 0;
+}
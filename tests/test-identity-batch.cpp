@@ -0,0 +1,224 @@
+/**
+ * Batch put/remove: memory identity and gateway services replay batches from the journal,
+ * binary serialization of the batch requests returns count of processed identities
+ */
+#include <iostream>
+#include <cassert>
+#include "lorawan/lorawan-error.h"
+#include "lorawan/helper/file-helper.h"
+#include "lorawan/storage/service/identity-service-mem.h"
+#include "lorawan/storage/service/gateway-service-mem.h"
+#include "lorawan/storage/serialization/identity-binary-serialization.h"
+
+#define DEVICE_COUNT    5000
+
+static const std::string JOURNAL_DB_NAME("test-batch");
+
+static void rmJournal()
+{
+    file::rmFile(JOURNAL_DB_NAME + SNAPSHOT_FILE_SUFFIX);
+    file::rmFile(JOURNAL_DB_NAME + JOURNAL_FILE_SUFFIX);
+}
+
+static std::vector<NETWORKIDENTITY> makeIdentities(
+    uint32_t first,
+    size_t count
+)
+{
+    std::vector<NETWORKIDENTITY> r;
+    for (uint32_t a = first; a < first + count; a++) {
+        NETWORKIDENTITY ni;
+        ni.value.devaddr = DEVADDR(a);
+        ni.value.devid.id.devEUI.u = a;
+        r.push_back(ni);
+    }
+    return r;
+}
+
+static void testIdentityBatch()
+{
+    rmJournal();
+    {
+        MemoryIdentityService s;
+        s.persistent = true;
+        int r = s.init(JOURNAL_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        r = s.putBatch(makeIdentities(1, DEVICE_COUNT));
+        assert(r == CODE_OK);
+        assert(s.size() == DEVICE_COUNT);
+        // absent addresses are skipped
+        std::vector<DEVADDR> addrs { DEVADDR(1), DEVADDR(2), DEVADDR(DEVICE_COUNT + 1) };
+        r = s.rmBatch(addrs);
+        assert(r == CODE_OK);
+        assert(s.size() == DEVICE_COUNT - 2);
+        // update existing
+        auto updated = makeIdentities(3, 1);
+        updated[0].value.devid.id.devEUI.u = 42;
+        r = s.putBatch(updated);
+        assert(r == CODE_OK);
+        r = s.putBatch(std::vector<NETWORKIDENTITY>());
+        assert(r == CODE_OK);
+        // no flush(), journal must be replayed
+    }
+    {
+        MemoryIdentityService s;
+        s.persistent = true;
+        int r = s.init(JOURNAL_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        assert(s.size() == DEVICE_COUNT - 2);
+        DEVICEID id;
+        r = s.get(id, DEVADDR(1));
+        assert(r != CODE_OK);
+        r = s.get(id, DEVADDR(3));
+        assert(r == CODE_OK && id.id.devEUI.u == 42);
+        r = s.get(id, DEVADDR(DEVICE_COUNT));
+        assert(r == CODE_OK && id.id.devEUI.u == DEVICE_COUNT);
+        // base class implementation calls put() and rm()
+        r = s.IdentityService::putBatch(makeIdentities(DEVICE_COUNT + 1, 10));
+        assert(r == CODE_OK);
+        r = s.IdentityService::rmBatch(std::vector<DEVADDR> { DEVADDR(3), DEVADDR(3) });
+        assert(r == CODE_OK);
+        assert(s.size() == DEVICE_COUNT + 7);
+        s.done();
+    }
+    rmJournal();
+}
+
+static void testGatewayBatch()
+{
+    rmJournal();
+    std::vector<GatewayIdentity> gis;
+    for (uint64_t i = 1; i <= 100; i++) {
+        GatewayIdentity gi;
+        gi.gatewayId = i;
+        gis.push_back(gi);
+    }
+    {
+        MemoryGatewayService s;
+        s.persistent = true;
+        int r = s.init(JOURNAL_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        r = s.putBatch(gis);
+        assert(r == CODE_OK);
+        std::vector<GatewayIdentity> rms(gis.begin(), gis.begin() + 10);
+        GatewayIdentity absent;
+        absent.gatewayId = 1000;
+        rms.push_back(absent);
+        r = s.rmBatch(rms);
+        assert(r == CODE_OK);
+        assert(s.size() == 90);
+    }
+    {
+        MemoryGatewayService s;
+        s.persistent = true;
+        int r = s.init(JOURNAL_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        assert(s.size() == 90);
+        GatewayIdentity gi;
+        r = s.get(gi, gis[0]);
+        assert(r == ERR_CODE_GATEWAY_NOT_FOUND);
+        r = s.get(gi, gis[50]);
+        assert(r == CODE_OK);
+        s.done();
+    }
+    rmJournal();
+}
+
+/**
+ * Serialize request as client does, query service and read response
+ */
+static int32_t query(
+    IdentityBinarySerialization &serialization,
+    ServiceMessage &request
+)
+{
+    std::vector<unsigned char> buf(SIZE_MAX_BATCH_REQUEST);
+    request.ntoh();
+    size_t sz = request.serialize(buf.data());
+    assert(sz <= SIZE_MAX_BATCH_REQUEST);
+    assert(isIdentityTag(buf.data(), sz));
+    unsigned char retBuf[300];
+    size_t retSize = serialization.query(retBuf, sizeof(retBuf), buf.data(), sz);
+    assert(retSize > 0);
+    IdentityOperationResponse response(retBuf, retSize);
+    response.ntoh();
+    assert(response.tag == request.tag);
+    return response.response;
+}
+
+static void testBatchSerialization()
+{
+    MemoryIdentityService s;
+    int r = s.init("", nullptr);
+    assert(r == CODE_OK);
+    IdentityBinarySerialization serialization(&s, 42, 42);
+
+    IdentityAssignBatchRequest assign(42, 42);
+    assign.identities = makeIdentities(1, MAX_IDENTITY_BATCH_SIZE);
+    IdentityAssignBatchRequest parsed;
+    {
+        // round trip keeps identities
+        std::vector<unsigned char> buf(SIZE_MAX_BATCH_REQUEST);
+        IdentityAssignBatchRequest copy(assign);
+        copy.ntoh();
+        size_t sz = copy.serialize(buf.data());
+        IdentityAssignBatchRequest copyParsed(buf.data(), sz);
+        copyParsed.ntoh();
+        assert(copyParsed.identities.size() == MAX_IDENTITY_BATCH_SIZE);
+        assert(copyParsed.identities.back().value.devaddr.u == MAX_IDENTITY_BATCH_SIZE);
+        assert(copyParsed.identities.back().value.devid.id.devEUI.u == MAX_IDENTITY_BATCH_SIZE);
+    }
+    int32_t count = query(serialization, assign);
+    assert(count == MAX_IDENTITY_BATCH_SIZE);
+    assert(s.size() == MAX_IDENTITY_BATCH_SIZE);
+    DEVICEID id;
+    r = s.get(id, DEVADDR(7));
+    assert(r == CODE_OK && id.id.devEUI.u == 7);
+
+    IdentityRmBatchRequest rm(42, 42);
+    rm.addrs = { DEVADDR(1), DEVADDR(2), DEVADDR(3) };
+    count = query(serialization, rm);
+    assert(count == 3);
+    assert(s.size() == MAX_IDENTITY_BATCH_SIZE - 3);
+    r = s.get(id, DEVADDR(2));
+    assert(r != CODE_OK);
+
+    // wrong access code
+    IdentityRmBatchRequest denied(42, 1);
+    denied.addrs = { DEVADDR(4) };
+    std::vector<unsigned char> buf(SIZE_MAX_BATCH_REQUEST);
+    denied.ntoh();
+    size_t sz = denied.serialize(buf.data());
+    unsigned char retBuf[300];
+    serialization.query(retBuf, sizeof(retBuf), buf.data(), sz);
+    r = s.get(id, DEVADDR(4));
+    assert(r == CODE_OK);
+    s.done();
+}
+
+static void testReserve()
+{
+    ConcurrentIdentityTable t;
+    t.reserve(DEVICE_COUNT);
+    size_t capacity = t.capacity();
+    assert(capacity >= DEVICE_COUNT * 2);
+    for (uint32_t a = 1; a <= DEVICE_COUNT; a++) {
+        t.put(a, DEVICEID());
+    }
+    // no rebuild while reserved identities are added
+    assert(t.capacity() == capacity);
+    t.reserve(10);
+    assert(t.capacity() == capacity);
+    DEVICEID id;
+    bool found = t.get(id, DEVICE_COUNT);
+    assert(found);
+}
+
+int main() {
+    testIdentityBatch();
+    testGatewayBatch();
+    testBatchSerialization();
+    testReserve();
+    std::cout << "OK" << std::endl;
+    return 0;
+}
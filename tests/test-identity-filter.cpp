@@ -0,0 +1,172 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <random>
+
+#include "lorawan/storage/service/identity-service-mem.h"
+#include "lorawan/storage/service/identity-filter-plan.h"
+#include "lorawan/lorawan-error.h"
+#include "lorawan/lorawan-string.h"
+
+// more than IDENTITY_FILTER_PARALLEL_SIZE to scan in parallel
+#define DEVICE_COUNT    70000
+#define APP_COUNT       16
+
+static std::vector<NETWORK_IDENTITY_FILTER> parse(
+    const std::string &expression
+)
+{
+    std::vector<NETWORK_IDENTITY_FILTER> r;
+    string2NETWORK_IDENTITY_FILTERS(r, expression.c_str(), expression.size());
+    return r;
+}
+
+/**
+ * Reference result: interpret filters row by row
+ */
+static std::vector<NETWORKIDENTITY> interpret(
+    const std::map<DEVADDR, DEVICEID> &devices,
+    const std::vector<NETWORK_IDENTITY_FILTER> &filters,
+    uint32_t offset,
+    uint8_t size
+)
+{
+    std::vector<NETWORKIDENTITY> r;
+    uint32_t o = 0;
+    for (auto &d : devices) {
+        if (!isIdentityFilteredV2(d.first, d.second.id, filters))
+            continue;
+        if (o++ < offset)
+            continue;
+        if (r.size() >= size)
+            break;
+        r.emplace_back(d.first, d.second);
+    }
+    return r;
+}
+
+static bool sameAddresses(
+    const std::vector<NETWORKIDENTITY> &a,
+    const std::vector<NETWORKIDENTITY> &b
+)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].value.devaddr.u != b[i].value.devaddr.u)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Device has two addresses with the same DevEUI, removing one address keeps the other one
+ */
+static void testSameEUI()
+{
+    MemoryIdentityService svc;
+    svc.init("", nullptr);
+    DEVICEID did;
+    did.id.devEUI = DEVEUI(0x70b3d5fe00000001ULL);
+    int r = svc.put(DEVADDR(0x26000002), did);
+    assert(r == CODE_OK);
+    r = svc.put(DEVADDR(0x26000001), did);
+    assert(r == CODE_OK);
+    NETWORKIDENTITY ni;
+    // lowest address goes first
+    r = svc.getNetworkIdentity(ni, did.id.devEUI);
+    assert(r == CODE_OK && ni.value.devaddr.u == 0x26000001);
+    std::vector<NETWORKIDENTITY> ret;
+    r = svc.filter(ret, parse("deveui = 70b3d5fe00000001"), 0, 10);
+    assert(r == CODE_OK && ret.size() == 2);
+    r = svc.rm(DEVADDR(0x26000001));
+    assert(r == CODE_OK);
+    r = svc.getNetworkIdentity(ni, did.id.devEUI);
+    assert(r == CODE_OK && ni.value.devaddr.u == 0x26000002);
+    // address re-assigned to other device
+    DEVICEID other;
+    other.id.devEUI = DEVEUI(0x70b3d5fe00000002ULL);
+    r = svc.put(DEVADDR(0x26000002), other);
+    assert(r == CODE_OK);
+    r = svc.getNetworkIdentity(ni, did.id.devEUI);
+    assert(r == ERR_CODE_DEVICE_EUI_NOT_FOUND);
+    r = svc.getNetworkIdentity(ni, other.id.devEUI);
+    assert(r == CODE_OK && ni.value.devaddr.u == 0x26000002);
+    svc.done();
+}
+
+int main() {
+    testSameEUI();
+    MemoryIdentityService svc;
+    svc.filterThreads = 4;
+    svc.init("", nullptr);
+    std::map<DEVADDR, DEVICEID> devices;
+    std::mt19937 rnd(7);
+    for (uint32_t n = 0; n < DEVICE_COUNT; n++) {
+        DEVICEID did;
+        did.id.activation = (n % 3) ? OTAA : ABP;
+        did.id.deviceclass = (DEVICECLASS) (n % 3);
+        did.id.devEUI = DEVEUI(0x70b3d50000000000ULL + rnd());
+        did.id.appEUI = DEVEUI(0x70b3d5ff00000000ULL + n % APP_COUNT);
+        DEVADDR a(0x26000000 + n * 7);
+        svc.put(a, did);
+        devices[a] = did;
+    }
+
+    const char *expressions[] = {
+        // full scan
+        "class = C and appeui = 70b3d5ff00000005",
+        "activation = ABP",
+        "class = A or class = B",
+        // address range seek
+        "addr >= 26001000 and addr < 26002000",
+        "addr > 26001000 and addr <= 26001000",
+        "addr = 26000007",
+        // DevEUI seek
+        "deveui >= 70b3d50000000000 and deveui < 70b3d50010000000 and class = B"
+    };
+    for (auto e : expressions) {
+        auto filters = parse(e);
+        for (uint32_t offset : { 0, 3, 1000 }) {
+            std::vector<NETWORKIDENTITY> ret;
+            assert(svc.filter(ret, filters, offset, 200) == CODE_OK);
+            auto expected = interpret(devices, filters, offset, 200);
+            IdentityFilterPlan plan(filters);
+            if (plan.isEUIRange() && !plan.isAddressRange()) {
+                // ordered by DevEUI, compare sets
+                assert(ret.size() == expected.size());
+                for (auto &r : ret) {
+                    assert(isIdentityFilteredV2(r.value.devaddr, r.value.devid.id, filters));
+                }
+            } else
+                assert(sameAddresses(ret, expected));
+        }
+    }
+
+    // compiled plan and interpreter agree on each row
+    auto filters = parse("class = C and appeui = 70b3d5ff00000005");
+    IdentityFilterPlan plan(filters);
+    assert(!plan.isAddressRange());
+    size_t found = 0;
+    for (auto &d : devices) {
+        bool m = plan.match(d.first, d.second.id);
+        assert(m == isIdentityFilteredV2(d.first, d.second.id, filters));
+        if (m)
+            found++;
+    }
+    assert(found > 0);
+    // address and DevEUI ranges
+    IdentityFilterPlan addrPlan(parse("addr >= 26001000 and addr < 26002000"));
+    assert(addrPlan.addrLow == 0x26001000 && addrPlan.addrHigh == 0x26001fff);
+    assert(!addrPlan.empty);
+    assert(IdentityFilterPlan(parse("addr > 26001000 and addr <= 26001000")).empty);
+    IdentityFilterPlan orPlan(parse("addr = 26000007 or class = C"));
+    assert(orPlan.hasOr && !orPlan.isAddressRange());
+    std::vector<NETWORKIDENTITY> ret;
+    svc.filter(ret, parse("addr = 26000007 or class = C"), 0, 10);
+    assert(ret.size() == 10);
+    assert(ret[0].value.devaddr.u == 0x26000007);
+
+    svc.done();
+    return 0;
+}
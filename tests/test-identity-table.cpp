@@ -0,0 +1,181 @@
+/**
+ * Concurrent identity table: put/get/rm, rebuild keeps identities and does not grow while addresses are added and
+ * removed, memory identity service get() while writer provisions devices, readers never see torn identities
+ */
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <atomic>
+#include <thread>
+
+#include "lorawan/storage/service/identity-service-mem.h"
+#include "lorawan/lorawan-error.h"
+
+#define DEVICE_COUNT        10000
+#define WRITE_COUNT         200000
+#define READER_COUNT        3
+
+/**
+ * Identity fields are written from the same address and generation
+ */
+static DEVICEID makeId(
+    uint32_t addr,
+    uint32_t generation
+)
+{
+    DEVICEID r;
+    r.id.devEUI.u = ((uint64_t) addr << 32) | generation;
+    r.id.appEUI.u = r.id.devEUI.u;
+    memcpy(&r.id.nwkSKey.c, &r.id.devEUI.u, sizeof(uint64_t));
+    memcpy(&r.id.appSKey.c[8], &r.id.devEUI.u, sizeof(uint64_t));
+    return r;
+}
+
+static void checkId(
+    const DEVICEID &id,
+    uint32_t addr
+)
+{
+    assert((uint32_t) (id.id.devEUI.u >> 32) == addr);
+    assert(id.id.appEUI.u == id.id.devEUI.u);
+    assert(memcmp(&id.id.nwkSKey.c, &id.id.devEUI.u, sizeof(uint64_t)) == 0);
+    assert(memcmp(&id.id.appSKey.c[8], &id.id.devEUI.u, sizeof(uint64_t)) == 0);
+}
+
+static void testTable()
+{
+    ConcurrentIdentityTable t;
+    DEVICEID id;
+    bool found = t.get(id, 1);
+    assert(!found);
+    bool removed = t.rm(1);
+    assert(!removed);
+    for (uint32_t a = 1; a <= DEVICE_COUNT; a++) {
+        t.put(a, makeId(a, 0));
+    }
+    assert(t.size() == DEVICE_COUNT);
+    assert(t.capacity() >= DEVICE_COUNT * 2);
+    for (uint32_t a = 1; a <= DEVICE_COUNT; a++) {
+        found = t.get(id, a);
+        assert(found);
+        checkId(id, a);
+        assert((uint32_t) id.id.devEUI.u == 0);
+    }
+    found = t.get(id, 0);
+    assert(!found);
+    found = t.get(id, DEVICE_COUNT + 1);
+    assert(!found);
+
+    // update in place
+    t.put(5, makeId(5, 1));
+    assert(t.size() == DEVICE_COUNT);
+    found = t.get(id, 5);
+    assert(found && (uint32_t) id.id.devEUI.u == 1);
+
+    // removed slots do not break probe chains
+    for (uint32_t a = 1; a <= DEVICE_COUNT; a += 2) {
+        removed = t.rm(a);
+        assert(removed);
+    }
+    removed = t.rm(1);
+    assert(!removed);
+    assert(t.size() == DEVICE_COUNT / 2);
+    for (uint32_t a = 1; a <= DEVICE_COUNT; a++) {
+        found = t.get(id, a);
+        assert(found == (a % 2 == 0));
+    }
+
+    // churn: removed slots are reclaimed by rebuild, table does not grow
+    size_t capacity = t.capacity();
+    for (uint32_t a = DEVICE_COUNT + 1; a <= DEVICE_COUNT * 20; a++) {
+        t.put(a, makeId(a, 2));
+        removed = t.rm(a);
+        assert(removed);
+    }
+    assert(t.size() == DEVICE_COUNT / 2);
+    assert(t.capacity() <= capacity);
+    for (uint32_t a = 2; a <= DEVICE_COUNT; a += 2) {
+        found = t.get(id, a);
+        assert(found);
+        checkId(id, a);
+    }
+
+    std::map<DEVADDR, DEVICEID> m;
+    m[DEVADDR((uint32_t) 7)] = makeId(7, 3);
+    t.assign(m);
+    assert(t.size() == 1);
+    found = t.get(id, 2);
+    assert(!found);
+    found = t.get(id, 7);
+    assert(found && (uint32_t) id.id.devEUI.u == 3);
+    t.clear();
+    found = t.get(id, 7);
+    assert(t.size() == 0 && !found);
+}
+
+/**
+ * Readers look up devices while writer updates, removes and adds devices and table is rebuilt
+ */
+static void testConcurrent()
+{
+    MemoryIdentityService s;
+    int r = s.init("", nullptr);
+    assert(r == CODE_OK);
+    for (uint32_t a = 0; a < DEVICE_COUNT; a++) {
+        s.put(DEVADDR(a), makeId(a, 0));
+    }
+    std::atomic<bool> stopped(false);
+    std::atomic<int> started(0);
+    size_t found[READER_COUNT] = {};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < READER_COUNT; t++) {
+        readers.emplace_back([&s, &stopped, &started, &found, t] {
+            started++;
+            uint32_t a = (uint32_t) t;
+            while (!stopped) {
+                a = (a + 7919) % (DEVICE_COUNT * 2);
+                DEVICEID id;
+                if (s.get(id, DEVADDR(a)) == CODE_OK) {
+                    checkId(id, a);
+                    found[t]++;
+                } else {
+                    // first half of addresses is never removed
+                    assert(a >= DEVICE_COUNT / 2);
+                }
+            }
+        });
+    }
+    while (started < READER_COUNT) {
+        std::this_thread::yield();
+    }
+    for (uint32_t i = 0; i < WRITE_COUNT; i++) {
+        uint32_t a = i % (DEVICE_COUNT * 2);
+        if (a >= DEVICE_COUNT / 2 && i % 3 == 0)
+            s.rm(DEVADDR(a));
+        else
+            s.put(DEVADDR(a), makeId(a, i));
+    }
+    stopped = true;
+    for (auto &t : readers) {
+        t.join();
+    }
+    for (int t = 0; t < READER_COUNT; t++) {
+        std::cout << "reader " << t << " found " << found[t] << std::endl;
+    }
+    DEVICEID id;
+    for (uint32_t a = 0; a < DEVICE_COUNT / 2; a++) {
+        r = s.get(id, DEVADDR(a));
+        assert(r == CODE_OK);
+        checkId(id, a);
+    }
+    assert(s.size() <= DEVICE_COUNT * 2);
+    s.done();
+    r = s.get(id, DEVADDR((uint32_t) 0));
+    assert(r == ERR_CODE_GATEWAY_NOT_FOUND);
+}
+
+int main() {
+    testTable();
+    testConcurrent();
+    return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * Just In Time downlink queue: order across counter roll-over, collisions, capacity, Class C ASAP slots
+ * and outdated packets
+ */
+#include <iostream>
+#include <cassert>
+
+#include "gateway-lora.h"
+
+#define SLOT_US     100000
+
+static const uint32_t TIME_BASE = 0xffffffff - 500000;  // counter wraps around in 0.5s
+
+static struct lgw_pkt_tx_s packetAt(
+    uint32_t count_us
+)
+{
+    struct lgw_pkt_tx_s pkt {};
+    pkt.tx_mode = TIMESTAMPED;
+    pkt.count_us = count_us;
+    pkt.freq_hz = 869525000;
+    pkt.modulation = MOD_LORA;
+    pkt.bandwidth = BW_125KHZ;
+    pkt.datarate = DR_LORA_SF7;
+    pkt.coderate = CR_LORA_4_5;
+    pkt.preamble = 8;
+    pkt.size = 12;
+    return pkt;
+}
+
+static enum jit_error_e enqueueAt(
+    struct jit_queue_s &queue,
+    uint32_t time_us,
+    uint32_t count_us,
+    enum jit_pkt_type_e pktType = JIT_PKT_TYPE_DOWNLINK_CLASS_A
+)
+{
+    struct lgw_pkt_tx_s pkt = packetAt(count_us);
+    return jit_enqueue(&queue, time_us, &pkt, pktType);
+}
+
+static uint32_t dequeueDue(
+    struct jit_queue_s &queue,
+    uint32_t time_us
+)
+{
+    int idx;
+    assert(jit_peek(&queue, time_us, &idx) == JIT_ERROR_OK);
+    assert(idx >= 0);
+    struct lgw_pkt_tx_s pkt;
+    enum jit_pkt_type_e pktType;
+    assert(jit_dequeue(&queue, idx, &pkt, &pktType) == JIT_ERROR_OK);
+    return pkt.count_us;
+}
+
+static void testOrder()
+{
+    struct jit_queue_s queue;
+    jit_queue_init_capacity(&queue, 8);
+    // enqueued in reverse order, half of packets after counter roll-over
+    for (int i = 7; i >= 0; i--) {
+        assert(enqueueAt(queue, TIME_BASE, TIME_BASE + SLOT_US + i * SLOT_US) == JIT_ERROR_OK);
+    }
+    assert(jit_queue_is_full(&queue));
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + 20 * SLOT_US) == JIT_ERROR_FULL);
+    // nothing to send yet
+    int idx;
+    assert(jit_peek(&queue, TIME_BASE, &idx) == JIT_ERROR_OK);
+    assert(idx == -1);
+    for (int i = 0; i < 8; i++) {
+        uint32_t t = TIME_BASE + SLOT_US + i * SLOT_US;
+        assert(dequeueDue(queue, t - 10000) == t);
+    }
+    assert(jit_queue_is_empty(&queue));
+    assert(jit_peek(&queue, TIME_BASE, &idx) == JIT_ERROR_EMPTY);
+    jit_queue_free(&queue);
+}
+
+static void testCollision()
+{
+    struct jit_queue_s queue;
+    jit_queue_init(&queue);
+    assert(queue.capacity == JIT_QUEUE_MAX);
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + 1000000) == JIT_ERROR_OK);
+    // overlaps pre-delay and time on air
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + 1000000 + 20000) == JIT_ERROR_COLLISION_PACKET);
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + 1000000 - 20000) == JIT_ERROR_COLLISION_PACKET);
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + 1000000 + SLOT_US) == JIT_ERROR_OK);
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + 10000) == JIT_ERROR_TOO_LATE);
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + 600000000) == JIT_ERROR_TOO_EARLY);
+
+    // beacon guard applies to Class B
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + 10000000, JIT_PKT_TYPE_BEACON) == JIT_ERROR_OK);
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + 10000000 - 1000000, JIT_PKT_TYPE_DOWNLINK_CLASS_B) == JIT_ERROR_COLLISION_BEACON);
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + 10000000 - 1000000, JIT_PKT_TYPE_DOWNLINK_CLASS_A) == JIT_ERROR_OK);
+    assert(queue.num_beacon == 1);
+
+    // Class C takes the first free slot after queued packets colliding with "now + margin"
+    struct lgw_pkt_tx_s pkt = packetAt(0);
+    uint32_t now = TIME_BASE + 1000000 - 80000;
+    assert(jit_enqueue(&queue, now, &pkt, JIT_PKT_TYPE_DOWNLINK_CLASS_C) == JIT_ERROR_OK);
+    assert(pkt.tx_mode == TIMESTAMPED);
+    assert(pkt.count_us - (TIME_BASE + 1000000 + SLOT_US) > SLOT_US / 2);
+    assert(pkt.count_us - (TIME_BASE + 1000000 + SLOT_US) < SLOT_US * 2);
+    assert(queue.num_pkt == 5);
+    jit_queue_free(&queue);
+}
+
+static void testOutdated()
+{
+    struct jit_queue_s queue;
+    jit_queue_init(&queue);
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + SLOT_US) == JIT_ERROR_OK);
+    assert(enqueueAt(queue, TIME_BASE, TIME_BASE + 3 * SLOT_US) == JIT_ERROR_OK);
+    // first packet is missed
+    int idx;
+    assert(jit_peek(&queue, TIME_BASE + 3 * SLOT_US - 10000, &idx) == JIT_ERROR_OK);
+    assert(idx >= 0);
+    assert(queue.num_dropped == 1);
+    assert(queue.num_pkt == 1);
+    struct lgw_pkt_tx_s pkt;
+    enum jit_pkt_type_e pktType;
+    assert(jit_dequeue(&queue, idx, &pkt, &pktType) == JIT_ERROR_OK);
+    assert(pkt.count_us == TIME_BASE + 3 * SLOT_US);
+    // free slot
+    assert(jit_dequeue(&queue, idx, &pkt, &pktType) == JIT_ERROR_EMPTY);
+    jit_queue_free(&queue);
+}
+
+int main() {
+    testOrder();
+    testCollision();
+    testOutdated();
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <string>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "lorawan/task/message-task-dispatcher.h"
+#include "lorawan/proto/gw/basic-udp.h"
+#include "lorawan/storage/service/identity-service-mem.h"
+#include "lorawan/helper/aes-helper.h"
+#include "lorawan/helper/codec-helper.h"
+#include "lorawan/lorawan-conv.h"
+#include "lorawan/lorawan-error.h"
+#include "lorawan/lorawan-key.h"
+#include "lorawan/lorawan-mic.h"
+
+#define GW_1    0x1001
+#define GW_2    0x1002
+#define GW_3    0x1003
+
+/**
+ * Dispatcher sends Join-accept from this socket to the gateway address
+ */
+class TestSocket : public TaskSocket {
+public:
+    SOCKET openSocket() override {
+        sock = socket(AF_INET, SOCK_DGRAM, 0);
+        return sock;
+    }
+    void closeSocket() override {
+        close(sock);
+    }
+};
+
+static const KEY128 NWK_KEY("000102030405060708090a0b0c0d0e0f");
+
+static DEVEUI deviceEUI(
+    uint32_t n
+)
+{
+    return DEVEUI(0x70b3d50000000000ULL + n);
+}
+
+static void putDevice(
+    IdentityService &svc,
+    uint32_t n
+)
+{
+    DEVICEID did;
+    did.id.activation = OTAA;
+    did.id.devEUI = deviceEUI(n);
+    did.id.appEUI = DEVEUI(0x70b3d5ffffffffffULL);
+    did.id.nwkKey = NWK_KEY;
+    did.id.appKey = NWK_KEY;
+    svc.put(DEVADDR(n), did);
+}
+
+static GwPushData joinRequest(
+    uint32_t n,
+    uint16_t devNonce,
+    uint64_t gwId,
+    float lsnr
+)
+{
+    JOIN_REQUEST_HEADER h {};
+    h.mhdr.f.mtype = MTYPE_JOIN_REQUEST;
+    h.frame.joinEUI = DEVEUI(0x70b3d5ffffffffffULL);
+    h.frame.devEUI = deviceEUI(n);
+    h.frame.devNonce.u = devNonce;
+    h.mic = NTOH4(calculateMICJoinRequest(&h, NWK_KEY));
+    GwPushData r;
+    setLORAWAN_MESSAGE_STORAGE(r.rxData, &h, SIZE_JOIN_REQUEST_HEADER);
+    memset(&r.rxMetadata, 0, sizeof(r.rxMetadata));
+    r.rxMetadata.gatewayId = gwId;
+    r.rxMetadata.tmst = 1000000;
+    r.rxMetadata.freq = 868100000;
+    r.rxMetadata.modu = MODULATION_LORA;
+    r.rxMetadata.bandwidth = BANDWIDTH_INDEX_125KHZ;
+    r.rxMetadata.spreadingFactor = DRLORA_SF7;
+    r.rxMetadata.codingRate = CRLORA_4_5;
+    r.rxMetadata.lsnr = lsnr;
+    return r;
+}
+
+/**
+ * Receive PULL_RESP, decrypt Join-accept and check MIC
+ * @return gateway identifier from the PULL_RESP prefix
+ */
+static uint64_t receiveJoinAccept(
+    int sock,
+    JOIN_ACCEPT_FRAME &retVal
+)
+{
+    char buf[1024];
+    ssize_t sz = recv(sock, buf, sizeof(buf) - 1, 0);
+    assert(sz > SIZE_SEMTECH_PREFIX_GW);
+    buf[sz] = '\0';
+    std::string s(buf + SIZE_SEMTECH_PREFIX_GW, sz - SIZE_SEMTECH_PREFIX_GW);
+    // RX1 window: uplink tmst + 5s
+    assert(s.find("\"tmst\":6000000") != std::string::npos);
+    assert(s.find("\"ipol\": true") != std::string::npos);
+    auto d = s.find("\"data\":\"");
+    assert(d != std::string::npos);
+    d += 8;
+    auto e = s.find('"', d);
+    uint8_t frame[64];
+    int fsz = base64Decode(frame, sizeof(frame), s.c_str() + d, e - d);
+    assert(fsz == 1 + SIZE_JOIN_ACCEPT_FRAME);
+    assert(((MHDR *) frame)->f.mtype == MTYPE_JOIN_ACCEPT);
+    memmove(&retVal, frame + 1, SIZE_JOIN_ACCEPT_FRAME);
+    encryptJoinAcceptResponse(retVal, NWK_KEY);     // XOR is symmetric
+    uint8_t micBuf[1 + SIZE_JOIN_ACCEPT_FRAME];
+    micBuf[0] = frame[0];
+    memmove(micBuf + 1, &retVal, SIZE_JOIN_ACCEPT_FRAME);
+    assert(NTOH4(calculateMICJoinResponse(*(const JOIN_ACCEPT_FRAME *) micBuf, NWK_KEY)) == retVal.mic);
+    return ((SEMTECH_PREFIX_GW *) buf)->mac.u;
+}
+
+/**
+ * LoRaWAN 1.0.x session keys: aes128_encrypt(NwkKey, tag | JoinNonce | NetID | DevNonce | pad16).
+ * Expected keys are AES-128-ECB of the blocks computed by OpenSSL
+ */
+static void testSessionKeys()
+{
+    KEY128 key;
+    const uint8_t k[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+    memmove(key.c, k, sizeof(k));
+    // bytes as they are sent over the air, little endian
+    JOINNONCE joinNonce;
+    joinNonce.c[0] = 0x56;
+    joinNonce.c[1] = 0x34;
+    joinNonce.c[2] = 0x12;
+    NETID netId;
+    netId.c[0] = 0x13;
+    netId.c[1] = 0;
+    netId.c[2] = 0;
+    DEVNONCE devNonce;
+    devNonce.c[0] = 0xcd;
+    devNonce.c[1] = 0xab;
+    // block 02563412130000cdab00000000000000
+    const uint8_t expectedAppSKey[16] = { 0x0f, 0xf0, 0xa4, 0x65, 0x7a, 0x03, 0xca, 0x86, 0xa5, 0x74, 0x0f, 0xf1, 0xda, 0x31, 0x4e, 0x3d };
+    // block 01563412130000cdab00000000000000
+    const uint8_t expectedNwkSKey[16] = { 0xc6, 0x70, 0xe8, 0x57, 0x56, 0x69, 0x70, 0x41, 0xd6, 0x92, 0x59, 0x80, 0x07, 0x45, 0x84, 0x24 };
+    KEY128 appSKey, nwkSKey;
+    deriveAppSKey(appSKey, key, netId, joinNonce, devNonce);
+    deriveFNwkSIntKey(nwkSKey, key, netId, joinNonce, devNonce);
+    assert(memcmp(appSKey.c, expectedAppSKey, sizeof(expectedAppSKey)) == 0);
+    assert(memcmp(nwkSKey.c, expectedNwkSKey, sizeof(expectedNwkSKey)) == 0);
+}
+
+int main() {
+    testSessionKeys();
+    MemoryIdentityService svc;
+    DirectClient client;
+    client.svcIdentity = &svc;
+    for (uint32_t n = 1; n <= 3; n++) {
+        putDevice(svc, n);
+    }
+
+    MessageTaskDispatcher dispatcher;
+    dispatcher.setIdentityClient(&client);
+    GatewayBasicUdpProtocol parser(&dispatcher);
+    dispatcher.addParser(&parser);
+
+    TestSocket taskSocket;
+    assert(taskSocket.openSocket() >= 0);
+    // gateway
+    int gwSock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in gwAddr {};
+    gwAddr.sin_family = AF_INET;
+    gwAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(gwSock, (struct sockaddr *) &gwAddr, sizeof(gwAddr)) == 0);
+    socklen_t len = sizeof(gwAddr);
+    getsockname(gwSock, (struct sockaddr *) &gwAddr, &len);
+    struct timeval tv { 1, 0 };
+    setsockopt(gwSock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    const struct sockaddr &addr = *(const struct sockaddr *) &gwAddr;
+
+    TASK_TIME t0 = TASK_CLOCK::now();
+    auto due = t0 + std::chrono::milliseconds(DEF_JOIN_COLLECT_MS);
+
+    // heard by two gateways, duplicate merged, reply via gateway with better SNR
+    GwPushData jr1 = joinRequest(1, 7, GW_1, 2.0);
+    GwPushData jr1dup = joinRequest(1, 7, GW_2, 8.5);
+    dispatcher.pushData(&taskSocket, addr, jr1, t0, &parser);
+    dispatcher.pushData(&taskSocket, addr, jr1dup, t0, &parser);
+    assert(dispatcher.metrics.duplicates.get() == 1);
+    assert(dispatcher.joinPipeline.size() == 1);
+    // duplicates are still collected
+    assert(dispatcher.joinPipeline.process(t0) == 0);
+    assert(dispatcher.joinPipeline.waitMicroseconds(t0) == DEF_JOIN_COLLECT_MS * 1000);
+    assert(dispatcher.joinPipeline.process(due) == 1);
+    assert(dispatcher.metrics.joinAccepts.get() == 1);
+    JOIN_ACCEPT_FRAME ja {};
+    assert(receiveJoinAccept(gwSock, ja) == GW_2);
+    assert(ja.hdr.devAddr == DEVADDR(1));
+    assert(ja.hdr.joinNonce.get() == 1);
+    // session keys are stored
+    DEVICEID did;
+    assert(svc.get(did, DEVADDR(1)) == CODE_OK);
+    KEY128 appSKey, nwkSKey;
+    deriveAppSKey(appSKey, NWK_KEY, ja.hdr.netId, ja.hdr.joinNonce, jr1.rxData.data.joinRequest.devNonce);
+    deriveFNwkSIntKey(nwkSKey, NWK_KEY, ja.hdr.netId, ja.hdr.joinNonce, jr1.rxData.data.joinRequest.devNonce);
+    assert(did.id.appSKey == appSKey);
+    assert(did.id.nwkSKey == nwkSKey);
+    assert(did.id.devNonce.u == 7);
+    assert(did.id.joinNonce.get() == 1);
+
+    // replayed DevNonce after Join-request expired in the queue
+    dispatcher.cleanupOldMessages(t0 + std::chrono::seconds(DEF_JOIN_EXPIRATION_SECONDS + 1));
+    assert(dispatcher.queue.joins.empty());
+    TASK_TIME t1 = TASK_CLOCK::now();
+    dispatcher.pushData(&taskSocket, addr, jr1, t1, &parser);
+    // unknown device
+    GwPushData jr9 = joinRequest(9, 1, GW_1, 2.0);
+    dispatcher.pushData(&taskSocket, addr, jr9, t1, &parser);
+    assert(dispatcher.joinPipeline.process(t1 + std::chrono::milliseconds(DEF_JOIN_COLLECT_MS)) == 2);
+    assert(dispatcher.metrics.joinReplays.get() == 1);
+    assert(dispatcher.metrics.joinUnknown.get() == 1);
+    assert(dispatcher.metrics.joinAccepts.get() == 1);
+
+    // gateway rate limit
+    dispatcher.joinPipeline.ratePerGateway = 1;
+    dispatcher.joinPipeline.burstPerGateway = 1;
+    TASK_TIME t2 = TASK_CLOCK::now();
+    GwPushData jr2 = joinRequest(2, 1, GW_3, 2.0);
+    GwPushData jr3 = joinRequest(3, 1, GW_3, 2.0);
+    dispatcher.pushData(&taskSocket, addr, jr2, t2, &parser);
+    dispatcher.pushData(&taskSocket, addr, jr3, t2, &parser);
+    assert(dispatcher.joinPipeline.process(t2 + std::chrono::milliseconds(DEF_JOIN_COLLECT_MS)) == 2);
+    assert(dispatcher.metrics.joinAccepts.get() == 2);
+    assert(dispatcher.metrics.joinRateLimited.get() == 1);
+    assert(receiveJoinAccept(gwSock, ja) == GW_3);
+
+    // too late for RX1, RX2 requires regional plan
+    dispatcher.joinPipeline.ratePerGateway = 0;
+    TASK_TIME t3 = TASK_CLOCK::now();
+    GwPushData jr3b = joinRequest(3, 2, GW_3, 2.0);
+    dispatcher.pushData(&taskSocket, addr, jr3b, t3, &parser);
+    assert(dispatcher.joinPipeline.process(t3 + std::chrono::seconds(5)) == 1);
+    assert(dispatcher.metrics.joinLate.get() == 1);
+
+    assert(dispatcher.metrics.joinRequests.get() == 6);
+    assert(dispatcher.metrics.joinStages[JOIN_STAGE_DERIVE].getCount() == 4);
+    assert(dispatcher.metrics.toPrometheus().find("tlns_join_stage_nanoseconds{stage=\"derive\"") != std::string::npos);
+    std::cout << dispatcher.metrics.toJsonString() << std::endl;
+
+    close(gwSock);
+    taskSocket.closeSocket();
+    return 0;
+}
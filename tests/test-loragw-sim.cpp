@@ -0,0 +1,183 @@
+/**
+ * LoraGatewayListener upstream, JIT and TX timing over the software concentrator (loragw-sim)
+ */
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <atomic>
+#include <thread>
+
+#include "lorawan/lorawan-error.h"
+#include "gateway-lora.h"
+#include "loragw-sim.h"
+#include "rak2287.h"
+#include "gateway-settings-helper.h"
+#include "gen/gateway-usb-conf.h"
+
+#define UPLINK_RATE     200     ///< packets per second
+#define UPLINK_COUNT    100
+#define TX_COUNT        10
+#define TX_DELAY_US     200000  ///< RX1 window is 1s, keep test short
+#define TX_INTERVAL_MS  100
+
+static std::atomic<size_t> pushCount(0);
+
+static void onPushData(
+    MessageTaskDispatcher* dispatcher,
+    const TaskSocket *taskSocket,
+    const sockaddr &addr,
+    SEMTECH_PROTOCOL_METADATA_RX metadata,
+    void *radioPacket,
+    size_t size
+)
+{
+    assert(size == 17);
+    assert(((uint8_t *) radioPacket)[0] == 0x40);
+    pushCount++;
+}
+
+static void testCounter()
+{
+    auto &c = SimulatedConcentrator::instance();
+    c.counterOffset = 0xffffffff - 50000;   // counter wraps around in 50ms
+    assert(lgw_start() == LGW_HAL_SUCCESS);
+    assert(lgw_start() == LGW_HAL_ERROR);
+    uint32_t t0;
+    assert(lgw_get_instcnt(&t0) == LGW_HAL_SUCCESS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    uint32_t t1;
+    lgw_get_instcnt(&t1);
+    assert(t1 < t0);
+    assert((uint32_t) (t1 - t0) >= 100000);
+
+    // TX in the past is late, TX status changes scheduled -> emitting -> free
+    struct lgw_pkt_tx_s pkt {};
+    pkt.tx_mode = TIMESTAMPED;
+    pkt.modulation = MOD_LORA;
+    pkt.bandwidth = BW_125KHZ;
+    pkt.datarate = DR_LORA_SF7;
+    pkt.coderate = CR_LORA_4_5;
+    pkt.preamble = 8;
+    pkt.size = 12;
+    lgw_get_instcnt(&pkt.count_us);
+    pkt.count_us -= 1000;
+    assert(lgw_send(&pkt) == LGW_HAL_SUCCESS);
+    lgw_get_instcnt(&pkt.count_us);
+    pkt.count_us += 50000;
+    assert(lgw_send(&pkt) == LGW_HAL_SUCCESS);
+    uint8_t status;
+    assert(lgw_status(0, TX_STATUS, &status) == LGW_HAL_SUCCESS);
+    assert(status == TX_SCHEDULED);
+    std::this_thread::sleep_for(std::chrono::milliseconds(55));
+    lgw_status(0, TX_STATUS, &status);
+    assert(status == TX_EMITTING);
+    std::this_thread::sleep_for(std::chrono::milliseconds(lgw_time_on_air(&pkt) + 5));
+    lgw_status(0, TX_STATUS, &status);
+    assert(status == TX_FREE);
+
+    auto s = c.stats();
+    assert(s.sent == 2);
+    assert(s.late == 1);
+    assert(s.minLeadUs < 0);
+    assert(s.maxLeadUs > 45000);
+    lgw_stop();
+    c.reset();
+    c.counterOffset = 0;
+}
+
+static void testFifoOverflow()
+{
+    auto &c = SimulatedConcentrator::instance();
+    SimulatedPacketStream stream;
+    stream.packetsPerSecond = 1000;
+    stream.count = SIM_RX_FIFO_SIZE * 2;
+    assert(lgw_start() == LGW_HAL_SUCCESS);
+    c.setStream(stream);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    struct lgw_pkt_rx_s rx[SIM_RX_FIFO_SIZE * 2];
+    int n = lgw_receive(SIM_RX_FIFO_SIZE * 2, rx);
+    assert(n == SIM_RX_FIFO_SIZE);
+    // tmst grows with arrival time, 1ms apart
+    for (int i = 1; i < n; i++) {
+        assert(rx[i].count_us - rx[i - 1].count_us == 1000);
+        assert(rx[i].status == STAT_CRC_OK);
+    }
+    auto s = c.stats();
+    assert(s.generated == SIM_RX_FIFO_SIZE * 2);
+    assert(s.dropped == SIM_RX_FIFO_SIZE);
+    lgw_stop();
+    c.reset();
+    c.setStream(SimulatedPacketStream());
+}
+
+static void testListener()
+{
+    auto &c = SimulatedConcentrator::instance();
+    size_t regionIndex = findGatewayRegionIndex(lorawanGatewaySettings, "EU863");
+    GatewaySettings *settings = &lorawanGatewaySettings[regionIndex];
+
+    LoraGatewayListener listener;
+    listener.init(settings, nullptr);
+    listener.flags = FLAG_GATEWAY_LISTENER_NO_BEACON;
+    listener.setOnPushData(onPushData);
+
+    SimulatedPacketStream stream;
+    stream.packetsPerSecond = UPLINK_RATE;
+    stream.count = UPLINK_COUNT;
+    stream.poisson = true;
+    c.setStream(stream);
+    assert(listener.start() == CODE_OK);
+    assert(listener.eui == c.eui);
+
+    int rfChain = 0;
+    for (; rfChain < LGW_RF_CHAIN_NB; rfChain++) {
+        if (settings->sx130x.rfConfs[rfChain].tx_enable)
+            break;
+    }
+    assert(rfChain < LGW_RF_CHAIN_NB);
+    for (int i = 0; i < TX_COUNT; i++) {
+        TxPacket tx;
+        tx.pkt.rf_chain = (uint8_t) rfChain;
+        tx.pkt.freq_hz = 869525000;
+        tx.pkt.tx_mode = TIMESTAMPED;
+        tx.pkt.count_us = c.counter() + TX_DELAY_US;
+        tx.pkt.rf_power = settings->sx130x.txLut[rfChain].lut[0].rf_power;
+        tx.pkt.modulation = MOD_LORA;
+        tx.pkt.bandwidth = BANDWIDTH_INDEX_125KHZ;
+        tx.pkt.datarate = DR_LORA_SF7;
+        tx.pkt.coderate = CR_LORA_4_5;
+        tx.pkt.invert_pol = true;
+        tx.pkt.size = 12;
+        assert(listener.enqueueTxPacket(tx) == CODE_OK);
+        // JIT queue rejects packets closer than time on air plus guard time
+        std::this_thread::sleep_for(std::chrono::milliseconds(TX_INTERVAL_MS));
+    }
+
+    for (int i = 0; i < 100; i++) {
+        if (pushCount == UPLINK_COUNT && c.stats().sent == TX_COUNT)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    listener.stop(1);
+
+    auto s = c.stats();
+    std::cerr << s.toJsonString() << std::endl;
+    assert(s.dropped == 0);
+    assert(pushCount == UPLINK_COUNT);
+    assert(s.received == UPLINK_COUNT);
+    assert(s.sent == TX_COUNT);
+    assert(s.late == 0);
+    assert(s.minLeadUs >= SIM_TX_START_DELAY_US);
+    for (auto &t : c.transmitted()) {
+        assert(t.pkt.freq_hz == 869525000);
+        assert(t.pkt.bandwidth == BW_125KHZ);
+    }
+    assert(listener.measurements.get(meas_nb_tx_ok) == TX_COUNT);
+}
+
+int main() {
+    testCounter();
+    testFifoOverflow();
+    testListener();
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include "lorawan/task/message-ready-list.h"
+
+#define PRODUCERS   4
+#define PER_PRODUCER 10000
+
+static void testOrder()
+{
+    MessageReadyList l;
+    assert(l.empty());
+    DEVADDR a(1), b(2), c(3);
+    l.pushLocal(a);
+    bool wasEmpty = l.push(b);
+    assert(wasEmpty);
+    wasEmpty = l.push(c);
+    assert(!wasEmpty);
+    std::vector<DEVADDR> r;
+    size_t count = l.pop(r);
+    assert(count == 3);
+    assert(r[0] == a && r[1] == b && r[2] == c);
+    assert(l.empty());
+    wasEmpty = l.push(a);
+    assert(wasEmpty);
+}
+
+static void testProducers()
+{
+    MessageReadyList l;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; p++) {
+        threads.emplace_back([&l, p] {
+            for (uint32_t i = 0; i < PER_PRODUCER; i++) {
+                l.push(DEVADDR((uint32_t) (p * PER_PRODUCER + i)));
+            }
+        });
+    }
+    std::vector<DEVADDR> r;
+    while (r.size() < PRODUCERS * PER_PRODUCER)
+        l.pop(r);
+    for (auto &t : threads) {
+        t.join();
+    }
+    // each producer's addresses are in order
+    uint32_t last[PRODUCERS];
+    for (auto &v : last) {
+        v = 0;
+    }
+    for (auto &a : r) {
+        uint32_t v = a.u;
+        int p = (int) (v / PER_PRODUCER);
+        assert(v + 1 > last[p]);
+        last[p] = v + 1;
+    }
+    assert(l.empty());
+}
+
+int main(int argc, char **argv)
+{
+    testOrder();
+    testProducers();
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "lorawan/task/message-task-dispatcher.h"
+#include "lorawan/task/packet-capture.h"
+#include "lorawan/task/packet-replay.h"
+#include "lorawan/proto/gw/basic-udp.h"
+#include "lorawan/storage/service/identity-service-mem.h"
+#include "lorawan/lorawan-string.h"
+#include "lorawan/lorawan-error.h"
+
+#define PACKET_COUNT        20
+#define PACKET_INTERVAL_MS  10
+
+static const std::string CAPTURE_FILE_NAME("test-packet-capture.cap");
+static const std::string RECAPTURE_FILE_NAME("test-packet-recapture.cap");
+
+// PUSH_DATA with one rxpk, see test-decode-rxpk.cpp
+static const char *PUSH_DATA_HEX = "02bbe50000006cc3743eed467b227278706b223a5b7b22746d7374223a343032333131313534302c"
+    "226368616e223a332c2272666368223a302c2266726571223a3836342e3730303030302c2273746174223a312c226d6f6475223a22"
+    "4c4f5241222c2264617472223a22534631324257313235222c22636f6472223a22342f35222c226c736e72223a2d31382e352c2272"
+    "737369223a2d3132312c2273697a65223a33372c2264617461223a22514441445251474151774143334749312b374553394d697030"
+    "356a436c6f536f464e367a634b65437877394d7357457634513d3d227d5d7d";
+
+static struct sockaddr_in gatewayAddress()
+{
+    struct sockaddr_in a {};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(1700);
+    a.sin_addr.s_addr = htonl(0x0a000001);
+    return a;
+}
+
+static void testFile()
+{
+    struct sockaddr_in a = gatewayAddress();
+    // capture keeps microseconds
+    TASK_TIME t0 = std::chrono::time_point_cast<std::chrono::microseconds>(TASK_CLOCK::now());
+    std::string large(5000, 'x');
+    {
+        PacketCaptureWriter w(64);  // small buffer, written to the file on each append
+        int rc = w.open(CAPTURE_FILE_NAME);
+        assert(rc == CODE_OK);
+        rc = w.append(t0, 3, (const sockaddr *) &a, sizeof(a), "abc", 3);
+        assert(rc == CODE_OK);
+        // from onReceiveRawData hook, no address
+        rc = w.append(t0 + std::chrono::milliseconds(5), 4, nullptr, 0, large.c_str(), large.size());
+        assert(rc == CODE_OK);
+        rc = w.append(t0 + std::chrono::seconds(1), 3, (const sockaddr *) &a, sizeof(a), "", 0);
+        assert(rc == CODE_OK);
+        assert(w.size() == 3);
+    }
+    PacketCaptureReader r;
+    int rc = r.open(CAPTURE_FILE_NAME);
+    assert(rc == CODE_OK);
+    PacketCaptureRecord rec;
+    rc = r.next(rec);
+    assert(rc == 1);
+    assert(rec.socketId == 3 && rec.data == "abc");
+    assert(rec.addrLen == sizeof(a) && memcmp(&rec.addr, &a, sizeof(a)) == 0);
+    assert(rec.receivedTime == t0);
+    rc = r.next(rec);
+    assert(rc == 1);
+    assert(rec.socketId == 4 && rec.data == large && rec.addrLen == 0);
+    assert(rec.receivedTime - t0 == std::chrono::milliseconds(5));
+    rc = r.next(rec);
+    assert(rc == 1);
+    assert(rec.data.empty() && rec.addrLen == sizeof(a));
+    rc = r.next(rec);
+    assert(rc == 0);
+    r.close();
+
+    // torn record at the end
+    std::string content;
+    {
+        std::ifstream f(CAPTURE_FILE_NAME, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream f(CAPTURE_FILE_NAME, std::ios::binary | std::ios::trunc);
+        f.write(content.c_str(), (std::streamsize) content.size() - 3);
+    }
+    rc = r.open(CAPTURE_FILE_NAME);
+    assert(rc == CODE_OK);
+    rc = r.next(rec);
+    assert(rc == 1);
+    rc = r.next(rec);
+    assert(rc == 1);
+    rc = r.next(rec);
+    assert(rc == 0);
+    r.close();
+
+    // not a capture file
+    {
+        std::ofstream f(CAPTURE_FILE_NAME, std::ios::binary | std::ios::trunc);
+        f << "not a capture file";
+    }
+    rc = r.open(CAPTURE_FILE_NAME);
+    assert(rc == ERR_CODE_INVALID_PACKET);
+    rc = r.open("nonexistent.cap");
+    assert(rc == ERR_CODE_CAPTURE_OPEN);
+}
+
+static void waitPushData(
+    MessageTaskDispatcher &dispatcher,
+    size_t count
+)
+{
+    for (int i = 0; i < 500 && dispatcher.metrics.pushData.get() < count; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(dispatcher.metrics.pushData.get() == count);
+}
+
+static void testReplay()
+{
+    struct sockaddr_in a = gatewayAddress();
+    std::string pushData = hex2string(PUSH_DATA_HEX);
+    TASK_TIME t0 = TASK_CLOCK::now() - std::chrono::hours(1);
+    {
+        PacketCaptureWriter w;
+        int rc = w.open(CAPTURE_FILE_NAME);
+        assert(rc == CODE_OK);
+        for (int i = 0; i < PACKET_COUNT; i++) {
+            w.append(t0 + std::chrono::milliseconds(i * PACKET_INTERVAL_MS), 3, (const sockaddr *) &a, sizeof(a),
+                pushData.c_str(), pushData.size());
+        }
+    }
+
+    MemoryIdentityService svc;
+    DirectClient client;
+    client.svcIdentity = &svc;
+    MessageTaskDispatcher dispatcher;
+    dispatcher.setIdentityClient(&client);
+    GatewayBasicUdpProtocol parser(&dispatcher);
+    dispatcher.addParser(&parser);
+    auto replaySocket = new TaskReplaySocket;
+    dispatcher.sockets.push_back(replaySocket);
+    // record what dispatcher has processed
+    PacketCaptureWriter recapture;
+    int rc = recapture.open(RECAPTURE_FILE_NAME);
+    assert(rc == CODE_OK);
+    dispatcher.capture = &recapture;
+    dispatcher.start();
+    for (int i = 0; i < 100 && dispatcher.state != TASK_RUN; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(dispatcher.state == TASK_RUN);
+
+    // as fast as possible
+    PacketReplay fast(replaySocket, false);
+    rc = fast.run(CAPTURE_FILE_NAME);
+    assert(rc == CODE_OK);
+    assert(fast.count == PACKET_COUNT);
+    waitPushData(dispatcher, PACKET_COUNT);
+    // ACKs are discarded
+    assert(replaySocket->replies == PACKET_COUNT);
+
+    // real time
+    auto start = std::chrono::steady_clock::now();
+    PacketReplay realTime(replaySocket, true);
+    rc = realTime.run(CAPTURE_FILE_NAME);
+    assert(rc == CODE_OK);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    assert(elapsed >= (PACKET_COUNT - 1) * PACKET_INTERVAL_MS);
+    waitPushData(dispatcher, PACKET_COUNT * 2);
+    assert(replaySocket->received == PACKET_COUNT * 2);
+
+    dispatcher.stop();
+    dispatcher.capture = nullptr;
+    recapture.close();
+
+    // dispatcher received packets with captured source address and intervals
+    PacketCaptureReader r;
+    rc = r.open(RECAPTURE_FILE_NAME);
+    assert(rc == CODE_OK);
+    PacketCaptureRecord rec;
+    TASK_TIME first;
+    for (int i = 0; i < PACKET_COUNT * 2; i++) {
+        rc = r.next(rec);
+        assert(rc == 1);
+        assert(rec.addrLen == sizeof(a) && memcmp(&rec.addr, &a, sizeof(a)) == 0);
+        assert(rec.data == pushData);
+        if (i % PACKET_COUNT == 0)
+            first = rec.receivedTime;
+        assert(rec.receivedTime - first == std::chrono::milliseconds((i % PACKET_COUNT) * PACKET_INTERVAL_MS));
+    }
+    rc = r.next(rec);
+    assert(rc == 0);
+    std::cout << dispatcher.metrics.toJsonString() << std::endl;
+}
+
+int main() {
+    testFile();
+    testReplay();
+    remove(CAPTURE_FILE_NAME.c_str());
+    remove(RECAPTURE_FILE_NAME.c_str());
+    return 0;
+}
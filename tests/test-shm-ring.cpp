@@ -0,0 +1,212 @@
+/**
+ * Shared memory ring bridge: C reader gets records written by ShmRingBridge, new reader starts at the head,
+ * lapped reader skips lost records, concurrent readers never see torn records
+ */
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <unistd.h>
+
+#include "lorawan/bridge/shm-ring-bridge.h"
+#include "lorawan/lorawan-error.h"
+
+#define RING_FILE_NAME      "test-shm-ring.ring"
+#define CONCURRENT_COUNT    200000
+
+static const uint64_t GW_1 = 0x0102030405060708;
+static const uint64_t GW_2 = 0x1112131415161718;
+
+static void setItem(
+    MessageQueueItem &item,
+    uint32_t i
+)
+{
+    item.radioPacket.mhdr.f.mtype = MTYPE_UNCONFIRMED_DATA_UP;
+    item.radioPacket.data.uplink.devaddr.u = i;
+    item.radioPacket.data.uplink.f.foptslen = 0;
+    item.radioPacket.data.uplink.fcnt = (uint16_t) i;
+    item.radioPacket.data.uplink.setFport(2);
+    item.radioPacket.data.uplink.setPayload(&i, sizeof(i));
+    item.radioPacket.payloadSize = sizeof(i);
+}
+
+// record must be consistent: address, frame counter and payload are written from the same number
+static uint32_t checkRecord(
+    const shm_ring_record &r
+)
+{
+    uint32_t a = shm_ring_record_addr(&r);
+    assert(shm_ring_record_fcnt(&r) == (uint16_t) a);
+    assert(shm_ring_record_fport(&r) == 2);
+    size_t sz;
+    const uint8_t *p = shm_ring_record_payload(&r, &sz);
+    assert(sz == sizeof(uint32_t));
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    assert(v == a);
+    assert(r.seq == (uint64_t) a + 1);
+    return a;
+}
+
+static void testReadWrite()
+{
+    unlink(RING_FILE_NAME);
+    ShmRingBridge bridge;
+    int rc = bridge.init(RING_FILE_NAME, "10", nullptr);
+    assert(rc == CODE_OK);
+
+    shm_ring_reader reader;
+    rc = shm_ring_open(&reader, RING_FILE_NAME);
+    assert(rc == 0);
+    assert(reader.header->capacity == 16);
+    shm_ring_record r;
+    rc = shm_ring_read(&reader, &r);
+    assert(rc == 0);
+
+    std::vector<AppBridgePayload> batch;
+    MessageQueueItem item;
+    struct sockaddr addr {};
+    SEMTECH_PROTOCOL_METADATA_RX rx {};
+    rx.freq = 868100000;
+    rx.rssi = -100;
+    rx.lsnr = -2.5;
+    rx.spreadingFactor = DRLORA_SF7;
+    item.metadata[GW_1] = GatewayMetadata(nullptr, addr, METADATA_TYPE_RX, rx, nullptr);
+    rx.rssi = -50;
+    rx.lsnr = 7.5;
+    item.metadata[GW_2] = GatewayMetadata(nullptr, addr, METADATA_TYPE_RX, rx, nullptr);
+    for (uint32_t i = 0; i < 10; i++) {
+        setItem(item, i);
+        batch.emplace_back(item, true, i % 2 == 0);
+    }
+    bridge.onPayloadBatch(nullptr, batch);
+    assert(bridge.written() == 10);
+    assert(shm_ring_lag(&reader) == 10);
+    for (uint32_t i = 0; i < 10; i++) {
+        rc = shm_ring_read(&reader, &r);
+        assert(rc == 1);
+        uint32_t a = checkRecord(r);
+        assert(a == i);
+        assert(r.gateway_id == GW_2 && r.gateways == 2);
+        assert(r.rssi == -50 && r.lsnr == 75 && r.freq == 868100000 && r.spreading_factor == 7);
+        assert(r.flags == (SHM_RING_FLAG_DECODED | (i % 2 == 0 ? SHM_RING_FLAG_MIC_MATCHED : 0)));
+        long long dt = (long long) (r.time / 1000000) - (long long) time(nullptr);
+        assert(dt >= -1 && dt <= 1);
+    }
+    rc = shm_ring_read(&reader, &r);
+    assert(rc == 0);
+    assert(reader.lost == 0);
+
+    // new reader starts with the next record written
+    shm_ring_reader reader2;
+    rc = shm_ring_open(&reader2, RING_FILE_NAME);
+    assert(rc == 0);
+    rc = shm_ring_read(&reader2, &r);
+    assert(rc == 0);
+    setItem(item, 10);
+    bridge.onPayload(nullptr, &item, true, true);
+    rc = shm_ring_read(&reader2, &r);
+    assert(rc == 1 && checkRecord(r) == 10);
+    rc = shm_ring_read(&reader, &r);
+    assert(rc == 1 && checkRecord(r) == 10);
+
+    // lapped reader skips overwritten records
+    for (uint32_t i = 11; i < 100; i++) {
+        setItem(item, i);
+        bridge.onPayload(nullptr, &item, true, true);
+    }
+    uint32_t last = 10;
+    size_t c = 0;
+    while (shm_ring_read(&reader, &r) > 0) {
+        uint32_t a = checkRecord(r);
+        assert(a > last);
+        last = a;
+        c++;
+    }
+    assert(last == 99);
+    assert(reader.lost > 0 && c + reader.lost == 89);
+    shm_ring_close(&reader2);
+
+    // writer continues after restart
+    bridge.done();
+    ShmRingBridge bridge2;
+    rc = bridge2.init(RING_FILE_NAME, "16", nullptr);
+    assert(rc == CODE_OK);
+    assert(bridge2.written() == 100);
+    setItem(item, 100);
+    bridge2.onPayload(nullptr, &item, true, true);
+    rc = shm_ring_read(&reader, &r);
+    assert(rc == 1 && checkRecord(r) == 100);
+    shm_ring_close(&reader);
+    bridge2.done();
+
+    // invalid file
+    rc = shm_ring_open(&reader, "nonexistent.ring");
+    assert(rc == -1);
+    unlink(RING_FILE_NAME);
+}
+
+/**
+ * Two readers follow the writer
+ */
+static void testConcurrent()
+{
+    unlink(RING_FILE_NAME);
+    ShmRingBridge bridge;
+    int rc = bridge.init(RING_FILE_NAME, "1024", nullptr);
+    assert(rc == CODE_OK);
+    std::atomic<bool> stopped(false);
+    std::atomic<int> opened(0);
+    size_t counts[2] = { 0, 0 };
+    uint64_t lost[2] = { 0, 0 };
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; t++) {
+        readers.emplace_back([&stopped, &opened, &counts, &lost, t] {
+            shm_ring_reader reader;
+            int rc = shm_ring_open(&reader, RING_FILE_NAME);
+            assert(rc == 0);
+            assert(reader.next == 0);
+            opened++;
+            shm_ring_record r;
+            int64_t last = -1;
+            for (;;) {
+                bool s = stopped;
+                if (shm_ring_read(&reader, &r) > 0) {
+                    uint32_t a = checkRecord(r);
+                    assert((int64_t) a > last);
+                    last = a;
+                    counts[t]++;
+                } else if (s)
+                    break;
+            }
+            lost[t] = reader.lost;
+            shm_ring_close(&reader);
+        });
+    }
+    while (opened < 2) {
+        std::this_thread::yield();
+    }
+    MessageQueueItem item;
+    for (uint32_t i = 0; i < CONCURRENT_COUNT; i++) {
+        setItem(item, i);
+        bridge.onPayload(nullptr, &item, true, true);
+    }
+    stopped = true;
+    for (auto &t : readers) {
+        t.join();
+    }
+    for (int t = 0; t < 2; t++) {
+        std::cout << "reader " << t << " read " << counts[t] << " lost " << lost[t] << std::endl;
+        assert(counts[t] + lost[t] == CONCURRENT_COUNT);
+    }
+    bridge.done();
+    unlink(RING_FILE_NAME);
+}
+
+int main() {
+    testReadWrite();
+    testConcurrent();
+    return 0;
+}
@@ -0,0 +1,339 @@
+#include <string>
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "lorawan/lorawan-error.h"
+#include "lorawan/helper/file-helper.h"
+#include "lorawan/storage/service/storage-snapshot.h"
+#include "lorawan/storage/service/identity-service-mem.h"
+#include "lorawan/storage/service/identity-service-json.h"
+#include "lorawan/storage/service/gateway-service-mem.h"
+
+static const std::string IDENTITY_SNAPSHOT_FILE_NAME("test-identity.snapshot");
+static const std::string GATEWAY_SNAPSHOT_FILE_NAME("test-gateway.snapshot");
+static const std::string JOURNAL_DB_NAME("test-journal");
+static const std::string JSON_DB_NAME("test-identity.json");
+static const std::string JSON_EXPORT_NAME("test-identity-export.json");
+
+static void testIdentitySnapshot()
+{
+    std::map<DEVADDR, DEVICEID> m;
+    for (uint32_t i = 1; i <= 1000; i++) {
+        DEVADDR a(i * 3);
+        DEVICEID id;
+        id.id.devEUI.u = i;
+        m[a] = id;
+    }
+    int r = IdentitySnapshot::save(IDENTITY_SNAPSHOT_FILE_NAME, m);
+    assert(r == CODE_OK);
+
+    IdentitySnapshot s;
+    r = s.open(IDENTITY_SNAPSHOT_FILE_NAME);
+    assert(r == CODE_OK);
+    assert(s.size() == m.size());
+
+    DEVICEID id;
+    r = s.get(id, DEVADDR(300));
+    assert(r == CODE_OK);
+    assert(id.id.devEUI.u == 100);
+    r = s.get(id, DEVADDR(301));
+    assert(r == ERR_CODE_DEVICE_ADDRESS_NOTFOUND);
+
+    std::map<DEVADDR, DEVICEID> m2;
+    assert(s.load(m2) == m.size());
+    for (auto &v : m) {
+        auto f = m2.find(v.first);
+        assert(f != m2.end());
+        assert(f->second.id.devEUI.u == v.second.id.devEUI.u);
+    }
+    s.close();
+    file::rmFile(IDENTITY_SNAPSHOT_FILE_NAME);
+}
+
+static void testGatewaySnapshot()
+{
+    std::map<uint64_t, GatewayIdentity> m;
+    for (uint64_t i = 1; i <= 100; i++) {
+        GatewayIdentity gi;
+        gi.gatewayId = i << 32;
+        m[gi.gatewayId] = gi;
+    }
+    int r = GatewaySnapshot::save(GATEWAY_SNAPSHOT_FILE_NAME, m);
+    assert(r == CODE_OK);
+
+    GatewaySnapshot s;
+    r = s.open(GATEWAY_SNAPSHOT_FILE_NAME);
+    assert(r == CODE_OK);
+    assert(s.size() == m.size());
+
+    GatewayIdentity gi;
+    r = s.get(gi, 7ULL << 32);
+    assert(r == CODE_OK);
+    assert(gi.gatewayId == 7ULL << 32);
+    r = s.get(gi, 7);
+    assert(r == ERR_CODE_GATEWAY_NOT_FOUND);
+    s.close();
+    file::rmFile(GATEWAY_SNAPSHOT_FILE_NAME);
+}
+
+static void testInvalidSnapshot()
+{
+    // identity reader must refuse gateway snapshot
+    std::map<uint64_t, GatewayIdentity> m;
+    GatewaySnapshot::save(GATEWAY_SNAPSHOT_FILE_NAME, m);
+    IdentitySnapshot s;
+    int r = s.open(GATEWAY_SNAPSHOT_FILE_NAME);
+    assert(r == ERR_CODE_DB_DATABASE_OPEN);
+    r = s.open("not-exists.snapshot");
+    assert(r == ERR_CODE_DB_DATABASE_OPEN);
+    file::rmFile(GATEWAY_SNAPSHOT_FILE_NAME);
+
+    // count * record size overflows to 0
+    GatewayIdentity gi;
+    gi.gatewayId = 1;
+    m[gi.gatewayId] = gi;
+    GatewaySnapshot::save(GATEWAY_SNAPSHOT_FILE_NAME, m);
+    FILE *f = fopen(GATEWAY_SNAPSHOT_FILE_NAME.c_str(), "r+b");
+    uint64_t count = 1ULL << 61;
+    fseek(f, 8, SEEK_SET);
+    fwrite(&count, sizeof(count), 1, f);
+    fclose(f);
+    GatewaySnapshot g;
+    r = g.open(GATEWAY_SNAPSHOT_FILE_NAME);
+    assert(r == ERR_CODE_DB_DATABASE_OPEN);
+    file::rmFile(GATEWAY_SNAPSHOT_FILE_NAME);
+}
+
+static void testIdentityJournal()
+{
+    file::rmFile(JOURNAL_DB_NAME + SNAPSHOT_FILE_SUFFIX);
+    file::rmFile(JOURNAL_DB_NAME + JOURNAL_FILE_SUFFIX);
+    {
+        MemoryIdentityService s;
+        s.persistent = true;
+        int r = s.init(JOURNAL_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        for (uint32_t i = 1; i <= 100; i++) {
+            DEVICEID id;
+            id.id.devEUI.u = i;
+            r = s.put(DEVADDR(i), id);
+            assert(r == CODE_OK);
+        }
+        r = s.rm(DEVADDR(1));
+        assert(r == CODE_OK);
+        // no flush(), journal must be replayed
+    }
+    {
+        MemoryIdentityService s;
+        s.persistent = true;
+        int r = s.init(JOURNAL_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        assert(s.size() == 99);
+        DEVICEID id;
+        r = s.get(id, DEVADDR(50));
+        assert(r == CODE_OK);
+        assert(id.id.devEUI.u == 50);
+        // compact to the snapshot
+        s.flush();
+        r = s.rm(DEVADDR(2));
+        assert(r == CODE_OK);
+        s.done();
+    }
+    // torn record at the end of journal must be discarded
+    FILE *f = fopen((JOURNAL_DB_NAME + JOURNAL_FILE_SUFFIX).c_str(), "ab");
+    fwrite("P123", 4, 1, f);
+    fclose(f);
+    {
+        MemoryIdentityService s;
+        s.persistent = true;
+        int r = s.init(JOURNAL_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        assert(s.size() == 98);
+        DEVICEID id;
+        r = s.get(id, DEVADDR(2));
+        assert(r != CODE_OK);
+        id.id.devEUI.u = 1000;
+        r = s.put(DEVADDR(1000), id);
+        assert(r == CODE_OK);
+    }
+    {
+        MemoryIdentityService s;
+        s.persistent = true;
+        int r = s.init(JOURNAL_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        assert(s.size() == 99);
+    }
+    file::rmFile(JOURNAL_DB_NAME + SNAPSHOT_FILE_SUFFIX);
+    file::rmFile(JOURNAL_DB_NAME + JOURNAL_FILE_SUFFIX);
+}
+
+static void testGatewayJournal()
+{
+    file::rmFile(JOURNAL_DB_NAME + SNAPSHOT_FILE_SUFFIX);
+    file::rmFile(JOURNAL_DB_NAME + JOURNAL_FILE_SUFFIX);
+    {
+        MemoryGatewayService s;
+        s.persistent = true;
+        int r = s.init(JOURNAL_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        for (uint64_t i = 1; i <= 10; i++) {
+            GatewayIdentity gi;
+            gi.gatewayId = i;
+            r = s.put(gi);
+            assert(r == CODE_OK);
+        }
+        GatewayIdentity gi;
+        gi.gatewayId = 5;
+        r = s.rm(gi);
+        assert(r == CODE_OK);
+    }
+    {
+        MemoryGatewayService s;
+        s.persistent = true;
+        int r = s.init(JOURNAL_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        assert(s.size() == 9);
+    }
+    file::rmFile(JOURNAL_DB_NAME + SNAPSHOT_FILE_SUFFIX);
+    file::rmFile(JOURNAL_DB_NAME + JOURNAL_FILE_SUFFIX);
+    {
+        // journal is opt-in
+        MemoryGatewayService s;
+        int r = s.init(JOURNAL_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        GatewayIdentity gi;
+        gi.gatewayId = 1;
+        r = s.put(gi);
+        assert(r == CODE_OK);
+        assert(!file::fileExists(JOURNAL_DB_NAME + JOURNAL_FILE_SUFFIX));
+    }
+    file::rmFile(JOURNAL_DB_NAME + JOURNAL_FILE_SUFFIX);
+}
+
+static std::string readText(
+    const std::string &fileName
+)
+{
+    std::ifstream f(fileName);
+    return std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+}
+
+/**
+ * flush() compacts journal into the snapshot only, done() rewrites JSON file,
+ * exportJson() writes other file
+ */
+static void testJsonFlush()
+{
+    file::rmFile(JSON_DB_NAME + SNAPSHOT_FILE_SUFFIX);
+    file::rmFile(JSON_DB_NAME + JOURNAL_FILE_SUFFIX);
+    const std::string json("[{\"addr\": \"00000001\", \"deveui\": \"0000000000000001\"}]");
+    FILE *f = fopen(JSON_DB_NAME.c_str(), "w");
+    fputs(json.c_str(), f);
+    fclose(f);
+    {
+        JsonIdentityService s;
+        int r = s.init(JSON_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        assert(s.size() == 1);
+        DEVICEID id;
+        id.id.devEUI.u = 2;
+        r = s.put(DEVADDR(2), id);
+        assert(r == CODE_OK);
+        s.flush();
+        assert(file::fileExists(JSON_DB_NAME + SNAPSHOT_FILE_SUFFIX));
+        assert(readText(JSON_DB_NAME) == json);
+        bool exported = s.exportJson(JSON_EXPORT_NAME);
+        assert(exported);
+        s.done();
+        assert(readText(JSON_DB_NAME) == readText(JSON_EXPORT_NAME));
+    }
+    {
+        // loaded from the snapshot
+        JsonIdentityService s;
+        int r = s.init(JSON_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        assert(s.size() == 2);
+        s.done();
+    }
+    // JSON file has identities written on done()
+    file::rmFile(JSON_DB_NAME + SNAPSHOT_FILE_SUFFIX);
+    {
+        JsonIdentityService s;
+        int r = s.init(JSON_DB_NAME, nullptr);
+        assert(r == CODE_OK);
+        assert(s.size() == 2);
+        DEVICEID id;
+        r = s.get(id, DEVADDR(2));
+        assert(r == CODE_OK);
+        assert(id.id.devEUI.u == 2);
+        s.done();
+    }
+    file::rmFile(JSON_DB_NAME);
+    file::rmFile(JSON_EXPORT_NAME);
+    file::rmFile(JSON_DB_NAME + SNAPSHOT_FILE_SUFFIX);
+    file::rmFile(JSON_DB_NAME + JOURNAL_FILE_SUFFIX);
+}
+
+static void testListFrom()
+{
+    MemoryIdentityService s;
+    int r = s.init("", nullptr);
+    assert(r == CODE_OK);
+    for (uint32_t i = 1; i <= 10; i++) {
+        DEVICEID id;
+        id.id.devEUI.u = i;
+        r = s.put(DEVADDR(i), id);
+        assert(r == CODE_OK);
+    }
+    // pages of 3 addresses, cursor is last address of the previous page
+    std::vector<NETWORKIDENTITY> all;
+    std::vector<NETWORKIDENTITY> page;
+    DEVADDR cursor;
+    bool first = true;
+    do {
+        page.clear();
+        r = s.listFrom(page, first ? nullptr : &cursor, 3);
+        assert(r == CODE_OK);
+        if (!page.empty())
+            cursor = page.back().value.devaddr;
+        first = false;
+        all.insert(all.end(), page.begin(), page.end());
+    } while (page.size() == 3);
+    assert(all.size() == 10);
+    for (uint32_t i = 0; i < 10; i++) {
+        assert(all[i].value.devaddr.u == i + 1);
+    }
+    // base class implementation pages over list()
+    page.clear();
+    DEVADDR a(7);
+    r = s.IdentityService::listFrom(page, &a, 100);
+    assert(r == CODE_OK);
+    assert(page.size() == 3 && page[0].value.devaddr.u == 8);
+
+    MemoryGatewayService g;
+    for (uint64_t i = 1; i <= 5; i++) {
+        GatewayIdentity gi;
+        gi.gatewayId = i;
+        r = g.put(gi);
+        assert(r == CODE_OK);
+    }
+    std::vector<GatewayIdentity> gp;
+    uint64_t gc = 2;
+    r = g.listFrom(gp, &gc, 10);
+    assert(r == CODE_OK);
+    assert(gp.size() == 3 && gp[0].gatewayId == 3);
+}
+
+int main(int argc, char **argv) {
+    testIdentitySnapshot();
+    testGatewaySnapshot();
+    testInvalidSnapshot();
+    testIdentityJournal();
+    testGatewayJournal();
+    testJsonFlush();
+    testListFrom();
+    std::cout << "OK" << std::endl;
+    return 0;
+}
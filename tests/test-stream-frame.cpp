@@ -0,0 +1,148 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "lorawan/task/stream-frame.h"
+#include "lorawan/task/task-accepted-socket.h"
+#include "lorawan/lorawan-error.h"
+
+static std::string frame(
+    const std::string &message
+)
+{
+    char h[STREAM_FRAME_HEADER_SIZE];
+    StreamFrameBuffer::header(h, message.size());
+    return std::string(h, STREAM_FRAME_HEADER_SIZE) + message;
+}
+
+static void put(
+    StreamFrameBuffer &b,
+    const std::string &bytes
+)
+{
+    size_t sz;
+    char *p = b.space(sz);
+    assert(sz >= bytes.size());
+    memmove(p, bytes.c_str(), bytes.size());
+    b.received(bytes.size());
+}
+
+static std::vector<std::string> extract(
+    StreamFrameBuffer &b
+)
+{
+    std::vector<std::string> r;
+    const char *f;
+    size_t sz;
+    while (b.next(f, sz) > 0) {
+        r.emplace_back(f, sz);
+    }
+    return r;
+}
+
+static void testCoalesced()
+{
+    StreamFrameBuffer b;
+    put(b, frame("first") + frame("w") + frame("third message"));
+    auto r = extract(b);
+    assert(r.size() == 3);
+    assert(r[0] == "first" && r[1] == "w" && r[2] == "third message");
+    assert(b.size() == 0);
+}
+
+static void testSplit()
+{
+    StreamFrameBuffer b;
+    std::string s = frame("split message") + frame("next");
+    // one byte per read
+    std::vector<std::string> r;
+    for (char c : s) {
+        put(b, std::string(1, c));
+        auto m = extract(b);
+        r.insert(r.end(), m.begin(), m.end());
+    }
+    assert(r.size() == 2);
+    assert(r[0] == "split message" && r[1] == "next");
+    // header split, then message and half of the next one
+    std::string t = frame("abc") + frame("defgh");
+    put(b, t.substr(0, 2));
+    assert(extract(b).empty());
+    put(b, t.substr(2, 9));
+    r = extract(b);
+    assert(r.size() == 1 && r[0] == "abc");
+    put(b, t.substr(11));
+    r = extract(b);
+    assert(r.size() == 1 && r[0] == "defgh");
+}
+
+static void testTooLarge()
+{
+    StreamFrameBuffer b;
+    char h[STREAM_FRAME_HEADER_SIZE];
+    StreamFrameBuffer::header(h, STREAM_FRAME_MAX_SIZE + 1);
+    put(b, std::string(h, STREAM_FRAME_HEADER_SIZE));
+    const char *f;
+    size_t sz;
+    int r = b.next(f, sz);
+    assert(r == ERR_CODE_INVALID_PACKET);
+}
+
+static void testSocket()
+{
+    int fds[2];
+    int rc = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    assert(rc == 0);
+    TaskSocketPreNAcceptedSocket pa(nullptr, fds[0]);
+    TaskAcceptedSocket a(pa);
+    // client writes two messages at once
+    std::string request = frame("PUSH_DATA") + frame("m");
+    ssize_t c = write(fds[1], request.c_str(), request.size());
+    assert(c == (ssize_t) request.size());
+    c = a.receive();
+    assert(c == (ssize_t) request.size());
+    auto r = extract(a.frames);
+    assert(r.size() == 2 && r[0] == "PUSH_DATA" && r[1] == "m");
+    // replies are written at once by flush()
+    a.beginBatch();
+    c = a.sendMessage("ACK1", 4, nullptr, 0);
+    assert(c == 4);
+    c = a.sendMessage("ACK2", 4, nullptr, 0);
+    assert(c == 4);
+    std::string large(10000, 'x');
+    c = a.sendMessage(large.c_str(), large.size(), nullptr, 0);
+    assert(c == (ssize_t) large.size());
+    c = a.flush();
+    assert(c > 0);
+    // without batch reply is written immediately
+    c = a.sendMessage("ACK3", 4, nullptr, 0);
+    assert(c == 4);
+    StreamFrameBuffer client;
+    std::vector<std::string> replies;
+    while (replies.size() < 4) {
+        size_t sz;
+        char *p = client.space(sz);
+        c = read(fds[1], p, sz);
+        assert(c > 0);
+        client.received((size_t) c);
+        auto m = extract(client);
+        replies.insert(replies.end(), m.begin(), m.end());
+    }
+    assert(replies[0] == "ACK1" && replies[1] == "ACK2" && replies[2] == large && replies[3] == "ACK3");
+    // peer closed connection
+    close(fds[1]);
+    c = a.receive();
+    assert(c == 0);
+}
+
+int main() {
+    testCoalesced();
+    testSplit();
+    testTooLarge();
+    testSocket();
+    return 0;
+}
@@ -0,0 +1,255 @@
+/**
+ * Multi-concentrator gateway: worker process link over the socket pair, duplicate uplinks received by
+ * two concentrators are processed once, worker over the software concentrator (loragw-sim)
+ */
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "lorawan/lorawan-error.h"
+#include "lorawan/proto/gw/basic-udp.h"
+#include "lorawan/storage/service/identity-service-mem.h"
+#include "loragw-sim.h"
+#include "task-usb-worker-socket.h"
+#include "usb-gateway-worker.h"
+#include "gateway-settings-helper.h"
+#include "gen/gateway-usb-conf.h"
+
+#define UPLINK_COUNT    20
+#define SIM_UPLINK_RATE 200
+#define SIM_UPLINK_COUNT 50
+#define TX_DELAY_US     200000
+
+static const uint64_t EUI_1 = 0x0102030405060708;
+static const uint64_t EUI_2 = 0x1112131415161718;
+
+static std::atomic<size_t> processed(0);
+static std::atomic<size_t> processedByBoth(0);
+static std::atomic<size_t> pings(0);
+
+static void socketPair(
+    int fds[2]
+)
+{
+    int r = socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds);
+    assert(r == 0);
+}
+
+// unconfirmed data up from the address
+static std::string uplink(
+    uint32_t addr
+)
+{
+    uint8_t p[13] = { 0x40, (uint8_t) addr, (uint8_t) (addr >> 8), (uint8_t) (addr >> 16), (uint8_t) (addr >> 24),
+        0, 1, 0, 1, 0x55, 1, 2, 3 };
+    return std::string((const char *) p, sizeof(p));
+}
+
+static void sendUplink(
+    int sock,
+    uint64_t eui,
+    const std::string &packet
+)
+{
+    SEMTECH_PROTOCOL_METADATA_RX m {};
+    m.gatewayId = eui;
+    m.freq = 868100000;
+    m.rssi = -100;
+    ssize_t sz = sendUsbWorkerUplink(sock, eui, m, packet.c_str(), packet.size());
+    assert(sz > 0);
+}
+
+static void testRecord()
+{
+    int fds[2];
+    socketPair(fds);
+    struct lgw_pkt_tx_s pkt {};
+    pkt.freq_hz = 869525000;
+    pkt.size = 12;
+    ssize_t sz = sendUsbWorkerTx(fds[0], EUI_1, pkt);
+    assert(sz > 0);
+    uint32_t m[MEASUREMENT_COUNT_SIZE] = { 1, 2, 3 };
+    sz = sendUsbWorkerMeasurements(fds[0], EUI_1, m);
+    assert(sz > 0);
+    sz = send(fds[0], "x", 1, 0);
+    assert(sz == 1);
+
+    char buffer[USB_WORKER_RECORD_MAX_SIZE];
+    UsbWorkerRecord r;
+    sz = recv(fds[1], buffer, sizeof(buffer), 0);
+    int rc = r.parse(buffer, sz);
+    assert(rc == CODE_OK);
+    assert(r.type == UWR_TX && r.eui == EUI_1);
+    assert(r.tx.freq_hz == 869525000 && r.tx.size == 12);
+    sz = recv(fds[1], buffer, sizeof(buffer), 0);
+    rc = r.parse(buffer, sz);
+    assert(rc == CODE_OK);
+    assert(r.type == UWR_MEASUREMENTS && r.measurements[2] == 3);
+    sz = recv(fds[1], buffer, sizeof(buffer), 0);
+    rc = r.parse(buffer, sz);
+    assert(rc == ERR_CODE_INVALID_PACKET);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * Two concentrators receive the same uplinks
+ */
+static void testDuplicates()
+{
+    MemoryIdentityService svc;
+    DirectClient client;
+    client.svcIdentity = &svc;
+    MessageTaskDispatcher dispatcher;
+    dispatcher.setIdentityClient(&client);
+    GatewayBasicUdpProtocol parser(&dispatcher);
+    dispatcher.addParser(&parser);
+    dispatcher.onPushData = [] (
+        MessageTaskDispatcher* dispatcher,
+        MessageQueueItem *item
+    ) {
+        processed++;
+        if (item->metadata.size() == 2)
+            processedByBoth++;
+    };
+    dispatcher.onGatewayPing = [] (
+        MessageTaskDispatcher* dispatcher,
+        uint64_t id,
+        TaskSocket *taskSocket
+    ) {
+        assert(((TaskUsbWorkerSocket *) taskSocket)->eui == id);
+        pings++;
+    };
+
+    int fds1[2], fds2[2];
+    socketPair(fds1);
+    socketPair(fds2);
+    auto s1 = new TaskUsbWorkerSocket(fds1[0], "/dev/ttyACM0");
+    auto s2 = new TaskUsbWorkerSocket(fds2[0], "/dev/ttyACM1");
+    dispatcher.sockets.push_back(s1);
+    dispatcher.sockets.push_back(s2);
+
+    // records wait in the socket buffers until dispatcher starts
+    ssize_t sz = sendUsbWorkerHello(fds1[1], EUI_1);
+    assert(sz > 0);
+    sz = sendUsbWorkerHello(fds2[1], EUI_2);
+    assert(sz > 0);
+    for (uint32_t i = 0; i < UPLINK_COUNT; i++) {
+        sendUplink(fds1[1], EUI_1, uplink(0x01000000 + i));
+        sendUplink(fds2[1], EUI_2, uplink(0x01000000 + i));
+    }
+    uint32_t m[MEASUREMENT_COUNT_SIZE] {};
+    m[meas_nb_rx_rcv] = UPLINK_COUNT;
+    sz = sendUsbWorkerMeasurements(fds2[1], EUI_2, m);
+    assert(sz > 0);
+    sz = send(fds1[1], "x", 1, 0);
+    assert(sz == 1);
+
+    dispatcher.start();
+    for (int i = 0; i < 200 && (processed < UPLINK_COUNT || s2->measurements.get(meas_nb_rx_rcv) == 0); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    assert(pings == 2);
+    assert(s1->eui == EUI_1 && s2->eui == EUI_2);
+    assert(s1->uplinks == UPLINK_COUNT && s2->uplinks == UPLINK_COUNT);
+    assert(s1->errors == 1 && s2->errors == 0);
+    assert(s2->measurements.get(meas_nb_rx_rcv) == UPLINK_COUNT);
+    assert(dispatcher.metrics.uplinks.get() == UPLINK_COUNT * 2);
+    assert(dispatcher.metrics.duplicates.get() == UPLINK_COUNT);
+    // each uplink is processed once with metadata from both concentrators
+    assert(processed == UPLINK_COUNT);
+    assert(processedByBoth == UPLINK_COUNT);
+    dispatcher.stop();
+    close(fds1[1]);
+    close(fds2[1]);
+}
+
+/**
+ * Worker runs the software concentrator
+ */
+static void testWorker()
+{
+    auto &c = SimulatedConcentrator::instance();
+    size_t regionIndex = findGatewayRegionIndex(lorawanGatewaySettings, "EU863");
+    GatewaySettings *settings = &lorawanGatewaySettings[regionIndex];
+    int fds[2];
+    socketPair(fds);
+
+    SimulatedPacketStream stream;
+    stream.packetsPerSecond = SIM_UPLINK_RATE;
+    stream.count = SIM_UPLINK_COUNT;
+    c.setStream(stream);
+    UsbGatewayWorker worker(fds[1]);
+    worker.measurementsIntervalMs = 100;
+    int workerResult = -1;
+    std::thread t([&] {
+        workerResult = worker.run(settings, nullptr, FLAG_GATEWAY_LISTENER_NO_BEACON, 0, 0);
+    });
+
+    char buffer[USB_WORKER_RECORD_MAX_SIZE];
+    UsbWorkerRecord r;
+    ssize_t sz = recv(fds[0], buffer, sizeof(buffer), 0);
+    int rc = r.parse(buffer, sz);
+    assert(rc == CODE_OK);
+    assert(r.type == UWR_HELLO && r.eui == c.eui);
+
+    int rfChain = 0;
+    for (; rfChain < LGW_RF_CHAIN_NB; rfChain++) {
+        if (settings->sx130x.rfConfs[rfChain].tx_enable)
+            break;
+    }
+    TxPacket tx;
+    tx.pkt.rf_chain = (uint8_t) rfChain;
+    tx.pkt.freq_hz = 869525000;
+    tx.pkt.tx_mode = TIMESTAMPED;
+    tx.pkt.count_us = c.counter() + TX_DELAY_US;
+    tx.pkt.rf_power = settings->sx130x.txLut[rfChain].lut[0].rf_power;
+    tx.pkt.modulation = MOD_LORA;
+    tx.pkt.bandwidth = BANDWIDTH_INDEX_125KHZ;
+    tx.pkt.datarate = DR_LORA_SF7;
+    tx.pkt.coderate = CR_LORA_4_5;
+    tx.pkt.invert_pol = true;
+    tx.pkt.size = 12;
+    sz = sendUsbWorkerTx(fds[0], c.eui, tx.pkt);
+    assert(sz > 0);
+
+    size_t uplinks = 0;
+    bool measured = false;
+    struct timeval tv { 2, 0 };
+    setsockopt(fds[0], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    while (uplinks < SIM_UPLINK_COUNT || !measured) {
+        sz = recv(fds[0], buffer, sizeof(buffer), 0);
+        assert(sz > 0);
+        rc = r.parse(buffer, sz);
+        assert(rc == CODE_OK);
+        if (r.type == UWR_UPLINK) {
+            assert(r.metadata.gatewayId == c.eui);
+            assert(r.payloadSize == 17);
+            uplinks++;
+        }
+        if (r.type == UWR_MEASUREMENTS && r.measurements[meas_nb_rx_ok] == SIM_UPLINK_COUNT)
+            measured = true;
+    }
+    for (int i = 0; i < 50 && c.stats().sent == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    worker.stop();
+    t.join();
+    assert(workerResult == CODE_OK);
+    assert(worker.uplinks == SIM_UPLINK_COUNT && worker.dropped == 0);
+    assert(c.stats().sent == 1);
+    close(fds[0]);
+}
+
+int main() {
+    testRecord();
+    testDuplicates();
+    testWorker();
+    return 0;
+}
@@ -52,7 +52,7 @@ static void testSelect() {
     TaskTimerSocket taskTimerSocket;
     SOCKET ts = taskTimerSocket.openSocket();
 
-    TASK_TIME t = std::chrono::system_clock::now() + std::chrono::milliseconds(100);
+    TASK_TIME t = TASK_CLOCK::now() + std::chrono::milliseconds(100);
     taskTimerSocket.setStartupTime(t);
 
     FD_ZERO(&masterReadSocketSet);
@@ -80,7 +80,7 @@ static void testSelect() {
             if (sz < 0)
                 std::cerr << "Error " << GetLastError() << std::endl;
 
-            TASK_TIME t = std::chrono::system_clock::now() + std::chrono::milliseconds (100);
+            TASK_TIME t = TASK_CLOCK::now() + std::chrono::milliseconds (100);
             taskTimerSocket.setStartupTime(t);
         }
         running = cnt < 5;
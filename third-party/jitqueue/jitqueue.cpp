@@ -16,13 +16,13 @@ License: Revised BSD License, see LICENSE.Semtech.txt file include in the projec
 /* --- DEPENDANCIES --------------------------------------------------------- */
 
 #include <mutex>
-#include <algorithm>
+#include <map>
+#include <vector>
 #include <iostream>
 #include <cassert>
+#include <cstring>
 #include "jitqueue.h"
 
-#define DEBUG_JIT   0
-
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE MACROS ------------------------------------------------------- */
 
@@ -37,6 +37,68 @@ License: Revised BSD License, see LICENSE.Semtech.txt file include in the projec
                                             to ensure beacon can be sent */
 #define BEACON_RESERVED         2120000 /* Time on air of the beacon, with some margin */
 
+#define JIT_TIME_BASE           (1ULL << 40)    /* keeps extended timestamps of late packets positive */
+
+/*
+ * Packets are stored in the node pool, pool slot is the packet index returned by jit_peek().
+ * Slots are ordered by the 64 bit extended timestamp, so the packet to be sent next is the first one,
+ * and collision test is limited to the packets whose reservation can overlap the new one.
+ * 32 bit concentrator counter wraps around every 71 minutes, while the packets in the queue span
+ * TX_MAX_ADVANCE_DELAY at most, so counter extension keeps the order across the roll-over.
+ */
+typedef std::multimap<uint64_t, uint32_t> jit_order_t;  /* extended timestamp -> node slot */
+
+struct jit_index_s {
+    std::vector<struct jit_node_s> nodes;       /* node pool */
+    std::vector<jit_order_t::iterator> where;   /* node slot -> position in the order, order.end() if slot is free */
+    std::vector<uint32_t> free_slots;
+    jit_order_t order;
+    uint64_t time_ext;                          /* last concentrator time extended to 64 bits */
+    uint32_t max_pre_delay;                     /* widest reservation in the queue, bounds the collision search */
+    uint32_t max_post_delay;
+
+    explicit jit_index_s(uint32_t capacity)
+        : nodes(capacity), where(capacity), time_ext(JIT_TIME_BASE), max_pre_delay(0), max_post_delay(0)
+    {
+        free_slots.reserve(capacity);
+        for (uint32_t i = capacity; i > 0; i--) {
+            free_slots.push_back(i - 1);
+            where[i - 1] = order.end();
+        }
+    }
+
+    void sync(uint32_t time_us) {
+        /* Warning: signed arithmetic, time can go back a little when threads read counter concurrently */
+        time_ext += (int32_t) (time_us - (uint32_t) time_ext);
+    }
+
+    uint64_t key(uint32_t count_us) const {
+        return time_ext + (int32_t) (count_us - (uint32_t) time_ext);
+    }
+
+    uint32_t insert(const struct jit_node_s &node) {
+        uint32_t slot = free_slots.back();
+        free_slots.pop_back();
+        nodes[slot] = node;
+        where[slot] = order.emplace(key(node.pkt.count_us), slot);
+        if (node.pre_delay > max_pre_delay)
+            max_pre_delay = node.pre_delay;
+        if (node.post_delay > max_post_delay)
+            max_post_delay = node.post_delay;
+        return slot;
+    }
+
+    void erase(uint32_t slot) {
+        order.erase(where[slot]);
+        where[slot] = order.end();
+        free_slots.push_back(slot);
+        if (order.empty()) {
+            max_pre_delay = 0;
+            max_post_delay = 0;
+        }
+    }
+};
+
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE VARIABLES (GLOBAL) ------------------------------------------- */
 static std::mutex mx_jit_queue;
@@ -44,87 +106,80 @@ static std::mutex mx_jit_queue;
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
 
-/* -------------------------------------------------------------------------- */
-/* --- PUBLIC FUNCTIONS DEFINITION ----------------------------------------- */
-
-C_CALL bool jit_queue_is_full(struct jit_queue_s *queue) {
-    bool result;
-    mx_jit_queue.lock();
-    result = (queue->num_pkt == JIT_QUEUE_MAX)?true:false;
-
-    mx_jit_queue.unlock();
-
-    return result;
+static bool jit_collision_test(uint32_t p1_count_us, uint32_t p1_pre_delay, uint32_t p1_post_delay, uint32_t p2_count_us, uint32_t p2_pre_delay, uint32_t p2_post_delay) {
+    if (((p1_count_us - p2_count_us) <= (p1_pre_delay + p2_post_delay + TX_MARGIN_DELAY)) ||
+        ((p2_count_us - p1_count_us) <= (p2_pre_delay + p1_post_delay + TX_MARGIN_DELAY))) {
+        return true;
+    } else {
+        return false;
+    }
 }
 
-C_CALL bool jit_queue_is_empty(struct jit_queue_s *queue) {
-    bool result;
-    mx_jit_queue.lock();
-    result = (queue->num_pkt == 0)?true:false;
-    mx_jit_queue.unlock();
-    return result;
+/*
+ * Return first enqueued packet which reservation overlaps [count_us - pre_delay, count_us + post_delay]
+ * Only packets starting in the window widened by the longest enqueued reservation are tested.
+ * If ignore_beacon_guard is set, beacon pre-delay is reduced to TX_START_DELAY (Class A/C downlinks).
+ */
+static jit_order_t::iterator jit_find_collision(struct jit_index_s *idx, uint32_t count_us, uint32_t pre_delay, uint32_t post_delay, bool ignore_beacon_guard) {
+    uint64_t k = idx->key(count_us);
+    uint64_t from = k - pre_delay - idx->max_post_delay - TX_MARGIN_DELAY;
+    uint64_t to = k + post_delay + idx->max_pre_delay + TX_MARGIN_DELAY;
+    for (auto it = idx->order.lower_bound(from); it != idx->order.end() && it->first <= to; it++) {
+        const struct jit_node_s &node = idx->nodes[it->second];
+        uint32_t target_pre_delay = (ignore_beacon_guard && (node.pkt_type == JIT_PKT_TYPE_BEACON)) ? TX_START_DELAY : node.pre_delay;
+        if (jit_collision_test(count_us, pre_delay, post_delay, node.pkt.count_us, target_pre_delay, node.post_delay))
+            return it;
+    }
+    return idx->order.end();
 }
 
-C_CALL void jit_queue_init(struct jit_queue_s *queue) {
-    int i;
+static void jit_drop(struct jit_queue_s *queue, uint32_t slot) {
+    struct jit_index_s *idx = (struct jit_index_s *) queue->index;
+    if (idx->nodes[slot].pkt_type == JIT_PKT_TYPE_BEACON)
+        queue->num_beacon--;
+    queue->num_pkt--;
+    idx->erase(slot);
+}
 
-    mx_jit_queue.lock();
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC FUNCTIONS DEFINITION ----------------------------------------- */
 
-    memset(queue, 0, sizeof(*queue));
-    for (i=0; i<JIT_QUEUE_MAX; i++) {
-        queue->nodes[i].pre_delay = 0;
-        queue->nodes[i].post_delay = 0;
-    }
+bool jit_queue_is_full(struct jit_queue_s *queue) {
+    std::lock_guard<std::mutex> lock(mx_jit_queue);
+    return queue->num_pkt >= queue->capacity;
+}
 
-    mx_jit_queue.unlock();
+bool jit_queue_is_empty(struct jit_queue_s *queue) {
+    std::lock_guard<std::mutex> lock(mx_jit_queue);
+    return queue->num_pkt == 0;
 }
 
-C_CALL void jit_sort_queue(struct jit_queue_s *queue) {
-    if (queue->num_pkt == 0)
-        return;
-    std::cout <<"sorting queue in ascending order packet timestamp - queue size: " << (int) queue->num_pkt << std::endl;
-    std::sort(queue->nodes, queue->nodes + queue->num_pkt, [=] (const struct jit_node_s &a, const struct jit_node_s &b) {
-        return a.pkt.count_us < b.pkt.count_us;
-    });
-    std::cout <<"sorting queue done" << std::endl;
+void jit_queue_init(struct jit_queue_s *queue) {
+    jit_queue_init_capacity(queue, JIT_QUEUE_MAX);
 }
 
-C_CALL bool jit_collision_test(uint32_t p1_count_us, uint32_t p1_pre_delay, uint32_t p1_post_delay, uint32_t p2_count_us, uint32_t p2_pre_delay, uint32_t p2_post_delay) {
-    if (((p1_count_us - p2_count_us) <= (p1_pre_delay + p2_post_delay + TX_MARGIN_DELAY)) ||
-        ((p2_count_us - p1_count_us) <= (p2_pre_delay + p1_post_delay + TX_MARGIN_DELAY))) {
-        return true;
-    } else {
-        return false;
-    }
+void jit_queue_init_capacity(struct jit_queue_s *queue, uint32_t capacity) {
+    std::lock_guard<std::mutex> lock(mx_jit_queue);
+    memset(queue, 0, sizeof(*queue));
+    queue->capacity = capacity;
+    queue->index = new jit_index_s(capacity);
 }
 
-int printRFM2json(
-    std::ostream &ss,
-    const uint8_t *payload,
-    uint16_t size
-);
+void jit_queue_free(struct jit_queue_s *queue) {
+    std::lock_guard<std::mutex> lock(mx_jit_queue);
+    delete (struct jit_index_s *) queue->index;
+    memset(queue, 0, sizeof(*queue));
+}
 
-C_CALL enum jit_error_e jit_enqueue(struct jit_queue_s *queue, uint32_t time_us, struct lgw_pkt_tx_s *packet, enum jit_pkt_type_e pkt_type) {
-    int i = 0;
+enum jit_error_e jit_enqueue(struct jit_queue_s *queue, uint32_t time_us, struct lgw_pkt_tx_s *packet, enum jit_pkt_type_e pkt_type) {
     uint32_t packet_post_delay = 0;
     uint32_t packet_pre_delay = 0;
-    uint32_t target_pre_delay = 0;
-    enum jit_error_e err_collision;
     uint32_t asap_count_us;
 
-    std::cout <<"Current concentrator time is " << time_us << " pkt_type: " << (int) pkt_type << std::endl;
-
-
-    if (packet == NULL) {
-        std::cerr <<"ERROR: invalid parameter" << std::endl;
+    if (packet == NULL || queue->index == NULL) {
         return JIT_ERROR_INVALID;
     }
 
-    if (jit_queue_is_full(queue)) {
-        std::cerr <<"ERROR: cannot enqueue packet, JIT queue is full" << std::endl;
-        return JIT_ERROR_FULL;
-    }
-
     /* Compute packet pre/post delays depending on packet's type */
     switch (pkt_type) {
         case JIT_PKT_TYPE_DOWNLINK_CLASS_A:
@@ -142,7 +197,14 @@ C_CALL enum jit_error_e jit_enqueue(struct jit_queue_s *queue, uint32_t time_us,
             break;
     }
 
-    mx_jit_queue.lock();
+    std::lock_guard<std::mutex> lock(mx_jit_queue);
+    struct jit_index_s *idx = (struct jit_index_s *) queue->index;
+
+    if (queue->num_pkt >= queue->capacity) {
+        return JIT_ERROR_FULL;
+    }
+
+    idx->sync(time_us);
 
     /* An immediate downlink becomes a timestamped downlink "ASAP" */
     /* Set the packet count_us to the first available slot */
@@ -152,53 +214,21 @@ C_CALL enum jit_error_e jit_enqueue(struct jit_queue_s *queue, uint32_t time_us,
 
         /* Search for the ASAP timestamp to be given to the packet */
         asap_count_us = time_us + 2 * TX_JIT_DELAY; /* margin */
-        if (queue->num_pkt == 0) {
-            /* If the jit queue is empty, we can insert this packet */
-            std::cerr <<"DEBUG: insert IMMEDIATE downlink, first in JiT queue, count_us: " << asap_count_us << std::endl;
-        } else {
-            /* Else we can try to insert it:
-                - ASAP meaning NOW + MARGIN
-                - at the last index of the queue
-                - between 2 downlinks in the queue
-            */
-
-            /* First, try if the ASAP time collides with an already enqueued downlink */
-            for (i=0; i<queue->num_pkt; i++) {
-                if (jit_collision_test(asap_count_us, packet_pre_delay, packet_post_delay, queue->nodes[i].pkt.count_us, queue->nodes[i].pre_delay, queue->nodes[i].post_delay) == true) {
-                    std::cerr <<"DEBUG: cannot insert IMMEDIATE downlink at count_us= " << asap_count_us
-                                << " collides with " << queue->nodes[i].pkt.count_us
-                                << "(index = " << i << std::endl;
-                    break;
-                }
-            }
-            if (i == queue->num_pkt) {
-                /* No collision with ASAP time, we can insert it */
-                std::cerr << "DEBUG: insert IMMEDIATE downlink ASAP at " << asap_count_us << " (no collision)" << std::endl;
-            } else {
-                /* Search for the best slot then */
-                for (i=0; i<queue->num_pkt; i++) {
-                    asap_count_us = queue->nodes[i].pkt.count_us + queue->nodes[i].post_delay + packet_pre_delay + TX_JIT_DELAY + TX_MARGIN_DELAY;
-                    if (i == (queue->num_pkt - 1)) {
-                        /* Last packet index, we can insert after this one */
-                        std::cerr << "DEBUG: insert IMMEDIATE downlink, last in JiT queue" << asap_count_us << std::endl;
-                    } else {
-                        /* Check if packet can be inserted between this index and the next one */
-                        std::cerr << "DEBUG: try to insert IMMEDIATE downlink (count_us=" << asap_count_us
-                                     << ") between index " << i
-                                     << " and index " << i + 1
-                                     << "?" << std::endl;
-                        if (jit_collision_test(asap_count_us, packet_pre_delay, packet_post_delay, queue->nodes[i+1].pkt.count_us, queue->nodes[i+1].pre_delay, queue->nodes[i+1].post_delay) == true) {
-                            std::cerr << "DEBUG: failed to insert IMMEDIATE downlink (count_us="
-                                         << asap_count_us << "), continue..." << std::endl;
-                            continue;
-                        } else {
-                            std::cout << "DEBUG: insert IMMEDIATE downlink (count_us="
-                                      << asap_count_us << "), continue..." << std::endl;
-                            break;
-                        }
-                    }
-                }
-            }
+        /* Try to insert it:
+            - ASAP meaning NOW + MARGIN
+            - between 2 downlinks in the queue, starting from the one ASAP time collides with
+            - at the last index of the queue
+        */
+        auto it = jit_find_collision(idx, asap_count_us, packet_pre_delay, packet_post_delay, false);
+        while (it != idx->order.end()) {
+            const struct jit_node_s &node = idx->nodes[it->second];
+            asap_count_us = node.pkt.count_us + node.post_delay + packet_pre_delay + TX_JIT_DELAY + TX_MARGIN_DELAY;
+            /* Check if packet can be inserted between this packet and the next one */
+            if (++it == idx->order.end())
+                break;
+            const struct jit_node_s &next = idx->nodes[it->second];
+            if (!jit_collision_test(asap_count_us, packet_pre_delay, packet_post_delay, next.pkt.count_us, next.pre_delay, next.post_delay))
+                break;
         }
         /* Set packet with ASAP timestamp */
         packet->count_us = asap_count_us;
@@ -213,11 +243,6 @@ C_CALL enum jit_error_e jit_enqueue(struct jit_queue_s *queue, uint32_t time_us,
      *      t_packet < t_current + TX_START_DELAY + MARGIN
      */
     if ((packet->count_us - time_us) <= (TX_START_DELAY + TX_MARGIN_DELAY + TX_JIT_DELAY)) {
-        std::cerr << "ERROR: Packet REJECTED, already too late to send it (current=" << time_us
-            << ", packet=" << packet->count_us
-            <<", type=" << (int) pkt_type
-            << asap_count_us << "), continue..." << std::endl;
-        mx_jit_queue.unlock();
         return JIT_ERROR_TOO_LATE;
     }
 
@@ -234,11 +259,6 @@ C_CALL enum jit_error_e jit_enqueue(struct jit_queue_s *queue, uint32_t time_us,
      */
     if ((pkt_type == JIT_PKT_TYPE_DOWNLINK_CLASS_A) || (pkt_type == JIT_PKT_TYPE_DOWNLINK_CLASS_B)) {
         if ((packet->count_us - time_us) > TX_MAX_ADVANCE_DELAY) {
-            std::cerr << "\"ERROR: Packet REJECTED, timestamp seems wrong, too much in advance (current=" << time_us
-                      << ", packet=)" << packet->count_us
-                      <<", type=" << (int) pkt_type
-                      << asap_count_us << "), continue..." << std::endl;
-            mx_jit_queue.unlock();
             return JIT_ERROR_TOO_EARLY;
         }
     }
@@ -246,220 +266,125 @@ C_CALL enum jit_error_e jit_enqueue(struct jit_queue_s *queue, uint32_t time_us,
     /* Check criteria_3: does this new packet overlap with a packet already enqueued ?
      *  Note: - need to take into account packet's pre_delay and post_delay of each packet
      *        - Valid for both Downlinks and beacon packets
-     *        - Beacon guard can be ignored if we try to queue a Class A downlink
+     *        - Beacon guard can be ignored if we try to queue a Class A/C downlink
      */
-    for (i=0; i<queue->num_pkt; i++) {
-        /* We ignore Beacon Guard for Class A/C downlinks */
-        if (((pkt_type == JIT_PKT_TYPE_DOWNLINK_CLASS_A) || (pkt_type == JIT_PKT_TYPE_DOWNLINK_CLASS_C)) && (queue->nodes[i].pkt_type == JIT_PKT_TYPE_BEACON)) {
-            target_pre_delay = TX_START_DELAY;
-        } else {
-            target_pre_delay = queue->nodes[i].pre_delay;
-        }
-
-        /* Check if there is a collision
-         *  Warning: unsigned arithmetic (handle roll-over)
-         *      t_packet_new - pre_delay_packet_new < t_packet_prev + post_delay_packet_prev (OVERLAP on post delay)
-         *      t_packet_new + post_delay_packet_new > t_packet_prev - pre_delay_packet_prev (OVERLAP on pre delay)
-         */
-        if (jit_collision_test(packet->count_us, packet_pre_delay, packet_post_delay, queue->nodes[i].pkt.count_us, target_pre_delay, queue->nodes[i].post_delay) == true) {
-            switch (queue->nodes[i].pkt_type) {
-                case JIT_PKT_TYPE_DOWNLINK_CLASS_A:
-                case JIT_PKT_TYPE_DOWNLINK_CLASS_B:
-                case JIT_PKT_TYPE_DOWNLINK_CLASS_C:
-                    std::cerr << "ERROR: Packet (type=" << (int) pkt_type << ") REJECTED, collision with packet already programmed at " << queue->nodes[i].pkt.count_us
-                        << ", (" << packet->count_us << std::endl;
-
-                    err_collision = JIT_ERROR_COLLISION_PACKET;
-                    break;
-                case JIT_PKT_TYPE_BEACON:
-                    if (pkt_type != JIT_PKT_TYPE_BEACON) {
-                        /* do not overload logs for beacon/beacon collision, as it is expected to happen with beacon pre-scheduling algorith used */
-                        std::cerr << "ERROR: Packet (type=" << (int) pkt_type << ") REJECTED, collision with beacon already programmed at "
-                            << queue->nodes[i].pkt.count_us << ", (" << packet->count_us << std::endl;
-                    }
-                    err_collision = JIT_ERROR_COLLISION_BEACON;
-                    break;
-                default:
-                    std::cerr << "ERROR: Unknown packet type, should not occur, BUG?" << std::endl;
-                    assert(0);
-                    break;
-            }
-            mx_jit_queue.unlock();
-            return err_collision;
+    auto collision = jit_find_collision(idx, packet->count_us, packet_pre_delay, packet_post_delay,
+        (pkt_type == JIT_PKT_TYPE_DOWNLINK_CLASS_A) || (pkt_type == JIT_PKT_TYPE_DOWNLINK_CLASS_C));
+    if (collision != idx->order.end()) {
+        switch (idx->nodes[collision->second].pkt_type) {
+            case JIT_PKT_TYPE_DOWNLINK_CLASS_A:
+            case JIT_PKT_TYPE_DOWNLINK_CLASS_B:
+            case JIT_PKT_TYPE_DOWNLINK_CLASS_C:
+                return JIT_ERROR_COLLISION_PACKET;
+            case JIT_PKT_TYPE_BEACON:
+                return JIT_ERROR_COLLISION_BEACON;
+            default:
+                assert(0);
+                return JIT_ERROR_INVALID;
         }
     }
 
     /* Finally enqueue it */
-    /* Insert packet at the end of the queue */
-    memcpy(&(queue->nodes[queue->num_pkt].pkt), packet, sizeof(struct lgw_pkt_tx_s));
-    queue->nodes[queue->num_pkt].pre_delay = packet_pre_delay;
-    queue->nodes[queue->num_pkt].post_delay = packet_post_delay;
-    queue->nodes[queue->num_pkt].pkt_type = pkt_type;
+    struct jit_node_s node;
+    memcpy(&node.pkt, packet, sizeof(struct lgw_pkt_tx_s));
+    node.pre_delay = packet_pre_delay;
+    node.post_delay = packet_post_delay;
+    node.pkt_type = pkt_type;
+    idx->insert(node);
     if (pkt_type == JIT_PKT_TYPE_BEACON) {
         queue->num_beacon++;
     }
     queue->num_pkt++;
-    /* Sort the queue in ascending order of packet timestamp */
-    jit_sort_queue(queue);
-
-    /* Done */
-    mx_jit_queue.unlock();
-
-    jit_print_queue(queue, false, DEBUG_JIT);
-
-    std::cout << "enqueued packet with count_us=" << packet->count_us
-            << " (size " << packet->size << " bytes, toa = " << packet_post_delay
-            << " type= " << (int) pkt_type << std::endl;
-    for (int i = 0; i < 27 + packet->size; i++) {
-        printf("%02x", ((uint8_t *)packet )[i]);
-    }
-    std::cout << std::endl;
-    printRFM2json(std::cout, (uint8_t *) packet, 27 + packet->size);
-    std::cout << std::endl;
-
     return JIT_ERROR_OK;
 }
 
-C_CALL enum jit_error_e jit_dequeue(struct jit_queue_s *queue, int index, struct lgw_pkt_tx_s *packet, enum jit_pkt_type_e *pkt_type) {
-    if (packet == NULL) {
-        std::cerr << "ERROR: invalid parameter" << std::endl;
+enum jit_error_e jit_dequeue(struct jit_queue_s *queue, int index, struct lgw_pkt_tx_s *packet, enum jit_pkt_type_e *pkt_type) {
+    if (packet == NULL || queue->index == NULL) {
         return JIT_ERROR_INVALID;
     }
 
-    if ((index < 0) || (index >= JIT_QUEUE_MAX)) {
-        std::cerr << "ERROR: invalid parameter" << std::endl;
+    std::lock_guard<std::mutex> lock(mx_jit_queue);
+    struct jit_index_s *idx = (struct jit_index_s *) queue->index;
+
+    if ((index < 0) || ((uint32_t) index >= queue->capacity)) {
         return JIT_ERROR_INVALID;
     }
 
-    if (jit_queue_is_empty(queue)) {
-        std::cerr << "ERROR: cannot dequeue packet, JIT queue is empty" << std::endl;
+    if (queue->num_pkt == 0) {
         return JIT_ERROR_EMPTY;
     }
 
-    mx_jit_queue.lock();
-
-    /* Dequeue requested packet */
-    memcpy(packet, &(queue->nodes[index].pkt), sizeof(struct lgw_pkt_tx_s));
-    queue->num_pkt--;
-    *pkt_type = queue->nodes[index].pkt_type;
-    if (*pkt_type == JIT_PKT_TYPE_BEACON) {
-        queue->num_beacon--;
-        std::cout << "--- Beacon dequeued ---" << std::endl;
-    }
-
-    /* Replace dequeued packet with last packet of the queue */
-    memcpy(&(queue->nodes[index]), &(queue->nodes[queue->num_pkt]), sizeof(struct jit_node_s));
-    memset(&(queue->nodes[queue->num_pkt]), 0, sizeof(struct jit_node_s));
-
-    /* Sort queue in ascending order of packet timestamp */
-    jit_sort_queue(queue);
-
-    /* Done */
-    mx_jit_queue.unlock();
-
-    jit_print_queue(queue, false, DEBUG_JIT);
-
-    std::cout << "dequeued packet with count_us=" << packet->count_us << " from index " << index << std::endl;
-    for (int i = 0; i < 27 + packet->size; i++) {
-        printf("%02x", ((uint8_t *)packet )[i]);
+    if (idx->where[index] == idx->order.end()) {
+        /* slot is free */
+        return JIT_ERROR_INVALID;
     }
-    std::cout << std::endl;
-    printRFM2json(std::cout, (uint8_t *) packet, 27 + packet->size);
-    std::cout << std::endl;
 
+    /* Dequeue requested packet */
+    memcpy(packet, &(idx->nodes[index].pkt), sizeof(struct lgw_pkt_tx_s));
+    *pkt_type = idx->nodes[index].pkt_type;
+    jit_drop(queue, (uint32_t) index);
     return JIT_ERROR_OK;
 }
 
-C_CALL enum jit_error_e jit_peek(struct jit_queue_s *queue, uint32_t time_us, int *pkt_idx) {
+enum jit_error_e jit_peek(struct jit_queue_s *queue, uint32_t time_us, int *pkt_idx) {
     /* Return index of node containing a packet inline with given time */
-    int i = 0;
-    int idx_highest_priority = -1;
-    if (pkt_idx == NULL) {
-        std::cerr << "ERROR: invalid parameter" << std::endl;
+    if (pkt_idx == NULL || queue->index == NULL) {
         return JIT_ERROR_INVALID;
     }
 
-    if (jit_queue_is_empty(queue)) {
+    std::lock_guard<std::mutex> lock(mx_jit_queue);
+    struct jit_index_s *idx = (struct jit_index_s *) queue->index;
+
+    if (queue->num_pkt == 0) {
         return JIT_ERROR_EMPTY;
     }
 
-    mx_jit_queue.lock();
-
-    /* Search for highest priority packet to be sent */
-    for (i=0; i<queue->num_pkt; i++) {
+    idx->sync(time_us);
+    *pkt_idx = -1;
+    /* Highest priority packet to be sent is the first one in the order */
+    while (!idx->order.empty()) {
+        uint32_t slot = idx->order.begin()->second;
+        const struct jit_node_s &node = idx->nodes[slot];
         /* First check if that packet is outdated:
          *  If a packet seems too much in advance, and was not rejected at enqueue time,
-         *  it means that we missed it for peeking, we need to drop it
+         *  it means that we missed it for peeking, we need to drop it to avoid lock-up.
+         *  Dropped packets are counted in num_dropped.
          *
          *  Warning: unsigned arithmetic
          *      t_packet > t_current + TX_MAX_ADVANCE_DELAY
          */
-        if ((queue->nodes[i].pkt.count_us - time_us) >= TX_MAX_ADVANCE_DELAY) {
-            /* We drop the packet to avoid lock-up */
-            queue->num_pkt--;
-            if (queue->nodes[i].pkt_type == JIT_PKT_TYPE_BEACON) {
-                queue->num_beacon--;
-                std::cerr << "WARNING: --- Beacon dropped (current_time=" << time_us
-                    << ", packet_time=" << queue->nodes[i].pkt.count_us
-                    << ") ---" << std::endl;
-            } else {
-                std::cerr << "WARNING: --- Packet dropped (current_time=" << time_us
-                    << ", packet_time=" << queue->nodes[i].pkt.count_us << std::endl;
-            }
-
-            /* Replace dropped packet with last packet of the queue */
-            memcpy(&(queue->nodes[i]), &(queue->nodes[queue->num_pkt]), sizeof(struct jit_node_s));
-            memset(&(queue->nodes[queue->num_pkt]), 0, sizeof(struct jit_node_s));
-
-            /* Sort queue in ascending order of packet timestamp */
-            jit_sort_queue(queue);
-
-            /* restart loop  after purge to find packet to be sent */
-            i = 0;
+        if ((node.pkt.count_us - time_us) >= TX_MAX_ADVANCE_DELAY) {
+            jit_drop(queue, slot);
+            queue->num_dropped++;
             continue;
         }
-
-        /* Then look for highest priority packet to be sent:
+        /* Peek criteria 1: look for a packet to be sent in next TX_JIT_DELAY ms timeframe
          *  Warning: unsigned arithmetic (handle roll-over)
-         *      t_packet < t_highest
+         *      t_packet < t_current + TX_JIT_DELAY
          */
-        if ((idx_highest_priority == -1) || (((queue->nodes[i].pkt.count_us - time_us) < (queue->nodes[idx_highest_priority].pkt.count_us - time_us)))) {
-            idx_highest_priority = i;
+        if ((node.pkt.count_us - time_us) < TX_JIT_DELAY) {
+            *pkt_idx = (int) slot;
         }
+        break;
     }
-
-    /* Peek criteria 1: look for a packet to be sent in next TX_JIT_DELAY ms timeframe
-     *  Warning: unsigned arithmetic (handle roll-over)
-     *      t_packet < t_current + TX_JIT_DELAY
-     */
-    if ((queue->nodes[idx_highest_priority].pkt.count_us - time_us) < TX_JIT_DELAY) {
-        *pkt_idx = idx_highest_priority;
-        std::cout << "peek packet with count_us=" << queue->nodes[idx_highest_priority].pkt.count_us << " at index " << idx_highest_priority << std::endl;
-    } else {
-        *pkt_idx = -1;
-    }
-
-    mx_jit_queue.unlock();
-
     return JIT_ERROR_OK;
 }
 
-C_CALL void jit_print_queue(struct jit_queue_s *queue, bool show_all, int debug_level) {
-    int i = 0;
-    int loop_end;
-
-    if (jit_queue_is_empty(queue)) {
+void jit_print_queue(struct jit_queue_s *queue, bool show_all, int debug_level) {
+    if (!debug_level || queue->index == NULL)
+        return;
+    std::lock_guard<std::mutex> lock(mx_jit_queue);
+    struct jit_index_s *idx = (struct jit_index_s *) queue->index;
+    if (queue->num_pkt == 0) {
         std::cout << "INFO: [jit] queue is empty" << std::endl;
-
-    } else {
-        mx_jit_queue.lock();
-        std::cout << "INFO: [jit] queue contains " << (int) queue->num_pkt << " packets" << std::endl;
-        std::cout << "INFO: [jit] queue contains " << (int) queue->num_beacon << " beacons" << std::endl;
-        loop_end = (show_all == true) ? JIT_QUEUE_MAX : queue->num_pkt;
-        for (i=0; i<loop_end; i++) {
-            std::cout << " - node[" << i << "]: count_us = " << queue->nodes[i].pkt.count_us
-                << " - type=" << (int) queue->nodes[i].pkt_type  << std::endl;
-        }
-        mx_jit_queue.unlock();
+        return;
+    }
+    std::cout << "INFO: [jit] queue contains " << queue->num_pkt << " packets" << std::endl;
+    std::cout << "INFO: [jit] queue contains " << queue->num_beacon << " beacons" << std::endl;
+    if (show_all)
+        std::cout << "INFO: [jit] queue capacity " << queue->capacity << ", dropped " << queue->num_dropped << std::endl;
+    for (auto &it : idx->order) {
+        std::cout << " - node[" << it.second << "]: count_us = " << idx->nodes[it.second].pkt.count_us
+            << " - type=" << (int) idx->nodes[it.second].pkt_type << std::endl;
     }
 }
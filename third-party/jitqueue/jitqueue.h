@@ -23,7 +23,11 @@ extern "C" {
 /* -------------------------------------------------------------------------- */
 /* --- DEPENDANCIES --------------------------------------------------------- */
 
+#if defined(_MSC_VER) || defined(__MINGW32__)
 #include "platform-win.h"
+#else
+#include <sys/time.h>   /* timeval */
+#endif
 
 #include <stdint.h>     /* C99 types */
 #include <stdbool.h>    /* bool type */
@@ -33,7 +37,9 @@ extern "C" {
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC CONSTANTS ----------------------------------------------------- */
 
-#define JIT_QUEUE_MAX           32  /* Maximum number of packets to be stored in JiT queue */
+#ifndef JIT_QUEUE_MAX
+#define JIT_QUEUE_MAX           512 /* Default maximum number of packets to be stored in JiT queue, see jit_queue_init_capacity() */
+#endif
 #define JIT_NUM_BEACON_IN_QUEUE 3   /* Number of beacons to be loaded in JiT queue at any time */
 
 /* -------------------------------------------------------------------------- */
@@ -71,9 +77,11 @@ struct jit_node_s {
 };
 
 struct jit_queue_s {
-    uint8_t num_pkt;                /* Total number of packets in the queue (downlinks, beacons...) */
-    uint8_t num_beacon;             /* Number of beacons in the queue */
-    struct jit_node_s nodes[JIT_QUEUE_MAX]; /* Nodes/packets array in the queue */
+    uint32_t num_pkt;               /* Total number of packets in the queue (downlinks, beacons...) */
+    uint32_t num_beacon;            /* Number of beacons in the queue */
+    uint32_t num_dropped;           /* Number of outdated packets dropped by jit_peek */
+    uint32_t capacity;              /* Maximum number of packets in the queue */
+    void *index;                    /* Node pool and timestamp ordered index, allocated by jit_queue_init() */
 };
 
 /* -------------------------------------------------------------------------- */
@@ -101,9 +109,28 @@ bool jit_queue_is_empty(struct jit_queue_s *queue);
 @param queue[in] Just in Time queue to be initialized. Memory should have been allocated already.
 
 This function is used to reset every elements in the allocated queue.
+Queue can store up to JIT_QUEUE_MAX packets. Call jit_queue_free() to release the node pool.
 */
 void jit_queue_init(struct jit_queue_s *queue);
 
+/**
+@brief Initialize a Just in Time queue with a given capacity.
+
+@param queue[in] Just in Time queue to be initialized. Memory should have been allocated already.
+@param capacity[in] Maximum number of packets to be stored in the queue.
+
+Packets are kept in a node pool ordered by timestamp, so enqueue, peek and dequeue
+cost O(log n) regardless of the capacity.
+*/
+void jit_queue_init_capacity(struct jit_queue_s *queue, uint32_t capacity);
+
+/**
+@brief Release memory allocated by jit_queue_init().
+
+@param queue[in] Just in Time queue to be released.
+*/
+void jit_queue_free(struct jit_queue_s *queue);
+
 /**
 @brief Add a packet in a Just-in-Time queue
 
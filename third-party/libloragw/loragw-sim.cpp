@@ -0,0 +1,448 @@
+#include <cstring>
+#include <sstream>
+
+#include "loragw-sim.h"
+
+#define SIM_FSK_SYNC_WORD_SIZE  3
+#define SIM_TEMPERATURE         25.0f
+#define SIM_DEVICE_COUNT        1000    ///< generated uplinks come from this number of addresses
+#define SIM_DEVADDR_BASE        0x26000000
+
+static const char *SIM_VERSION = "loragw-sim";
+
+SimulatedPacketStream::SimulatedPacketStream()
+    : packetsPerSecond(0), count(0), poisson(false),
+    frequencies { 868100000, 868300000, 868500000 },
+    bandwidth(BW_125KHZ), datarate(DR_LORA_SF7), coderate(CR_LORA_4_5),
+    rssi(-60.0f), snr(9.0f)
+{
+}
+
+std::string SimulatedConcentratorStats::toJsonString() const
+{
+    std::stringstream ss;
+    ss << R"({"generated": )" << generated << R"(, "received": )" << received
+       << R"(, "dropped": )" << dropped << R"(, "sent": )" << sent << R"(, "late": )" << late
+       << R"(, "minLeadUs": )" << minLeadUs << R"(, "maxLeadUs": )" << maxLeadUs
+       << R"(, "avgLeadUs": )" << avgLeadUs << "}";
+    return ss.str();
+}
+
+SimulatedConcentrator::SimulatedConcentrator()
+    : started(false), startTime(std::chrono::steady_clock::now()), rnd(42), nextArrival(0), streamIndex(0),
+    txStart {}, txEnd {}, counters {}, leadSum(0), counterOffset(0), eui(0x00000000feedbeefULL)
+{
+}
+
+SimulatedConcentrator &SimulatedConcentrator::instance()
+{
+    static SimulatedConcentrator concentrator;
+    return concentrator;
+}
+
+uint64_t SimulatedConcentrator::elapsed() const
+{
+    return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+void SimulatedConcentrator::generate(
+    uint64_t now
+)
+{
+    if (!started || stream.packetsPerSecond == 0)
+        return;
+    std::exponential_distribution<double> interval((double) stream.packetsPerSecond / 1E6);
+    while ((stream.count == 0 || streamIndex < stream.count) && nextArrival <= now) {
+        struct lgw_pkt_rx_s pkt;
+        makePacket(pkt, nextArrival);
+        push(pkt);
+        streamIndex++;
+        nextArrival += stream.poisson ? (uint64_t) interval(rnd) + 1 : 1000000 / stream.packetsPerSecond;
+    }
+}
+
+void SimulatedConcentrator::push(
+    const struct lgw_pkt_rx_s &pkt
+)
+{
+    counters.generated++;
+    if (fifo.size() >= SIM_RX_FIFO_SIZE) {
+        counters.dropped++;
+        return;
+    }
+    fifo.push_back(pkt);
+}
+
+void SimulatedConcentrator::makePacket(
+    struct lgw_pkt_rx_s &retVal,
+    uint64_t arrival
+)
+{
+    memset(&retVal, 0, sizeof(retVal));
+    size_t channel = stream.frequencies.empty() ? 0 : streamIndex % stream.frequencies.size();
+    retVal.freq_hz = stream.frequencies.empty() ? 868100000 : stream.frequencies[channel];
+    retVal.if_chain = (uint8_t) channel;
+    retVal.status = STAT_CRC_OK;
+    retVal.count_us = (uint32_t) (counterOffset + arrival);
+    retVal.rf_chain = 0;
+    retVal.modulation = MOD_LORA;
+    retVal.bandwidth = stream.bandwidth;
+    retVal.datarate = stream.datarate;
+    retVal.coderate = stream.coderate;
+    retVal.rssic = stream.rssi;
+    retVal.rssis = stream.rssi;
+    retVal.snr = stream.snr;
+    retVal.snr_min = stream.snr;
+    retVal.snr_max = stream.snr;
+    if (!stream.payloads.empty()) {
+        auto &p = stream.payloads[streamIndex % stream.payloads.size()];
+        retVal.size = (uint16_t) (p.size() < sizeof(retVal.payload) ? p.size() : sizeof(retVal.payload));
+        memmove(retVal.payload, p.data(), retVal.size);
+        return;
+    }
+    // unconfirmed data up: MHDR, DevAddr, FCtrl, FCnt, FPort, 4 bytes payload, MIC
+    uint32_t addr = SIM_DEVADDR_BASE + (uint32_t) (streamIndex % SIM_DEVICE_COUNT);
+    auto fCnt = (uint16_t) (streamIndex / SIM_DEVICE_COUNT);
+    uint8_t *p = retVal.payload;
+    *p++ = 0x40;
+    for (int i = 0; i < 4; i++) {
+        *p++ = (uint8_t) (addr >> (i * 8));
+    }
+    *p++ = 0;
+    *p++ = (uint8_t) fCnt;
+    *p++ = (uint8_t) (fCnt >> 8);
+    *p++ = 1;
+    memset(p, 0, 8);
+    retVal.size = (uint16_t) (p + 8 - retVal.payload);
+}
+
+void SimulatedConcentrator::setStream(
+    const SimulatedPacketStream &value
+)
+{
+    std::lock_guard<std::mutex> lock(mutexState);
+    stream = value;
+    streamIndex = 0;
+    nextArrival = elapsed();
+}
+
+void SimulatedConcentrator::inject(
+    const struct lgw_pkt_rx_s &pkt
+)
+{
+    std::lock_guard<std::mutex> lock(mutexState);
+    struct lgw_pkt_rx_s p = pkt;
+    p.count_us = (uint32_t) (counterOffset + elapsed());
+    push(p);
+}
+
+void SimulatedConcentrator::reset()
+{
+    std::lock_guard<std::mutex> lock(mutexState);
+    fifo.clear();
+    txs.clear();
+    counters = {};
+    leadSum = 0;
+    for (int i = 0; i < LGW_RF_CHAIN_NB; i++) {
+        txStart[i] = 0;
+        txEnd[i] = 0;
+    }
+}
+
+uint32_t SimulatedConcentrator::counter() const
+{
+    return (uint32_t) (counterOffset + elapsed());
+}
+
+std::vector<SimulatedTx> SimulatedConcentrator::transmitted() const
+{
+    std::lock_guard<std::mutex> lock(mutexState);
+    return txs;
+}
+
+SimulatedConcentratorStats SimulatedConcentrator::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutexState);
+    SimulatedConcentratorStats r = counters;
+    size_t scheduled = 0;
+    for (auto &t : txs) {
+        if (t.pkt.tx_mode != IMMEDIATE)
+            scheduled++;
+    }
+    r.avgLeadUs = scheduled ? (double) leadSum / (double) scheduled : 0;
+    return r;
+}
+
+int SimulatedConcentrator::start()
+{
+    std::lock_guard<std::mutex> lock(mutexState);
+    if (started)
+        return LGW_HAL_ERROR;
+    startTime = std::chrono::steady_clock::now();
+    nextArrival = 0;
+    streamIndex = 0;
+    started = true;
+    return LGW_HAL_SUCCESS;
+}
+
+int SimulatedConcentrator::stop()
+{
+    std::lock_guard<std::mutex> lock(mutexState);
+    started = false;
+    fifo.clear();
+    return LGW_HAL_SUCCESS;
+}
+
+int SimulatedConcentrator::receive(
+    uint8_t maxPackets,
+    struct lgw_pkt_rx_s *retVal
+)
+{
+    std::lock_guard<std::mutex> lock(mutexState);
+    if (!started || !retVal)
+        return LGW_HAL_ERROR;
+    generate(elapsed());
+    int n = 0;
+    while (n < maxPackets && !fifo.empty()) {
+        retVal[n++] = fifo.front();
+        fifo.pop_front();
+    }
+    counters.received += n;
+    return n;
+}
+
+int SimulatedConcentrator::send(
+    const struct lgw_pkt_tx_s &pkt
+)
+{
+    std::lock_guard<std::mutex> lock(mutexState);
+    if (!started || pkt.rf_chain >= LGW_RF_CHAIN_NB)
+        return LGW_HAL_ERROR;
+    uint64_t now = elapsed();
+    SimulatedTx t;
+    t.pkt = pkt;
+    t.sentCount = (uint32_t) (counterOffset + now);
+    t.leadUs = 0;
+    t.late = false;
+    uint64_t start = now;
+    if (pkt.tx_mode != IMMEDIATE) {
+        // count_us is the concentrator counter, ON_GPS time is converted by the caller
+        t.leadUs = (int32_t) (pkt.count_us - t.sentCount);
+        t.late = t.leadUs < SIM_TX_START_DELAY_US;
+        if (t.leadUs > 0)
+            start += (uint64_t) t.leadUs;
+        if (counters.sent == 0 || t.leadUs < counters.minLeadUs)
+            counters.minLeadUs = t.leadUs;
+        if (counters.sent == 0 || t.leadUs > counters.maxLeadUs)
+            counters.maxLeadUs = t.leadUs;
+        leadSum += t.leadUs;
+    }
+    counters.sent++;
+    if (t.late)
+        counters.late++;
+    txStart[pkt.rf_chain] = start;
+    txEnd[pkt.rf_chain] = start + (uint64_t) lgw_time_on_air(&pkt) * 1000;
+    txs.push_back(t);
+    return LGW_HAL_SUCCESS;
+}
+
+int SimulatedConcentrator::txStatus(
+    uint8_t rfChain,
+    uint8_t &retVal
+) const
+{
+    std::lock_guard<std::mutex> lock(mutexState);
+    if (rfChain >= LGW_RF_CHAIN_NB)
+        return LGW_HAL_ERROR;
+    if (!started) {
+        retVal = TX_OFF;
+        return LGW_HAL_SUCCESS;
+    }
+    uint64_t now = elapsed();
+    if (now < txStart[rfChain])
+        retVal = TX_SCHEDULED;
+    else if (now < txEnd[rfChain])
+        retVal = TX_EMITTING;
+    else
+        retVal = TX_FREE;
+    return LGW_HAL_SUCCESS;
+}
+
+int SimulatedConcentrator::abortTx(
+    uint8_t rfChain
+)
+{
+    std::lock_guard<std::mutex> lock(mutexState);
+    if (rfChain >= LGW_RF_CHAIN_NB)
+        return LGW_HAL_ERROR;
+    txStart[rfChain] = 0;
+    txEnd[rfChain] = 0;
+    return LGW_HAL_SUCCESS;
+}
+
+// loragw_hal.c entry points, configuration is accepted as is
+
+int lgw_board_setconf(struct lgw_conf_board_s *conf)
+{
+    return conf ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+}
+
+int lgw_rxrf_setconf(uint8_t rf_chain, struct lgw_conf_rxrf_s *conf)
+{
+    return (conf && rf_chain < LGW_RF_CHAIN_NB) ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+}
+
+int lgw_rxif_setconf(uint8_t if_chain, struct lgw_conf_rxif_s *conf)
+{
+    return (conf && if_chain < LGW_IF_CHAIN_NB) ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+}
+
+int lgw_demod_setconf(struct lgw_conf_demod_s *conf)
+{
+    return conf ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+}
+
+int lgw_txgain_setconf(uint8_t rf_chain, struct lgw_tx_gain_lut_s *conf)
+{
+    return (conf && rf_chain < LGW_RF_CHAIN_NB) ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+}
+
+int lgw_ftime_setconf(struct lgw_conf_ftime_s *conf)
+{
+    return conf ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+}
+
+int lgw_sx1261_setconf(struct lgw_conf_sx1261_s *conf)
+{
+    return conf ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+}
+
+int lgw_debug_setconf(struct lgw_conf_debug_s *conf)
+{
+    return conf ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+}
+
+int lgw_start(void)
+{
+    return SimulatedConcentrator::instance().start();
+}
+
+int lgw_stop(void)
+{
+    return SimulatedConcentrator::instance().stop();
+}
+
+int lgw_receive(uint8_t max_pkt, struct lgw_pkt_rx_s *pkt_data)
+{
+    return SimulatedConcentrator::instance().receive(max_pkt, pkt_data);
+}
+
+int lgw_send(struct lgw_pkt_tx_s *pkt_data)
+{
+    if (!pkt_data)
+        return LGW_HAL_ERROR;
+    return SimulatedConcentrator::instance().send(*pkt_data);
+}
+
+int lgw_status(uint8_t rf_chain, uint8_t select, uint8_t *code)
+{
+    if (!code)
+        return LGW_HAL_ERROR;
+    if (select == RX_STATUS) {
+        *code = RX_ON;
+        return LGW_HAL_SUCCESS;
+    }
+    if (select != TX_STATUS)
+        return LGW_HAL_ERROR;
+    return SimulatedConcentrator::instance().txStatus(rf_chain, *code);
+}
+
+int lgw_abort_tx(uint8_t rf_chain)
+{
+    return SimulatedConcentrator::instance().abortTx(rf_chain);
+}
+
+int lgw_get_trigcnt(uint32_t *trig_cnt_us)
+{
+    if (!trig_cnt_us)
+        return LGW_HAL_ERROR;
+    // PPS is not simulated, counter latched at the last whole second
+    uint32_t c = SimulatedConcentrator::instance().counter();
+    *trig_cnt_us = c - c % 1000000;
+    return LGW_HAL_SUCCESS;
+}
+
+int lgw_get_instcnt(uint32_t *inst_cnt_us)
+{
+    if (!inst_cnt_us)
+        return LGW_HAL_ERROR;
+    *inst_cnt_us = SimulatedConcentrator::instance().counter();
+    return LGW_HAL_SUCCESS;
+}
+
+int lgw_get_eui(uint64_t *eui)
+{
+    if (!eui)
+        return LGW_HAL_ERROR;
+    *eui = SimulatedConcentrator::instance().eui;
+    return LGW_HAL_SUCCESS;
+}
+
+int lgw_get_temperature(float *temperature)
+{
+    if (!temperature)
+        return LGW_HAL_ERROR;
+    *temperature = SIM_TEMPERATURE;
+    return LGW_HAL_SUCCESS;
+}
+
+const char* lgw_version_info()
+{
+    return SIM_VERSION;
+}
+
+uint32_t lgw_time_on_air(const struct lgw_pkt_tx_s *packet)
+{
+    if (!packet)
+        return 0;
+    if (packet->modulation == MOD_LORA) {
+        uint32_t us = lora_packet_time_on_air(packet->bandwidth, packet->datarate, packet->coderate,
+            packet->preamble, packet->no_header, packet->no_crc, packet->size, nullptr, nullptr, nullptr);
+        return (uint32_t) ((double) us / 1000.0 + 0.5);
+    }
+    if (packet->modulation == MOD_FSK && packet->datarate) {
+        // preamble, sync word, length, payload, CRC
+        double ms = 8 * (double) (packet->preamble + SIM_FSK_SYNC_WORD_SIZE + 1 + packet->size
+            + (packet->no_crc ? 0 : 2)) / (double) packet->datarate * 1E3;
+        return (uint32_t) ms + 1;
+    }
+    return 0;
+}
+
+int lgw_spectral_scan_start(uint32_t freq_hz, uint16_t nb_scan)
+{
+    return LGW_HAL_SUCCESS;
+}
+
+int lgw_spectral_scan_get_status(lgw_spectral_scan_status_t *status)
+{
+    if (!status)
+        return LGW_HAL_ERROR;
+    *status = LGW_SPECTRAL_SCAN_STATUS_COMPLETED;
+    return LGW_HAL_SUCCESS;
+}
+
+int lgw_spectral_scan_get_results(int16_t levels_dbm[LGW_SPECTRAL_SCAN_RESULT_SIZE], uint16_t results[LGW_SPECTRAL_SCAN_RESULT_SIZE])
+{
+    for (int i = 0; i < LGW_SPECTRAL_SCAN_RESULT_SIZE; i++) {
+        levels_dbm[i] = (int16_t) (-140 + i * 5);
+        results[i] = 0;
+    }
+    return LGW_HAL_SUCCESS;
+}
+
+int lgw_spectral_scan_abort()
+{
+    return LGW_HAL_SUCCESS;
+}
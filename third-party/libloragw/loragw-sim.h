@@ -0,0 +1,151 @@
+/**
+ * Software concentrator.
+ * loragw-sim library implements loragw_hal.c entry points (lgw_start(), lgw_receive(), lgw_send(), lgw_status(),
+ * lgw_get_instcnt() etc.) without USB concentrator, so LoraGatewayListener upstream, downstream and JIT threads
+ * can run in tests and benchmarks. Link loragw-sim library instead of loragw.
+ *
+ * Concentrator counter (tmst) is microseconds since lgw_start() plus counterOffset and wraps around at 2^32.
+ * Received packets are generated by the SimulatedPacketStream at the configured rate and wait in the RX FIFO
+ * until lgw_receive() fetches them, packets arrived when FIFO is full are dropped.
+ * TX requests are recorded with the lead time: how early packet was passed to the concentrator before its
+ * count_us. Packet passed less than SIM_TX_START_DELAY_US before count_us is late.
+ *
+ * Usage:
+ *  SimulatedPacketStream stream;
+ *  stream.packetsPerSecond = 100;
+ *  SimulatedConcentrator::instance().setStream(stream);
+ *  listener.start();
+ *  ...
+ *  SimulatedConcentratorStats stats = SimulatedConcentrator::instance().stats();
+ */
+#ifndef LORAGW_SIM_H_
+#define LORAGW_SIM_H_ 1
+
+#include <chrono>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+
+#include "gateway-lora.h"
+
+#define SIM_RX_FIFO_SIZE        16      ///< SX1302 RX buffer, packets
+#define SIM_TX_START_DELAY_US   1500    ///< concentrator needs at least this time to program TX
+
+class SimulatedPacketStream {
+public:
+    uint32_t packetsPerSecond;      ///< 0- no packets generated
+    size_t count;                   ///< packets to generate, 0- unlimited
+    bool poisson;                   ///< exponential intervals between packets instead of equal intervals
+    std::vector<uint32_t> frequencies;  ///< channels used in turn, Hz
+    uint8_t bandwidth;              ///< BW_125KHZ
+    uint32_t datarate;              ///< DR_LORA_SF7
+    uint8_t coderate;               ///< CR_LORA_4_5
+    float rssi;
+    float snr;
+    std::vector<std::vector<uint8_t> > payloads;    ///< payloads used in turn, if empty unconfirmed uplink from address packet number
+    SimulatedPacketStream();
+};
+
+class SimulatedTx {
+public:
+    struct lgw_pkt_tx_s pkt;
+    uint32_t sentCount;             ///< concentrator counter when lgw_send() called
+    int32_t leadUs;                 ///< count_us - sentCount, 0 for IMMEDIATE
+    bool late;                      ///< passed to the concentrator too late to be sent at count_us
+};
+
+class SimulatedConcentratorStats {
+public:
+    size_t generated;               ///< packets arrived to the concentrator
+    size_t received;                ///< packets fetched by lgw_receive()
+    size_t dropped;                 ///< packets arrived when RX FIFO was full
+    size_t sent;                    ///< lgw_send() calls
+    size_t late;                    ///< packets passed too late
+    int32_t minLeadUs;
+    int32_t maxLeadUs;
+    double avgLeadUs;
+    std::string toJsonString() const;
+};
+
+class SimulatedConcentrator {
+private:
+    mutable std::mutex mutexState;
+    bool started;
+    std::chrono::steady_clock::time_point startTime;
+    SimulatedPacketStream stream;
+    std::mt19937 rnd;
+    uint64_t nextArrival;           ///< microseconds since start
+    size_t streamIndex;             ///< packets generated by the stream
+    std::deque<struct lgw_pkt_rx_s> fifo;
+    std::vector<SimulatedTx> txs;
+    uint64_t txStart[LGW_RF_CHAIN_NB];  ///< microseconds since start
+    uint64_t txEnd[LGW_RF_CHAIN_NB];
+    SimulatedConcentratorStats counters;
+    int64_t leadSum;
+
+    /**
+     * @return microseconds since start
+     */
+    uint64_t elapsed() const;
+    /**
+     * Put stream packets arrived before now to the RX FIFO
+     */
+    void generate(
+        uint64_t now
+    );
+    void push(
+        const struct lgw_pkt_rx_s &pkt
+    );
+    void makePacket(
+        struct lgw_pkt_rx_s &retVal,
+        uint64_t arrival
+    );
+public:
+    uint32_t counterOffset;         ///< initial counter value e.g. close to wrap around
+    uint64_t eui;
+
+    SimulatedConcentrator();
+    static SimulatedConcentrator &instance();
+
+    /**
+     * Replace packet stream, stream starts at the current counter
+     */
+    void setStream(
+        const SimulatedPacketStream &stream
+    );
+    /**
+     * Put packet to the RX FIFO, count_us is set to the current counter
+     */
+    void inject(
+        const struct lgw_pkt_rx_s &pkt
+    );
+    /**
+     * Clear FIFO, transmitted packets and statistics
+     */
+    void reset();
+    uint32_t counter() const;
+    std::vector<SimulatedTx> transmitted() const;
+    SimulatedConcentratorStats stats() const;
+
+    // loragw_hal.c entry points
+    int start();
+    int stop();
+    int receive(
+        uint8_t maxPackets,
+        struct lgw_pkt_rx_s *retVal
+    );
+    int send(
+        const struct lgw_pkt_tx_s &pkt
+    );
+    int txStatus(
+        uint8_t rfChain,
+        uint8_t &retVal
+    ) const;
+    int abortTx(
+        uint8_t rfChain
+    );
+};
+
+#endif